@@ -0,0 +1,162 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "ByteVector.hpp"
+
+// count heap allocations made by the benchmarked code
+static std::atomic<size_t> allocations(0);
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if(void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// reference implementations of the previous element-wise packing
+bool packElementwise(msp::ByteVector& data,
+                     const std::vector<uint16_t>& channels) {
+    for(const uint16_t c : channels) {
+        for(size_t i(0); i < sizeof(c); ++i) {
+            data.push_back(c >> (i * 8) & 0xFF);
+        }
+    }
+    return true;
+}
+
+bool unpackElementwise(const msp::ByteVector& data,
+                       std::vector<uint16_t>& channels) {
+    channels.clear();
+    while(data.unpacking_remaining() >= sizeof(uint16_t)) {
+        uint16_t c = 0;
+        for(size_t i(0); i < sizeof(c); ++i) {
+            c |= data[data.unpacking_offset() + i] << (8 * i);
+        }
+        data.consume(sizeof(c));
+        channels.push_back(c);
+    }
+    return !channels.empty();
+}
+
+bool unpackStringElementwise(const msp::ByteVector& data, std::string& val) {
+    val.clear();
+    int8_t tmp = {};
+    while(data.unpacking_remaining()) {
+        tmp = int8_t(data[data.unpacking_offset()]);
+        data.consume(1);
+        val += tmp;
+    }
+    return true;
+}
+
+template <typename F> double nsPerCall(const size_t n, F&& f) {
+    const auto tstart = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < n; ++i) f(i);
+    const auto tend = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(tend - tstart).count() /
+           double(n);
+}
+
+void report(const std::string& name, const double t_old, const double t_new) {
+    std::cout << name << std::endl;
+    std::cout << " element-wise: " << t_old << " ns" << std::endl;
+    std::cout << " bulk:         " << t_new << " ns" << std::endl;
+    std::cout << " speedup:      " << t_old / t_new << "x" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const size_t n = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+
+    size_t sink = 0;
+
+    // 18 RC channels as sent with MSP_RC and MSP_SET_RAW_RC
+    const std::vector<uint16_t> channels(18, 1500);
+
+    const double t_pack_old = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data;
+        packElementwise(data, channels);
+        sink += data[i % data.size()];
+    });
+    const double t_pack_new = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data;
+        data.pack(channels);
+        sink += data[i % data.size()];
+    });
+
+    msp::ByteVector payload;
+    payload.pack(channels);
+    std::vector<uint16_t> decoded;
+
+    const double t_unpack_old = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data(payload.begin(), payload.end());
+        unpackElementwise(data, decoded);
+        sink += decoded[i % decoded.size()];
+    });
+    const double t_unpack_new = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data(payload.begin(), payload.end());
+        data.unpack(decoded);
+        sink += decoded[i % decoded.size()];
+    });
+
+    // board and craft names, box names etc.
+    msp::ByteVector text;
+    text.pack(std::string("ARM;ANGLE;HORIZON;BARO;MAG;HEADFREE;HEADADJ;"
+                          "CAMSTAB;PASSTHRU;BEEPERON;LEDLOW;OSD DISABLE SW;"
+                          "TELEMETRY;BLACKBOX;FAILSAFE;AIRMODE;"));
+    std::string str;
+
+    const double t_string_old = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data(text.begin(), text.end());
+        unpackStringElementwise(data, str);
+        sink += str[i % str.size()];
+    });
+    const double t_string_new = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data(text.begin(), text.end());
+        data.unpack(str);
+        sink += str[i % str.size()];
+    });
+
+    // receiving a short telemetry payload byte by byte and handing a copy to
+    // the decoder, as std::vector<uint8_t> and with inline storage
+    const size_t telemetry_size = 22;
+    size_t alloc_vector = allocations;
+    const double t_vector = nsPerCall(n, [&](size_t i) {
+        std::vector<uint8_t> frame;
+        for(size_t b = 0; b < telemetry_size; ++b) frame.push_back(uint8_t(b));
+        const std::vector<uint8_t> copy(frame);
+        sink += copy[i % copy.size()];
+    });
+    alloc_vector = allocations - alloc_vector;
+
+    size_t alloc_inline = allocations;
+    const double t_inline = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector frame;
+        for(size_t b = 0; b < telemetry_size; ++b) frame.push_back(uint8_t(b));
+        const msp::ByteVector copy(frame);
+        sink += copy[i % copy.size()];
+    });
+    alloc_inline = allocations - alloc_inline;
+
+    std::cout << "ByteVector (" << n << " iterations)" << std::endl;
+    report("pack 18 x uint16_t", t_pack_old, t_pack_new);
+    report("unpack 18 x uint16_t", t_unpack_old, t_unpack_new);
+    report("unpack string (" + std::to_string(text.size()) + " bytes)",
+           t_string_old, t_string_new);
+    std::cout << "receive and copy " << telemetry_size << " bytes" << std::endl;
+    std::cout << " std::vector:    " << t_vector << " ns, "
+              << double(alloc_vector) / double(n) << " allocations"
+              << std::endl;
+    std::cout << " inline storage: " << t_inline << " ns, "
+              << double(alloc_inline) / double(n) << " allocations"
+              << std::endl;
+    std::cout << " speedup:        " << t_vector / t_inline << "x" << std::endl;
+    return sink == 0;
+}
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <set>
+#include <string>
+#include "msp_msg.hpp"
+
+// reference implementation of the previous std::set based status decoding
+struct SetStatus {
+    msp::Value<uint16_t> cycle_time;
+    msp::Value<uint16_t> i2c_errors;
+    std::set<msp::msg::Sensor> sensors;
+    std::set<size_t> box_mode_flags;
+    msp::Value<uint8_t> current_profile;
+
+    bool decode(const msp::ByteVector& data) {
+        using msp::msg::Sensor;
+        bool rc = true;
+        rc &= data.unpack(cycle_time);
+        rc &= data.unpack(i2c_errors);
+
+        sensors.clear();
+        uint16_t sensor = 0;
+        rc &= data.unpack(sensor);
+        if(sensor & (1 << 0)) sensors.insert(Sensor::Accelerometer);
+        if(sensor & (1 << 1)) sensors.insert(Sensor::Barometer);
+        if(sensor & (1 << 2)) sensors.insert(Sensor::Magnetometer);
+        if(sensor & (1 << 3)) sensors.insert(Sensor::GPS);
+        if(sensor & (1 << 4)) sensors.insert(Sensor::Sonar);
+        if(sensor & (1 << 5)) sensors.insert(Sensor::OpticalFlow);
+        if(sensor & (1 << 6)) sensors.insert(Sensor::Pitot);
+        if(sensor & (1 << 15)) sensors.insert(Sensor::GeneralHealth);
+
+        box_mode_flags.clear();
+        uint32_t flag = 0;
+        rc &= data.unpack(flag);
+        for(size_t ibox(0); ibox < sizeof(flag) * CHAR_BIT; ibox++) {
+            if(flag & (uint32_t(1) << ibox)) box_mode_flags.insert(ibox);
+        }
+
+        rc &= data.unpack(current_profile);
+        return rc;
+    }
+};
+
+template <typename F> double nsPerCall(const size_t n, F&& f) {
+    const auto tstart = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < n; ++i) f(i);
+    const auto tend = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(tend - tstart).count() /
+           double(n);
+}
+
+int main(int argc, char* argv[]) {
+    const size_t n = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+
+    // typical status payload with several sensors and boxes active
+    msp::ByteVector payload;
+    payload.pack(uint16_t(1000));
+    payload.pack(uint16_t(0));
+    payload.pack(uint16_t(0x800F));
+    payload.pack(uint32_t(0x0F0F0F0F));
+    payload.pack(uint8_t(0));
+    payload.pack(uint16_t(10));
+    payload.pack(uint16_t(125));
+
+    size_t sink = 0;
+
+    SetStatus set_status;
+    const double t_set = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data(payload.begin(), payload.end());
+        data[8] = uint8_t(i);
+        set_status.decode(data);
+        sink += set_status.box_mode_flags.size();
+    });
+
+    msp::msg::Status status(msp::FirmwareVariant::BTFL);
+    const double t_flags = nsPerCall(n, [&](size_t i) {
+        msp::ByteVector data(payload.begin(), payload.end());
+        data[8] = uint8_t(i);
+        status.decode(data);
+        sink += status.box_mode_flags.size();
+    });
+
+    std::cout << "Status decode (" << n << " iterations)" << std::endl;
+    std::cout << " std::set: " << t_set << " ns" << std::endl;
+    std::cout << " FlagSet:  " << t_flags << " ns" << std::endl;
+    std::cout << " speedup:  " << t_set / t_flags << "x" << std::endl;
+    return sink == 0;
+}
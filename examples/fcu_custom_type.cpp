@@ -8,8 +8,8 @@ struct MyIdent : public msp::Message {
 
     msp::ByteVector raw_data;
 
-    virtual bool decode(const msp::ByteVector &data) override {
-        raw_data = data;
+    virtual bool decode(const msp::ByteView &data) override {
+        raw_data = msp::ByteVector(data.begin(), data.end());
         return true;
     }
 };
@@ -0,0 +1,59 @@
+#include <Client.hpp>
+#include <Proxy.hpp>
+#include <msp_msg.hpp>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+static volatile std::sig_atomic_t running = 1;
+
+void onExit(int /*signal*/) { running = 0; }
+
+int main(int argc, char* argv[]) {
+    const std::string device =
+        (argc > 1) ? std::string(argv[1]) : "/dev/ttyUSB0";
+    const size_t baudrate = (argc > 2) ? std::stoul(argv[2]) : 115200;
+    const std::string path =
+        (argc > 3) ? std::string(argv[3]) : "/tmp/msp.sock";
+    const uint16_t port =
+        (argc > 4) ? uint16_t(std::stoul(argv[4])) : uint16_t(5760);
+
+    msp::client::Client client;
+    client.setLoggingLevel(msp::client::LoggingLevel::WARNING);
+    client.setAutoReconnect(true);
+    if(!client.start(device, baudrate)) {
+        std::cerr << "cannot open " << device << std::endl;
+        return 1;
+    }
+    // telemetry polls of several programs are merged into one request
+    for(const msp::ID id : {msp::ID::MSP_STATUS,
+                            msp::ID::MSP_RAW_IMU,
+                            msp::ID::MSP_MOTOR,
+                            msp::ID::MSP_RC,
+                            msp::ID::MSP_RAW_GPS,
+                            msp::ID::MSP_ATTITUDE,
+                            msp::ID::MSP_ALTITUDE,
+                            msp::ID::MSP_ANALOG})
+        client.markRead(id);
+
+    // local programs on the Unix domain socket are served before the tools
+    // on the TCP socket
+    msp::client::Proxy proxy(client);
+    if(!proxy.listenUnix(path, 1) || proxy.listenTcp(port) == 0 ||
+       !proxy.start()) {
+        std::cerr << "cannot listen on " << path << " and port " << port
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "proxy for " << device << " on " << path << " and port "
+              << port << std::endl;
+
+    // Ctrl+C to quit
+    std::signal(SIGINT, onExit);
+    std::signal(SIGTERM, onExit);
+    while(running) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    proxy.stop();
+    std::cout << proxy.stats();
+    client.stop();
+}
@@ -0,0 +1,41 @@
+#include <Client.hpp>
+#include <FontTransfer.hpp>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " font.mcm [device] [baudrate] [window]" << std::endl;
+        return 1;
+    }
+    const std::string device =
+        (argc > 2) ? std::string(argv[2]) : "/dev/ttyUSB0";
+    const size_t baudrate = (argc > 3) ? std::stoul(argv[3]) : 115200;
+
+    fcu::OsdFont font;
+    if(!font.load(argv[1])) {
+        std::cerr << "cannot parse " << argv[1] << std::endl;
+        return 1;
+    }
+
+    msp::client::Client client;
+    client.setLoggingLevel(msp::client::LoggingLevel::WARNING);
+    if(!client.start(device, baudrate)) {
+        std::cerr << "cannot open " << device << std::endl;
+        return 1;
+    }
+
+    fcu::FontTransferOptions options;
+    if(argc > 4) options.window = std::stoul(argv[4]);
+    options.progress = [](const fcu::FontTransferProgress& p) {
+        static const char* phases[] = {"read", "write", "verify"};
+        std::cout << "\r" << phases[int(p.phase)] << " " << p.done << "/"
+                  << p.total << " " << p.bytesPerSecond() << " bytes/s   "
+                  << std::flush;
+    };
+    const fcu::FontTransferReport report =
+        fcu::FontTransfer(client).upload(font, options);
+    std::cout << std::endl << report;
+    client.stop();
+    return report.success ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#include <Client.hpp>
+#include <iostream>
+#include <msp_msg.hpp>
+
+// round trip time of the API version request with the given settings
+static double measure(const std::string& device, const size_t baudrate,
+                      const bool tuned, const size_t count) {
+    msp::client::Client client;
+    client.setLoggingLevel(msp::client::LoggingLevel::WARNING);
+    if(tuned) client.setSerialTuning(msp::client::SerialTuning());
+    if(!client.start(device, baudrate)) return -1;
+    std::cout << client.getSerialStatus();
+
+    msp::msg::ApiVersion api(msp::FirmwareVariant::INAV);
+    for(size_t i = 0; i < count; ++i) client.sendMessage(api, 1.0);
+    const msp::client::RttEstimator rtt = client.getRttEstimate();
+    client.stop();
+    std::cout << " RTT: " << rtt.srtt() * 1e3 << " +/- " << rtt.rttvar() * 1e3
+              << " ms (" << rtt.samples() << " samples)" << std::endl;
+    return rtt.srtt();
+}
+
+int main(int argc, char* argv[]) {
+    const std::string device =
+        (argc > 1) ? std::string(argv[1]) : "/dev/ttyUSB0";
+    const size_t baudrate = (argc > 2) ? std::stoul(argv[2]) : 115200;
+    const size_t count    = (argc > 3) ? std::stoul(argv[3]) : 200;
+
+    std::cout << "### default settings" << std::endl;
+    const double untuned = measure(device, baudrate, false, count);
+    std::cout << "### low latency settings" << std::endl;
+    const double tuned = measure(device, baudrate, true, count);
+    if(untuned < 0 || tuned < 0) {
+        std::cerr << "cannot open " << device << std::endl;
+        return 1;
+    }
+    std::cout << "speedup: " << untuned / tuned << std::endl;
+}
@@ -2,42 +2,284 @@
 #define BYTE_VECTOR_HPP
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <vector>
+#include "ByteView.hpp"
 #include "Value.hpp"
 
 namespace msp {
 
 struct Packable;
 
-class ByteVector : public std::vector<uint8_t> {
+/**
+ * @brief Contiguous, resizable container of bytes with an unpacking cursor.
+ * Payloads of up to inline_capacity bytes, which covers nearly all MSP
+ * messages, are stored inside the object itself, so that creating, copying and
+ * filling such ByteVectors does not allocate memory. Larger frames are moved
+ * to the heap transparently. The interface mimics std::vector<uint8_t>.
+ */
+class ByteVector {
 public:
+    typedef uint8_t value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef uint8_t& reference;
+    typedef const uint8_t& const_reference;
+    typedef uint8_t* pointer;
+    typedef const uint8_t* const_pointer;
+    typedef uint8_t* iterator;
+    typedef const uint8_t* const_iterator;
+
+    /**
+     * @brief Number of bytes stored without heap allocation
+     */
+    static constexpr size_type inline_capacity = 64;
+
     /**
      * @brief ByteVector constructor
      */
-    ByteVector() : offset(0) {}
+    ByteVector() :
+        data_(inline_), size_(0), capacity_(inline_capacity), offset(0) {}
 
     /**
      * @brief ByteVector constructor
-     * @param arg1 Single argument passed to constructor of parent std::vector
-     * class
+     * @param count Number of zero-initialised bytes
+     */
+    explicit ByteVector(const size_type count) : ByteVector() {
+        resize(count);
+    }
+
+    /**
+     * @brief ByteVector constructor
+     * @param count Number of bytes
+     * @param value Value of all bytes
+     */
+    ByteVector(const size_type count, const uint8_t value) : ByteVector() {
+        assign(count, value);
+    }
+
+    /**
+     * @brief ByteVector constructor copying a range of bytes
+     * @param first Iterator to the first byte
+     * @param last Iterator past the last byte
      */
-    template <typename T1>
-    ByteVector(T1 arg1) : std::vector<uint8_t>(arg1), offset(0) {}
+    template <class InputIt,
+              typename std::enable_if<!std::is_integral<InputIt>::value,
+                                      InputIt>::type* = nullptr>
+    ByteVector(InputIt first, InputIt last) : ByteVector() {
+        assign(first, last);
+    }
 
     /**
      * @brief ByteVector constructor
-     * @param arg1 First of two arguments passed to constructor of parent
-     * std::vector class
-     * @param arg2 Second of two arguments passed to constructor of parent
-     * std::vector class
+     * @param init List of bytes
+     */
+    ByteVector(std::initializer_list<uint8_t> init) :
+        ByteVector(init.begin(), init.end()) {}
+
+    /**
+     * @brief ByteVector constructor copying the content of a std::vector
+     * @param data Vector of bytes
+     */
+    ByteVector(const std::vector<uint8_t>& data) :
+        ByteVector(data.begin(), data.end()) {}
+
+    ByteVector(const ByteVector& other) : ByteVector() {
+        assign(other.begin(), other.end());
+        offset = other.offset;
+    }
+
+    ByteVector(ByteVector&& other) noexcept : ByteVector() {
+        steal(other);
+    }
+
+    ByteVector& operator=(const ByteVector& other) {
+        if(this != &other) {
+            assign(other.begin(), other.end());
+            offset = other.offset;
+        }
+        return *this;
+    }
+
+    ByteVector& operator=(ByteVector&& other) noexcept {
+        if(this != &other) {
+            heap_.reset();
+            data_     = inline_;
+            capacity_ = inline_capacity;
+            steal(other);
+        }
+        return *this;
+    }
+
+    iterator begin() { return data_; }
+
+    const_iterator begin() const { return data_; }
+
+    const_iterator cbegin() const { return data_; }
+
+    iterator end() { return data_ + size_; }
+
+    const_iterator end() const { return data_ + size_; }
+
+    const_iterator cend() const { return data_ + size_; }
+
+    uint8_t* data() { return data_; }
+
+    const uint8_t* data() const { return data_; }
+
+    size_type size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    size_type capacity() const { return capacity_; }
+
+    size_type max_size() const { return std::numeric_limits<size_type>::max(); }
+
+    /**
+     * @brief Queries if the data is stored inside the object
+     * @returns True if no heap memory is used
+     */
+    bool is_inline() const { return data_ == inline_; }
+
+    reference operator[](const size_type i) { return data_[i]; }
+
+    const_reference operator[](const size_type i) const { return data_[i]; }
+
+    reference at(const size_type i) {
+        if(i >= size_) throw std::out_of_range("ByteVector::at");
+        return data_[i];
+    }
+
+    const_reference at(const size_type i) const {
+        if(i >= size_) throw std::out_of_range("ByteVector::at");
+        return data_[i];
+    }
+
+    reference front() { return data_[0]; }
+
+    const_reference front() const { return data_[0]; }
+
+    reference back() { return data_[size_ - 1]; }
+
+    const_reference back() const { return data_[size_ - 1]; }
+
+    /**
+     * @brief Makes sure that at least new_cap bytes can be stored without
+     * further reallocation
+     * @param new_cap Minimal capacity
      */
-    template <typename T1, typename T2>
-    ByteVector(T1 arg1, T2 arg2) :
-        std::vector<uint8_t>(arg1, arg2), offset(0) {}
+    void reserve(const size_type new_cap) {
+        if(new_cap > capacity_) reallocate(new_cap);
+    }
+
+    void clear() { size_ = 0; }
+
+    void resize(const size_type count) { resize(count, 0); }
+
+    void resize(const size_type count, const uint8_t value) {
+        if(count > size_) {
+            grow(count);
+            std::memset(data_ + size_, value, count - size_);
+        }
+        size_ = count;
+    }
+
+    void push_back(const uint8_t value) {
+        if(size_ == capacity_) grow(size_ + 1);
+        data_[size_++] = value;
+    }
+
+    void pop_back() { --size_; }
+
+    void assign(const size_type count, const uint8_t value) {
+        clear();
+        resize(count, value);
+    }
+
+    template <class InputIt,
+              typename std::enable_if<!std::is_integral<InputIt>::value,
+                                      InputIt>::type* = nullptr>
+    void assign(InputIt first, InputIt last) {
+        if(aliases(first)) {
+            // source is part of this vector, copy it first
+            const ByteVector tmp(first, last);
+            assign(tmp.begin(), tmp.end());
+            return;
+        }
+        const size_type count = size_type(std::distance(first, last));
+        clear();
+        reserve(count);
+        std::copy(first, last, data_);
+        size_ = count;
+    }
+
+    void assign(std::initializer_list<uint8_t> init) {
+        assign(init.begin(), init.end());
+    }
+
+    iterator insert(const_iterator pos, const uint8_t value) {
+        return insert(pos, &value, &value + 1);
+    }
+
+    template <class InputIt,
+              typename std::enable_if<!std::is_integral<InputIt>::value,
+                                      InputIt>::type* = nullptr>
+    iterator insert(const_iterator pos, InputIt first, InputIt last) {
+        const size_type index = size_type(pos - data_);
+        if(aliases(first)) {
+            // source is part of this vector, copy it first
+            const ByteVector tmp(first, last);
+            return insert(data_ + index, tmp.begin(), tmp.end());
+        }
+        const size_type count = size_type(std::distance(first, last));
+        grow(size_ + count);
+        std::memmove(data_ + index + count, data_ + index, size_ - index);
+        std::copy(first, last, data_ + index);
+        size_ += count;
+        return data_ + index;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        const size_type index = size_type(first - data_);
+        const size_type count = size_type(last - first);
+        std::memmove(data_ + index, data_ + index + count,
+                     size_ - index - count);
+        size_ -= count;
+        return data_ + index;
+    }
+
+    void swap(ByteVector& other) noexcept {
+        ByteVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend bool operator==(const ByteVector& lhs, const ByteVector& rhs) {
+        return lhs.size_ == rhs.size_ &&
+               (lhs.size_ == 0 ||
+                std::memcmp(lhs.data_, rhs.data_, lhs.size_) == 0);
+    }
+
+    friend bool operator!=(const ByteVector& lhs, const ByteVector& rhs) {
+        return !(lhs == rhs);
+    }
+
+    friend bool operator<(const ByteVector& lhs, const ByteVector& rhs) {
+        return std::lexicographical_compare(lhs.begin(), lhs.end(),
+                                            rhs.begin(), rhs.end());
+    }
 
     /**
      * @brief Packs integer types into the ByteVector. Ensures little endian
@@ -49,11 +291,7 @@ public:
     template <typename T, typename std::enable_if<std::is_integral<T>::value,
                                                   T>::type* = nullptr>
     bool pack(const T& val) {
-        // little endian packing
-        for(size_t i(0); i < sizeof(val); ++i) {
-            this->push_back(val >> (i * 8) & 0xFF);
-        }
-        return true;
+        return pack(&val, 1);
     }
 
     /**
@@ -68,9 +306,51 @@ public:
               typename std::enable_if<std::is_floating_point<T>::value,
                                       T>::type* = nullptr>
     bool pack(const T& val) {
-        ByteVector b(sizeof(val));
-        reinterpret_cast<T&>(b.front()) = val;
-        return this->pack(b);
+        return pack(&val, 1);
+    }
+
+    /**
+     * @brief Packs an array of integer or floating point numbers into the
+     * ByteVector in little endian order. The ByteVector is resized once and
+     * the data is copied in one go on little endian hosts.
+     * @tparam T Underlying data type to be packed. Must be an arithmetic type.
+     * @param vals Pointer to the first element
+     * @param count Number of elements to pack
+     * @return true
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value,
+                                                  T>::type* = nullptr>
+    bool pack(const T* vals, const std::size_t count) {
+        const std::size_t pos = this->size();
+        this->resize(pos + count * sizeof(T));
+        ByteView::store(this->data() + pos, vals, count);
+        return true;
+    }
+
+    /**
+     * @brief Packs a fixed size array of numbers into the ByteVector in little
+     * endian order.
+     * @param vals Array to be packed
+     * @return true
+     */
+    template <typename T, std::size_t N,
+              typename std::enable_if<std::is_arithmetic<T>::value,
+                                      T>::type* = nullptr>
+    bool pack(const std::array<T, N>& vals) {
+        return pack(vals.data(), N);
+    }
+
+    /**
+     * @brief Packs a std::vector of numbers into the ByteVector in little
+     * endian order.
+     * @param vals Vector to be packed
+     * @return true
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                                                      !std::is_same<T, uint8_t>::value,
+                                                  T>::type* = nullptr>
+    bool pack(const std::vector<T>& vals) {
+        return pack(vals.data(), vals.size());
     }
 
     /**
@@ -92,9 +372,12 @@ public:
               typename std::enable_if<std::is_arithmetic<T2>::value,
                                       T2>::type* = nullptr>
     bool pack(const T1 val, const T2 scale, const T2 offset = 0) {
-        return pack(std::clamp(static_cast<encoding_T>((val + offset) * scale),
-                               std::numeric_limits<encoding_T>::min(),
-                               std::numeric_limits<encoding_T>::max()));
+        // saturate before converting, out of range conversions are undefined
+        const double scaled = (double(val) + double(offset)) * double(scale);
+        return pack(static_cast<encoding_T>(
+            std::clamp(scaled,
+                       double(std::numeric_limits<encoding_T>::lowest()),
+                       double(std::numeric_limits<encoding_T>::max()))));
     }
 
     /**
@@ -106,11 +389,8 @@ public:
      */
     bool pack(const std::string& val,
               size_t max_len = std::numeric_limits<size_t>::max()) {
-        size_t count = 0;
-        for(auto c : val) {
-            this->push_back(c);
-            if(++count == max_len) break;
-        }
+        const size_t count = std::min(val.size(), max_len);
+        this->insert(this->end(), val.begin(), val.begin() + count);
         // TODO: validate that this null termination is the right thing to do in
         // all cases definitly correct in tested cases
         this->push_back(0);
@@ -126,11 +406,8 @@ public:
      */
     bool pack(const ByteVector& data,
               size_t max_len = std::numeric_limits<size_t>::max()) {
-        size_t count = 0;
-        for(auto c : data) {
-            this->push_back(c);
-            if(++count == max_len) break;
-        }
+        const size_t count = std::min(data.size(), max_len);
+        this->insert(this->end(), data.begin(), data.begin() + count);
         return true;
     }
 
@@ -170,6 +447,38 @@ public:
         return pack<encoding_T>(val(), scale, offset);
     }
 
+    /**
+     * @brief Packs a field stored next to a ValueMask
+     * @param val Reference to the field and its presence flag
+     * @return True if successful, false if the field is not set
+     */
+    template <class T, class Word> bool pack(const ValueRef<T, Word>& val) {
+        if(!val.set()) return false;
+        return pack(val());
+    }
+
+    /**
+     * @brief Packs scaled fields stored next to a ValueMask as packed_val =
+     * (val+offset)*scale
+     * @tparam encoding_T Data type to use for the actual data packing (usually
+     * an integral type)
+     * @param val Reference to the field and its presence flag
+     * @param scale Value of scaling to apply to the offset value
+     * @param offset Value of offset to apply to the input value (optional,
+     * defaults to 0)
+     * @return True if successful, false if the field is not set
+     */
+    template <typename encoding_T, typename T1, class Word, typename T2,
+              typename std::enable_if<std::is_arithmetic<T1>::value,
+                                      T1>::type* = nullptr,
+              typename std::enable_if<std::is_arithmetic<T2>::value,
+                                      T2>::type* = nullptr>
+    bool pack(const ValueRef<T1, Word>& val, const T2 scale,
+              const T2 offset = 0) {
+        if(!val.set()) return false;
+        return pack<encoding_T>(val(), scale, offset);
+    }
+
     /**
      * @brief Packs a Value<ByteVector> into the ByteVector.
      * @param val The Value<ByteVector> to be packed
@@ -220,10 +529,8 @@ public:
                                                   T>::type* = nullptr>
     bool unpack(T& val) const {
         if(unpacking_remaining() < sizeof(val)) return false;
-        val = 0;
-        for(size_t i(0); i < sizeof(val); ++i) {
-            val |= (*this)[offset++] << (8 * i);
-        }
+        val = ByteView::load<T>(this->data() + offset);
+        offset += sizeof(val);
         return true;
     }
 
@@ -252,11 +559,66 @@ public:
                                       T>::type* = nullptr>
     bool unpack(T& val) const {
         if(unpacking_remaining() < sizeof(val)) return false;
-        val = reinterpret_cast<const T&>((*this)[offset]);
+        val = ByteView::load<T>(this->data() + offset);
         offset += sizeof(val);
         return true;
     }
 
+    /**
+     * @brief Extracts an array of little endian integer or floating point
+     * numbers from the ByteVector. Consumes count*sizeof(T) bytes, which are
+     * copied in one go on little endian hosts. Fails without consuming any
+     * data if not enough bytes are available.
+     * @tparam T Underlying data type to be extracted. Must be an arithmetic
+     * type.
+     * @param vals Pointer to the first destination element
+     * @param count Number of elements to extract
+     * @return True on successful unpack
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value,
+                                                  T>::type* = nullptr>
+    bool unpack(T* vals, const std::size_t count) const {
+        if(count > unpacking_remaining() / sizeof(T)) return false;
+        ByteView::load(vals, this->data() + offset, count);
+        offset += count * sizeof(T);
+        return true;
+    }
+
+    /**
+     * @brief Extracts a fixed size array of little endian numbers from the
+     * ByteVector. Fails without consuming any data if not enough bytes are
+     * available.
+     * @param vals Destination of unpack operation
+     * @return True on successful unpack
+     */
+    template <typename T, std::size_t N,
+              typename std::enable_if<std::is_arithmetic<T>::value,
+                                      T>::type* = nullptr>
+    bool unpack(std::array<T, N>& vals) const {
+        return unpack(vals.data(), N);
+    }
+
+    /**
+     * @brief Extracts little endian numbers from the ByteVector and stores
+     * them in a std::vector. Consumes all remaining complete elements unless
+     * instructed otherwise.
+     * @param vals Destination of unpack operation
+     * @param count Number of elements to extract. Optional, if unset, all
+     * remaining complete elements will be extracted.
+     * @return True on successful unpack
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                                                      !std::is_same<T, uint8_t>::value,
+                                                  T>::type* = nullptr>
+    bool unpack(std::vector<T>& vals,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        if(count == std::numeric_limits<size_t>::max())
+            count = unpacking_remaining() / sizeof(T);
+        if(count > unpacking_remaining() / sizeof(T)) return false;
+        vals.resize(count);
+        return unpack(vals.data(), count);
+    }
+
     /**
      * @brief Extracts data from the ByteVector and stores it in a
      * std::string. Consumes all remaining data unless instructed otherwise.
@@ -270,14 +632,9 @@ public:
         if(count == std::numeric_limits<size_t>::max())
             count = unpacking_remaining();
         if(count > unpacking_remaining()) return false;
-        bool rc = true;
-        val.clear();
-        int8_t tmp = {};
-        for(size_t i = 0; i < count; ++i) {
-            rc &= unpack(tmp);
-            val += tmp;
-        }
-        return rc;
+        val.assign(reinterpret_cast<const char*>(this->data() + offset), count);
+        offset += count;
+        return true;
     }
 
     /**
@@ -293,10 +650,9 @@ public:
                 size_t count = std::numeric_limits<size_t>::max()) const {
         if(count == std::numeric_limits<size_t>::max())
             count = unpacking_remaining();
-        if(!consume(count)) return false;
-        val.clear();
-        val.insert(
-            val.end(), unpacking_iterator(), unpacking_iterator() + count);
+        if(count > unpacking_remaining()) return false;
+        val.assign(unpacking_iterator(), unpacking_iterator() + count);
+        offset += count;
         return true;
     }
 
@@ -339,7 +695,10 @@ public:
               typename std::enable_if<std::is_base_of<Packable, T>::value,
                                       T>::type* = nullptr>
     bool unpack(T& obj) const {
-        return obj.unpack_from(*this);
+        const ByteView view(data() + offset, unpacking_remaining());
+        const bool rc = obj.unpack_from(view);
+        offset += view.unpacking_offset();
+        return rc;
     }
 
     /**
@@ -404,6 +763,37 @@ public:
         return val.set() = unpack<encoding_T>(val(), scale, offset);
     }
 
+    /**
+     * @brief Unpacks a field stored next to a ValueMask
+     * @param val Reference to the destination field and its presence flag
+     * @return True on successful unpack
+     */
+    template <class T, class Word>
+    bool unpack(const ValueRef<T, Word>& val) const {
+        return val.set() = unpack(val());
+    }
+
+    /**
+     * @brief Unpacks scaled fields stored next to a ValueMask as
+     * val = (packed_val/scale)-offset
+     * @tparam encoding_T data type used to store the scaled value (usually an
+     * integral type)
+     * @param val Reference to the destination field and its presence flag
+     * @param scale Value of scaling to apply to the offset value
+     * @param offset Value of offset to apply to the input value (optional,
+     * defaults to 0)
+     * @return True if successful
+     */
+    template <typename encoding_T, typename T1, class Word, typename T2 = float,
+              typename std::enable_if<std::is_arithmetic<T1>::value,
+                                      T1>::type* = nullptr,
+              typename std::enable_if<std::is_arithmetic<T2>::value,
+                                      T2>::type* = nullptr>
+    bool unpack(const ValueRef<T1, Word>& val, T2 scale = 1,
+                T2 offset = 0) const {
+        return val.set() = unpack<encoding_T>(val(), scale, offset);
+    }
+
     /**
      * @brief Gives the number of bytes which have already been consumed by
      * unpack operations.
@@ -415,17 +805,13 @@ public:
      * @brief Gives an iterator to the next element ready for unpacking
      * @returns iterator to the next byte for unpacking
      */
-    std::vector<uint8_t>::iterator unpacking_iterator() {
-        return this->begin() + offset;
-    }
+    iterator unpacking_iterator() { return this->begin() + offset; }
 
     /**
      * @brief Gives an iterator to the next element ready for unpacking
      * @returns iterator to the next byte for unpacking
      */
-    std::vector<uint8_t>::const_iterator unpacking_iterator() const {
-        return this->begin() + offset;
-    }
+    const_iterator unpacking_iterator() const { return this->begin() + offset; }
 
     /**
      * @brief Manually consumes data, thus skipping the values.
@@ -447,18 +833,67 @@ public:
      */
     std::size_t unpacking_remaining() const { return this->size() - offset; }
 
+private:
+    // grows the capacity geometrically to hold at least count bytes
+    void grow(const size_type count) {
+        if(count > capacity_) reallocate(std::max(count, 2 * capacity_));
+    }
+
+    void reallocate(const size_type new_cap) {
+        std::unique_ptr<uint8_t[]> heap(new uint8_t[new_cap]);
+        if(size_) std::memcpy(heap.get(), data_, size_);
+        heap_     = std::move(heap);
+        data_     = heap_.get();
+        capacity_ = new_cap;
+    }
+
+    // takes over the content of other and leaves it empty
+    void steal(ByteVector& other) {
+        if(other.is_inline()) {
+            if(other.size_) std::memcpy(inline_, other.inline_, other.size_);
+        }
+        else {
+            heap_     = std::move(other.heap_);
+            data_     = heap_.get();
+            capacity_ = other.capacity_;
+        }
+        size_              = other.size_;
+        offset             = other.offset;
+        other.data_        = other.inline_;
+        other.size_        = 0;
+        other.capacity_    = inline_capacity;
+        other.offset       = 0;
+    }
+
+    // checks if an iterator points into the storage of this vector
+    template <class It> bool aliases(const It& it) const {
+        if constexpr(std::is_pointer<It>::value) {
+            const std::less_equal<const void*> le;
+            return le(data_, it) && le(it, data_ + size_);
+        }
+        else {
+            return false;
+        }
+    }
+
+    uint8_t* data_;
+    size_type size_;
+    size_type capacity_;
+    std::unique_ptr<uint8_t[]> heap_;
+    uint8_t inline_[inline_capacity];
+
 protected:
     mutable std::size_t offset;
 };
 
 /**
  * @brief Definition of a pure virtual class used to indicate that a child
- * class can pack itself into a ByteVector and unpack itself from a ByteVector.
+ * class can pack itself into a ByteVector and unpack itself from a ByteView.
  */
 struct Packable {
     virtual ~Packable() {}
-    virtual bool pack_into(ByteVector& data) const   = 0;
-    virtual bool unpack_from(const ByteVector& data) = 0;
+    virtual bool pack_into(ByteVector& data) const = 0;
+    virtual bool unpack_from(const ByteView& data) = 0;
 };
 
 typedef std::shared_ptr<ByteVector> ByteVectorPtr;
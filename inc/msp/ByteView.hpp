@@ -0,0 +1,514 @@
+#ifndef BYTE_VIEW_HPP
+#define BYTE_VIEW_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Value.hpp"
+
+namespace msp {
+
+struct Packable;
+
+/**
+ * @brief Byte order of the host. MSP transfers all multi-byte values in little
+ * endian order, so on little endian hosts values and arrays of values can be
+ * copied to and from the wire with a single memcpy.
+ */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+constexpr bool host_little_endian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#elif defined(_WIN32)
+constexpr bool host_little_endian = true;
+#else
+constexpr bool host_little_endian = false;
+#endif
+
+/**
+ * @brief Detects resizable containers of bytes (e.g. ByteVector or
+ * std::vector<uint8_t>), which can be filled from a range of bytes by assign()
+ */
+template <class T, class = void> struct is_byte_buffer : std::false_type {};
+
+template <class T>
+struct is_byte_buffer<
+    T, std::void_t<decltype(std::declval<T&>().assign(
+           std::declval<const uint8_t*>(), std::declval<const uint8_t*>())),
+       decltype(std::declval<const T&>().data())>> :
+    std::is_same<typename T::value_type, uint8_t> {};
+
+/**
+ * @brief Non-owning, read-only view on a contiguous range of bytes with its own
+ * unpacking cursor. Creating a view does not copy the underlying data, so any
+ * number of views may decode the same buffer concurrently, as long as each
+ * thread uses its own view. The viewed data must outlive the view.
+ */
+class ByteView {
+public:
+    /**
+     * @brief ByteView constructor creating an empty view
+     */
+    ByteView() : data_(nullptr), size_(0), offset(0) {}
+
+    /**
+     * @brief ByteView constructor
+     * @param data Pointer to the first byte
+     * @param size Number of bytes in the view
+     */
+    ByteView(const uint8_t* data, const std::size_t size) :
+        data_(data), size_(size), offset(0) {}
+
+    /**
+     * @brief ByteView constructor viewing the full content of a contiguous
+     * container of bytes (e.g. a ByteVector or std::vector<uint8_t>).
+     * Unpacking starts at the beginning of the container.
+     * @param data Container to be viewed
+     */
+    template <class C,
+              typename std::enable_if<
+                  std::is_convertible<decltype(std::declval<const C&>().data()),
+                                      const uint8_t*>::value,
+                  C>::type* = nullptr>
+    ByteView(const C& data) :
+        data_(data.data()), size_(data.size()), offset(0) {}
+
+    /**
+     * @brief Gets a pointer to the first byte of the view
+     * @returns Pointer to the data
+     */
+    const uint8_t* data() const { return data_; }
+
+    /**
+     * @brief Gets the total number of bytes in the view
+     * @returns Number of bytes
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief Queries if the view is empty
+     * @returns True if there are no bytes in the view
+     */
+    bool empty() const { return size_ == 0; }
+
+    const uint8_t* begin() const { return data_; }
+
+    const uint8_t* end() const { return data_ + size_; }
+
+    uint8_t operator[](const std::size_t i) const { return data_[i]; }
+
+    /**
+     * @brief Creates a view on a sub-range of this view
+     * @param pos Position of the first byte
+     * @param count Number of bytes. Limited to the bytes available after pos.
+     * @returns New view with its own cursor
+     */
+    ByteView subview(
+        std::size_t pos,
+        std::size_t count = std::numeric_limits<size_t>::max()) const {
+        if(pos > size_) pos = size_;
+        if(count > size_ - pos) count = size_ - pos;
+        return ByteView(data_ + pos, count);
+    }
+
+    /**
+     * @brief Extracts little endian integers from the view. Consumes a number
+     * of bytes matching sizeof(T). Fails if not enough bytes are available.
+     * @tparam T Underlying data type to be extracted. Must be an integral type.
+     * @param val Destination of unpack operation.
+     * @return True on successful unpack
+     */
+    template <typename T, typename std::enable_if<std::is_integral<T>::value,
+                                                  T>::type* = nullptr>
+    bool unpack(T& val) const {
+        if(unpacking_remaining() < sizeof(val)) return false;
+        val = load<T>(data_ + offset);
+        offset += sizeof(val);
+        return true;
+    }
+
+    /**
+     * @brief unpack Extracts a boolen from a single byte
+     * @param val Destination of unpack operation.
+     * @return True on successful unpack
+     */
+    bool unpack(bool& val) const {
+        if(unpacking_remaining() < 1) return false;
+        val = data_[offset++];
+        return true;
+    }
+
+    /**
+     * @brief Extracts floating point numbers from the view. Consumes a number
+     * of bytes matching sizeof(T). Fails if not enough bytes are available.
+     * @tparam T Underlying data type to be extracted. Must be a floating point
+     * type.
+     * @param val Destination of unpack operation.
+     * @return True on successful unpack
+     */
+    template <typename T,
+              typename std::enable_if<std::is_floating_point<T>::value,
+                                      T>::type* = nullptr>
+    bool unpack(T& val) const {
+        if(unpacking_remaining() < sizeof(val)) return false;
+        val = load<T>(data_ + offset);
+        offset += sizeof(val);
+        return true;
+    }
+
+    /**
+     * @brief Extracts an array of little endian integer or floating point
+     * numbers from the view. Consumes count*sizeof(T) bytes, which are copied
+     * in one go on little endian hosts. Fails without consuming any data if
+     * not enough bytes are available.
+     * @tparam T Underlying data type to be extracted. Must be an arithmetic
+     * type.
+     * @param vals Pointer to the first destination element
+     * @param count Number of elements to extract
+     * @return True on successful unpack
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value,
+                                                  T>::type* = nullptr>
+    bool unpack(T* vals, const std::size_t count) const {
+        if(count > unpacking_remaining() / sizeof(T)) return false;
+        load(vals, data_ + offset, count);
+        offset += count * sizeof(T);
+        return true;
+    }
+
+    /**
+     * @brief Extracts a fixed size array of little endian numbers from the
+     * view. Fails without consuming any data if not enough bytes are
+     * available.
+     * @param vals Destination of unpack operation
+     * @return True on successful unpack
+     */
+    template <typename T, std::size_t N,
+              typename std::enable_if<std::is_arithmetic<T>::value,
+                                      T>::type* = nullptr>
+    bool unpack(std::array<T, N>& vals) const {
+        return unpack(vals.data(), N);
+    }
+
+    /**
+     * @brief Extracts little endian numbers from the view and stores them in
+     * a std::vector. Consumes all remaining complete elements unless
+     * instructed otherwise.
+     * @param vals Destination of unpack operation
+     * @param count Number of elements to extract. Optional, if unset, all
+     * remaining complete elements will be extracted.
+     * @return True on successful unpack
+     */
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                                                      !std::is_same<T, uint8_t>::value,
+                                                  T>::type* = nullptr>
+    bool unpack(std::vector<T>& vals,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        if(count == std::numeric_limits<size_t>::max())
+            count = unpacking_remaining() / sizeof(T);
+        if(count > unpacking_remaining() / sizeof(T)) return false;
+        vals.resize(count);
+        return unpack(vals.data(), count);
+    }
+
+    /**
+     * @brief Extracts data from the view and stores it in a std::string.
+     * Consumes all remaining data unless instructed otherwise.
+     * @param val Destination of unpack operation.
+     * @param count Max number of bytes to extract. Optional, if unset, all
+     * remaining bytes will be consumed.
+     * @return True on successful unpack
+     */
+    bool unpack(std::string& val,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        if(count == std::numeric_limits<size_t>::max())
+            count = unpacking_remaining();
+        if(count > unpacking_remaining()) return false;
+        val.assign(reinterpret_cast<const char*>(data_ + offset), count);
+        offset += count;
+        return true;
+    }
+
+    /**
+     * @brief Extracts data from the view and stores it in a container of bytes
+     * (e.g. a ByteVector). Consumes all remaining data unless instructed
+     * otherwise.
+     * @param val Destination of unpack operation.
+     * @param count Max number of bytes to extract. Optional, if unset, all
+     * remaining bytes will be consumed.
+     * @return True on successful unpack
+     */
+    template <class C, typename std::enable_if<is_byte_buffer<C>::value,
+                                               C>::type* = nullptr>
+    bool unpack(C& val,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        if(count == std::numeric_limits<size_t>::max())
+            count = unpacking_remaining();
+        if(count > unpacking_remaining()) return false;
+        val.assign(data_ + offset, data_ + offset + count);
+        offset += count;
+        return true;
+    }
+
+    /**
+     * @brief Extracts a sub-range of the view without copying the data.
+     * Consumes all remaining data unless instructed otherwise.
+     * @param val Destination of unpack operation.
+     * @param count Max number of bytes to extract. Optional, if unset, all
+     * remaining bytes will be consumed.
+     * @return True on successful unpack
+     */
+    bool unpack(ByteView& val,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        if(count == std::numeric_limits<size_t>::max())
+            count = unpacking_remaining();
+        if(count > unpacking_remaining()) return false;
+        val = ByteView(data_ + offset, count);
+        offset += count;
+        return true;
+    }
+
+    /**
+     * @brief Unpacks scaled value types (e.g. scaled int to floating point) as
+     * val = (packed_val/scale)-offset
+     * @tparam encoding_T data type used to store the scaled value (usually an
+     * integral type)
+     * @tparam T1 type of output value (usually a floating point type)
+     * @tparam T2 type of scale and offset coefficients
+     * @param val Destination of unpack operation
+     * @param scale Value of scaling to apply to the offset value
+     * @param offset Value of offset to apply to the input value (optional,
+     * defaults to 0)
+     * @return True if successful
+     */
+    template <typename encoding_T, typename T1, typename T2,
+              typename std::enable_if<std::is_arithmetic<T1>::value,
+                                      T1>::type* = nullptr,
+              typename std::enable_if<std::is_arithmetic<T2>::value,
+                                      T2>::type* = nullptr>
+    bool unpack(T1& val, T2 scale, T2 offset = 0) const {
+        using cast_type = std::common_type_t<T1, T2>;
+
+        bool rc        = true;
+        encoding_T tmp = 0;
+        rc &= unpack(tmp);
+        val = static_cast<T1>(static_cast<cast_type>(tmp) /
+                                  static_cast<cast_type>(scale) -
+                              static_cast<cast_type>(offset));
+        return rc;
+    }
+
+    /**
+     * @brief unpack Unpacks an an object which inherits from type Packable
+     * @param val Reference to object to be unpacked
+     * @return True if successful
+     */
+    template <typename T,
+              typename std::enable_if<std::is_base_of<Packable, T>::value,
+                                      T>::type* = nullptr>
+    bool unpack(T& obj) const {
+        return obj.unpack_from(*this);
+    }
+
+    /**
+     * @brief Unpacks Value types other than string and byte container
+     * specializations
+     * @tparam T Type of the Value<T> being packed. May be automatically deduced
+     * from arguments
+     * @param val The destination of the unpack operation
+     * @return  true on success
+     */
+    template <class T,
+              typename std::enable_if<!is_byte_buffer<T>::value,
+                                      T>::type* = nullptr>
+    bool unpack(Value<T>& val) const {
+        return val.set() = unpack(val());
+    }
+
+    /**
+     * @brief Extracts data from the view and stores it in a
+     * Value<std::string>. Consumes all remaining data unless instructed
+     * otherwise.
+     * @param val Destination of unpack operation.
+     * @param count Max number of bytes to extract. Optional, if unset, all
+     * remaining bytes will be consumed.
+     * @return True on successful unpack
+     */
+    bool unpack(Value<std::string>& val,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        return val.set() = unpack(val(), count);
+    }
+
+    /**
+     * @brief Extracts data from the view and stores it in a Value of a byte
+     * container type (e.g. Value<ByteVector>). Consumes all remaining data
+     * unless instructed otherwise.
+     * @param val Destination of unpack operation.
+     * @param count Max number of bytes to extract. Optional, if unset, all
+     * remaining bytes will be consumed.
+     * @return True on successful unpack
+     */
+    template <class T,
+              typename std::enable_if<is_byte_buffer<T>::value,
+                                      T>::type* = nullptr>
+    bool unpack(Value<T>& val,
+                size_t count = std::numeric_limits<size_t>::max()) const {
+        return val.set() = unpack(val(), count);
+    }
+
+    /**
+     * @brief Unpacks scaled Value types (e.g. scaled int to floating point) as
+     * val = (packed_val/scale)-offset
+     * @tparam encoding_T data type used to store the scaled Value (usually an
+     * integral type)
+     * @tparam T1 type of output Value (usually a floating point type)
+     * @tparam T2 type of scale and offset coefficients (default: float)
+     * @param val Destination of unpack operation
+     * @param scale Value of scaling to apply to the offset value
+     * @param offset Value of offset to apply to the input value (optional,
+     * defaults to 0)
+     * @return True if successful
+     */
+    template <typename encoding_T, typename T1, typename T2 = float,
+              typename std::enable_if<std::is_arithmetic<T1>::value,
+                                      T1>::type* = nullptr,
+              typename std::enable_if<std::is_arithmetic<T2>::value,
+                                      T2>::type* = nullptr>
+    bool unpack(Value<T1>& val, T2 scale = 1, T2 offset = 0) const {
+        return val.set() = unpack<encoding_T>(val(), scale, offset);
+    }
+
+    /**
+     * @brief Unpacks a field stored next to a ValueMask
+     * @param val Reference to the destination field and its presence flag
+     * @return True on successful unpack
+     */
+    template <class T, class Word>
+    bool unpack(const ValueRef<T, Word>& val) const {
+        return val.set() = unpack(val());
+    }
+
+    /**
+     * @brief Unpacks scaled fields stored next to a ValueMask as
+     * val = (packed_val/scale)-offset
+     * @tparam encoding_T data type used to store the scaled value (usually an
+     * integral type)
+     * @param val Reference to the destination field and its presence flag
+     * @param scale Value of scaling to apply to the offset value
+     * @param offset Value of offset to apply to the input value (optional,
+     * defaults to 0)
+     * @return True if successful
+     */
+    template <typename encoding_T, typename T1, class Word, typename T2 = float,
+              typename std::enable_if<std::is_arithmetic<T1>::value,
+                                      T1>::type* = nullptr,
+              typename std::enable_if<std::is_arithmetic<T2>::value,
+                                      T2>::type* = nullptr>
+    bool unpack(const ValueRef<T1, Word>& val, T2 scale = 1,
+                T2 offset = 0) const {
+        return val.set() = unpack<encoding_T>(val(), scale, offset);
+    }
+
+    /**
+     * @brief Gives the number of bytes which have already been consumed by
+     * unpack operations.
+     * @returns Number of bytes already consumed
+     */
+    std::size_t unpacking_offset() const { return offset; }
+
+    /**
+     * @brief Gives an iterator to the next element ready for unpacking
+     * @returns iterator to the next byte for unpacking
+     */
+    const uint8_t* unpacking_iterator() const { return data_ + offset; }
+
+    /**
+     * @brief Manually consumes data, thus skipping the values.
+     * @param count Number of bytes to consume
+     * @returns True if successful
+     * @returns False if there were not enough bytes to satisfy the request
+     */
+    bool consume(std::size_t count) const {
+        if(count > unpacking_remaining()) {
+            return false;
+        }
+        offset += count;
+        return true;
+    }
+
+    /**
+     * @brief Returns the number of bytes still avialable for unpacking
+     * @returns Number of bytes remaining
+     */
+    std::size_t unpacking_remaining() const { return size_ - offset; }
+
+    /**
+     * @brief Reads a little endian number from unaligned memory
+     * @tparam T Arithmetic type to be read
+     * @param src Pointer to the first byte
+     * @returns Value in host byte order
+     */
+    template <typename T> static T load(const uint8_t* src) {
+        T val;
+        load(&val, src, 1);
+        return val;
+    }
+
+    /**
+     * @brief Reads an array of little endian numbers from unaligned memory
+     * @tparam T Arithmetic type to be read
+     * @param dst Pointer to the first destination element
+     * @param src Pointer to the first byte
+     * @param count Number of elements
+     */
+    template <typename T>
+    static void load(T* dst, const uint8_t* src, const std::size_t count) {
+        if(count == 0) return;
+        if(host_little_endian || sizeof(T) == 1) {
+            std::memcpy(dst, src, count * sizeof(T));
+            return;
+        }
+        for(std::size_t i(0); i < count; ++i) {
+            uint8_t tmp[sizeof(T)];
+            for(std::size_t b(0); b < sizeof(T); ++b) {
+                tmp[b] = src[i * sizeof(T) + sizeof(T) - 1 - b];
+            }
+            std::memcpy(dst + i, tmp, sizeof(T));
+        }
+    }
+
+    /**
+     * @brief Writes an array of numbers as little endian bytes into unaligned
+     * memory
+     * @tparam T Arithmetic type to be written
+     * @param dst Pointer to the first destination byte
+     * @param src Pointer to the first element
+     * @param count Number of elements
+     */
+    template <typename T>
+    static void store(uint8_t* dst, const T* src, const std::size_t count) {
+        if(count == 0) return;
+        if(host_little_endian || sizeof(T) == 1) {
+            std::memcpy(dst, src, count * sizeof(T));
+            return;
+        }
+        for(std::size_t i(0); i < count; ++i) {
+            uint8_t tmp[sizeof(T)];
+            std::memcpy(tmp, src + i, sizeof(T));
+            for(std::size_t b(0); b < sizeof(T); ++b) {
+                dst[i * sizeof(T) + b] = tmp[sizeof(T) - 1 - b];
+            }
+        }
+    }
+
+protected:
+    const uint8_t* data_;
+    std::size_t size_;
+    mutable std::size_t offset;
+};
+
+}  // namespace msp
+
+#endif
@@ -3,15 +3,24 @@
 
 #include <pthread.h>
 #include <asio.hpp>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 #include "ByteVector.hpp"
 #include "FirmwareVariants.hpp"
+#include "Framing.hpp"
 #include "Message.hpp"
+#include "PushStream.hpp"
+#include "RttEstimator.hpp"
+#include "SerialTuning.hpp"
+#include "ThreadPolicy.hpp"
 #include "Subscription.hpp"
 
 namespace msp {
@@ -33,6 +42,84 @@ struct ReceivedMessage {
     MessageStatus status;
 };
 
+/**
+ * @brief Counters of a supervised connection
+ */
+struct ConnectionStats {
+    uint64_t link_losses = 0;  ///<! number of detected link losses
+    uint64_t reconnects  = 0;  ///<! number of restored connections
+    double last_latency  = 0;  ///<! seconds from the last loss to its recovery
+    double max_latency   = 0;  ///<! longest recovery in seconds
+};
+
+/**
+ * @brief Counters of the frame parser
+ */
+struct FramingStats {
+    uint64_t frames          = 0;  ///<! frames passed to the consumers
+    uint64_t crc_errors      = 0;  ///<! frames with a wrong checksum
+    uint64_t resyncs         = 0;  ///<! number of times data was skipped
+    uint64_t bytes_discarded = 0;  ///<! bytes skipped while resynchronising
+};
+
+/**
+ * @brief Receives the raw bytes of a passthrough link. The data points into
+ * the receive buffer of the client and is only valid during the call.
+ */
+typedef std::function<void(const uint8_t* data, std::size_t size)>
+    PassthroughHandler;
+
+/**
+ * @brief Observes the payload of every valid frame which is received. The
+ * payload points into the receive buffer of the client and is only valid
+ * during the call.
+ */
+typedef std::function<void(const msp::ID id, const ByteView& payload)>
+    FrameTap;
+
+/**
+ * @brief Settings of the baudrate probe
+ */
+struct BaudrateProbe {
+    // candidate rates, the fastest stable one is chosen
+    std::vector<size_t> rates = {
+        921600, 460800, 230400, 115200, 57600, 38400, 19200, 9600};
+    // time to wait for a single ping (in seconds)
+    double timeout = 0.1;
+    // number of pings in the burst test
+    size_t burst = 20;
+    // largest fraction of lost or corrupt responses in the burst test
+    double max_error_rate = 0.05;
+};
+
+/**
+ * @brief Scheduling and placement of the threads of a client. Callback
+ * executors are configured by their constructor, see ThreadPool.
+ */
+struct ThreadConfig {
+    // receiving thread (msp-io)
+    ThreadPolicy io;
+    // timer threads of the subscriptions (msp-timer)
+    ThreadPolicy scheduler;
+    // reconnecting thread (msp-supervisor)
+    ThreadPolicy supervisor;
+    // lock all pages of the process into memory (mlockall)
+    bool lock_memory = false;
+};
+
+/**
+ * @brief Settings for a steady state without heap allocations and page
+ * faults in the receiving thread and the request timers
+ */
+struct RealtimeProfile {
+    // largest frame payload, the frame buffers are preallocated for it
+    std::size_t max_payload = 1024;
+    // stack of the receiving thread which is touched in advance (in bytes)
+    std::size_t prefault_stack = 64 * 1024;
+    // lock all pages of the process into memory (mlockall)
+    bool lock_memory = true;
+};
+
 class Client {
 public:
     /**
@@ -56,15 +143,19 @@ public:
     void setLoggingLevel(const LoggingLevel& level);
 
     /**
-     * @brief Change the device path on the next connect
-     * @param ver Version of MSP to use
+     * @brief Set the highest MSP version understood by the flight controller.
+     * The framing is chosen per message: IDs below 255 always use the shorter
+     * MSPv1 frame (with a jumbo header for payloads of 255 bytes or more).
+     * MSPv2-only IDs are sent as native MSPv2 frames for version 2, and
+     * tunnelled in MSPv1 MSP_V2_FRAME frames for version 1.
+     * @param ver Version of MSP to use (1 or 2)
      * @return True if successful
      */
     bool setVersion(const int& ver);
 
     /**
-     * @brief Query the cached device path
-     * @return Cached path to device
+     * @brief Query the highest MSP version used for sending
+     * @return MSP version
      */
     int getVersion() const;
 
@@ -92,31 +183,259 @@ public:
      */
     bool stop();
 
+    /**
+     * @brief Start communications with a flight controller at the fastest
+     * stable baudrate. The candidate rates are tried from the fastest to the
+     * slowest with MSP_API_VERSION pings. A rate which answers is accepted if
+     * a short burst of pings stays below the error threshold.
+     * @param device Path to the serial device
+     * @param probe Candidate rates and thresholds
+     * @return Selected baudrate, 0 if no rate worked and the client is stopped
+     */
+    size_t probeBaudrate(const std::string& device,
+                         const BaudrateProbe& probe = BaudrateProbe());
+
+    /**
+     * @brief Change the baudrate of the open serial device. The new rate is
+     * also used for reconnecting.
+     * @param baudrate New baudrate
+     * @return True on success
+     */
+    bool setBaudrate(const size_t baudrate);
+
+    /**
+     * @brief Query the baudrate of the serial device
+     * @return Baudrate
+     */
+    size_t getBaudrate() const;
+
+    /**
+     * @brief Apply low latency settings whenever the serial device is opened
+     * (Linux only), e.g. ASYNC_LOW_LATENCY, which removes up to 16 ms of
+     * buffering of USB-serial adapters. Takes effect on the next start().
+     * @param tuning Settings to apply
+     */
+    void setSerialTuning(const SerialTuning& tuning);
+
+    /**
+     * @brief Query the effective settings of the open serial device
+     * @return Settings of the device
+     */
+    SerialStatus getSerialStatus();
+
     /**
      * @brief Query the system to see if a connection is active
      * @return true on success
      */
     bool isConnected() const;
 
+    /**
+     * @brief Supervise the connection. A read error (e.g. an unplugged
+     * USB-serial adapter) closes the port and fails all pending requests. With
+     * automatic reconnection, the device is then reopened periodically with
+     * the settings passed to start(). Once it is back, the reconnect callback
+     * runs and the subscriptions are resumed. Must be called before start().
+     * @param enable True to reconnect automatically
+     * @param period Interval between two attempts to reopen the device (in
+     * seconds)
+     */
+    void setAutoReconnect(const bool enable, const double& period = 0.1);
+
+    /**
+     * @brief Set a handshake which is run after the device was reopened. It
+     * is called in the supervisor thread and may send requests.
+     * @param callback Function returning true if the connection is usable,
+     * on false the device is reopened again
+     */
+    void setReconnectCallback(const std::function<bool()>& callback);
+
+    /**
+     * @brief Query the counters of the supervised connection
+     * @return Copy of the counters
+     */
+    ConnectionStats getConnectionStats() const;
+
+    /**
+     * @brief Sets the scheduling and placement of all threads of the client.
+     * Running threads are updated immediately, threads which are started
+     * later apply the policy themselves.
+     * @param config Policies of the threads
+     * @return True if all policies could be applied
+     */
+    bool setThreadConfig(const ThreadConfig& config);
+
+    /**
+     * @brief Query the scheduling and placement of the threads
+     * @return Copy of the configuration
+     */
+    ThreadConfig getThreadConfig() const;
+
+    /**
+     * @brief Prepare the client for hard real time use. When the read thread
+     * starts, the frame buffers are preallocated and prefaulted, the stack of
+     * the thread is prefaulted and the memory is locked. Afterwards, frames
+     * up to max_payload bytes are sent and received without heap allocations
+     * as long as subscriptions, push streams and the cache are not modified
+     * and listeners run inline. Blocking requests still allocate. Must be
+     * called before start().
+     * @param profile Buffer sizes and memory settings
+     */
+    void setRealtimeProfile(const RealtimeProfile& profile);
+
+    /**
+     * @brief Query the real time profile
+     * @return Copy of the profile
+     */
+    RealtimeProfile getRealtimeProfile() const;
+
     /**
      * @brief Send a message to the connected flight controller. If
      * the message sends data to the flight controller, it will be packed into
      * a buffer and sent. The method will block (optionally for a finite amount
      * of time) until a matching response is received from the flight
      * controller. If the response includes data, it will be unpacked back into
-     * the same Message object.
+     * the same Message object. Concurrent requests without payload for the
+     * same read ID (see markRead()) share a single request on the wire, and
+     * may be answered from the response cache (see setCacheTtl()). Any other
+     * request clears the response cache.
      * @param message Reference to a Message-derived object to be sent/recieved.
      * @param timeout Maximum amount of time to block waiting for a response.
-     * A value of 0 (default) means wait forever.
+     * A value of 0 (default) means wait forever, or until the retries of the
+     * RetryPolicy are exhausted.
+     * @param use_cache False to send the request even if the response cache
+     * holds a valid response
+     */
+    bool sendMessage(msp::Message& message, const double& timeout = 0,
+                     const bool use_cache = true);
+
+    /**
+     * @brief Send several messages back to back to the connected flight
+     * controller without waiting for the individual responses in between. The
+     * method will block (optionally for a finite amount of time) until a
+     * response has been received for every message. Responses are unpacked
+     * into the matching Message objects in the order in which they arrive.
+     * @param messages Messages to be sent/received. Every message ID must only
+     * be used once per call, a repeated ID fails unless both messages are
+     * reads without payload. A message whose ID has a pending request of another caller,
+     * which it cannot share, fails at once instead of waiting for it.
+     * @param timeout Maximum amount of time to block waiting for all
+     * responses. A value of 0 (default) means wait forever, or until the
+     * retries of the RetryPolicy are exhausted.
+     * @return Vector with one entry per message, which is true if a valid
+     * response was received and decoded
+     */
+    std::vector<bool> sendMessages(const std::vector<msp::Message*>& messages,
+                                   const double& timeout = 0);
+
+    /**
+     * @brief Mark a message ID as a read, which does not change the state of
+     * the flight controller. Only requests without payload for a read ID are
+     * shared by concurrent callers and answered from the response cache. Any
+     * other request, e.g. MSP_EEPROM_WRITE or MSP_REBOOT without payload, is
+     * sent on its own and clears the cache.
+     * @param id Message ID
+     * @param read False to treat the ID as a write again, which disables its
+     * cache as well
+     */
+    void markRead(const msp::ID& id, const bool read = true);
+
+    /**
+     * @brief Query if a message ID is marked as a read
+     * @param id Message ID
+     * @return True if requests without payload for the ID may be shared
+     */
+    bool isRead(const msp::ID& id) const;
+
+    /**
+     * @brief Cache responses to requests without payload for a message ID,
+     * which marks the ID as a read (see markRead()). Requests for the ID are
+     * answered locally while the cached response is younger than the TTL.
+     * Sending any other message clears the cache, since it may change the
+     * cached values, and so does its response, which may follow responses to
+     * requests sent before it. Responses which arrive while such a message is
+     * pending are not cached. A lost link clears the cache as well.
+     * @param id Message ID, e.g. of near-static messages like BoardInfo
+     * @param ttl Time to live in seconds, 0 disables caching for the ID
+     */
+    void setCacheTtl(const msp::ID& id, const double& ttl);
+
+    /**
+     * @brief Drop all cached responses, the TTL settings are kept
+     */
+    void clearCache();
+
+    /**
+     * @brief Set the timeouts and retransmissions of requests. Unanswered
+     * requests are resent after the timeout of an attempt, which is derived
+     * from the measured round trip time if the policy is adaptive. The default
+     * policy sends every request once and waits for the timeout given to
+     * sendMessage().
+     * @param policy Retry policy
+     */
+    void setRetryPolicy(const RetryPolicy& policy);
+
+    /**
+     * @brief Query the retry policy
+     * @return Retry policy
+     */
+    RetryPolicy getRetryPolicy() const;
+
+    /**
+     * @brief Query the round trip time estimate of the link. Round trip times
+     * are measured for every request which is answered without
+     * retransmission.
+     * @return Copy of the estimator
      */
-    bool sendMessage(msp::Message& message, const double& timeout = 0);
+    RttEstimator getRttEstimate() const;
 
     /**
-     * @brief Send a message, but do not wait for any response
+     * @brief Computes the timeout of the first attempt of a request
+     * @param id Message ID
+     * @param size Size of the request payload
+     * @return Timeout in seconds
+     */
+    double getRequestTimeout(const msp::ID& id,
+                             const std::size_t size = 0) const;
+
+    /**
+     * @brief Set the largest payload which is accepted in a received frame.
+     * Frames announcing a larger payload are treated as corrupt, so that a
+     * damaged size byte cannot swallow the following frames.
+     * @param size Payload size in bytes (default 4096)
+     */
+    void setMaxPayloadSize(const std::size_t size);
+
+    /**
+     * @brief Set the largest payload which is accepted in a received frame
+     * with the given message ID, overriding the default
+     * @param id Message ID
+     * @param size Payload size in bytes
+     */
+    void setMaxPayloadSize(const msp::ID& id, const std::size_t size);
+
+    /**
+     * @brief Query the counters of the frame parser
+     * @return Snapshot of the counters
+     */
+    FramingStats getFramingStats() const;
+
+    /**
+     * @brief Send a message, but do not wait for any response. A message
+     * which is not a read without payload clears the response cache.
      * @param message Reference to a Message-derived object to be sent
      */
     bool sendMessageNoWait(const msp::Message& message);
 
+    /**
+     * @brief Send several payloads of the same message ID, but do not wait for
+     * any response. The frames are packed back to back into a single write.
+     * @param id Message ID
+     * @param payloads Payloads of the messages
+     * @return True if all frames were written
+     */
+    bool sendBatchNoWait(const msp::ID id,
+                         const std::vector<ByteVector>& payloads);
+
     /**
      * @brief Register callback function that is called when a message of
      * matching ID is received
@@ -124,56 +443,84 @@ public:
      * @param context Object containing callback method
      * @param tp Period of timer that will send subscribed requests (in
      * seconds).
+     * @param executor Executor running the callback, by default it is called
+     * in the receiving thread
      * @return pointer to subscription that is added to internal list
      */
     template <typename T, typename C,
               class = typename std::enable_if<
                   std::is_base_of<msp::Message, T>::value>::type>
-    std::shared_ptr<SubscriptionBase> subscribe(void (C::*callback)(const T&),
-                                                C* context, const double& tp) {
-        return subscribe<T>(std::bind(callback, context, std::placeholders::_1),
-                            tp);
+    std::shared_ptr<SubscriptionBase> subscribe(
+        void (C::*callback)(const T&), C* context, const double& tp,
+        const std::shared_ptr<Executor>& executor = nullptr) {
+        return subscribe<T>(
+            std::bind(callback, context, std::placeholders::_1), tp, executor);
     }
 
     /**
      * @brief Register callback function that is called when a
-     * message of matching ID is received. Replaces the previous callback of the
-     * same ID.
+     * message of matching ID is received. The callback is added as a new
+     * listener to an existing subscription of the same message type, every
+     * received message is decoded once for all listeners.
      * @param recv_callback Function to be called upon receipt of message
      * @param tp Period of timer that will send subscribed requests (in
-     * seconds).
+     * seconds). It also limits the rate of this callback. The requests are
+     * sent with the smallest period of all listeners.
+     * @param executor Executor running the callback. By default (nullptr) it is
+     * called in the receiving thread. A ThreadPool runs the callbacks of
+     * different subscriptions in parallel, while the callbacks of one
+     * subscription stay in order. A Strand serializes all callbacks sharing it.
      * @return pointer to subscription that is added to internal list
      */
     template <typename T, class = typename std::enable_if<
                               std::is_base_of<msp::Message, T>::value>::type>
     std::shared_ptr<SubscriptionBase> subscribe(
-        const std::function<void(const T&)>& recv_callback, const double& tp) {
-        // validate the period
-        if(!(tp >= 0.0)) throw std::runtime_error("Period must be positive!");
-
-        // get the id of the message in question
-        const msp::ID id = T(fw_variant).id();
-        if(log_level_ >= INFO)
-            std::cout << "SUBSCRIBING TO " << id << std::endl;
-
-        // generate the callback for sending messages
-        std::function<bool(const Message&)> send_callback =
-            std::bind(&Client::sendMessageNoWait, this, std::placeholders::_1);
+        const std::function<void(const T&)>& recv_callback, const double& tp,
+        const std::shared_ptr<Executor>& executor = nullptr) {
+        return addSubscriber<T>(recv_callback, tp, executor).first;
+    }
 
-        // create a shared pointer to a new Subscription and set all properties
-        auto subscription = std::make_shared<Subscription<T>>(
-            recv_callback, send_callback, std::make_unique<T>(fw_variant), tp);
+    /**
+     * @brief Register callback function that is called when a message of
+     * matching ID is received, like subscribe()
+     * @param recv_callback Function to be called upon receipt of message
+     * @param tp Minimum period between two callbacks (in seconds)
+     * @param executor Executor running the callback, see subscribe()
+     * @return ID of the listener, which can be passed to removeListener()
+     */
+    template <typename T, class = typename std::enable_if<
+                              std::is_base_of<msp::Message, T>::value>::type>
+    ListenerId addListener(
+        const std::function<void(const T&)>& recv_callback, const double& tp,
+        const std::shared_ptr<Executor>& executor = nullptr) {
+        return addSubscriber<T>(recv_callback, tp, executor).second;
+    }
 
-        // gonna modify the subscription map, so lock the mutex
-        std::lock_guard<std::mutex> lock(mutex_subscriptions);
+    /**
+     * @brief Remove a single listener of a subscription. The subscription is
+     * removed together with its last listener.
+     * @param id Message ID
+     * @param listener ID of the listener
+     * @return True if the listener was removed
+     */
+    bool removeListener(const msp::ID& id, const ListenerId& listener);
 
-        // delete old subscription
-        if(subscriptions.count(id)) subscriptions.erase(id);
+    /**
+     * @brief Change the callback period of a single listener
+     * @param id Message ID
+     * @param listener ID of the listener
+     * @param tp Minimum period between two callbacks (in seconds)
+     * @return True if the listener exists
+     */
+    bool setListenerPeriod(const msp::ID& id, const ListenerId& listener,
+                           const double& tp);
 
-        // move the new subscription into the subscription map
-        subscriptions.emplace(id, std::move(subscription));
-        return subscriptions[id];
-    }
+    /**
+     * @brief Remove a subscription with all its listeners
+     * @param id Message ID
+     * @return True if there was a subscription
+     */
+    bool unsubscribe(const msp::ID& id);
 
     /**
      * @brief Check if message ID already has a subscription
@@ -193,6 +540,98 @@ public:
         return subscriptions.at(id);
     }
 
+    /**
+     * @brief Open a ring buffer for unsolicited push telemetry (e.g.
+     * msp::msg::BtflPush480). Matching frames are decoded directly into the
+     * ring by the receiving thread and bypass pending requests and
+     * subscriptions. Replaces a previous stream of the same ID.
+     * @param capacity Minimum number of buffered samples
+     * @return Pointer to the stream, samples are read with PushStream::read
+     */
+    template <typename T, class = typename std::enable_if<
+                              std::is_base_of<msp::Message, T>::value>::type>
+    std::shared_ptr<PushStream<typename T::sample_type>> openPushStream(
+        const std::size_t capacity = 1024) {
+        const msp::ID id = T(fw_variant).id();
+        auto stream =
+            std::make_shared<PushStream<typename T::sample_type>>(capacity);
+        std::lock_guard<std::mutex> lock(mutex_push_streams);
+        push_streams[id]  = stream;
+        push_stream_count = push_streams.size();
+        return stream;
+    }
+
+    /**
+     * @brief Stop routing frames into a push stream. Frames of this ID are
+     * dispatched to subscriptions again.
+     * @param id Message ID
+     * @return True if a stream was closed
+     */
+    bool closePushStream(const msp::ID& id);
+
+    /**
+     * @brief Check if message ID is routed to a push stream
+     * @param id Message ID
+     * @return True if there is a matching push stream
+     */
+    bool hasPushStream(const msp::ID& id);
+
+    /**
+     * @brief Set a function which is called in the receiving thread with
+     * every valid frame before it is dispatched, including push telemetry
+     * and frames without a pending request or subscription
+     * @param tap Function observing the frames, an empty function removes
+     * the previous one
+     */
+    void setFrameTap(const FrameTap& tap);
+
+    /**
+     * @brief Send the request which makes the flight controller enter a
+     * passthrough mode (e.g. msp::msg::Set4WayIF for the 4-way ESC interface
+     * or a serial passthrough), then switch to passthrough, see
+     * startPassthrough()
+     * @param request Request to enter the passthrough mode
+     * @param handler Receives the raw bytes from the link
+     * @param timeout Maximum time to wait for the response (in seconds)
+     * @return True if the request was answered and the client switched
+     */
+    bool enterPassthrough(msp::Message& request,
+                          const PassthroughHandler& handler,
+                          const double& timeout = 1.0);
+
+    /**
+     * @brief Turn the connection into a raw full-duplex byte pipe. The
+     * receiving thread stops parsing MSP frames and hands every received
+     * chunk to the handler without copying it, including data which was
+     * received but not parsed yet. The subscriptions are paused and MSP
+     * requests fail until stopPassthrough() is called.
+     * @param handler Receives the raw bytes from the link, it is called in
+     * the receiving thread
+     * @return True if the client switched to passthrough
+     */
+    bool startPassthrough(const PassthroughHandler& handler);
+
+    /**
+     * @brief Return to MSP, e.g. after the 4-way interface was left. A serial
+     * passthrough usually only ends with a reboot of the flight controller.
+     * @return True if the client was in passthrough
+     */
+    bool stopPassthrough();
+
+    /**
+     * @brief Check if the connection is a raw byte pipe
+     * @return True in passthrough
+     */
+    bool isPassthrough() const { return passthrough_; }
+
+    /**
+     * @brief Write raw bytes to the link in passthrough, without framing
+     * @param data Bytes to write
+     * @param size Number of bytes
+     * @return True if all bytes were written
+     */
+    bool writeRaw(const uint8_t* data, const std::size_t size);
+
     /**
      * @brief Main entry point for processing received data. It
      * is called directly by the ASIO library, and as such it much match the
@@ -225,12 +664,211 @@ public:
     }
 
     /**
-     * @brief Updates the receiver thread to Realtime priority
+     * @brief Updates the receiver thread to Realtime priority (SCHED_FIFO, 80)
      * @return True on success
      */
     bool setRealtimePriority();
 
 protected:
+    /**
+     * @brief Schedule the next read of the receiving thread, either of a
+     * MSP frame or of raw bytes in passthrough
+     */
+    void scheduleRead();
+
+    /**
+     * @brief Hands the received raw bytes to the passthrough handler
+     * @param ec ASIO error code
+     * @param bytes_transferred Number of bytes received
+     */
+    void processRaw(const asio::error_code& ec,
+                    const std::size_t bytes_transferred);
+
+    /**
+     * @brief Cancel the pending read in the receiving thread, so that the
+     * next read is scheduled in the new mode
+     */
+    void switchReadMode();
+
+    /**
+     * @brief Request on the wire, which is answered by the next received
+     * message with the same ID
+     */
+    struct PendingRequest {
+        // shared with all consumers, empty until received
+        std::shared_ptr<const ReceivedMessage> response;
+        // true if the request has no payload and can be shared
+        bool shared = false;
+        // true if the request could not be sent or was not answered
+        bool failed = false;
+        // size of the request payload
+        std::size_t size = 0;
+        // number of times the request was sent
+        std::size_t attempts = 0;
+        // time of the first attempt
+        std::chrono::steady_clock::time_point sent;
+        // time of the next retransmission, max() if none is scheduled
+        std::chrono::steady_clock::time_point deadline;
+        // number of callers waiting for the response
+        std::size_t waiters = 0;
+    };
+
+    /**
+     * @brief Response in the cache
+     */
+    struct CachedResponse {
+        double ttl = 0;
+        std::chrono::steady_clock::time_point stamp;
+        std::shared_ptr<const ReceivedMessage> response;
+    };
+
+    /**
+     * @brief Registers a request for a message ID, or joins a pending
+     * request without payload for the same ID. A request which cannot be
+     * joined waits until the pending request of the ID was answered, failed
+     * or was given up by all its callers, so that no caller loses its
+     * response.
+     * @param id Message ID
+     * @param shared True if the request has no payload
+     * @param size Size of the request payload
+     * @param end Time until which to wait for a pending request of the ID
+     * @param owner Set to true if the caller has to send the request
+     * @return Pending request, empty if the ID was still busy at the end
+     */
+    std::shared_ptr<PendingRequest> registerRequest(
+        const msp::ID& id, const bool shared, const std::size_t size,
+        const std::chrono::steady_clock::time_point& end, bool& owner);
+
+    /**
+     * @brief Removes a caller from a request. A request which failed is
+     * removed for all its callers, otherwise it stays registered until its
+     * last caller gave up, so that the others still receive the response.
+     * @param id Message ID
+     * @param request Pending request
+     * @param failed True if the request could not be sent or was not
+     * answered after all retries
+     */
+    void unregisterRequest(const msp::ID& id,
+                           const std::shared_ptr<PendingRequest>& request,
+                           const bool failed);
+
+    /**
+     * @brief Resends a pending request if its attempt timed out. Every caller
+     * waiting for the request may call this, the first one after the timeout
+     * sends the request again. If all retries are used, the request fails.
+     * @param id Message ID
+     * @param request Pending request
+     * @param data Request payload
+     * @return Time at which the request has to be checked again
+     */
+    std::chrono::steady_clock::time_point retransmit(
+        const msp::ID& id, const std::shared_ptr<PendingRequest>& request,
+        const ByteVector& data);
+
+    /**
+     * @brief Computes the timeout of an attempt of a request
+     * @param id Message ID
+     * @param size Size of the request payload
+     * @param attempt Number of the attempt, starting at 0
+     * @return Timeout in seconds, 0 if requests are not retransmitted
+     */
+    double attemptTimeout(const msp::ID& id, const std::size_t size,
+                          const std::size_t attempt) const;
+
+    /**
+     * @brief Adds a round trip time measurement, unless a message of the ID
+     * was sent without waiting (e.g. by a subscription) shortly before or
+     * after the request, whose response may be taken for the answer
+     * @param id Message ID
+     * @param size Size of the request payload
+     * @param response_size Size of the response payload
+     * @param sent Time at which the request was sent
+     */
+    void updateRtt(const msp::ID& id, const std::size_t size,
+                   const std::size_t response_size,
+                   const std::chrono::steady_clock::time_point& sent);
+
+    /**
+     * @brief Records that a message was sent without waiting for its response
+     * @param id Message ID
+     */
+    void noteUnmatchedSend(const msp::ID& id);
+
+    /**
+     * @brief Groups requests into classes of similar frame size
+     * @param bytes Size of the request and response payloads
+     * @return Index of the class
+     */
+    static std::size_t sizeClass(std::size_t bytes);
+
+    /**
+     * @brief Queries a cached response
+     * @param id Message ID
+     * @return Cached response, empty if there is none or it is outdated
+     */
+    std::shared_ptr<const ReceivedMessage> getCachedResponse(const msp::ID& id);
+
+    /**
+     * @brief Decodes a received response into a message
+     * @param message Message to be updated
+     * @param response Received response
+     * @return True if the response is valid and was decoded
+     */
+    static bool decodeResponse(msp::Message& message,
+                               const ReceivedMessage& response);
+
+    /**
+     * @brief Adds a listener to the subscription of a message type
+     * @param recv_callback Function to be called upon receipt of message
+     * @param tp Minimum period between two callbacks (in seconds)
+     * @param executor Executor running the callback
+     * @return Pair of the subscription and the ID of the new listener
+     */
+    template <typename T>
+    std::pair<std::shared_ptr<SubscriptionBase>, ListenerId> addSubscriber(
+        const std::function<void(const T&)>& recv_callback, const double& tp,
+        const std::shared_ptr<Executor>& executor) {
+        // validate the period
+        if(!(tp >= 0.0)) throw std::runtime_error("Period must be positive!");
+
+        // get the id of the message in question
+        const msp::ID id = T(fw_variant).id();
+        if(log_level_ >= INFO)
+            std::cout << "SUBSCRIBING TO " << id << std::endl;
+
+        // gonna modify the subscription map, so lock the mutex
+        std::lock_guard<std::mutex> lock(mutex_subscriptions);
+
+        // share the subscription with all listeners of the same type
+        const auto it = subscriptions.find(id);
+        if(it != subscriptions.end()) {
+            const auto existing =
+                std::dynamic_pointer_cast<Subscription<T>>(it->second);
+            if(existing) {
+                const ListenerId listener =
+                    existing->addListener(recv_callback, tp, executor);
+                return std::make_pair(it->second, listener);
+            }
+            // a different type decodes this ID, replace it
+            subscriptions.erase(it);
+        }
+
+        // generate the callback for sending messages
+        std::function<bool(const Message&)> send_callback =
+            std::bind(&Client::sendMessageNoWait, this, std::placeholders::_1);
+
+        // create a shared pointer to a new Subscription and set all properties
+        auto subscription = std::make_shared<Subscription<T>>(
+            send_callback, std::make_unique<T>(fw_variant));
+        subscription->setThreadPolicy(getThreadConfig().scheduler);
+        const ListenerId listener =
+            subscription->addListener(recv_callback, tp, executor);
+
+        // move the new subscription into the subscription map
+        subscriptions.emplace(id, std::move(subscription));
+        return std::make_pair(subscriptions[id], listener);
+    }
+
     /**
      * @brief Establish connection to serial device and start read thread
      * @return True on success
@@ -243,6 +881,13 @@ protected:
      */
     bool disconnectPort();
 
+    /**
+     * @brief Preallocates the frame buffers and prefaults the memory of the
+     * receiving thread according to the real time profile
+     * @return True if the memory could be locked
+     */
+    bool prepareRealtime();
+
     /**
      * @brief Starts the receiver thread that handles incomming messages
      * @return True on success
@@ -255,6 +900,36 @@ protected:
      */
     bool stopReadThread();
 
+    /**
+     * @brief Closes the port after a read error, fails all pending requests
+     * and wakes up the supervisor
+     * @param ec Error of the read operation
+     */
+    void linkLost(const asio::error_code& ec);
+
+    /**
+     * @brief Reopens the device with the settings of the last start()
+     * @return True if the device is open and the read thread is running
+     */
+    bool reopenPort();
+
+    /**
+     * @brief Starts the supervisor thread if automatic reconnection is enabled
+     * @return True on success
+     */
+    bool startSupervisor();
+
+    /**
+     * @brief Stops the supervisor thread
+     */
+    void stopSupervisor();
+
+    /**
+     * @brief Main loop of the supervisor thread, which restores lost
+     * connections
+     */
+    void supervise();
+
     /**
      * @brief Starts the receiver thread that handles incomming messages
      * @return True on success
@@ -273,6 +948,55 @@ protected:
      */
     uint8_t extractChar();
 
+    /**
+     * @brief Location of the next frame in the received data
+     */
+    struct FrameLocation {
+        // number of bytes in front of the frame, which are discarded
+        std::size_t skip = 0;
+        // size of the frame, if it is complete
+        std::size_t size = 0;
+        // true if the frame is complete and can be parsed
+        bool complete = false;
+    };
+
+    /**
+     * @brief Searches the next frame. A candidate frame which is incomplete or
+     * has a wrong checksum is skipped if a valid frame starts within its span,
+     * so that a corrupt size byte costs a single frame.
+     * @param data Received data
+     * @param size Number of received bytes
+     * @return Location of the frame
+     */
+    FrameLocation findFrame(const uint8_t* data, const std::size_t size) const;
+
+    /**
+     * @brief Searches the next complete frame with a correct checksum
+     * @param data Received data
+     * @param size Number of received bytes
+     * @param from Offset at which the search starts
+     * @return Location of the frame, which is not complete if none was found
+     */
+    FrameLocation findValidFrame(const uint8_t* data, const std::size_t size,
+                                 const std::size_t from) const;
+
+    /**
+     * @brief Checks the header, size and checksum of a candidate frame
+     * @param data Received data, starting with '$'
+     * @param size Number of bytes available
+     * @param frame_size Set to the size of the frame once the header is known
+     * @return Result of the check
+     */
+    FrameCheck checkFrame(const uint8_t* data, const std::size_t size,
+                          std::size_t& frame_size) const;
+
+    /**
+     * @brief Queries the largest payload accepted for a message ID
+     * @param id Message ID
+     * @return Payload size in bytes
+     */
+    std::size_t maxPayloadSize(const msp::ID& id) const;
+
     /**
      * @brief messageReady Method used by ASIO library to determine if a
      * full message is present in receiving buffer. It must match the function
@@ -285,23 +1009,73 @@ protected:
     /**
      * @brief processOneMessageV1 Iterates over characters in the ASIO buffer
      * to identify and unpack a MSPv1 encoded message
-     * @return ReceivedMessage data structure containing the results of
-     * unpacking
+     * @param msg ReceivedMessage data structure receiving the results of
+     * unpacking, the capacity of its payload is reused
      */
-    ReceivedMessage processOneMessageV1();
+    void processOneMessageV1(ReceivedMessage& msg);
 
     /**
      * @brief processOneMessageV2 Iterates over characters in the ASIO buffer
      * to identify and unpack a MSPv2 encoded message
-     * @return ReceivedMessage data structure containing the results of
-     * unpacking
+     * @param msg ReceivedMessage data structure receiving the results of
+     * unpacking, the capacity of its payload is reused
      */
-    ReceivedMessage processOneMessageV2();
+    void processOneMessageV2(ReceivedMessage& msg);
 
     /**
-     * @brief packMessageV1 Packs data ID and data payload into a MSPv1
-     * formatted buffer ready for sending to the serial device
+     * @brief dispatchMessage Hands a received message to waiting requests and
+     * subscriptions. The message is only copied if a request or the cache
+     * keeps it.
+     * @param msg Received message
+     */
+    void dispatchMessage(const ReceivedMessage& msg);
+
+    /**
+     * @brief unpackV2Frame Extracts the MSPv2 message tunnelled in the payload
+     * of a MSPv1 MSP_V2_FRAME message
+     * @param msg Received MSP_V2_FRAME message, replaced by the inner message
+     */
+    void unpackV2Frame(ReceivedMessage& msg) const;
+
+    /**
+     * @brief packMessage Packs data ID and data payload into the shortest
+     * frame supported by the flight controller for this ID
+     * @param id msp::ID of the message being packed
+     * @param data Optional binary payload to be packed into the outbound buffer
+     * @return ByteVector of full message ready for sending, empty if the
+     * payload is too large for any framing
+     */
+    ByteVector packMessage(const msp::ID id,
+                           const ByteVector& data = ByteVector(0)) const;
+
+    /**
+     * @brief packMessage Packs data ID and data payload into a buffer whose
+     * capacity is reused
+     * @param id msp::ID of the message being packed
+     * @param data Binary payload to be packed into the outbound buffer
+     * @param msg Destination of the full message, previous content is
+     * discarded
+     * @return False if the payload is too large for any framing
+     */
+    bool packMessage(const msp::ID id, const ByteVector& data,
+                     ByteVector& msg) const;
+
+    /**
+     * @brief appendMessage Appends the shortest frame supported by the flight
+     * controller for this ID to a buffer
      * @param id msp::ID of the message being packed
+     * @param data Binary payload to be packed into the outbound buffer
+     * @param msg Buffer receiving the frame
+     * @return False if the payload is too large for any framing
+     */
+    bool appendMessage(const msp::ID id, const ByteVector& data,
+                       ByteVector& msg) const;
+
+    /**
+     * @brief packMessageV1 Packs data ID and data payload into a MSPv1
+     * formatted buffer ready for sending to the serial device. Payloads of 255
+     * bytes or more are sent as jumbo frames.
+     * @param id msp::ID of the message being packed, must be below 256
      * @param data Optional binary payload to be packed into the outbound buffer
      * @return ByteVector of full MSPv1 message ready for sending
      */
@@ -309,12 +1083,33 @@ protected:
                              const ByteVector& data = ByteVector(0)) const;
 
     /**
-     * @brief crcV1 Computes a checksum for MSPv1 messages
-     * @param id uint8_t MSP ID
-     * @param data Payload which is also part of the checksum
-     * @return uint8_t checksum
+     * @brief packMessageV1 Appends a MSPv1 frame to a buffer
+     * @param id msp::ID of the message being packed, must be below 256
+     * @param data Binary payload to be packed into the outbound buffer
+     * @param msg Buffer receiving the frame
+     */
+    void packMessageV1(const msp::ID id, const ByteVector& data,
+                       ByteVector& msg) const;
+
+    /**
+     * @brief packMessageV2OverV1 Packs data ID and data payload into a MSPv2
+     * frame which is tunnelled in a MSPv1 MSP_V2_FRAME frame, for flight
+     * controllers that only accept MSPv1 framing
+     * @param id msp::ID of the message being packed
+     * @param data Optional binary payload to be packed into the outbound buffer
+     * @return ByteVector of full message ready for sending
+     */
+    ByteVector packMessageV2OverV1(
+        const msp::ID id, const ByteVector& data = ByteVector(0)) const;
+
+    /**
+     * @brief packMessageV2OverV1 Appends a tunnelled MSPv2 frame to a buffer
+     * @param id msp::ID of the message being packed
+     * @param data Binary payload to be packed into the outbound buffer
+     * @param msg Buffer receiving the frame
      */
-    uint8_t crcV1(const uint8_t id, const ByteVector& data) const;
+    void packMessageV2OverV1(const msp::ID id, const ByteVector& data,
+                             ByteVector& msg) const;
 
     /**
      * @brief packMessageV2 Packs data ID and data payload into a MSPv2
@@ -327,20 +1122,13 @@ protected:
                              const ByteVector& data = ByteVector(0)) const;
 
     /**
-     * @brief crcV2 Computes a checksum for MSPv2 messages
-     * @param crc Checksum value from which to start calculations
-     * @param data ByteVector of data to be wrapped into the checksum
-     * @return uint8_t checksum
-     */
-    uint8_t crcV2(uint8_t crc, const ByteVector& data) const;
-
-    /**
-     * @brief crcV2 Computes a checksum for MSPv2 messages
-     * @param crc Checksum value from which to start calculations
-     * @param data Single byte to use in the checksum calculation
-     * @return uint8_t checksum
+     * @brief packMessageV2 Appends a MSPv2 frame to a buffer
+     * @param id msp::ID of the message being packed
+     * @param data Binary payload to be packed into the outbound buffer
+     * @param msg Buffer receiving the frame
      */
-    uint8_t crcV2(uint8_t crc, const uint8_t& b) const;
+    void packMessageV2(const msp::ID id, const ByteVector& data,
+                       ByteVector& msg) const;
 
 protected:
     asio::io_service io;     ///<! io service
@@ -358,13 +1146,88 @@ protected:
     std::mutex mutex_buffer;
     std::mutex mutex_send;
 
-    // holder for received data
-    std::unique_ptr<ReceivedMessage> request_received;
+    // frame buffers which keep their capacity, tx_frame is guarded by
+    // mutex_send and rx_message is only used by the receiving thread
+    ByteVector tx_frame;
+    ReceivedMessage rx_message;
+
+    // requests waiting for a response, shared by all callers of the same ID.
+    // The receiving thread skips the locks if the count is 0.
+    std::map<msp::ID, std::shared_ptr<PendingRequest>> pending_requests;
+    std::atomic<std::size_t> pending_count;
+
+    // cached responses to requests without payload, and the IDs which may
+    // be shared and cached
+    mutable std::mutex mutex_cache;
+    std::map<msp::ID, CachedResponse> response_cache;
+    std::set<msp::ID> read_ids;
+    std::atomic<std::size_t> cache_count;
+
+    // round trip time estimates and retransmission of requests
+    mutable std::mutex mutex_rtt;
+    RetryPolicy retry_policy;
+    RttEstimator rtt_link;
+    std::map<std::size_t, RttEstimator> rtt_by_size;
+    std::map<msp::ID, std::size_t> response_sizes;
+    // last message per ID sent without a pending request
+    std::map<msp::ID, std::chrono::steady_clock::time_point> unmatched_sent;
 
     // subscription management
     std::mutex mutex_subscriptions;
     std::map<msp::ID, std::shared_ptr<SubscriptionBase>> subscriptions;
 
+    // push telemetry streams, only locked to look up the stream of a frame
+    std::mutex mutex_push_streams;
+    std::map<msp::ID, std::shared_ptr<PushStreamBase>> push_streams;
+    std::atomic<std::size_t> push_stream_count;
+
+    // resynchronisation of the received data
+    mutable std::mutex mutex_framing;
+    std::size_t max_payload_size_;
+    std::map<msp::ID, std::size_t> max_payload_sizes;
+    std::atomic<uint64_t> frames_received;
+    std::atomic<uint64_t> crc_errors;
+    std::atomic<uint64_t> resyncs;
+    std::atomic<uint64_t> bytes_discarded;
+
+    // scheduling and placement of the threads
+    mutable std::mutex mutex_threads;
+    ThreadConfig thread_config_;
+    bool realtime_enabled_;
+    RealtimeProfile realtime_profile_;
+
+    // serial device settings beyond the asio options
+    bool serial_tuning_enabled_;
+    SerialTuning serial_tuning_;
+
+    // supervised connection
+    std::string device_;
+    size_t baudrate_;
+    std::thread supervisor;
+    mutable std::mutex mutex_supervisor;
+    std::condition_variable cv_supervisor;
+    bool supervisor_stop;
+    bool link_lost;
+    std::chrono::steady_clock::time_point link_lost_stamp;
+    bool auto_reconnect_;
+    double reconnect_period_;
+    std::function<bool()> reconnect_callback;
+    ConnectionStats connection_stats;
+
+    // raw byte pipe after the flight controller entered a passthrough mode.
+    // The receiving thread reschedules its read when mode_switch_ is set,
+    // which is only used by the receiving thread.
+    std::atomic<bool> passthrough_;
+    bool mode_switch_;
+    std::mutex mutex_passthrough;
+    PassthroughHandler passthrough_handler_;
+
+    // observer of the received frames, the flag skips the mutex while no
+    // tap is set
+    std::atomic<bool> has_frame_tap_;
+    std::mutex mutex_frame_tap;
+    FrameTap frame_tap_;
+
     // debugging
     LoggingLevel log_level_;
 
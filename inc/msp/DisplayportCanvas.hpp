@@ -0,0 +1,201 @@
+#ifndef DISPLAYPORT_CANVAS_HPP
+#define DISPLAYPORT_CANVAS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ByteVector.hpp"
+#include "Client.hpp"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+/**
+ * @brief Sub-commands of MSP_DISPLAYPORT, the first byte of the payload
+ */
+enum class DisplayportCommand : uint8_t {
+    HEARTBEAT    = 0,
+    RELEASE      = 1,
+    CLEAR_SCREEN = 2,
+    WRITE_STRING = 3,  ///<! row, column, attribute, characters
+    DRAW_SCREEN  = 4,
+    OPTIONS      = 5
+};
+
+/**
+ * @brief Settings of a DisplayPort canvas
+ */
+struct DisplayportCanvasOptions {
+    // size of the screen, the default is the HD grid of Betaflight and INAV
+    uint8_t rows = 20;
+    uint8_t cols = 53;
+    // longest string of a single write, receivers truncate longer strings
+    std::size_t max_run = 30;
+    // character of an empty cell, as left by a clear screen command
+    uint8_t blank = ' ';
+};
+
+/**
+ * @brief Traffic of a single commit
+ */
+struct DisplayportCommitStats {
+    bool full          = false;  ///<! screen was cleared and redrawn
+    std::size_t cells  = 0;      ///<! cells which changed
+    std::size_t writes = 0;      ///<! string writes
+    std::size_t bytes  = 0;      ///<! bytes of all frames, including the draw
+};
+
+/**
+ * @brief Host side character canvas of an MSP DisplayPort OSD with double
+ * buffering. Drawing only changes the back buffer. A commit compares it with
+ * the screen of the receiver and sends the changed cells as runs of string
+ * writes, which are packed back to back into a single write and followed by
+ * a draw command. Runs are merged across unchanged cells if that is shorter
+ * than the overhead of another write. The canvas is not thread safe.
+ */
+class DisplayportCanvas {
+public:
+    /**
+     * @brief DisplayportCanvas constructor. The first commit clears the
+     * screen of the receiver.
+     * @param client Started client which is connected to the receiver
+     * @param options Size of the screen and limits of the writes
+     */
+    explicit DisplayportCanvas(
+        msp::client::Client& client,
+        const DisplayportCanvasOptions& options = DisplayportCanvasOptions());
+
+    /**
+     * @brief Query the number of rows
+     * @return Number of rows
+     */
+    uint8_t rows() const { return options_.rows; }
+
+    /**
+     * @brief Query the number of columns
+     * @return Number of columns
+     */
+    uint8_t cols() const { return options_.cols; }
+
+    /**
+     * @brief Fill the back buffer with blank cells
+     */
+    void clear();
+
+    /**
+     * @brief Write a string to the back buffer, clipped at the end of the row
+     * @param row Row of the first character
+     * @param col Column of the first character
+     * @param text Characters, indices into the font of the OSD
+     * @param attr Attribute of the characters (font page, blink)
+     * @return Number of characters written
+     */
+    std::size_t write(const uint8_t row, const uint8_t col,
+                      const std::string& text, const uint8_t attr = 0);
+
+    /**
+     * @brief Set a single cell of the back buffer
+     * @param row Row of the cell
+     * @param col Column of the cell
+     * @param chr Character, index into the font of the OSD
+     * @param attr Attribute of the character
+     * @return False if the cell is outside of the canvas
+     */
+    bool put(const uint8_t row, const uint8_t col, const uint8_t chr,
+             const uint8_t attr = 0);
+
+    /**
+     * @brief Query the character of a cell of the back buffer
+     * @param row Row of the cell
+     * @param col Column of the cell
+     * @return Character, the blank character outside of the canvas
+     */
+    uint8_t character(const uint8_t row, const uint8_t col) const;
+
+    /**
+     * @brief Query the attribute of a cell of the back buffer
+     * @param row Row of the cell
+     * @param col Column of the cell
+     * @return Attribute, 0 outside of the canvas
+     */
+    uint8_t attribute(const uint8_t row, const uint8_t col) const;
+
+    /**
+     * @brief Forget the screen of the receiver, the next commit clears and
+     * redraws it (e.g. after the receiver restarted)
+     */
+    void invalidate();
+
+    /**
+     * @brief Send the changes of the back buffer and a draw command. Does not
+     * allocate memory once the buffers reached the size of the largest
+     * commit.
+     * @return True if all frames were written, otherwise the next commit
+     * redraws the screen
+     */
+    bool commit();
+
+    /**
+     * @brief Query the traffic of the last commit
+     * @return Statistics of the last commit
+     */
+    const DisplayportCommitStats& lastCommit() const { return stats_; }
+
+private:
+    std::size_t index(const uint8_t row, const uint8_t col) const {
+        return std::size_t(row) * options_.cols + col;
+    }
+
+    bool changed(const std::size_t i) const {
+        return back_chars_[i] != front_chars_[i] ||
+               back_attrs_[i] != front_attrs_[i];
+    }
+
+    /**
+     * @brief Appends the string writes of the changes in a row
+     * @param row Row of the canvas
+     */
+    void diffRow(const uint8_t row);
+
+    /**
+     * @brief Appends a string write of a run of cells
+     * @param row Row of the run
+     * @param begin First column of the run
+     * @param end Column past the run
+     */
+    void addRun(const uint8_t row, const std::size_t begin,
+                const std::size_t end);
+
+    void addCommand(const DisplayportCommand command);
+
+    msp::client::Client& client_;
+    DisplayportCanvasOptions options_;
+
+    // cells being drawn
+    std::vector<uint8_t> back_chars_;
+    std::vector<uint8_t> back_attrs_;
+    // cells as shown by the receiver
+    std::vector<uint8_t> front_chars_;
+    std::vector<uint8_t> front_attrs_;
+    bool front_valid_;
+
+    // payloads of the commit, which keep their capacity
+    std::vector<msp::ByteVector> payloads_;
+    DisplayportCommitStats stats_;
+};
+
+}  // namespace fcu
+
+inline std::ostream& operator<<(std::ostream& s,
+                                const fcu::DisplayportCommitStats& stats) {
+    s << "#Displayport commit:" << std::endl;
+    s << " Full redraw: " << (stats.full ? "yes" : "no") << std::endl;
+    s << " Cells: " << stats.cells << std::endl;
+    s << " Writes: " << stats.writes << std::endl;
+    s << " Bytes: " << stats.bytes << std::endl;
+    return s;
+}
+
+#endif  // DISPLAYPORT_CANVAS_HPP
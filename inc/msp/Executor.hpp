@@ -0,0 +1,173 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadPolicy.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Runs callbacks of subscriptions
+ */
+class Executor {
+public:
+    typedef std::function<void()> Task;
+
+    virtual ~Executor() {}
+
+    /**
+     * @brief Schedules a task for execution
+     * @param task Function to be called
+     */
+    virtual void post(Task&& task) = 0;
+};
+
+/**
+ * @brief Runs every task immediately in the calling thread
+ */
+class InlineExecutor : public Executor {
+public:
+    virtual void post(Task&& task) override { task(); }
+};
+
+/**
+ * @brief Runs tasks in parallel on a fixed number of worker threads. Tasks
+ * which are queued when the pool is destroyed are still executed.
+ */
+class ThreadPool : public Executor {
+public:
+    /**
+     * @brief ThreadPool constructor starting the worker threads
+     * @param threads Number of worker threads, 0 uses one per core
+     * @param policy Scheduling and placement of the worker threads, which are
+     * named msp-pool-N
+     */
+    explicit ThreadPool(std::size_t threads         = 0,
+                        const ThreadPolicy& policy = ThreadPolicy()) :
+        stop_(false) {
+        if(threads == 0) threads = std::thread::hardware_concurrency();
+        if(threads == 0) threads = 1;
+        for(std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back(&ThreadPool::work, this, policy, i);
+        }
+    }
+
+    /**
+     * @brief ThreadPool destructor, waits until all queued tasks are done
+     */
+    virtual ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for(std::thread& worker : workers_) worker.join();
+    }
+
+    virtual void post(Task&& task) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    /**
+     * @brief Queries the number of worker threads
+     * @return Number of threads
+     */
+    std::size_t size() const { return workers_.size(); }
+
+private:
+    void work(const ThreadPolicy policy, const std::size_t index) {
+        applyThreadPolicy(
+            pthread_self(), policy, "msp-pool-" + std::to_string(index));
+        while(true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if(tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Runs tasks one after another in the order in which they were posted,
+ * using the threads of another executor. Tasks of different strands run in
+ * parallel if the underlying executor has several threads.
+ */
+class Strand : public Executor {
+public:
+    /**
+     * @brief Strand constructor
+     * @param executor Executor which runs the tasks, it must not be an
+     * InlineExecutor if tasks are posted from several threads
+     */
+    explicit Strand(const std::shared_ptr<Executor>& executor) :
+        executor_(executor),
+        state_(std::make_shared<State>()) {}
+
+    virtual void post(Task&& task) override {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->tasks.push_back(std::move(task));
+            // a running drain task picks up the new task
+            if(state_->running) return;
+            state_->running = true;
+        }
+        const std::shared_ptr<State> state = state_;
+        executor_->post([state] { drain(state); });
+    }
+
+private:
+    // shared with the queued drain task, which may outlive the strand
+    struct State {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        bool running = false;
+    };
+
+    static void drain(const std::shared_ptr<State>& state) {
+        while(true) {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if(state->tasks.empty()) {
+                    state->running = false;
+                    return;
+                }
+                task = std::move(state->tasks.front());
+                state->tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::shared_ptr<Executor> executor_;
+    std::shared_ptr<State> state_;
+};
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // EXECUTOR_HPP
@@ -0,0 +1,220 @@
+#ifndef FLAG_SET_HPP
+#define FLAG_SET_HPP
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <set>
+#include <type_traits>
+#include <utility>
+
+namespace msp {
+
+/**
+ * @brief Set of small integral or enum keys which is stored as a fixed-width
+ * bit mask. The interface mimics std::set, but inserting, erasing, counting
+ * and assigning never allocate memory. Keys are iterated in ascending order.
+ * @tparam T Key type. Must be an integral or enum type.
+ * @tparam Word Unsigned integer type holding the bit mask. Keys must be
+ * smaller than the number of bits in Word.
+ */
+template <class T, class Word = uint32_t> class FlagSet {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                  "FlagSet keys must be integral or enum types");
+    static_assert(std::is_unsigned<Word>::value,
+                  "FlagSet words must be unsigned integer types");
+
+public:
+    typedef T key_type;
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef Word word_type;
+
+    /**
+     * @brief Forward iterator over the keys in the set
+     */
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef T reference;
+
+        const_iterator() : bits_(0) {}
+
+        explicit const_iterator(const Word bits) : bits_(bits) {}
+
+        T operator*() const { return T(lowestBit(bits_)); }
+
+        const_iterator& operator++() {
+            // clear the lowest bit that is set
+            bits_ &= Word(bits_ - 1);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& rhs) const {
+            return bits_ == rhs.bits_;
+        }
+
+        bool operator!=(const const_iterator& rhs) const {
+            return bits_ != rhs.bits_;
+        }
+
+    private:
+        Word bits_;
+    };
+
+    typedef const_iterator iterator;
+
+    /**
+     * @brief FlagSet constructor creating an empty set
+     */
+    FlagSet() : bits_(0) {}
+
+    /**
+     * @brief FlagSet constructor
+     * @param keys List of keys to be inserted
+     */
+    FlagSet(std::initializer_list<T> keys) : bits_(0) {
+        for(const T& key : keys) insert(key);
+    }
+
+    /**
+     * @brief Gets the maximum number of keys that can be stored
+     * @returns Number of bits in the underlying word
+     */
+    static constexpr size_type max_size() { return sizeof(Word) * CHAR_BIT; }
+
+    /**
+     * @brief Queries the presence of a key
+     * @param key Key to look for
+     * @returns 1 if the key is present, 0 otherwise
+     */
+    size_type count(const T& key) const {
+        return inRange(key) ? size_type((bits_ >> index(key)) & 1) : 0;
+    }
+
+    /**
+     * @brief Inserts a key
+     * @param key Key to be inserted
+     * @returns Pair of an iterator and a flag which is true if the key was
+     * inserted. Keys out of range are not inserted.
+     */
+    std::pair<iterator, bool> insert(const T& key) {
+        if(!inRange(key)) return std::make_pair(end(), false);
+        const bool inserted = !count(key);
+        bits_ |= mask(key);
+        return std::make_pair(find(key), inserted);
+    }
+
+    /**
+     * @brief Removes a key
+     * @param key Key to be removed
+     * @returns Number of removed keys (0 or 1)
+     */
+    size_type erase(const T& key) {
+        const size_type n = count(key);
+        if(n) bits_ &= Word(~mask(key));
+        return n;
+    }
+
+    /**
+     * @brief Finds a key
+     * @param key Key to look for
+     * @returns Iterator to the key, or end() if the key is not present
+     */
+    iterator find(const T& key) const {
+        if(!count(key)) return end();
+        // drop all keys below the requested one
+        return iterator(Word(bits_ & ~Word(mask(key) - 1)));
+    }
+
+    /**
+     * @brief Removes all keys
+     */
+    void clear() { bits_ = 0; }
+
+    /**
+     * @brief Queries if the set is empty
+     * @returns True if there are no keys in the set
+     */
+    bool empty() const { return bits_ == 0; }
+
+    /**
+     * @brief Counts the keys in the set
+     * @returns Number of keys
+     */
+    size_type size() const {
+        size_type n = 0;
+        for(Word b = bits_; b; b &= Word(b - 1)) ++n;
+        return n;
+    }
+
+    /**
+     * @brief Gets an iterator to the smallest key
+     * @returns Iterator to the first key
+     */
+    iterator begin() const { return iterator(bits_); }
+
+    /**
+     * @brief Gets the past-the-end iterator
+     * @returns Iterator past the largest key
+     */
+    iterator end() const { return iterator(0); }
+
+    /**
+     * @brief Gets the underlying bit mask, bit i is set if key i is present
+     * @returns Bit mask
+     */
+    Word bits() const { return bits_; }
+
+    /**
+     * @brief Replaces the content of the set by a bit mask
+     * @param bits Bit mask, bit i is set if key i is present
+     */
+    void setBits(const Word bits) { bits_ = bits; }
+
+    /**
+     * @brief Converts to a std::set with the same keys
+     */
+    operator std::set<T>() const { return std::set<T>(begin(), end()); }
+
+    bool operator==(const FlagSet& rhs) const { return bits_ == rhs.bits_; }
+
+    bool operator!=(const FlagSet& rhs) const { return bits_ != rhs.bits_; }
+
+private:
+    static size_type index(const T& key) { return size_type(key); }
+
+    static bool inRange(const T& key) {
+        // negative keys wrap around to large indices
+        return index(key) < max_size();
+    }
+
+    static Word mask(const T& key) { return Word(Word(1) << index(key)); }
+
+    static size_type lowestBit(const Word bits) {
+#if defined(__GNUC__) || defined(__clang__)
+        return size_type(__builtin_ctzll((unsigned long long)bits));
+#else
+        size_type n = 0;
+        for(Word b = bits; !(b & 1); b >>= 1) ++n;
+        return n;
+#endif
+    }
+
+    Word bits_;
+};
+
+}  // namespace msp
+
+#endif
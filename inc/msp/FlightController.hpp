@@ -1,8 +1,13 @@
 #ifndef FLIGHTCONTROLLER_HPP
 #define FLIGHTCONTROLLER_HPP
 
+#include <atomic>
+#include <mutex>
+#include <type_traits>
 #include "Client.hpp"
 #include "FlightMode.hpp"
+#include "FontTransfer.hpp"
+#include "MissionTransfer.hpp"
 #include "PeriodicTimer.hpp"
 #include "msp_msg.hpp"
 
@@ -27,7 +32,16 @@ public:
      * connecting the internal Client object and querying the flight controller
      * for information necessary to configure the internal state to match the
      * capabiliites of the flight controller.
-     * @param timeout Timeout passed to each internal operation (seconds)
+     * @param device Path to the serial device
+     * @param baudrate Baudrate of the connection, 0 probes for the fastest
+     * stable rate (see msp::client::Client::probeBaudrate)
+     * @param timeout Timeout of the protocol version query, and of the
+     * remaining queries, which are sent as one batch and share the timeout
+     * (seconds). A value of 0 (default) waits until the retries of the
+     * RetryPolicy are exhausted. Unanswered queries of optional information,
+     * like the board name, are skipped, but a std::runtime_error is thrown if
+     * the box names or IDs are not answered.
+     * @param print_info Print the information about the flight controller
      * @return True on success
      */
     bool connect(const std::string &device, const size_t baudrate = 115200,
@@ -98,6 +112,21 @@ public:
      */
     bool reboot();
 
+    /**
+     * @brief Moves the MSP connection to another baudrate. The baudrate of
+     * the flight controller port is changed via MSP_SET_CF_SERIAL_CONFIG and
+     * saved, the flight controller is rebooted and the host port follows.
+     * Not needed for USB (VCP) connections, which ignore the baudrate.
+     * @param port_identifier Identifier of the flight controller port which
+     * is connected to the host (e.g. 0 for UART1)
+     * @param baudrate New baudrate
+     * @param timeout Time to wait for the flight controller after the reboot
+     * (in seconds)
+     * @return True if the flight controller answers at the new rate
+     */
+    bool setMspBaudrate(const uint8_t port_identifier, const size_t baudrate,
+                        const double timeout = 5.0);
+
     /**
      * @brief Queries the currently set firmware variant (Cleanflight,
      * Betaflight, etc.)
@@ -117,6 +146,44 @@ public:
      */
     std::string getBoardName() const;
 
+    /**
+     * @brief Queries the time it took the last call to connect() to open the
+     * connection and collect all flight controller information
+     * @return Time to ready in seconds
+     */
+    double getConnectTime() const;
+
+    /**
+     * @brief Restore the connection automatically after the flight controller
+     * disappeared, e.g. after a reset of the USB-serial adapter. The box map,
+     * channel map and control source are kept and re-applied after a short
+     * handshake. Must be called before connect().
+     * @param enable True to reconnect automatically
+     * @param period Interval between two attempts to reopen the device (in
+     * seconds)
+     */
+    void setAutoReconnect(const bool enable, const double period = 0.1) {
+        client_.setAutoReconnect(enable, period);
+    }
+
+    /**
+     * @brief Query the number of link losses and the reconnect latency
+     * @return Counters of the supervised connection
+     */
+    msp::client::ConnectionStats getConnectionStats() const {
+        return client_.getConnectionStats();
+    }
+
+    /**
+     * @brief Sets the scheduling class, priority and CPU affinity of the
+     * threads of the client, e.g. to pin the control path to isolated cores
+     * @param config Policies of the threads
+     * @return True if all policies could be applied
+     */
+    bool setThreadConfig(const msp::client::ThreadConfig &config) {
+        return client_.setThreadConfig(config);
+    }
+
     /**
      * @brief Set the verbosity of the output
      * @param level LoggingLevel matching the desired amount of output (default
@@ -157,14 +224,18 @@ public:
      * @param context Object with callback method
      * @param tp Period of timer that will send subscribed requests (in
      * seconds), by default this is 0 and requests are not sent periodically
+     * @param executor Executor running the callback, by default it is called
+     * in the receiving thread
      * @return Pointer to subscription that is added to internal list
      */
     template <typename T, typename C,
               class = typename std::enable_if<
                   std::is_base_of<msp::Message, T>::value>::type>
     std::shared_ptr<msp::client::SubscriptionBase> subscribe(
-        void (C::*callback)(const T &), C *context, const double tp = 0.0) {
-        return client_.subscribe(callback, context, tp);
+        void (C::*callback)(const T &), C *context, const double tp = 0.0,
+        const std::shared_ptr<msp::client::Executor> &executor = nullptr) {
+        return subscribe<T>(
+            std::bind(callback, context, std::placeholders::_1), tp, executor);
     }
 
     /**
@@ -173,13 +244,46 @@ public:
      * function pointer)
      * @param tp Period of timer that will send subscribed requests (in
      * seconds), by default this is 0 and requests are not sent periodically
+     * @param executor Executor running the callback, by default it is called
+     * in the receiving thread
      * @return Pointer to subscription that is added to internal list
+     * @note Several callbacks can subscribe to the same message type, e.g.
+     * msp::msg::Status next to the internal status listener. The message is
+     * requested with the smallest period of all callbacks.
      */
     template <typename T, class = typename std::enable_if<
                               std::is_base_of<msp::Message, T>::value>::type>
     std::shared_ptr<msp::client::SubscriptionBase> subscribe(
-        const std::function<void(const T &)> &callback, const double tp = 0.0) {
-        return client_.subscribe(callback, tp);
+        const std::function<void(const T &)> &callback, const double tp = 0.0,
+        const std::shared_ptr<msp::client::Executor> &executor = nullptr) {
+        return client_.subscribe(callback, tp, executor);
+    }
+
+    /**
+     * @brief Register callback function that is called when type is received,
+     * like subscribe()
+     * @param callback Function to be called
+     * @param tp Minimum period between two callbacks (in seconds)
+     * @param executor Executor running the callback
+     * @return ID of the listener, which can be passed to removeListener()
+     */
+    template <typename T, class = typename std::enable_if<
+                              std::is_base_of<msp::Message, T>::value>::type>
+    msp::client::ListenerId addListener(
+        const std::function<void(const T &)> &callback, const double tp = 0.0,
+        const std::shared_ptr<msp::client::Executor> &executor = nullptr) {
+        return client_.addListener(callback, tp, executor);
+    }
+
+    /**
+     * @brief Remove a single callback of a subscription
+     * @param id Message ID
+     * @param listener ID of the listener
+     * @return True if the listener was removed
+     */
+    bool removeListener(const msp::ID &id,
+                        const msp::client::ListenerId &listener) {
+        return client_.removeListener(id, listener);
     }
 
     /**
@@ -201,6 +305,27 @@ public:
         return client_.getSubscription(id);
     }
 
+    /**
+     * @brief Open a ring buffer for unsolicited push telemetry
+     * @param capacity Minimum number of buffered samples
+     * @return Pointer to the stream
+     */
+    template <typename T, class = typename std::enable_if<
+                              std::is_base_of<msp::Message, T>::value>::type>
+    std::shared_ptr<msp::client::PushStream<typename T::sample_type>>
+    openPushStream(const std::size_t capacity = 1024) {
+        return client_.openPushStream<T>(capacity);
+    }
+
+    /**
+     * @brief Stop routing frames into a push stream
+     * @param id Message ID
+     * @return True if a stream was closed
+     */
+    bool closePushStream(const msp::ID &id) {
+        return client_.closePushStream(id);
+    }
+
     /**
      * @brief Sends a message to the flight controller
      * @param message Reference to a Message-derived object
@@ -212,16 +337,102 @@ public:
         return client_.sendMessage(message, timeout);
     }
 
+    /**
+     * @brief Sends several messages back to back to the flight controller and
+     * collects the responses as they arrive
+     * @param messages Messages to be sent/received
+     * @param timeout Number of seconds to wait for all responses. Default
+     * value of 0 means no timeout.
+     * @return Vector with one entry per message, which is true on success
+     */
+    std::vector<bool> sendMessages(const std::vector<msp::Message *> &messages,
+                                   const double timeout = 0) {
+        return client_.sendMessages(messages, timeout);
+    }
+
+    /**
+     * @brief Let concurrent requests without payload of a message type share
+     * one request on the wire. The queries of the flight controller, like
+     * MSP_STATUS or MSP_BOXNAMES, are marked as reads already.
+     * @param id Message ID
+     * @param read False if the message changes the flight controller
+     */
+    void markRead(const msp::ID &id, const bool read = true) {
+        client_.markRead(id, read);
+    }
+
+    /**
+     * @brief Answer requests of a message type from a cached response, which
+     * marks it as a read
+     * @param id Message ID
+     * @param ttl Number of seconds a response stays valid, 0 disables caching
+     */
+    void setCacheTtl(const msp::ID &id, const double ttl) {
+        client_.setCacheTtl(id, ttl);
+    }
+
+    /**
+     * @brief Set the timeouts and retransmissions of requests
+     * @param policy Retry policy, see msp::client::RetryPolicy
+     */
+    void setRetryPolicy(const msp::client::RetryPolicy &policy) {
+        client_.setRetryPolicy(policy);
+    }
+
+    /**
+     * @brief Uploads a waypoint mission with a sliding window, verifies it by
+     * reading it back and stores it with MSP_WP_MISSION_SAVE
+     * @param mission Waypoints in order, the first one becomes number 1
+     * @param options Settings of the transfer
+     * @return Report with the transfer time and the number of retries
+     */
+    MissionTransferReport uploadMission(
+        const Mission &mission,
+        const MissionTransferOptions &options = MissionTransferOptions()) {
+        return MissionTransfer(client_).upload(mission, options);
+    }
+
+    /**
+     * @brief Downloads the waypoint mission of the flight controller
+     * @param mission Receives the waypoints
+     * @param options Settings of the transfer
+     * @return Report with the transfer time and the number of retries
+     */
+    MissionTransferReport downloadMission(
+        Mission &mission,
+        const MissionTransferOptions &options = MissionTransferOptions()) {
+        return MissionTransfer(client_).download(mission, options);
+    }
+
+    /**
+     * @brief Uploads an OSD font with a sliding window. Characters which
+     * already match are skipped if the flight controller supports reading
+     * them back.
+     * @param font Font, e.g. loaded from a .mcm file
+     * @param options Settings of the transfer, including a progress callback
+     * @return Report with the transfer time and the throughput
+     */
+    FontTransferReport uploadFont(
+        const OsdFont &font,
+        const FontTransferOptions &options = FontTransferOptions()) {
+        return FontTransfer(client_).upload(font, options);
+    }
+
     /**
      * @brief Queries the flight controller for Box (flight mode) information
+     * @param timeout Maximum amount of time to block waiting for the
+     * responses. A value of 0 (default) means wait forever, or until the
+     * retries of the RetryPolicy are exhausted.
      */
-    void initBoxes();
+    void initBoxes(const double &timeout = 0);
 
     /**
      * @brief Gets the information collected by the initBoxes() method
-     * @return Reference to the internal mapping of strings to box IDs
+     * @return Copy of the internal mapping of strings to box IDs, which is
+     * replaced if a different flight controller reconnects
      */
-    const std::map<std::string, size_t> &getBoxNames() const {
+    std::map<std::string, size_t> getBoxNames() const {
+        std::lock_guard<std::mutex> lock(identity_mutex_);
         return box_name_ids_;
     }
 
@@ -298,28 +509,95 @@ public:
     bool hasSonar() const { return hasSensor(msp::msg::Sensor::Sonar); }
 
     /**
-     * @brief Queries the flight controller to see if a status is active
+     * @brief Sets the period of the internal Status listener, which is
+     * started by connect() and keeps the cached box mode flags up to date. A
+     * period of 0 stops requesting the status for the cache, and every status
+     * query will send a blocking request instead.
+     * @param period Period in seconds (default 0.05)
+     */
+    void setStatusPeriod(const double period);
+
+    /**
+     * @brief Resolves the name of a box (flight mode) to a bit mask which can
+     * be tested with isBoxActive()
+     * @param box_name Name of the box
+     * @return Bit mask of the box, or 0 if the box is unknown
+     */
+    uint32_t getBoxMask(const std::string &box_name) const;
+
+    /**
+     * @brief Tests the box mode flags of the most recently received Status
+     * against a bit mask. This never blocks.
+     * @param mask Bit mask as returned by getBoxMask()
+     * @param max_age Maximum age of the cached status in seconds. A value of 0
+     * (default) accepts status information of any age.
+     * @return True if any of the boxes in the mask is active and the cached
+     * status is not older than max_age
+     */
+    bool isBoxActive(const uint32_t mask, const double &max_age = 0) const {
+        if(max_age > 0 && !(getStatusAge() <= max_age)) return false;
+        return box_mode_flags_.load(std::memory_order_acquire) & mask;
+    }
+
+    /**
+     * @brief Queries the age of the cached status
+     * @return Age in seconds, infinity if no status has been received yet
+     */
+    double getStatusAge() const;
+
+    /**
+     * @brief Queries the flight controller to see if a status is active. The
+     * cached status is used if it is not older than max_age, or if max_age is
+     * 0 and the internal Status subscription keeps it up to date. Otherwise
+     * the status is requested, bypassing the response cache of the client.
+     * Throws std::runtime_error if the box is unknown or the status cannot be
+     * requested.
      * @param status_name of boxitems
-     * @param timeout Maximum amount of time to block waiting for a response.
+     * @param timeout Maximum amount of time to block waiting for a response if
+     * the status is requested. A value of 0 (default) waits until the retries
+     * of the RetryPolicy are exhausted.
+     * @param max_age Maximum age of the cached status in seconds, 0 (default)
+     * accepts a status of the last few status periods
      * @return True if status if active
      */
     bool isStatusActive(const std::string &status_name,
-                        const double &timeout = 0);
+                        const double &timeout = 0, const double &max_age = 0);
 
     /**
      * @brief Queries the flight controller to see if the ARM status is active.
      * Not to be confused with armSet(), which queries whether the flight
      * controller has been instructued to turn on the ARM status.
+     * @param max_age Maximum age of the cached status in seconds, 0 (default)
+     * accepts a status of the last few status periods. An older status is
+     * requested, see isStatusActive().
+     * @param timeout Maximum amount of time to block waiting for the status if
+     * it is requested
      * @return True if the ARM status is active
      */
-    bool isArmed() { return isStatusActive("ARM", 0.1); }
+    bool isArmed(const double &max_age = 0, const double &timeout = 0.1) {
+        const uint32_t mask = arm_mask_;
+        if(mask && status_stream_ && isStatusFresh(max_age))
+            return isBoxActive(mask);
+        return isStatusActive("ARM", timeout, max_age);
+    }
 
     /**
      * @brief Queries the flight controller to see if the FAILSAFE status is
      * active.
+     * @param max_age Maximum age of the cached status in seconds, see
+     * isArmed()
+     * @param timeout Maximum amount of time to block waiting for the status if
+     * it is requested, 0 (default) waits until the retries of the RetryPolicy
+     * are exhausted
      * @return True if the FAILSAFE status is active
      */
-    bool isStatusFailsafe() { return isStatusActive("FAILSAFE"); }
+    bool isStatusFailsafe(const double &max_age = 0,
+                          const double &timeout = 0) {
+        const uint32_t mask = failsafe_mask_;
+        if(mask && status_stream_ && isStatusFresh(max_age))
+            return isBoxActive(mask);
+        return isStatusActive("FAILSAFE", timeout, max_age);
+    }
 
     /**
      * @brief Directly sets motor values using SetMotor message
@@ -342,17 +620,75 @@ public:
         const std::set<std::string> &remove = std::set<std::string>());
 
 private:
+    /**
+     * @brief Updates the internal mapping of box names to box IDs
+     * @param box_names Response to a BoxNames request
+     * @param box_ids Response to a BoxIds request
+     */
+    void updateBoxes(const msp::msg::BoxNames &box_names,
+                     const msp::msg::BoxIds &box_ids);
+
+    /**
+     * @brief Updates the cached box mode flags
+     * @param status Most recently received Status message
+     */
+    void updateStatus(const msp::msg::Status &status);
+
+    /**
+     * @brief Checks if the cached status may be used instead of a request
+     * @param max_age Maximum age of the cached status in seconds, 0 accepts
+     * a status of the last few status periods
+     * @return True if the cached status is not older than max_age
+     */
+    bool isStatusFresh(const double &max_age) const;
+
+    /**
+     * @brief Starts the internal Status subscription if a status period is set
+     */
+    void startStatusStream();
+
+    /**
+     * @brief Configures the receiver of the flight controller
+     * @param source Control source
+     * @param timeout Maximum amount of time to block waiting for each
+     * response, 0 waits until the retries of the RetryPolicy are exhausted
+     * @return True if the configuration was sent and acknowledged
+     */
+    bool applyControlSource(const ControlSource source,
+                            const double &timeout = 0);
+
+    /**
+     * @brief Handshake after the client reopened the device. It checks that
+     * the same flight controller is back and restores the control source.
+     * @return True if the connection is usable
+     */
+    bool restoreConnection();
+
     // Client instance for managing the actual comms with the flight controller
     msp::client::Client client_;
 
-    // parameters updated by the connect method to cache flight controller info
-    std::string board_name_;
-    msp::FirmwareVariant fw_variant_;
+    // parameters updated by the connect method to cache flight controller info,
+    // the identity is replaced by the supervisor thread of the client if a
+    // different flight controller reconnects
+    std::atomic<msp::FirmwareVariant> fw_variant_;
     int msp_version_;
+    // guards the board name, the box and the channel map
+    mutable std::mutex identity_mutex_;
+    std::string board_name_;
     std::map<std::string, size_t> box_name_ids_;
-    std::set<msp::msg::Sensor> sensors_;
+    msp::FlagSet<msp::msg::Sensor> sensors_;
     std::array<uint8_t, msp::msg::MAX_MAPPABLE_RX_INPUTS> channel_map_;
     std::set<msp::msg::Capability> capabilities_;
+    double connect_time_;
+
+    // cached status, updated by the internal Status listener
+    std::atomic<double> status_period_;
+    std::atomic<bool> status_stream_;
+    msp::client::ListenerId status_listener_;
+    std::atomic<uint32_t> box_mode_flags_;
+    std::atomic<int64_t> status_stamp_;  // steady clock, in ns
+    std::atomic<uint32_t> arm_mask_;
+    std::atomic<uint32_t> failsafe_mask_;
 
     // parameters updated by the user, and consumed by MSP control messages
     std::array<double, 4> rpyt_;
@@ -0,0 +1,213 @@
+#ifndef FONT_TRANSFER_HPP
+#define FONT_TRANSFER_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Client.hpp"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+/**
+ * @brief Character font of a MAX7456 compatible OSD
+ */
+struct OsdFont {
+    // bytes per character in a .mcm file, the last 10 bytes are metadata
+    static const std::size_t CHARACTER_BYTES = 64;
+    // bytes of the 12x18 pixels with 2 bits each
+    static const std::size_t VISIBLE_BYTES = 54;
+
+    typedef std::array<uint8_t, CHARACTER_BYTES> Character;
+
+    std::vector<Character> characters;
+
+    /**
+     * @brief Parses a font in the .mcm format: a "MAX7456" header line
+     * followed by one line with 8 binary digits per byte
+     * @param in Source of the font
+     * @return True if the font is well formed and has at least one character
+     */
+    bool read(std::istream& in);
+
+    /**
+     * @brief Writes the font in the .mcm format
+     * @param out Destination of the font
+     * @return True on success
+     */
+    bool write(std::ostream& out) const;
+
+    /**
+     * @brief Reads a .mcm file
+     * @param path Path to the file
+     * @return True on success
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Writes a .mcm file
+     * @param path Path to the file
+     * @return True on success
+     */
+    bool save(const std::string& path) const;
+};
+
+enum class FontTransferPhase { READ, WRITE, VERIFY };
+
+/**
+ * @brief Progress of a font transfer, passed to the progress callback
+ */
+struct FontTransferProgress {
+    FontTransferPhase phase = FontTransferPhase::READ;
+    std::size_t done        = 0;  ///<! characters completed in this phase
+    std::size_t total       = 0;  ///<! characters of this phase
+    std::size_t bytes       = 0;  ///<! character bytes sent and received
+    double elapsed          = 0;  ///<! time since the start in seconds
+
+    double bytesPerSecond() const { return elapsed > 0 ? bytes / elapsed : 0; }
+};
+
+/**
+ * @brief Settings of a font transfer
+ */
+struct FontTransferOptions {
+    // maximum number of characters in flight
+    std::size_t window = 4;
+    // time to wait for the response to a single character (in seconds)
+    double timeout = 0.5;
+    // read the font first and only write characters which differ
+    bool skip_matching = true;
+    // read the written characters back and write them again if they differ
+    bool verify = true;
+    // number of additional write rounds for characters which failed
+    std::size_t max_retries = 2;
+    // called in the transferring thread whenever a character completes
+    std::function<void(const FontTransferProgress&)> progress;
+};
+
+/**
+ * @brief Outcome of a font transfer
+ */
+struct FontTransferReport {
+    bool success           = false;  ///<! all characters transferred
+    bool readback          = false;  ///<! MSP_OSD_CHAR_READ is supported
+    double duration        = 0;      ///<! time of the transfer in seconds
+    std::size_t characters = 0;      ///<! number of characters of the font
+    std::size_t written    = 0;      ///<! number of characters written
+    std::size_t skipped    = 0;      ///<! characters which already matched
+    std::size_t retries    = 0;      ///<! characters written again
+    std::size_t bytes      = 0;      ///<! character bytes sent and received
+    std::vector<std::size_t> failed;  ///<! characters which were not confirmed
+
+    double bytesPerSecond() const {
+        return duration > 0 ? bytes / duration : 0;
+    }
+};
+
+/**
+ * @brief Transfers OSD fonts with MSP_OSD_CHAR_WRITE and MSP_OSD_CHAR_READ.
+ * Up to a window of characters is sent without waiting for the responses in
+ * between. Reads are matched by the address in the response, writes by the
+ * number of acknowledgements, since the flight controller handles requests
+ * in order.
+ */
+class FontTransfer {
+public:
+    /**
+     * @brief FontTransfer constructor
+     * @param client Started client which is connected to the flight controller
+     */
+    explicit FontTransfer(msp::client::Client& client);
+
+    /**
+     * @brief Uploads a font. If the flight controller supports reading
+     * characters, characters which already match are skipped and the written
+     * ones are verified.
+     * @param font Font to upload
+     * @param options Settings of the transfer
+     * @return Report of the transfer
+     */
+    FontTransferReport upload(
+        const OsdFont& font,
+        const FontTransferOptions& options = FontTransferOptions());
+
+    /**
+     * @brief Reads the visible bytes of the font of the flight controller
+     * @param font Receives the characters, the metadata bytes are cleared
+     * @param characters Number of characters to read
+     * @param options Settings of the transfer
+     * @return Report of the transfer
+     */
+    FontTransferReport download(
+        OsdFont& font, const std::size_t characters = 256,
+        const FontTransferOptions& options = FontTransferOptions());
+
+private:
+    typedef std::array<uint8_t, OsdFont::VISIBLE_BYTES> Visible;
+
+    /**
+     * @brief Pipelined reads of a set of characters
+     * @param addrs Addresses of the characters
+     * @param phase Phase reported to the progress callback
+     * @return Visible bytes of the characters which were received
+     */
+    std::map<std::size_t, Visible> readRound(
+        const std::vector<std::size_t>& addrs, const FontTransferPhase phase);
+
+    /**
+     * @brief Pipelined writes of a set of characters
+     * @param font Font to write
+     * @param addrs Addresses of the characters
+     * @return True if every write was acknowledged
+     */
+    bool writeRound(const OsdFont& font, const std::vector<std::size_t>& addrs);
+
+    void onRead(const msp::msg::OsdCharRead& chr);
+
+    void onWriteAck(const msp::msg::OsdCharWrite&);
+
+    void reportProgress(const FontTransferPhase phase, const std::size_t done,
+                        const std::size_t total);
+
+    static Visible visible(const OsdFont::Character& chr);
+
+    msp::client::Client& client_;
+
+    // settings and counters of the running transfer
+    FontTransferOptions options_;
+    FontTransferReport report_;
+    std::chrono::steady_clock::time_point start_;
+
+    // responses, filled by the receiving thread
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<std::size_t, Visible> received_;
+    std::size_t acks_;
+};
+
+}  // namespace fcu
+
+inline std::ostream& operator<<(std::ostream& s,
+                                const fcu::FontTransferReport& report) {
+    s << "#Font transfer:" << std::endl;
+    s << " Success: " << (report.success ? "yes" : "no") << std::endl;
+    s << " Read-back: " << (report.readback ? "yes" : "no") << std::endl;
+    s << " Characters: " << report.characters << " (" << report.written
+      << " written, " << report.skipped << " skipped)" << std::endl;
+    s << " Retries: " << report.retries << std::endl;
+    s << " Duration: " << report.duration * 1000 << " ms" << std::endl;
+    s << " Throughput: " << report.bytesPerSecond() << " bytes/s" << std::endl;
+    s << " Failed: " << report.failed.size() << std::endl;
+    return s;
+}
+
+#endif  // FONT_TRANSFER_HPP
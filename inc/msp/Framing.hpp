@@ -0,0 +1,147 @@
+#ifndef FRAMING_HPP
+#define FRAMING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "ByteVector.hpp"
+
+namespace msp {
+namespace client {
+
+// message ID of MSPv1 frames which tunnel a MSPv2 frame
+constexpr uint8_t MSP_V2_FRAME_ID = 255;
+
+/**
+ * @brief Direction of a frame, the byte after the preamble
+ */
+enum class FrameDirection : uint8_t {
+    REQUEST        = '<',  ///<! to the flight controller
+    RESPONSE       = '>',  ///<! from the flight controller
+    ERROR_RESPONSE = '!'   ///<! from the flight controller, e.g. unknown ID
+};
+
+/**
+ * @brief Result of checking a candidate frame
+ */
+enum FrameCheck {
+    FRAME_INVALID,     // not a frame, the preamble is a random byte
+    FRAME_INCOMPLETE,  // more data is needed
+    FRAME_CRC_ERROR,   // complete frame with a wrong checksum
+    FRAME_VALID        // complete frame with a correct checksum
+};
+
+/**
+ * @brief Header of a MSPv1 or MSPv2 frame
+ */
+struct FrameHeader {
+    bool v2                  = false;
+    FrameDirection direction = FrameDirection::REQUEST;
+    uint16_t id              = 0;
+    // size of the header including preamble and direction
+    std::size_t header_size  = 0;
+    std::size_t payload_size = 0;
+
+    /**
+     * @brief Queries the size of the frame including the checksum
+     * @return Size in bytes
+     */
+    std::size_t frameSize() const { return header_size + payload_size + 1; }
+};
+
+/**
+ * @brief Continues a MSPv1 checksum
+ * @param crc Checksum value from which to start calculations
+ * @param begin Pointer to the first byte
+ * @param end Pointer past the last byte
+ * @return uint8_t checksum
+ */
+uint8_t crcV1(uint8_t crc, const uint8_t* begin, const uint8_t* end);
+
+/**
+ * @brief Continues a MSPv2 checksum
+ * @param crc Checksum value from which to start calculations
+ * @param b Single byte to use in the checksum calculation
+ * @return uint8_t checksum
+ */
+uint8_t crcV2(uint8_t crc, const uint8_t b);
+
+/**
+ * @brief Continues a MSPv2 checksum
+ * @param crc Checksum value from which to start calculations
+ * @param begin Pointer to the first byte
+ * @param end Pointer past the last byte
+ * @return uint8_t checksum
+ */
+uint8_t crcV2(uint8_t crc, const uint8_t* begin, const uint8_t* end);
+
+/**
+ * @brief Appends a MSPv1 frame to a buffer. Payloads of 255 bytes or more
+ * are sent as jumbo frames.
+ * @param out Buffer receiving the frame
+ * @param direction Direction of the frame
+ * @param id Message ID, must be below 256
+ * @param payload Payload
+ */
+void appendFrameV1(ByteVector& out, const FrameDirection direction,
+                   const uint8_t id, const ByteVector& payload);
+
+/**
+ * @brief Appends a MSPv2 frame to a buffer
+ * @param out Buffer receiving the frame
+ * @param direction Direction of the frame
+ * @param id Message ID
+ * @param payload Payload of at most 65535 bytes
+ */
+void appendFrameV2(ByteVector& out, const FrameDirection direction,
+                   const uint16_t id, const ByteVector& payload);
+
+/**
+ * @brief Appends a MSPv2 frame which is tunnelled in a MSPv1 MSP_V2_FRAME
+ * frame to a buffer
+ * @param out Buffer receiving the frame
+ * @param direction Direction of the frame
+ * @param id Message ID
+ * @param payload Payload of at most 65529 bytes
+ */
+void appendFrameV2OverV1(ByteVector& out, const FrameDirection direction,
+                         const uint16_t id, const ByteVector& payload);
+
+/**
+ * @brief Reads the header of a candidate frame
+ * @param data Received data, starting with '$'
+ * @param size Number of bytes available
+ * @param header Set to the header once it is complete
+ * @return FRAME_INVALID if the data is no frame, FRAME_INCOMPLETE if the
+ * header is incomplete, FRAME_VALID once the header was read
+ */
+FrameCheck readFrameHeader(const uint8_t* data, const std::size_t size,
+                           FrameHeader& header);
+
+/**
+ * @brief Checks that a frame is complete and its checksum is correct
+ * @param data Received data, starting with '$'
+ * @param size Number of bytes available
+ * @param header Header read by readFrameHeader()
+ * @return FRAME_INCOMPLETE, FRAME_CRC_ERROR or FRAME_VALID
+ */
+FrameCheck checkFramePayload(const uint8_t* data, const std::size_t size,
+                             const FrameHeader& header);
+
+/**
+ * @brief Locates the MSPv2 message tunnelled in the payload of a MSPv1
+ * MSP_V2_FRAME frame
+ * @param payload Payload of the MSPv1 frame
+ * @param size Size of the payload
+ * @param id Set to the ID of the inner message
+ * @param inner_size Set to the size of the inner payload, which starts 5
+ * bytes into the payload
+ * @return FRAME_INVALID if the sizes do not match, FRAME_CRC_ERROR if the
+ * inner checksum is wrong, FRAME_VALID otherwise
+ */
+FrameCheck readTunnelledFrame(const uint8_t* payload, const std::size_t size,
+                              uint16_t& id, std::size_t& inner_size);
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // FRAMING_HPP
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 #include "ByteVector.hpp"
+#include "ByteView.hpp"
 #include "FirmwareVariants.hpp"
 
 namespace msp {
@@ -46,7 +47,19 @@ public:
     FirmwareVariant getFirmwareVariant() const { return fw_variant; }
 
     /**
-     * @brief Decode message contents from a ByteVector
+     * @brief Decode message contents from a ByteView without copying the data.
+     * The default implementation copies the data and forwards it to the
+     * ByteVector overload.
+     * @param data Source of data
+     * @returns True on success
+     */
+    virtual bool decode(const ByteView& data) {
+        return decode(ByteVector(data.begin(), data.end()));
+    }
+
+    /**
+     * @brief Decode message contents from a ByteVector. Kept for message types
+     * which have not been ported to the ByteView overload.
      * @param data Source of data
      * @returns False. Override methods should return true on success
      */
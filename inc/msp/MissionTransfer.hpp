@@ -0,0 +1,160 @@
+#ifndef MISSION_TRANSFER_HPP
+#define MISSION_TRANSFER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "Client.hpp"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+/**
+ * @brief Waypoint of a mission as stored by the flight controller
+ */
+struct Waypoint {
+    uint8_t action = 1;  ///<! INAV: 1 = waypoint, 4 = RTH, 6 = jump, 8 = land
+    int32_t lat    = 0;  ///<! latitude in 1e-7 degree
+    int32_t lon    = 0;  ///<! longitude in 1e-7 degree
+    int32_t alt    = 0;  ///<! altitude in cm
+    uint16_t p1    = 0;  ///<! heading (MultiWii) or action parameter (INAV)
+    uint16_t p2    = 0;  ///<! stay time (MultiWii) or action parameter (INAV)
+    uint16_t p3    = 0;  ///<! action parameter (INAV only)
+    uint8_t flag   = 0;  ///<! 0xA5 marks the last waypoint of a mission
+
+    bool operator==(const Waypoint& other) const {
+        return action == other.action && lat == other.lat &&
+               lon == other.lon && alt == other.alt && p1 == other.p1 &&
+               p2 == other.p2 && p3 == other.p3 && flag == other.flag;
+    }
+
+    bool operator!=(const Waypoint& other) const { return !(*this == other); }
+};
+
+typedef std::vector<Waypoint> Mission;
+
+/**
+ * @brief Settings of a mission transfer
+ */
+struct MissionTransferOptions {
+    // maximum number of waypoints in flight
+    std::size_t window = 8;
+    // time to wait for the read-back of a single waypoint (in seconds)
+    double timeout = 0.5;
+    // number of additional rounds for waypoints which failed
+    std::size_t max_retries = 3;
+    // store the mission in the non-volatile memory after the upload
+    bool save = true;
+    // time to wait for the flight controller to store the mission
+    double save_timeout = 2.0;
+};
+
+/**
+ * @brief Outcome of a mission transfer
+ */
+struct MissionTransferReport {
+    bool success          = false;  ///<! all waypoints transferred and verified
+    bool saved            = false;  ///<! mission stored in non-volatile memory
+    double duration       = 0;      ///<! time of the transfer in seconds
+    std::size_t waypoints = 0;      ///<! number of waypoints of the mission
+    std::size_t requests  = 0;      ///<! number of frames sent
+    std::size_t retries   = 0;      ///<! number of waypoints transferred again
+    std::size_t rounds    = 0;      ///<! number of passes over the mission
+    std::vector<std::size_t> failed;  ///<! indices which could not be verified
+};
+
+/**
+ * @brief Transfers waypoint missions with a sliding window. Every waypoint
+ * is written with MSP_SET_WP and immediately read back with MSP_WP, without
+ * waiting for the previous waypoint. The flight controller handles requests
+ * in order, so the read-back confirms the write. Waypoints which are missing
+ * or differ are transferred again in the next round, then the mission is
+ * committed with MSP_WP_MISSION_SAVE.
+ */
+class MissionTransfer {
+public:
+    /**
+     * @brief MissionTransfer constructor
+     * @param client Started client which is connected to the flight controller
+     */
+    explicit MissionTransfer(msp::client::Client& client);
+
+    /**
+     * @brief Uploads and verifies a mission. The flag of the last waypoint
+     * is set to 0xA5, all other flags are cleared.
+     * @param mission Waypoints in order, the first one becomes number 1
+     * @param options Settings of the transfer
+     * @return Report of the transfer
+     */
+    MissionTransferReport upload(
+        const Mission& mission,
+        const MissionTransferOptions& options = MissionTransferOptions());
+
+    /**
+     * @brief Downloads the mission which is stored by the flight controller
+     * @param mission Receives the waypoints
+     * @param options Settings of the transfer, save is ignored
+     * @return Report of the transfer
+     */
+    MissionTransferReport download(
+        Mission& mission,
+        const MissionTransferOptions& options = MissionTransferOptions());
+
+private:
+    struct Pending {
+        std::size_t index;  // index of the waypoint (0 based)
+        bool write;         // write the waypoint before reading it back
+    };
+
+    /**
+     * @brief Pipelined pass over a set of waypoints
+     * @param pending Waypoints in ascending order
+     * @param upload Compare the read-back with the mission
+     * @param options Settings of the transfer
+     * @param report Counts the requests
+     * @return Waypoints which were not confirmed. A waypoint which differs
+     * has to be written again, a lost read-back is only repeated.
+     */
+    std::vector<Pending> transferRound(const std::vector<Pending>& pending,
+                                       const bool upload,
+                                       const MissionTransferOptions& options,
+                                       MissionTransferReport& report);
+
+    void onWaypoint(const msp::msg::WayPoint& wp);
+
+    bool sendWaypoint(const std::size_t index);
+
+    bool requestWaypoint(const std::size_t index);
+
+    msp::client::Client& client_;
+
+    // mission to upload, or received waypoints of a download
+    Mission mission_;
+
+    // read-back responses, keyed by the waypoint number
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint8_t, Waypoint> received_;
+};
+
+}  // namespace fcu
+
+inline std::ostream& operator<<(std::ostream& s,
+                                const fcu::MissionTransferReport& report) {
+    s << "#Mission transfer:" << std::endl;
+    s << " Success: " << (report.success ? "yes" : "no") << std::endl;
+    s << " Saved: " << (report.saved ? "yes" : "no") << std::endl;
+    s << " Waypoints: " << report.waypoints << std::endl;
+    s << " Duration: " << report.duration * 1000 << " ms" << std::endl;
+    s << " Requests: " << report.requests << std::endl;
+    s << " Retries: " << report.retries << " in " << report.rounds
+      << " rounds" << std::endl;
+    s << " Failed: " << report.failed.size() << std::endl;
+    return s;
+}
+
+#endif  // MISSION_TRANSFER_HPP
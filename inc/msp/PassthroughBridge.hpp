@@ -0,0 +1,164 @@
+#ifndef PASSTHROUGH_BRIDGE_HPP
+#define PASSTHROUGH_BRIDGE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Client.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Modes of MSP_SET_4WAY_IF (MSP_SET_PASSTHROUGH in Betaflight), set as
+ * msp::msg::Set4WayIF::esc_mode
+ */
+enum class PassthroughMode : uint8_t {
+    SERIAL_FUNCTION = 0xFD,  ///<! serial port with the function in port index
+    SERIAL_ID       = 0xFE,  ///<! serial port with the identifier in port index
+    ESC_4WAY        = 0xFF   ///<! 4-way interface to the ESCs
+};
+
+/**
+ * @brief Splices the raw byte pipe of a Client in passthrough to a pseudo
+ * terminal or a TCP socket, so that ESC configurators and other tools talk
+ * to the bridged device through the existing connection. The bytes from the
+ * device are written to the peer by the receiving thread of the client
+ * without copying them, the bytes from the peer are read by a thread of the
+ * bridge (msp-bridge). Only supported on Linux.
+ */
+class PassthroughBridge {
+public:
+    /**
+     * @brief PassthroughBridge constructor
+     * @param client Started client which is connected to the flight controller
+     */
+    explicit PassthroughBridge(Client& client);
+
+    /**
+     * @brief PassthroughBridge destructor, stops the bridge
+     */
+    ~PassthroughBridge();
+
+    /**
+     * @brief Use a new pseudo terminal as the peer. Must be called while the
+     * bridge is stopped.
+     * @return Path of the terminal which is opened by the tool, empty on
+     * failure or while the bridge is running
+     */
+    std::string openPty();
+
+    /**
+     * @brief Use a TCP socket as the peer. One connection is accepted at a
+     * time, a new one replaces the previous one. Must be called while the
+     * bridge is stopped.
+     * @param port TCP port, 0 picks a free port
+     * @param address Local address to listen on
+     * @return Port the bridge is listening on, 0 on failure or while the
+     * bridge is running
+     */
+    uint16_t listenTcp(const uint16_t port = 0,
+                       const std::string& address = "127.0.0.1");
+
+    /**
+     * @brief Send the request to enter the passthrough mode (e.g. a
+     * msp::msg::Set4WayIF) and start forwarding
+     * @param request Request to enter the passthrough mode
+     * @param timeout Maximum time to wait for the response (in seconds)
+     * @return True if the bridge is running
+     */
+    bool start(msp::Message& request, const double timeout = 1.0);
+
+    /**
+     * @brief Start forwarding, the flight controller already is in a
+     * passthrough mode
+     * @return True if the bridge is running
+     */
+    bool start();
+
+    /**
+     * @brief Stop forwarding, close the peer and switch the client back to
+     * MSP
+     */
+    void stop();
+
+    /**
+     * @brief Query the number of bytes forwarded to the device
+     * @return Number of bytes
+     */
+    uint64_t bytesToDevice() const { return to_device_; }
+
+    /**
+     * @brief Query the number of bytes forwarded from the device
+     * @return Number of bytes
+     */
+    uint64_t bytesFromDevice() const { return from_device_; }
+
+    /**
+     * @brief Query the number of bytes from the device which were dropped,
+     * because no peer was connected or the peer fell more than 64 KiB behind
+     * @return Number of bytes
+     */
+    uint64_t bytesDropped() const { return dropped_; }
+
+private:
+    /**
+     * @brief Forwards bytes from the device to the peer, runs on the receiving
+     * thread of the client and never blocks. Bytes which the peer cannot take
+     * right away are queued for the bridge thread.
+     * @param data Received bytes
+     * @param size Number of bytes
+     */
+    void onDeviceData(const uint8_t* data, const std::size_t size);
+
+    /**
+     * @brief Writes to the peer without blocking. Called with mutex_peer_
+     * held.
+     * @param data Bytes to write
+     * @param size Number of bytes
+     * @return Number of bytes written
+     */
+    std::size_t writePeer(const uint8_t* data, const std::size_t size);
+
+    /**
+     * @brief Drops the queued bytes, e.g. when the peer changes. Called with
+     * mutex_peer_ held.
+     */
+    void clearBacklog();
+
+    void run();
+
+    void closeFds();
+
+    Client& client_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // pseudo terminal, the slave stays open so that the master never sees
+    // a hangup while no tool has the terminal open
+    int pty_master_;
+    int pty_slave_;
+
+    // TCP socket
+    int listen_fd_;
+    // the terminal and the socket are only replaced while the bridge is
+    // stopped, the bridge thread uses them without a lock
+
+    // peer which receives the bytes from the device, guarded by mutex_peer_
+    std::mutex mutex_peer_;
+    int peer_fd_;
+    // bytes from the device which the peer did not take yet, guarded by
+    // mutex_peer_
+    ByteVector backlog_;
+
+    std::atomic<uint64_t> to_device_;
+    std::atomic<uint64_t> from_device_;
+    std::atomic<uint64_t> dropped_;
+};
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // PASSTHROUGH_BRIDGE_HPP
@@ -7,7 +7,7 @@
 #include <memory>
 #include <mutex>
 #include <thread>
-#include <pthread.h>
+#include "ThreadPolicy.hpp"
 
 namespace msp {
 
@@ -50,7 +50,15 @@ public:
     void setPeriod(const double& period_seconds);
 
     /**
-     * @brief Updates the timer thread to Realtime priority
+     * @brief Sets the scheduling and placement of the timer thread. The
+     * policy is applied immediately and whenever the thread is restarted.
+     * @param policy Policy of the timer thread
+     * @return True if the policy was applied, or will be applied on start
+     */
+    bool setThreadPolicy(const ThreadPolicy& policy);
+
+    /**
+     * @brief Updates the timer thread to Realtime priority (SCHED_FIFO, 80)
      * @return True on success
      */
     bool setRealtimePriority();
@@ -61,6 +69,8 @@ private:
     std::chrono::duration<size_t, std::micro> period_us;
     std::timed_mutex mutex_timer;
     std::chrono::steady_clock::time_point tstart;
+    std::mutex mutex_policy;
+    ThreadPolicy policy_;
 
     std::atomic_flag running_ = ATOMIC_FLAG_INIT;
 };
@@ -0,0 +1,256 @@
+#ifndef PROXY_HPP
+#define PROXY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ByteVector.hpp"
+#include "Client.hpp"
+#include "Executor.hpp"
+#include "ThreadPolicy.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Settings of a multiplexing proxy
+ */
+struct ProxyOptions {
+    // maximum number of requests on the link at the same time, each one
+    // occupies a worker thread while it waits for its response
+    std::size_t max_in_flight = 4;
+    // time to wait for a response including retransmissions (in seconds),
+    // unanswered requests are answered with an error frame
+    double timeout = 1.0;
+    // maximum number of queued requests per connection, further requests
+    // are answered with an error frame
+    std::size_t max_queue = 64;
+    // scheduling of the proxy thread (msp-proxy) and the workers
+    // (msp-pool-N)
+    ThreadPolicy policy;
+};
+
+/**
+ * @brief Counters of a proxy
+ */
+struct ProxyStats {
+    uint64_t connections = 0;  ///<! connections accepted so far
+    uint64_t requests    = 0;  ///<! requests received from the connections
+    uint64_t forwarded   = 0;  ///<! requests sent to the flight controller
+    uint64_t merged      = 0;  ///<! requests answered by another's response
+    uint64_t failed      = 0;  ///<! requests answered with an error frame
+    uint64_t rejected    = 0;  ///<! requests dropped because of a full queue
+    uint64_t corrupt     = 0;  ///<! frames with a wrong checksum
+};
+
+/**
+ * @brief Shares the link of a Client among many local programs, e.g.
+ * configurators, an autopilot and diagnostic tools. The programs connect to
+ * Unix domain or TCP sockets and talk MSP (v1, v2 or v2 tunneled over v1) as
+ * if they were connected to the flight controller.
+ *
+ * Requests are queued per connection and scheduled by the priority of the
+ * socket the connection came in on, connections of the same priority take
+ * turns. Requests of the same message ID are sent one after another, so that
+ * every response is routed back to the request which caused it, requests of
+ * different IDs are pipelined. A request without payload for a read ID (see
+ * Client::markRead()) which is on the link without payload is merged into it
+ * and answered by the same response, so that polls of several programs are
+ * sent only once. Only supported on Linux.
+ */
+class Proxy {
+public:
+    /**
+     * @brief Proxy constructor
+     * @param client Started client which is connected to the flight controller
+     * @param options Scheduling settings
+     */
+    explicit Proxy(Client& client,
+                   const ProxyOptions& options = ProxyOptions());
+
+    /**
+     * @brief Proxy destructor, stops the proxy
+     */
+    ~Proxy();
+
+    /**
+     * @brief Accept connections on a Unix domain socket. An existing socket
+     * at the path is replaced, any other file makes the call fail.
+     * @param path Path of the socket
+     * @param priority Priority of the requests of the connections, higher
+     * values are sent first
+     * @return True on success
+     */
+    bool listenUnix(const std::string& path, const int priority = 0);
+
+    /**
+     * @brief Accept connections on a TCP socket
+     * @param port TCP port, 0 picks a free port
+     * @param address Local address to listen on
+     * @param priority Priority of the requests of the connections, higher
+     * values are sent first
+     * @return Port the proxy is listening on, 0 on failure
+     */
+    uint16_t listenTcp(const uint16_t port = 0,
+                       const std::string& address = "127.0.0.1",
+                       const int priority         = 0);
+
+    /**
+     * @brief Start accepting connections and forwarding requests
+     * @return True if the proxy is running
+     */
+    bool start();
+
+    /**
+     * @brief Stop forwarding, wait for the requests on the link and close all
+     * sockets
+     */
+    void stop();
+
+    /**
+     * @brief Check if the proxy is running
+     * @return True if the proxy is running
+     */
+    bool isRunning() const { return running_; }
+
+    /**
+     * @brief Query the number of open connections
+     * @return Number of connections
+     */
+    std::size_t connections();
+
+    /**
+     * @brief Query the counters of the proxy
+     * @return Snapshot of the counters
+     */
+    ProxyStats stats();
+
+private:
+    /**
+     * @brief Framing of a request, the response uses the same framing
+     */
+    enum class Framing : uint8_t { V1, V2_OVER_V1, V2 };
+
+    struct Request {
+        uint16_t id     = 0;
+        Framing framing = Framing::V1;
+        ByteVector payload;
+    };
+
+    struct Connection {
+        int fd       = -1;
+        int priority = 0;
+        bool closed  = false;
+        // received bytes which do not form a complete frame yet
+        ByteVector input;
+        // requests in arrival order, not scheduled yet
+        std::deque<Request> queue;
+        // encoded responses which were not written yet
+        ByteVector output;
+    };
+
+    /**
+     * @brief Request on the link, answered to all its waiters
+     */
+    struct Job {
+        uint16_t id = 0;
+        ByteVector payload;
+        std::vector<std::pair<std::shared_ptr<Connection>, Framing>> waiters;
+    };
+
+    struct Listener {
+        int fd       = -1;
+        int priority = 0;
+        std::string path;  ///<! path of a Unix domain socket, to be removed
+    };
+
+    void run();
+
+    void accept(const Listener& listener);
+
+    void receive(const std::shared_ptr<Connection>& connection);
+
+    void flush(const std::shared_ptr<Connection>& connection);
+
+    /**
+     * @brief Appends a response in the framing of its request
+     * @param out Destination
+     * @param framing Framing of the request
+     * @param error True to send an error frame without payload
+     * @param id Message ID
+     * @param payload Payload of the response
+     */
+    static void respond(ByteVector& out, const Framing framing,
+                        const bool error, const uint16_t id,
+                        const ByteVector& payload);
+
+    /**
+     * @brief Extracts the complete requests from the input of a connection
+     * @param connection Connection
+     */
+    void parse(Connection& connection);
+
+    /**
+     * @brief Moves queued requests to the link by priority and in turns, and
+     * merges requests into running jobs. Called with mutex_ held.
+     */
+    void schedule();
+
+    /**
+     * @brief Sends a job to the flight controller and answers its waiters,
+     * runs on a worker thread
+     * @param job Job
+     */
+    void execute(const std::shared_ptr<Job>& job);
+
+    /**
+     * @brief Wakes up the proxy thread
+     */
+    void notify();
+
+    void closeAll();
+
+    Client& client_;
+    const ProxyOptions options_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    // eventfd waking up the proxy thread when responses are ready
+    int wake_fd_;
+    std::unique_ptr<ThreadPool> pool_;
+
+    // guards everything below
+    std::mutex mutex_;
+    std::vector<Listener> listeners_;
+    // connections in their turn order, a connection which was served moves to
+    // the back
+    std::vector<std::shared_ptr<Connection>> connections_;
+    // jobs on the link, at most one per message ID
+    std::map<uint16_t, std::shared_ptr<Job>> jobs_;
+    ProxyStats stats_;
+};
+
+}  // namespace client
+}  // namespace msp
+
+inline std::ostream& operator<<(std::ostream& s,
+                                const msp::client::ProxyStats& stats) {
+    s << "#Proxy:" << std::endl;
+    s << " Connections: " << stats.connections << std::endl;
+    s << " Requests: " << stats.requests << std::endl;
+    s << " Forwarded: " << stats.forwarded << std::endl;
+    s << " Merged: " << stats.merged << std::endl;
+    s << " Failed: " << stats.failed << std::endl;
+    s << " Rejected: " << stats.rejected << std::endl;
+    s << " Corrupt: " << stats.corrupt << std::endl;
+    return s;
+}
+
+#endif  // PROXY_HPP
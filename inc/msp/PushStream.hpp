@@ -0,0 +1,192 @@
+#ifndef PUSH_STREAM_HPP
+#define PUSH_STREAM_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include "ByteView.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Counters of a push stream
+ */
+struct PushStreamStats {
+    uint64_t received      = 0;  ///<! frames decoded into the ring
+    uint64_t dropped       = 0;  ///<! frames discarded, the ring was full
+    uint64_t decode_errors = 0;  ///<! frames with a malformed payload
+    double rate            = 0;  ///<! smoothed arrival rate in Hz
+};
+
+class PushStreamBase {
+public:
+    PushStreamBase() {}
+
+    virtual ~PushStreamBase() {}
+
+    /**
+     * @brief Decodes an unsolicited frame into the next free ring slot. Must
+     * only be called by the thread which receives the frames.
+     * @param data Payload of the frame
+     * @return True if the frame was decoded and stored
+     */
+    virtual bool push(const ByteView& data) = 0;
+
+    /**
+     * @brief Number of samples which can be read without blocking
+     * @return Number of buffered samples
+     */
+    virtual std::size_t available() const = 0;
+
+    /**
+     * @brief Maximum number of buffered samples
+     * @return Number of ring slots
+     */
+    virtual std::size_t capacity() const = 0;
+
+    /**
+     * @brief Query the counters of the stream
+     * @return Snapshot of the counters
+     */
+    PushStreamStats stats() const {
+        PushStreamStats s;
+        s.received      = received_.load(std::memory_order_relaxed);
+        s.dropped       = dropped_.load(std::memory_order_relaxed);
+        s.decode_errors = decode_errors_.load(std::memory_order_relaxed);
+        s.rate          = rate_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+protected:
+    /**
+     * @brief Updates the arrival rate estimate with the current time
+     */
+    void updateRate() {
+        const std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        if(last_arrival_ != std::chrono::steady_clock::time_point()) {
+            const double dt =
+                std::chrono::duration<double>(now - last_arrival_).count();
+            if(dt > 0) {
+                // exponential moving average over roughly 16 frames
+                const double r = rate_.load(std::memory_order_relaxed);
+                rate_.store((r > 0) ? r + (1.0 / dt - r) / 16 : 1.0 / dt,
+                            std::memory_order_relaxed);
+            }
+        }
+        last_arrival_ = now;
+    }
+
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> decode_errors_{0};
+    std::atomic<double> rate_{0};
+    std::chrono::steady_clock::time_point last_arrival_;
+};
+
+/**
+ * @brief Lock-free ring of push telemetry samples with a single producer (the
+ * receiving thread of the Client) and a single consumer. Samples are decoded
+ * directly into preallocated slots, no memory is allocated after
+ * construction. If the consumer does not keep up, new samples are dropped and
+ * counted until slots become free again.
+ * @tparam T Sample type. Must be trivially copyable and provide a method
+ * bool decode(const ByteView&).
+ */
+template <class T> class PushStream : public PushStreamBase {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "push samples must be trivially copyable");
+
+public:
+    typedef T sample_type;
+
+    /**
+     * @brief PushStream constructor
+     * @param capacity Minimum number of buffered samples, rounded up to the
+     * next power of two
+     */
+    explicit PushStream(const std::size_t capacity) :
+        mask_(roundUp(capacity) - 1),
+        slots_(new T[mask_ + 1]) {}
+
+    virtual bool push(const ByteView& data) override {
+        updateRate();
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if(head - tail_.load(std::memory_order_acquire) > mask_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        T& slot = slots_[head & mask_];
+        slot    = T();
+        if(!slot.decode(data)) {
+            decode_errors_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        head_.store(head + 1, std::memory_order_release);
+        received_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    virtual std::size_t available() const override {
+        return head_.load(std::memory_order_acquire) -
+               tail_.load(std::memory_order_relaxed);
+    }
+
+    virtual std::size_t capacity() const override { return mask_ + 1; }
+
+    /**
+     * @brief Reads the oldest buffered samples. Must only be called by a
+     * single consumer thread.
+     * @param out Destination of at least n samples
+     * @param n Maximum number of samples to read
+     * @return Number of samples copied to out
+     */
+    std::size_t read(T* out, const std::size_t n) {
+        const std::size_t tail  = tail_.load(std::memory_order_relaxed);
+        const std::size_t avail = head_.load(std::memory_order_acquire) - tail;
+        const std::size_t count = (n < avail) ? n : avail;
+        for(std::size_t i = 0; i < count; ++i) {
+            out[i] = slots_[(tail + i) & mask_];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Reads the oldest buffered sample
+     * @param out Destination of the sample
+     * @return True if a sample was available
+     */
+    bool read(T& out) { return read(&out, 1) == 1; }
+
+    /**
+     * @brief Discards all buffered samples. Must only be called by the
+     * consumer thread.
+     */
+    void clear() {
+        tail_.store(head_.load(std::memory_order_acquire),
+                    std::memory_order_release);
+    }
+
+private:
+    static std::size_t roundUp(const std::size_t n) {
+        std::size_t c = 1;
+        while(c < n) c <<= 1;
+        return c;
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    // producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // PUSH_STREAM_HPP
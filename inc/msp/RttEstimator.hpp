@@ -0,0 +1,106 @@
+#ifndef RTT_ESTIMATOR_HPP
+#define RTT_ESTIMATOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Timeouts and retransmission of requests
+ */
+struct RetryPolicy {
+    // derive the timeout of every attempt from the measured round trip time,
+    // otherwise every attempt waits max_timeout
+    bool adaptive = false;
+    // number of retransmissions after the first attempt
+    std::size_t max_retries = 0;
+    // factor applied to the timeout after every retransmission
+    double backoff = 2.0;
+    // bounds of the timeout of a single attempt (in seconds)
+    double min_timeout = 0.005;
+    double max_timeout = 1.0;
+    // keep separate estimates for requests with different frame sizes
+    bool per_size = false;
+};
+
+/**
+ * @brief Smoothed round trip time and its variation (RFC 6298)
+ */
+class RttEstimator {
+public:
+    /**
+     * @brief RttEstimator constructor
+     * @param alpha Gain of the smoothed round trip time
+     * @param beta Gain of the round trip time variation
+     */
+    explicit RttEstimator(const double alpha = 0.125,
+                          const double beta  = 0.25) :
+        alpha_(alpha),
+        beta_(beta),
+        srtt_(0),
+        rttvar_(0),
+        samples_(0) {}
+
+    /**
+     * @brief Adds a round trip time measurement. Only requests which have not
+     * been retransmitted must be measured, since the response of a
+     * retransmitted request cannot be matched to an attempt.
+     * @param rtt Round trip time in seconds
+     */
+    void update(const double rtt) {
+        if(samples_ == 0) {
+            srtt_   = rtt;
+            rttvar_ = rtt / 2;
+        }
+        else {
+            rttvar_ = (1 - beta_) * rttvar_ + beta_ * std::abs(srtt_ - rtt);
+            srtt_   = (1 - alpha_) * srtt_ + alpha_ * rtt;
+        }
+        samples_++;
+    }
+
+    /**
+     * @brief Computes the retransmission timeout, SRTT + 4 * RTTVAR
+     * @param min_timeout Lower bound (in seconds)
+     * @param max_timeout Upper bound, also used without measurements
+     * @return Timeout in seconds
+     */
+    double timeout(const double min_timeout, const double max_timeout) const {
+        if(samples_ == 0) return max_timeout;
+        return std::min(std::max(srtt_ + 4 * rttvar_, min_timeout),
+                        max_timeout);
+    }
+
+    /**
+     * @brief Query the smoothed round trip time
+     * @return Round trip time in seconds
+     */
+    double srtt() const { return srtt_; }
+
+    /**
+     * @brief Query the variation of the round trip time
+     * @return Variation in seconds
+     */
+    double rttvar() const { return rttvar_; }
+
+    /**
+     * @brief Query the number of measurements
+     * @return Number of measurements
+     */
+    std::size_t samples() const { return samples_; }
+
+private:
+    double alpha_;
+    double beta_;
+    double srtt_;
+    double rttvar_;
+    std::size_t samples_;
+};
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // RTT_ESTIMATOR_HPP
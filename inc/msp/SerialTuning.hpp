@@ -0,0 +1,82 @@
+#ifndef SERIAL_TUNING_HPP
+#define SERIAL_TUNING_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Low latency settings of a serial device, which are not covered by
+ * the asio serial port options. Only supported on Linux.
+ */
+struct SerialTuning {
+    // set ASYNC_LOW_LATENCY and a 1 ms latency timer for FTDI adapters
+    bool low_latency = true;
+    // minimum number of bytes and timeout (in 0.1 s) of a read, -1 keeps the
+    // setting of the driver. VMIN = 1 and VTIME = 0 return every byte as
+    // soon as it arrives. VMIN = 0 lets an idle read return no data, which
+    // event driven readers like asio take as end of file.
+    int vmin  = 1;
+    int vtime = 0;
+    // size of the transmit FIFO of the UART, 0 keeps the setting of the driver
+    int xmit_fifo_size = 0;
+    // discard data which was received before the port was opened
+    bool flush_input = true;
+};
+
+/**
+ * @brief Effective settings of a serial device, -1 if unknown
+ */
+struct SerialStatus {
+    bool low_latency   = false;  ///<! ASYNC_LOW_LATENCY is set
+    int latency_timer  = -1;     ///<! latency timer of FTDI adapters in ms
+    long baudrate      = -1;     ///<! output baudrate
+    int vmin           = -1;     ///<! minimum number of bytes of a read
+    int vtime          = -1;     ///<! read timeout in 0.1 s
+    int xmit_fifo_size = -1;     ///<! transmit FIFO size of the UART
+};
+
+/**
+ * @brief Applies the low latency settings to an open serial device
+ * @param fd File descriptor of the device
+ * @param device Path to the device, used to find the latency timer in sysfs
+ * @param tuning Settings to apply
+ * @return True if all settings which are supported by the device were set
+ */
+bool applySerialTuning(const int fd, const std::string& device,
+                       const SerialTuning& tuning);
+
+/**
+ * @brief Sets an arbitrary baudrate (e.g. 1500000) via termios2 and BOTHER
+ * @param fd File descriptor of the device
+ * @param baudrate Baudrate in bit/s
+ * @return True on success
+ */
+bool setCustomBaudrate(const int fd, const size_t baudrate);
+
+/**
+ * @brief Queries the effective settings of a serial device
+ * @param fd File descriptor of the device
+ * @param device Path to the device, used to find the latency timer in sysfs
+ * @return Settings of the device
+ */
+SerialStatus querySerialStatus(const int fd, const std::string& device);
+
+}  // namespace client
+}  // namespace msp
+
+inline std::ostream& operator<<(std::ostream& s,
+                                const msp::client::SerialStatus& status) {
+    s << "#Serial port:" << std::endl;
+    s << " Baudrate: " << status.baudrate << std::endl;
+    s << " Low latency: " << (status.low_latency ? "yes" : "no") << std::endl;
+    s << " Latency timer: " << status.latency_timer << " ms" << std::endl;
+    s << " VMIN/VTIME: " << status.vmin << "/" << status.vtime << std::endl;
+    s << " TX FIFO: " << status.xmit_fifo_size << std::endl;
+    return s;
+}
+
+#endif  // SERIAL_TUNING_HPP
@@ -0,0 +1,43 @@
+#ifndef SOCKET_HPP
+#define SOCKET_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Switches a file descriptor to non-blocking I/O. Only supported on
+ * Linux.
+ * @param fd File descriptor
+ * @return True on success
+ */
+bool setNonBlocking(const int fd);
+
+/**
+ * @brief Opens a non-blocking TCP socket which accepts connections. Only
+ * supported on Linux.
+ * @param port TCP port, 0 picks a free port
+ * @param address Local address to listen on
+ * @param backlog Maximum number of connections waiting to be accepted
+ * @param bound_port Set to the port the socket is listening on
+ * @return File descriptor of the socket, -1 on failure
+ */
+int listenTcpSocket(const uint16_t port, const std::string& address,
+                    const int backlog, uint16_t& bound_port);
+
+/**
+ * @brief Accepts a connection of a listening socket as non-blocking socket.
+ * TCP connections send small frames without waiting for more data. Only
+ * supported on Linux.
+ * @param listen_fd Listening socket
+ * @param tcp True if the socket is a TCP socket
+ * @return File descriptor of the connection, -1 on failure
+ */
+int acceptSocket(const int listen_fd, const bool tcp);
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // SOCKET_HPP
@@ -1,21 +1,30 @@
 #ifndef SUBSCRIPTION_HPP
 #define SUBSCRIPTION_HPP
 
+#include <chrono>
 #include <functional>
-#include "Client.hpp"
+#include <mutex>
+#include <vector>
+#include "ByteView.hpp"
+#include "Executor.hpp"
 #include "Message.hpp"
 #include "PeriodicTimer.hpp"
 
 namespace msp {
 namespace client {
 
+/**
+ * @brief Identifies a listener of a subscription, 0 is never used
+ */
+typedef std::size_t ListenerId;
+
 class SubscriptionBase {
 public:
     SubscriptionBase() {}
 
     virtual ~SubscriptionBase() {}
 
-    virtual void decode(msp::ByteVector& data) const = 0;
+    virtual void decode(const msp::ByteView& data) const = 0;
 
     virtual void makeRequest() const = 0;
 
@@ -23,6 +32,30 @@ public:
 
     virtual const msp::Message& getMsgObject() const = 0;
 
+    /**
+     * @brief Removes a listener. The request period is reduced to the
+     * smallest period of the remaining listeners.
+     * @param listener ID of the listener
+     * @returns True if the listener was removed
+     */
+    virtual bool removeListener(const ListenerId& listener) = 0;
+
+    /**
+     * @brief Changes the minimum period between two callbacks of a listener
+     * and updates the request period accordingly
+     * @param listener ID of the listener
+     * @param period Period in seconds, 0 means every received message
+     * @returns True if the listener exists
+     */
+    virtual bool setListenerPeriod(const ListenerId& listener,
+                                   const double& period) = 0;
+
+    /**
+     * @brief Counts the listeners of the subscription
+     * @returns Number of listeners
+     */
+    virtual std::size_t listenerCount() const = 0;
+
     /**
      * @brief Checks to see if the subscription fires automatically
      * @returns True if the request happens automatically
@@ -37,6 +70,12 @@ public:
      */
     bool hasTimer() const { return timer_ ? true : false; }
 
+    /**
+     * @brief Queries the period of the automatic requests
+     * @returns Period in seconds, 0 if requests are not sent automatically
+     */
+    double getTimerPeriod() const { return timer_ ? timer_->getPeriod() : 0.0; }
+
     /**
      * @brief Start the timer for automatic execution
      * @returns True if the timer starts successfully
@@ -61,6 +100,7 @@ public:
             timer_ = std::unique_ptr<PeriodicTimer>(new PeriodicTimer(
                 std::bind(&SubscriptionBase::makeRequest, this),
                 period_seconds));
+            timer_->setThreadPolicy(timer_policy_);
             this->timer_->start();
         }
     }
@@ -77,26 +117,50 @@ public:
             timer_ = std::unique_ptr<PeriodicTimer>(new PeriodicTimer(
                 std::bind(&SubscriptionBase::makeRequest, this),
                 1.0 / rate_hz));
+            timer_->setThreadPolicy(timer_policy_);
             this->timer_->start();
         }
     }
 
     /**
-     * @brief Updates the timer thread to Realtime priority
+     * @brief Sets the scheduling and placement of the timer thread, also if
+     * the timer is created later
+     * @param policy Policy of the timer thread
      * @return True on success
      */
-    bool setRealtimePriority() {
+    bool setThreadPolicy(const ThreadPolicy& policy) {
+        timer_policy_ = policy;
         if(timer_) {
-            return timer_->setRealtimePriority();
+            return timer_->setThreadPolicy(policy);
         }
 
         return true;
     }
 
+    /**
+     * @brief Updates the timer thread to Realtime priority
+     * @return True on success
+     */
+    bool setRealtimePriority() {
+        return setThreadPolicy(ThreadPolicy::realtime());
+    }
+
 protected:
     std::unique_ptr<PeriodicTimer> timer_;
+    ThreadPolicy timer_policy_;
 };
 
+/**
+ * @brief Subscription to a message ID with any number of listeners. Every
+ * received message is decoded once and handed to all listeners by const
+ * reference. Each listener has its own minimum period between two callbacks,
+ * and the request is sent with the smallest period of all listeners.
+ * Listeners with an executor are called through their own Strand, so their
+ * callbacks stay in order but do not block the receiving thread or other
+ * listeners.
+ * @note Inline callbacks must not add or remove listeners of their own
+ * subscription
+ */
 template <typename T> class Subscription : public SubscriptionBase {
 public:
     typedef std::function<void(const T&)> CallbackT;
@@ -105,7 +169,18 @@ public:
     /**
      * @brief Subscription constructor
      */
-    Subscription() {}
+    Subscription() : next_listener_(1) {}
+
+    /**
+     * @brief Subscription constructor without listeners
+     * @param send_callback Callback to execute periodically to send message
+     * @param io_object Object which is used for encoding/decoding data
+     */
+    Subscription(const CallbackM& send_callback,
+                 std::unique_ptr<T>&& io_object) :
+        send_callback_(send_callback),
+        io_object_(std::move(io_object)),
+        next_listener_(1) {}
 
     /**
      * @brief Subscription constructor setting all parameters
@@ -116,23 +191,101 @@ public:
      */
     Subscription(const CallbackT& recv_callback, const CallbackM& send_callback,
                  std::unique_ptr<T>&& io_object, const double& period = 0.0) :
-        recv_callback_(recv_callback),
         send_callback_(send_callback),
-        io_object_(std::move(io_object)) {
-        if(period > 0.0) {
-            timer_ = std::unique_ptr<PeriodicTimer>(new PeriodicTimer(
-                std::bind(&Subscription<T>::makeRequest, this), period));
-            this->timer_->start();
-        }
+        io_object_(std::move(io_object)),
+        next_listener_(1) {
+        addListener(recv_callback, period);
     }
 
+    /**
+     * @brief Subscription destructor, stops the timer before the members it
+     * uses are destroyed
+     */
+    virtual ~Subscription() { timer_.reset(); }
+
     /**
      * @brief Virtual method for decoding received data
      * @param data Data to be unpacked
      */
-    virtual void decode(msp::ByteVector& data) const override {
+    virtual void decode(const msp::ByteView& data) const override {
         io_object_->decode(data);
-        recv_callback_(*io_object_);
+        const std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        // copy of the message shared by all asynchronous callbacks
+        std::shared_ptr<const T> snapshot;
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        for(Listener& listener : listeners_) {
+            if(!listener.isDue(now)) continue;
+            listener.last_call = now;
+            if(!listener.callback || !*listener.callback) continue;
+            if(!listener.executor) {
+                (*listener.callback)(*io_object_);
+                continue;
+            }
+            if(!snapshot) snapshot = std::make_shared<const T>(*io_object_);
+            const std::shared_ptr<const CallbackT> callback = listener.callback;
+            listener.executor->post(
+                [callback, snapshot] { (*callback)(*snapshot); });
+        }
+    }
+
+    /**
+     * @brief Adds a listener and updates the request period
+     * @param recv_callback Callback to execute upon receipt of message
+     * @param period Minimum period between two callbacks in seconds, which is
+     * also the maximum request period. 0 means every received message without
+     * requesting it.
+     * @param executor Executor running the callbacks. The default (nullptr)
+     * calls them in the receiving thread. A Strand is used as given, other
+     * executors are wrapped in a new Strand for this listener.
+     * @returns ID of the new listener
+     */
+    ListenerId addListener(
+        const CallbackT& recv_callback, const double& period,
+        const std::shared_ptr<Executor>& executor = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        Listener listener;
+        listener.id       = next_listener_++;
+        listener.callback = std::make_shared<const CallbackT>(recv_callback);
+        listener.period   = period;
+        if(std::dynamic_pointer_cast<Strand>(executor)) {
+            listener.executor = executor;
+        }
+        else if(executor &&
+                !std::dynamic_pointer_cast<InlineExecutor>(executor)) {
+            listener.executor = std::make_shared<Strand>(executor);
+        }
+        listeners_.push_back(listener);
+        updateTimerPeriod();
+        return listener.id;
+    }
+
+    virtual bool removeListener(const ListenerId& listener) override {
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        for(auto it = listeners_.begin(); it != listeners_.end(); ++it) {
+            if(it->id != listener) continue;
+            listeners_.erase(it);
+            updateTimerPeriod();
+            return true;
+        }
+        return false;
+    }
+
+    virtual bool setListenerPeriod(const ListenerId& listener,
+                                   const double& period) override {
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        for(Listener& l : listeners_) {
+            if(l.id != listener) continue;
+            l.period = period;
+            updateTimerPeriod();
+            return true;
+        }
+        return false;
+    }
+
+    virtual std::size_t listenerCount() const override {
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        return listeners_.size();
     }
 
     /**
@@ -158,18 +311,25 @@ public:
     }
 
     /**
-     * @brief Sets the callback to be executed on success
+     * @brief Sets the callback of the first listener
      * @param recv_callback the callback to be executed
      */
     void setReceiveCallback(const CallbackT& recv_callback) const {
-        recv_callback_ = recv_callback;
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        if(!listeners_.empty())
+            listeners_.front().callback =
+                std::make_shared<const CallbackT>(recv_callback);
     }
 
     /**
-     * @brief Calls the receive callback if it exists
+     * @brief Calls the receive callbacks of all listeners
      */
     virtual void handleResponse() const override {
-        if(recv_callback_) recv_callback_(*io_object_);
+        std::lock_guard<std::mutex> lock(mutex_listeners_);
+        for(const Listener& listener : listeners_) {
+            if(listener.callback && *listener.callback)
+                (*listener.callback)(*io_object_);
+        }
     }
 
     /**
@@ -188,9 +348,45 @@ public:
     }
 
 protected:
-    CallbackT recv_callback_;
+    struct Listener {
+        ListenerId id;
+        // shared with queued asynchronous calls
+        std::shared_ptr<const CallbackT> callback;
+        std::shared_ptr<Executor> executor;
+        double period;
+        std::chrono::steady_clock::time_point last_call;
+
+        bool isDue(const std::chrono::steady_clock::time_point& now) const {
+            if(!(period > 0.0)) return true;
+            // tolerate jitter of the request timer and the transmission
+            const double elapsed =
+                std::chrono::duration<double>(now - last_call).count();
+            return elapsed >= 0.9 * period;
+        }
+    };
+
+    /**
+     * @brief Sets the request period to the smallest listener period. Must be
+     * called with mutex_listeners_ locked.
+     */
+    void updateTimerPeriod() {
+        double period = 0.0;
+        for(const Listener& listener : listeners_) {
+            if(!(listener.period > 0.0)) continue;
+            if(!(period > 0.0) || listener.period < period)
+                period = listener.period;
+        }
+        // restarting the timer would send an extra request
+        if(timer_ && timer_->getPeriod() == period) return;
+        if(timer_ || period > 0.0) setTimerPeriod(period);
+    }
+
     CallbackM send_callback_;
     std::unique_ptr<T> io_object_;
+
+    mutable std::mutex mutex_listeners_;
+    mutable std::vector<Listener> listeners_;
+    ListenerId next_listener_;
 };
 
 }  // namespace client
@@ -0,0 +1,146 @@
+#ifndef TELEMETRY_PUBLISHER_HPP
+#define TELEMETRY_PUBLISHER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ByteView.hpp"
+#include "Client.hpp"
+#include "TelemetryShm.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Settings of a shared memory region for telemetry
+ */
+struct TelemetryPublisherOptions {
+    // maximum number of distinct message IDs with a latest value slot
+    std::size_t slots = 64;
+    // minimum number of ring entries, rounded up to the next power of two
+    std::size_t ring_capacity = 1024;
+    // largest payload which is published, larger frames are skipped
+    std::size_t max_payload = 256;
+    // message IDs to publish, empty publishes every received frame
+    std::vector<msp::ID> ids;
+};
+
+/**
+ * @brief Counters of a publisher
+ */
+struct TelemetryPublisherStats {
+    uint64_t published = 0;  ///<! payloads written to the region
+    uint64_t oversized = 0;  ///<! payloads larger than max_payload
+    uint64_t no_slot   = 0;  ///<! payloads of IDs which found no free slot
+};
+
+/**
+ * @brief Publishes the frames received by a Client in a named POSIX shared
+ * memory region, so that any number of local processes can read the
+ * telemetry with a TelemetryReader without touching the serial port. The
+ * payloads are written by the receiving thread of the client without
+ * allocating memory. Only supported on Linux.
+ */
+class TelemetryPublisher {
+public:
+    /**
+     * @brief TelemetryPublisher constructor
+     * @param name Name of the region, e.g. "/msp-telemetry"
+     * @param options Size of the region and selection of the messages
+     */
+    explicit TelemetryPublisher(const std::string& name,
+                                const TelemetryPublisherOptions& options =
+                                    TelemetryPublisherOptions());
+
+    /**
+     * @brief TelemetryPublisher destructor, detaches from the client and
+     * removes the region
+     */
+    ~TelemetryPublisher();
+
+    /**
+     * @brief Create the region, replacing a stale region of the same name
+     * @return True on success
+     */
+    bool open();
+
+    /**
+     * @brief Detach and remove the region. Readers which mapped it keep their
+     * mapping, but see no new data.
+     */
+    void close();
+
+    /**
+     * @brief Check if the region was created
+     * @return True if the region is mapped
+     */
+    bool isOpen() const { return base_ != nullptr; }
+
+    /**
+     * @brief Publish every frame received by the client
+     * @param client Client receiving the telemetry, e.g. from subscriptions
+     * @return False if the region is not open
+     */
+    bool attach(Client& client);
+
+    /**
+     * @brief Stop publishing the frames of the attached client
+     */
+    void detach();
+
+    /**
+     * @brief Write a payload to the slot of its ID and to the ring. Must only
+     * be called by one thread at a time.
+     * @param id Message ID
+     * @param payload Raw payload of the message
+     * @return True if the payload was published
+     */
+    bool publish(const msp::ID id, const ByteView& payload);
+
+    /**
+     * @brief Query the counters of the publisher
+     * @return Snapshot of the counters
+     */
+    TelemetryPublisherStats stats() const;
+
+private:
+    shm::Record* record(const std::size_t index) const;
+
+    void write(shm::Record* record, const msp::ID id, const uint64_t sequence,
+               const uint64_t stamp, const ByteView& payload);
+
+    const std::string name_;
+    TelemetryPublisherOptions options_;
+    Client* client_;
+
+    // mapping of the region
+    void* base_;
+    std::size_t size_;
+    shm::Header* header_;
+    std::size_t ring_capacity_;
+
+    // keys (ID + 1) of the slots in use, only accessed by the publishing
+    // thread
+    std::vector<uint32_t> slot_keys_;
+
+    std::atomic<uint64_t> published_;
+    std::atomic<uint64_t> oversized_;
+    std::atomic<uint64_t> no_slot_;
+};
+
+}  // namespace client
+}  // namespace msp
+
+inline std::ostream& operator<<(
+    std::ostream& s, const msp::client::TelemetryPublisherStats& stats) {
+    s << "#Telemetry publisher:" << std::endl;
+    s << " Published: " << stats.published << std::endl;
+    s << " Oversized: " << stats.oversized << std::endl;
+    s << " Without slot: " << stats.no_slot << std::endl;
+    return s;
+}
+
+#endif  // TELEMETRY_PUBLISHER_HPP
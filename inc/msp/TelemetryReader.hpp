@@ -0,0 +1,130 @@
+#ifndef TELEMETRY_READER_HPP
+#define TELEMETRY_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include "ByteView.hpp"
+#include "Message.hpp"
+#include "TelemetryShm.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Maps the shared memory region of a TelemetryPublisher read-only. It
+ * does not depend on the client or a serial port, so that any local process
+ * can read the telemetry. Every reader has its own cursor into the ring. A
+ * reader is used by one thread at a time.
+ */
+class TelemetryReader {
+public:
+    TelemetryReader();
+
+    /**
+     * @brief TelemetryReader destructor, unmaps the region
+     */
+    ~TelemetryReader();
+
+    TelemetryReader(const TelemetryReader&) = delete;
+    TelemetryReader& operator=(const TelemetryReader&) = delete;
+
+    /**
+     * @brief Map a region, the ring cursor starts at the newest entry
+     * @param name Name of the region, as given to the publisher
+     * @return False if the region does not exist or is not a telemetry region
+     */
+    bool open(const std::string& name);
+
+    /**
+     * @brief Unmap the region
+     */
+    void close();
+
+    /**
+     * @brief Check if a region is mapped
+     * @return True if a region is mapped
+     */
+    bool isOpen() const { return base_ != nullptr; }
+
+    /**
+     * @brief Copy the latest payload of a message ID
+     * @param id Message ID
+     * @param sample Receives the payload, the capacity of the payload is
+     * reused
+     * @return False if the ID was not published yet
+     */
+    bool latest(const msp::ID id, TelemetrySample& sample) const;
+
+    /**
+     * @brief Decode the latest payload of a message
+     * @param message Message which is decoded, its ID selects the slot
+     * @param stamp Optional destination of the CLOCK_MONOTONIC time of the
+     * reception in ns
+     * @return False if the ID was not published yet or the payload could not
+     * be decoded
+     */
+    template <typename T, class = typename std::enable_if<
+                              std::is_base_of<msp::Message, T>::value>::type>
+    bool latest(T& message, uint64_t* stamp = nullptr) {
+        if(!latest(message.id(), scratch_)) return false;
+        if(stamp != nullptr) *stamp = scratch_.stamp;
+        return message.decode(ByteView(scratch_.payload));
+    }
+
+    /**
+     * @brief Read the next payloads of the ring in arrival order. If the
+     * reader fell behind by more than the ring capacity, the oldest payloads
+     * are skipped and counted as lost.
+     * @param out Destination of at least n samples
+     * @param n Maximum number of samples to read
+     * @return Number of samples copied to out
+     */
+    std::size_t read(TelemetrySample* out, const std::size_t n);
+
+    /**
+     * @brief Read the next payload of the ring
+     * @param sample Destination of the sample
+     * @return True if a sample was available
+     */
+    bool read(TelemetrySample& sample) { return read(&sample, 1) == 1; }
+
+    /**
+     * @brief Number of payloads which can be read from the ring
+     * @return Number of payloads, at most the ring capacity
+     */
+    std::size_t available() const;
+
+    /**
+     * @brief Number of payloads which were skipped since the reader fell
+     * behind the publisher
+     * @return Number of payloads
+     */
+    uint64_t lost() const { return lost_; }
+
+private:
+    const shm::Record* record(const std::size_t index) const;
+
+    /**
+     * @brief Copy a record if it is not being written
+     * @param record Record to copy
+     * @param sample Destination of the copy
+     * @return False if the record was written concurrently
+     */
+    bool copy(const shm::Record* record, TelemetrySample& sample) const;
+
+    // mapping of the region
+    const void* base_;
+    std::size_t size_;
+    const shm::Header* header_;
+
+    uint64_t cursor_;
+    uint64_t lost_;
+    TelemetrySample scratch_;
+};
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // TELEMETRY_READER_HPP
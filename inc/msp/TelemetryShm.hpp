@@ -0,0 +1,103 @@
+#ifndef TELEMETRY_SHM_HPP
+#define TELEMETRY_SHM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "ByteVector.hpp"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Layout of the shared memory region written by a TelemetryPublisher
+ * and mapped by TelemetryReaders. The region starts with the header, followed
+ * by one slot per message ID with the latest payload and a ring of all
+ * published payloads in arrival order. Slots and ring entries are records of
+ * the same size, each guarded by a sequence lock: the publisher makes the
+ * sequence odd while it writes, readers retry a copy if the sequence was odd
+ * or changed. There is a single publisher, readers never write.
+ */
+namespace shm {
+
+// "MSPT", written last once the region is initialised
+static const uint32_t MAGIC   = 0x5450534D;
+static const uint32_t VERSION = 1;
+
+struct Header {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t slot_count;     ///<! number of per ID slots
+    uint32_t ring_capacity;  ///<! number of ring entries, a power of two
+    uint32_t max_payload;    ///<! largest payload of a record
+    uint32_t record_size;    ///<! distance between two records in bytes
+    // number of payloads written to the ring so far
+    alignas(64) std::atomic<uint64_t> head;
+};
+
+struct Record {
+    std::atomic<uint32_t> lock;  ///<! odd while the record is written
+    // message ID + 1 of a slot, 0 while the slot is unused
+    std::atomic<uint32_t> key;
+    uint64_t sequence;  ///<! ring position, or number of updates of a slot
+    uint64_t stamp;     ///<! CLOCK_MONOTONIC time of the reception in ns
+    uint32_t id;        ///<! message ID
+    uint32_t size;      ///<! payload size, the payload follows the record
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory needs lock free atomics");
+
+/**
+ * @brief Locates the payload which follows a record
+ * @param record Record
+ * @return Pointer to the first byte of the payload
+ */
+inline uint8_t* payload(Record* record) {
+    return reinterpret_cast<uint8_t*>(record + 1);
+}
+
+inline const uint8_t* payload(const Record* record) {
+    return reinterpret_cast<const uint8_t*>(record + 1);
+}
+
+/**
+ * @brief Computes the size of a record including its payload
+ * @param max_payload Largest payload
+ * @return Size rounded up to a cache line
+ */
+inline std::size_t recordSize(const std::size_t max_payload) {
+    return (sizeof(Record) + max_payload + 63) / 64 * 64;
+}
+
+/**
+ * @brief Computes the size of the region
+ * @param slots Number of per ID slots
+ * @param ring Number of ring entries
+ * @param max_payload Largest payload
+ * @return Size in bytes
+ */
+inline std::size_t regionSize(const std::size_t slots, const std::size_t ring,
+                              const std::size_t max_payload) {
+    return (sizeof(Header) + 63) / 64 * 64 +
+           (slots + ring) * recordSize(max_payload);
+}
+
+}  // namespace shm
+
+/**
+ * @brief Payload of a message copied out of the shared memory region
+ */
+struct TelemetrySample {
+    uint16_t id       = 0;  ///<! message ID
+    uint64_t sequence = 0;  ///<! ring position, or number of updates of a slot
+    uint64_t stamp    = 0;  ///<! CLOCK_MONOTONIC time of the reception in ns
+    ByteVector payload;     ///<! raw payload, decoded by the message types
+};
+
+}  // namespace client
+}  // namespace msp
+
+#endif  // TELEMETRY_SHM_HPP
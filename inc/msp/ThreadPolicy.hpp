@@ -0,0 +1,74 @@
+#ifndef THREAD_POLICY_HPP
+#define THREAD_POLICY_HPP
+
+#include <pthread.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace msp {
+
+/**
+ * @brief Scheduling class, priority and CPU placement of a thread
+ */
+struct ThreadPolicy {
+    enum class Scheduler {
+        INHERIT,  ///<! keep the class of the creating thread
+        OTHER,    ///<! SCHED_OTHER, default time sharing
+        BATCH,    ///<! SCHED_BATCH, throughput oriented time sharing
+        IDLE,     ///<! SCHED_IDLE, runs only on otherwise idle CPUs
+        FIFO,     ///<! SCHED_FIFO, real time, needs CAP_SYS_NICE
+        RR        ///<! SCHED_RR, real time with time slices
+    };
+
+    // scheduling class
+    Scheduler scheduler = Scheduler::INHERIT;
+    // static priority of FIFO and RR (1 to 99), ignored by the other classes
+    int priority = 0;
+    // CPUs the thread may run on, empty keeps the inherited affinity
+    std::vector<int> cpus;
+
+    /**
+     * @brief Creates a real time policy
+     * @param priority Static priority (1 to 99)
+     * @param cpus CPUs the thread may run on, empty allows all CPUs
+     * @return SCHED_FIFO policy
+     */
+    static ThreadPolicy realtime(const int priority           = 80,
+                                 const std::vector<int>& cpus = {}) {
+        ThreadPolicy policy;
+        policy.scheduler = Scheduler::FIFO;
+        policy.priority  = priority;
+        policy.cpus      = cpus;
+        return policy;
+    }
+};
+
+/**
+ * @brief Applies a policy to a running thread and names it for tracing
+ * @param thread Handle of the thread, e.g. pthread_self()
+ * @param policy Policy to apply
+ * @param name Name of the thread (at most 15 characters), empty keeps the
+ * current name
+ * @return True if all settings were applied
+ */
+bool applyThreadPolicy(const pthread_t thread, const ThreadPolicy& policy,
+                       const std::string& name);
+
+/**
+ * @brief Locks all current and future pages of the process into memory, so
+ * that time critical threads are not delayed by page faults
+ * @return True on success
+ */
+bool lockMemory();
+
+/**
+ * @brief Touches the stack of the calling thread, so that it does not page
+ * fault when a time critical path needs it later
+ * @param bytes Size of the stack to touch
+ */
+void prefaultStack(const std::size_t bytes);
+
+}  // namespace msp
+
+#endif  // THREAD_POLICY_HPP
@@ -1,9 +1,10 @@
 #ifndef VALUE_HPP
 #define VALUE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
-#include <utility>
+#include <type_traits>
 
 namespace msp {
 
@@ -12,20 +13,20 @@ public:
     /**
      * @brief cast to the internal type
      */
-    operator T() const { return data.first; }
+    operator T() const { return data; }
 
     /**
      * @brief cast to the writable refernce of internal type
      */
-    operator T&() { return data.first; }
+    operator T&() { return data; }
 
     /**
      * @brief Assignment operator for non-Value objects
      * @returns Reference to this object
      */
     Value<T>& operator=(const T rhs) {
-        data.first  = rhs;
-        data.second = true;
+        data  = rhs;
+        valid = true;
         return *this;
     }
 
@@ -33,28 +34,202 @@ public:
      * @brief Gets a reference to the internal data
      * @returns Reference to the data
      */
-    T& operator()() { return data.first; }
+    T& operator()() { return data; }
 
     /**
      * @brief Gets a copy of the data
      * @returns
      */
-    T operator()() const { return data.first; }
+    T operator()() const { return data; }
 
     /**
      * @brief Queries if the data has been set
      * @returns True if the internal data has been assigned
      */
-    bool set() const { return data.second; }
+    bool set() const { return valid; }
 
     /**
      * @brief Gets a reference to the data valid flag
      * @returns Reference to the data valid flag
      */
-    bool& set() { return data.second; }
+    bool& set() { return valid; }
 
 private:
-    std::pair<T, bool> data;
+    // plain members keep Value trivially copyable for trivially copyable T
+    T data{};
+    bool valid = false;
+};
+
+template <class T, class Word> class ValueRef;
+
+/**
+ * @brief Presence flags for the fields of a message, one bit per field. Large
+ * or frequently copied structs store their fields as plain values next to a
+ * single ValueMask instead of using Value<T>, which pads each field with its
+ * own flag. ValueRef provides Value-compatible access to such fields.
+ * @tparam Word Unsigned integer type holding the bits, limits the number of
+ * fields
+ */
+template <class Word = uint32_t> class ValueMask {
+    static_assert(std::is_unsigned<Word>::value,
+                  "ValueMask words must be unsigned integer types");
+
+public:
+    /**
+     * @brief Queries if a field has been set
+     * @param bit Index of the field
+     * @returns True if the field has been assigned
+     */
+    bool test(const std::size_t bit) const { return (bits_ >> bit) & 1; }
+
+    /**
+     * @brief Sets or clears the presence flag of a field
+     * @param bit Index of the field
+     * @param value New state of the flag
+     */
+    void set(const std::size_t bit, const bool value = true) {
+        if(value)
+            bits_ |= Word(Word(1) << bit);
+        else
+            bits_ &= Word(~Word(Word(1) << bit));
+    }
+
+    /**
+     * @brief Marks all fields as unset
+     */
+    void reset() { bits_ = 0; }
+
+    /**
+     * @brief Gets the raw presence flags
+     * @returns Bit mask, bit i is set if field i has been assigned
+     */
+    Word bits() const { return bits_; }
+
+    /**
+     * @brief Creates a Value-compatible reference to a field
+     * @param value Storage of the field
+     * @param bit Index of the field
+     * @returns Reference to the field and its presence flag
+     */
+    template <class T> ValueRef<T, Word> ref(T& value, const std::size_t bit) {
+        return ValueRef<T, Word>(value, *this, bit);
+    }
+
+    /**
+     * @brief Creates a read-only Value-compatible reference to a field
+     * @param value Storage of the field
+     * @param bit Index of the field
+     * @returns Reference to the field and its presence flag
+     */
+    template <class T>
+    ValueRef<const T, Word> ref(const T& value, const std::size_t bit) const {
+        return ValueRef<const T, Word>(value, *this, bit);
+    }
+
+private:
+    Word bits_ = 0;
+};
+
+/**
+ * @brief Reference to a plain field and its bit in a ValueMask with the same
+ * interface as Value<T>. References to const fields are read-only.
+ * @tparam T Type of the field, may be const
+ * @tparam Word Word type of the ValueMask
+ */
+template <class T, class Word = uint32_t> class ValueRef {
+    typedef typename std::remove_const<T>::type value_type;
+    typedef typename std::conditional<std::is_const<T>::value,
+                                      const ValueMask<Word>,
+                                      ValueMask<Word>>::type mask_type;
+
+public:
+    /**
+     * @brief Assignable reference to a presence flag, returned by set()
+     */
+    class Flag {
+    public:
+        Flag(ValueMask<Word>& mask, const std::size_t bit) :
+            mask_(mask), bit_(bit) {}
+
+        operator bool() const { return mask_.test(bit_); }
+
+        const Flag& operator=(const bool value) const {
+            mask_.set(bit_, value);
+            return *this;
+        }
+
+    private:
+        ValueMask<Word>& mask_;
+        std::size_t bit_;
+    };
+
+    ValueRef(T& value, mask_type& mask, const std::size_t bit) :
+        value_(value), mask_(mask), bit_(bit) {}
+
+    /**
+     * @brief cast to the internal type
+     */
+    operator value_type() const { return value_; }
+
+    /**
+     * @brief Assigns the field and marks it as set
+     * @returns Reference to this object
+     */
+    const ValueRef& operator=(const value_type rhs) const {
+        value_ = rhs;
+        mask_.set(bit_);
+        return *this;
+    }
+
+    /**
+     * @brief Copies the value and presence flag of another field
+     * @returns Reference to this object
+     */
+    template <class U>
+    const ValueRef& operator=(const ValueRef<U, Word>& rhs) const {
+        value_ = rhs();
+        mask_.set(bit_, rhs.set());
+        return *this;
+    }
+
+    const ValueRef& operator=(const ValueRef& rhs) const {
+        return operator=<T>(rhs);
+    }
+
+    /**
+     * @brief Copies the value and presence flag of a Value
+     * @returns Reference to this object
+     */
+    const ValueRef& operator=(const Value<value_type>& rhs) const {
+        value_ = rhs();
+        mask_.set(bit_, rhs.set());
+        return *this;
+    }
+
+    /**
+     * @brief Gets a reference to the field
+     * @returns Reference to the data
+     */
+    T& operator()() const { return value_; }
+
+    /**
+     * @brief Queries if the data has been set, or gets an assignable
+     * reference to the presence flag for writable fields
+     * @returns Presence flag
+     */
+    auto set() const {
+        if constexpr(std::is_const<T>::value) {
+            return mask_.test(bit_);
+        }
+        else {
+            return Flag(mask_, bit_);
+        }
+    }
+
+private:
+    T& value_;
+    mask_type& mask_;
+    std::size_t bit_;
 };
 
 }  // namespace msp
@@ -68,6 +243,21 @@ inline std::ostream& operator<<(std::ostream& s, const msp::Value<T>& val) {
     return s;
 }
 
+template <class T, class Word>
+inline std::ostream& operator<<(std::ostream& s,
+                                const msp::ValueRef<T, Word>& val) {
+    typedef typename std::remove_const<T>::type value_type;
+    if(!val.set())
+        s << "<unset>";
+    else if(std::is_same<value_type, uint8_t>::value)
+        s << uint32_t(val());
+    else if(std::is_same<value_type, int8_t>::value)
+        s << int32_t(val());
+    else
+        s << val();
+    return s;
+}
+
 template <>
 inline std::ostream& operator<<(std::ostream& s,
                                 const msp::Value<uint8_t>& val) {
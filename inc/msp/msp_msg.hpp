@@ -12,6 +12,7 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include "FlagSet.hpp"
 #include "Message.hpp"
 
 /*================================================================
@@ -414,7 +415,7 @@ struct ApiVersion : public Message {
     Value<uint8_t> major;
     Value<uint8_t> minor;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(protocol);
         rc &= data.unpack(major);
@@ -438,7 +439,7 @@ struct FcVariant : public Message {
 
     Value<std::string> identifier;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(identifier, data.size());
     }
 
@@ -459,7 +460,7 @@ struct FcVersion : public Message {
     Value<uint8_t> minor;
     Value<uint8_t> patch_level;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(major);
         rc &= data.unpack(minor);
@@ -487,7 +488,7 @@ struct BoardInfo : public Message {
     Value<uint8_t> comms_capabilites;
     Value<std::string> name;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(identifier, BOARD_IDENTIFIER_LENGTH);
         rc &= data.unpack(version);
@@ -520,7 +521,7 @@ struct BuildInfo : public Message {
     Value<std::string> buildTime;
     Value<std::string> shortGitRevision;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(buildDate, BUILD_DATE_LENGTH);
         rc &= data.unpack(buildTime, BUILD_TIME_LENGTH);
@@ -554,7 +555,7 @@ struct InavPid : public InavPidSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_INAV_PID; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(async_mode);
         rc &= data.unpack(acc_task_frequency);
@@ -602,7 +603,7 @@ struct BoardName : public Message {
 
     Value<std::string> name;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(name);
     }
 };
@@ -639,7 +640,7 @@ struct NavPosHold : public NavPosHoldSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_NAV_POSHOLD; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(user_control_mode);
         rc &= data.unpack(max_auto_speed);
@@ -692,7 +693,7 @@ struct CalibrationData : public CalibrationDataSettings, public Message {
 
     Value<uint8_t> axis_calibration_flags;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(axis_calibration_flags);
         rc &= data.unpack(acc_zero_x);
@@ -744,7 +745,7 @@ struct PositionEstimationConfig : public PositionEstimationConfigSettings,
         return ID::MSP_POSITION_ESTIMATION_CONFIG;
     }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack<uint16_t>(w_z_baro_p, 100);
         rc &= data.unpack<uint16_t>(w_z_gps_p, 100);
@@ -818,7 +819,7 @@ struct WpGetInfo : public Message {
     Value<bool> wp_list_valid;
     Value<uint8_t> wp_count;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(wp_capabilites);
         rc &= data.unpack(max_waypoints);
@@ -849,7 +850,7 @@ struct RthAndLandConfig : public RthAndLandConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_RTH_AND_LAND_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(min_rth_distance);
         rc &= data.unpack(rth_climb_first);
@@ -910,7 +911,7 @@ struct FwConfig : public FwConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_FW_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(cruise_throttle);
         rc &= data.unpack(min_throttle);
@@ -961,7 +962,7 @@ struct BatteryConfig : public BatteryConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_BATTERY_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(vbatmincellvoltage);
         rc &= data.unpack(vbatmaxcellvoltage);
@@ -1008,7 +1009,7 @@ struct ModeRanges : public Message {
 
     std::array<box_description, MAX_MODE_ACTIVATION_CONDITION_COUNT> boxes;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(size_t i = 0; i < MAX_MODE_ACTIVATION_CONDITION_COUNT; i++) {
             rc &= data.unpack(boxes[i].id);
@@ -1050,7 +1051,7 @@ struct Feature : public Message {
 
     std::set<std::string> features;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         uint32_t mask;
         bool rc = data.unpack(mask);
         if(!rc) return rc;
@@ -1102,7 +1103,7 @@ struct BoardAlignment : public BoardAlignmentSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_BOARD_ALIGNMENT; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(roll);
         rc &= data.unpack(pitch);
@@ -1141,7 +1142,7 @@ struct CurrentMeterConfig : public CurrentMeterConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_CURRENT_METER_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(currnet_scale);
         rc &= data.unpack(current_offset);
@@ -1178,7 +1179,7 @@ struct Mixer : public Message {
 
     Value<uint8_t> mode;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(mode);
     }
 };
@@ -1200,48 +1201,126 @@ struct SetMixer : public Message {
 
 struct RxConfigSettings {
     size_t valid_data_groups;
+
+    // presence flags of the fields below
+    ValueMask<> present;
+    uint32_t rx_spi_id_                = 0;
+    uint16_t maxcheck_                 = 0;
+    uint16_t midrc_                    = 0;
+    uint16_t mincheck_                 = 0;
+    uint16_t rx_min_usec_              = 0;
+    uint16_t rx_max_usec_              = 0;
+    uint16_t airModeActivateThreshold_ = 0;
+    uint8_t serialrx_provider_         = 0;
+    uint8_t spektrum_sat_bind_         = 0;
+    uint8_t rcInterpolation_           = 0;
+    uint8_t rcInterpolationInterval_   = 0;
+    uint8_t rx_spi_protocol_           = 0;
+    uint8_t rx_spi_rf_channel_count_   = 0;
+    uint8_t fpvCamAngleDegrees_        = 0;
+    uint8_t receiverType_              = 0;
+
     // group1
-    Value<uint8_t> serialrx_provider;
-    Value<uint16_t> maxcheck;
-    Value<uint16_t> midrc;
-    Value<uint16_t> mincheck;
-    Value<uint8_t> spektrum_sat_bind;
+    ValueRef<uint8_t> serialrx_provider() {
+        return present.ref(serialrx_provider_, 0);
+    }
+    ValueRef<const uint8_t> serialrx_provider() const {
+        return present.ref(serialrx_provider_, 0);
+    }
+    ValueRef<uint16_t> maxcheck() { return present.ref(maxcheck_, 1); }
+    ValueRef<const uint16_t> maxcheck() const {
+        return present.ref(maxcheck_, 1);
+    }
+    ValueRef<uint16_t> midrc() { return present.ref(midrc_, 2); }
+    ValueRef<const uint16_t> midrc() const { return present.ref(midrc_, 2); }
+    ValueRef<uint16_t> mincheck() { return present.ref(mincheck_, 3); }
+    ValueRef<const uint16_t> mincheck() const {
+        return present.ref(mincheck_, 3);
+    }
+    ValueRef<uint8_t> spektrum_sat_bind() {
+        return present.ref(spektrum_sat_bind_, 4);
+    }
+    ValueRef<const uint8_t> spektrum_sat_bind() const {
+        return present.ref(spektrum_sat_bind_, 4);
+    }
     // group 2
-    Value<uint16_t> rx_min_usec;
-    Value<uint16_t> rx_max_usec;
+    ValueRef<uint16_t> rx_min_usec() { return present.ref(rx_min_usec_, 5); }
+    ValueRef<const uint16_t> rx_min_usec() const {
+        return present.ref(rx_min_usec_, 5);
+    }
+    ValueRef<uint16_t> rx_max_usec() { return present.ref(rx_max_usec_, 6); }
+    ValueRef<const uint16_t> rx_max_usec() const {
+        return present.ref(rx_max_usec_, 6);
+    }
     // group 3
-    Value<uint8_t> rcInterpolation;
-    Value<uint8_t> rcInterpolationInterval;
-    Value<uint16_t> airModeActivateThreshold;
+    ValueRef<uint8_t> rcInterpolation() {
+        return present.ref(rcInterpolation_, 7);
+    }
+    ValueRef<const uint8_t> rcInterpolation() const {
+        return present.ref(rcInterpolation_, 7);
+    }
+    ValueRef<uint8_t> rcInterpolationInterval() {
+        return present.ref(rcInterpolationInterval_, 8);
+    }
+    ValueRef<const uint8_t> rcInterpolationInterval() const {
+        return present.ref(rcInterpolationInterval_, 8);
+    }
+    ValueRef<uint16_t> airModeActivateThreshold() {
+        return present.ref(airModeActivateThreshold_, 9);
+    }
+    ValueRef<const uint16_t> airModeActivateThreshold() const {
+        return present.ref(airModeActivateThreshold_, 9);
+    }
     // group 4
-    Value<uint8_t> rx_spi_protocol;
-    Value<uint32_t> rx_spi_id;
-    Value<uint8_t> rx_spi_rf_channel_count;
+    ValueRef<uint8_t> rx_spi_protocol() {
+        return present.ref(rx_spi_protocol_, 10);
+    }
+    ValueRef<const uint8_t> rx_spi_protocol() const {
+        return present.ref(rx_spi_protocol_, 10);
+    }
+    ValueRef<uint32_t> rx_spi_id() { return present.ref(rx_spi_id_, 11); }
+    ValueRef<const uint32_t> rx_spi_id() const {
+        return present.ref(rx_spi_id_, 11);
+    }
+    ValueRef<uint8_t> rx_spi_rf_channel_count() {
+        return present.ref(rx_spi_rf_channel_count_, 12);
+    }
+    ValueRef<const uint8_t> rx_spi_rf_channel_count() const {
+        return present.ref(rx_spi_rf_channel_count_, 12);
+    }
     // group 5
-    Value<uint8_t> fpvCamAngleDegrees;
+    ValueRef<uint8_t> fpvCamAngleDegrees() {
+        return present.ref(fpvCamAngleDegrees_, 13);
+    }
+    ValueRef<const uint8_t> fpvCamAngleDegrees() const {
+        return present.ref(fpvCamAngleDegrees_, 13);
+    }
     // group 6 - iNav only
-    Value<uint8_t> receiverType;
+    ValueRef<uint8_t> receiverType() { return present.ref(receiverType_, 14); }
+    ValueRef<const uint8_t> receiverType() const {
+        return present.ref(receiverType_, 14);
+    }
 
     std::ostream& rxConfigPrint(std::ostream& s) const {
         s << "#RX configuration:" << std::endl;
-        s << " serialrx_provider: " << serialrx_provider << std::endl;
-        s << " maxcheck: " << maxcheck << std::endl;
-        s << " midrc: " << midrc << std::endl;
-        s << " mincheck: " << mincheck << std::endl;
-        s << " spektrum_sat_bind: " << spektrum_sat_bind << std::endl;
-        s << " rx_min_usec: " << rx_min_usec << std::endl;
-        s << " rx_max_usec: " << rx_max_usec << std::endl;
-        s << " rcInterpolation: " << rcInterpolation << std::endl;
-        s << " rcInterpolationInterval: " << rcInterpolationInterval
+        s << " serialrx_provider: " << serialrx_provider() << std::endl;
+        s << " maxcheck: " << maxcheck() << std::endl;
+        s << " midrc: " << midrc() << std::endl;
+        s << " mincheck: " << mincheck() << std::endl;
+        s << " spektrum_sat_bind: " << spektrum_sat_bind() << std::endl;
+        s << " rx_min_usec: " << rx_min_usec() << std::endl;
+        s << " rx_max_usec: " << rx_max_usec() << std::endl;
+        s << " rcInterpolation: " << rcInterpolation() << std::endl;
+        s << " rcInterpolationInterval: " << rcInterpolationInterval()
           << std::endl;
-        s << " airModeActivateThreshold: " << airModeActivateThreshold
+        s << " airModeActivateThreshold: " << airModeActivateThreshold()
           << std::endl;
-        s << " rx_spi_protocol: " << rx_spi_protocol << std::endl;
-        s << " rx_spi_id: " << rx_spi_id << std::endl;
-        s << " rx_spi_rf_channel_count: " << rx_spi_rf_channel_count
+        s << " rx_spi_protocol: " << rx_spi_protocol() << std::endl;
+        s << " rx_spi_id: " << rx_spi_id() << std::endl;
+        s << " rx_spi_rf_channel_count: " << rx_spi_rf_channel_count()
           << std::endl;
-        s << " fpvCamAngleDegrees: " << fpvCamAngleDegrees << std::endl;
-        s << " receiverType: " << receiverType << std::endl;
+        s << " fpvCamAngleDegrees: " << fpvCamAngleDegrees() << std::endl;
+        s << " receiverType: " << receiverType() << std::endl;
         return s;
     }
 };
@@ -1252,39 +1331,39 @@ struct RxConfig : public RxConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_RX_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc           = true;
         valid_data_groups = 1;
-        rc &= data.unpack(serialrx_provider);
-        rc &= data.unpack(maxcheck);
-        rc &= data.unpack(midrc);
-        rc &= data.unpack(mincheck);
-        rc &= data.unpack(spektrum_sat_bind);
+        rc &= data.unpack(serialrx_provider());
+        rc &= data.unpack(maxcheck());
+        rc &= data.unpack(midrc());
+        rc &= data.unpack(mincheck());
+        rc &= data.unpack(spektrum_sat_bind());
         if(data.unpacking_remaining() == 0) return rc;
 
         valid_data_groups += 1;
-        rc &= data.unpack(rx_min_usec);
-        rc &= data.unpack(rx_max_usec);
+        rc &= data.unpack(rx_min_usec());
+        rc &= data.unpack(rx_max_usec());
         if(data.unpacking_remaining() == 0) return rc;
 
         valid_data_groups += 1;
-        rc &= data.unpack(rcInterpolation);
-        rc &= data.unpack(rcInterpolationInterval);
-        rc &= data.unpack(airModeActivateThreshold);
+        rc &= data.unpack(rcInterpolation());
+        rc &= data.unpack(rcInterpolationInterval());
+        rc &= data.unpack(airModeActivateThreshold());
         if(data.unpacking_remaining() == 0) return rc;
 
         valid_data_groups += 1;
-        rc &= data.unpack(rx_spi_protocol);
-        rc &= data.unpack(rx_spi_id);
-        rc &= data.unpack(rx_spi_rf_channel_count);
+        rc &= data.unpack(rx_spi_protocol());
+        rc &= data.unpack(rx_spi_id());
+        rc &= data.unpack(rx_spi_rf_channel_count());
         if(data.unpacking_remaining() == 0) return rc;
 
         valid_data_groups += 1;
-        rc &= data.unpack(fpvCamAngleDegrees);
+        rc &= data.unpack(fpvCamAngleDegrees());
         if(data.unpacking_remaining() == 0) return rc;
 
         valid_data_groups += 1;
-        rc &= data.unpack(receiverType);
+        rc &= data.unpack(receiverType());
         return rc;
     }
 
@@ -1302,26 +1381,26 @@ struct SetRxConfig : public RxConfigSettings, public Message {
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
         bool rc             = true;
-        rc &= data->pack(serialrx_provider);
-        rc &= data->pack(maxcheck);
-        rc &= data->pack(midrc);
-        rc &= data->pack(mincheck);
-        rc &= data->pack(spektrum_sat_bind);
+        rc &= data->pack(serialrx_provider());
+        rc &= data->pack(maxcheck());
+        rc &= data->pack(midrc());
+        rc &= data->pack(mincheck());
+        rc &= data->pack(spektrum_sat_bind());
         if(valid_data_groups == 1) goto packing_finished;
-        rc &= data->pack(rx_min_usec);
-        rc &= data->pack(rx_max_usec);
+        rc &= data->pack(rx_min_usec());
+        rc &= data->pack(rx_max_usec());
         if(valid_data_groups == 2) goto packing_finished;
-        rc &= data->pack(rcInterpolation);
-        rc &= data->pack(rcInterpolationInterval);
-        rc &= data->pack(airModeActivateThreshold);
+        rc &= data->pack(rcInterpolation());
+        rc &= data->pack(rcInterpolationInterval());
+        rc &= data->pack(airModeActivateThreshold());
         if(valid_data_groups == 3) goto packing_finished;
-        rc &= data->pack(rx_spi_protocol);
-        rc &= data->pack(rx_spi_id);
-        rc &= data->pack(rx_spi_rf_channel_count);
+        rc &= data->pack(rx_spi_protocol());
+        rc &= data->pack(rx_spi_id());
+        rc &= data->pack(rx_spi_rf_channel_count());
         if(valid_data_groups == 4) goto packing_finished;
-        rc &= data->pack(fpvCamAngleDegrees);
+        rc &= data->pack(fpvCamAngleDegrees());
         if(valid_data_groups == 5) goto packing_finished;
-        rc &= data->pack(receiverType);
+        rc &= data->pack(receiverType());
     packing_finished:
         if(!rc) data.reset();
         return data;
@@ -1337,7 +1416,7 @@ struct HsvColor : public Packable {
     Value<uint8_t> s;
     Value<uint8_t> v;
 
-    bool unpack_from(const ByteVector& data) {
+    bool unpack_from(const ByteView& data) {
         bool rc = true;
         rc &= data.unpack(h);
         rc &= data.unpack(s);
@@ -1362,7 +1441,7 @@ struct LedColors : public Message {
 
     std::array<HsvColor, LED_CONFIGURABLE_COLOR_COUNT> colors;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(auto& c : colors) {
             rc &= data.unpack(c);
@@ -1381,11 +1460,11 @@ struct SetLedColors : public Message {
 
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
-        bool rc             = true;
-        for(size_t i = 0; i < LED_CONFIGURABLE_COLOR_COUNT; ++i) {
-            rc &= data->pack(colors[i].h);
-            rc &= data->pack(colors[i].s);
-            rc &= data->pack(colors[i].v);
+        // 4 bytes per colour
+        data->reserve(4 * LED_CONFIGURABLE_COLOR_COUNT);
+        bool rc = true;
+        for(const auto& c : colors) {
+            rc &= data->pack(c);
         }
         if(!rc) data.reset();
         return data;
@@ -1400,12 +1479,8 @@ struct LedStripConfigs : public Message {
 
     std::array<uint32_t, LED_MAX_STRIP_LENGTH> configs;
 
-    virtual bool decode(const ByteVector& data) override {
-        bool rc = true;
-        for(size_t i = 0; i < LED_MAX_STRIP_LENGTH; ++i) {
-            rc &= data.unpack(configs[i]);
-        }
-        return rc;
+    virtual bool decode(const ByteView& data) override {
+        return data.unpack(configs);
     }
 };
 
@@ -1436,7 +1511,7 @@ struct RssiConfig : public Message {
 
     Value<uint8_t> rssi_channel;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(rssi_channel);
     }
 };
@@ -1473,7 +1548,7 @@ struct AdjustmentRanges : public Message {
 
     std::array<adjustmentRange, MAX_ADJUSTMENT_RANGE_COUNT> ranges;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(size_t i = 0; i < MAX_ADJUSTMENT_RANGE_COUNT; ++i) {
             rc &= data.unpack(ranges[i].adjustmentIndex);
@@ -1528,7 +1603,7 @@ struct CfSerialConfig : public Message {
 
     std::vector<CfSerialConfigSettings> configs;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         do {
             CfSerialConfigSettings tmp;
@@ -1581,7 +1656,7 @@ struct VoltageMeterConfig : public VoltageMeterConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_VOLTAGE_METER_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(scale_dV);
         rc &= data.unpack(cell_min_dV);
@@ -1618,7 +1693,7 @@ struct SonarAltitude : public Message {
 
     Value<uint32_t> altitude_cm;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(altitude_cm);
     }
 };
@@ -1631,7 +1706,7 @@ struct PidController : public Message {
 
     Value<uint8_t> controller_id;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(controller_id);
     }
 };
@@ -1656,7 +1731,7 @@ struct ArmingConfig : public ArmingConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_ARMING_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(auto_disarm_delay);
         rc &= data.unpack(disarm_kill_switch);
@@ -1700,13 +1775,8 @@ struct RxMap : public RxMapSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_RX_MAP; }
 
-    virtual bool decode(const ByteVector& data) override {
-        if(data.size() < MAX_MAPPABLE_RX_INPUTS) return false;
-        bool rc = true;
-        for(size_t i = 0; i < MAX_MAPPABLE_RX_INPUTS; ++i) {
-            rc &= data.unpack(map[i]);
-        }
-        return rc;
+    virtual bool decode(const ByteView& data) override {
+        return data.unpack(map);
     }
 
     virtual std::ostream& print(std::ostream& s) const override {
@@ -1722,11 +1792,7 @@ struct SetRxMap : public RxMapSettings, public Message {
 
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
-        bool rc             = true;
-        for(const auto& channel : map) {
-            rc &= data->pack(channel);
-        }
-        if(!rc) data.reset();
+        if(!data->pack(map)) data.reset();
         return data;
     }
 
@@ -1754,7 +1820,7 @@ struct BfConfig : public BfConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_BF_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(mixer_mode);
         rc &= data.unpack(feature_mask);
@@ -1807,7 +1873,7 @@ struct BfBuildInfo : public Message {
     Value<uint32_t> reserved1;
     Value<uint32_t> reserved2;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(build_date, 11);
         rc &= data.unpack(reserved1);
@@ -1827,7 +1893,7 @@ struct DataflashSummary : public Message {
     Value<uint32_t> total_size;
     Value<uint32_t> offset;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(flash_is_ready);
         rc &= data.unpack(sectors);
@@ -1859,11 +1925,10 @@ struct DataflashRead : public Message {
         return data;
     }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(read_address);
-        flash_data = ByteVector(data.unpacking_iterator(), data.end());
-        rc &= data.consume(flash_data.size());
+        rc &= data.unpack(flash_data);
         return rc;
     }
 };
@@ -1874,7 +1939,7 @@ struct DataflashErase : public Message {
 
     virtual ID id() const override { return ID::MSP_DATAFLASH_ERASE; }
 
-    virtual bool decode(const ByteVector& /*data*/) override { return true; }
+    virtual bool decode(const ByteView& /*data*/) override { return true; }
 };
 
 // MSP_LOOP_TIME: 73
@@ -1885,7 +1950,7 @@ struct LoopTime : public Message {
 
     Value<uint16_t> loop_time;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(loop_time);
     }
 };
@@ -1928,7 +1993,7 @@ struct FailsafeConfig : public FailsafeSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_FAILSAFE_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc           = true;
         extended_contents = false;
         rc &= data.unpack(delay);
@@ -1992,7 +2057,7 @@ struct RxFailConfigs : public Message {
 
     std::vector<RxFailChannelSettings> channels;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         channels.clear();
         while(rc && data.unpacking_remaining()) {
@@ -2013,7 +2078,7 @@ struct SetRxFailConfigs : public RxFailChannelSettings, public Message {
 
     Value<uint8_t> channel;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(channel);
         rc &= data.unpack(mode);
@@ -2034,7 +2099,7 @@ struct SdcardSummary : public Message {
     Value<uint32_t> free_space_kb;
     Value<uint32_t> total_space_kb;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(flags);
         rc &= data.unpack(state);
@@ -2061,7 +2126,7 @@ struct BlackboxConfig : public BlackboxConfigSettings, public Message {
 
     Value<uint8_t> supported;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc     = true;
         p_ratio_set = false;
         rc &= data.unpack(supported);
@@ -2110,7 +2175,7 @@ struct TransponderConfig : public Message {
     Value<uint8_t> provider;
     ByteVector provider_data;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(transponder_count);
         if(!transponder_count()) return rc;
@@ -2123,9 +2188,7 @@ struct TransponderConfig : public Message {
         rc &= data.unpack(provider);
         if(!provider()) return rc;
         uint8_t data_len = transponder_data[provider() - 1].data_length();
-        provider_data    = ByteVector(data.unpacking_iterator(),
-                                   data.unpacking_iterator() + data_len);
-        rc &= data.consume(data_len);
+        rc &= data.unpack(provider_data, data_len);
         return rc;
     }
 };
@@ -2167,7 +2230,7 @@ struct OsdConfig : public Message {
     Value<uint16_t> neg_alt_alarm;
     std::array<uint16_t, OSD_ITEM_COUNT> item_pos;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(osd_flags);
         if(rc && osd_flags()) {
@@ -2226,7 +2289,36 @@ struct SetOsdConfig : public Message {
     }
 };
 
-// MSP_OSD_CHAR_READ: 86 No reference implementation
+// MSP_OSD_CHAR_READ: 86
+// No reference implementation. The request selects the character like
+// MSP_OSD_CHAR_WRITE, the response repeats the 16 bit address in front of the
+// visible bytes of the character, so that pipelined reads can be matched.
+struct OsdCharRead : public Message {
+    OsdCharRead(FirmwareVariant v) : Message(v) {}
+
+    virtual ID id() const override { return ID::MSP_OSD_CHAR_READ; }
+
+    Value<uint16_t> addr;
+    std::array<uint8_t, 54> font_data;
+
+    virtual ByteVectorUptr encode() const override {
+        ByteVectorUptr data = std::make_unique<ByteVector>();
+        bool rc             = true;
+        if(addr() > 0xFF)
+            rc &= data->pack(addr);
+        else
+            rc &= data->pack(uint8_t(addr()));
+        if(!rc) data.reset();
+        return data;
+    }
+
+    virtual bool decode(const ByteView& data) override {
+        bool rc = true;
+        rc &= data.unpack(addr);
+        rc &= data.unpack(font_data);
+        return rc;
+    }
+};
 
 // MSP_OSD_CHAR_WRITE: 87
 struct OsdCharWrite : public Message {
@@ -2234,16 +2326,18 @@ struct OsdCharWrite : public Message {
 
     virtual ID id() const override { return ID::MSP_OSD_CHAR_WRITE; }
 
-    Value<uint8_t> addr;
+    // characters above 255 (e.g. 512 character fonts) use a 16 bit address
+    Value<uint16_t> addr;
     std::array<uint8_t, 54> font_data;
 
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
         bool rc             = true;
-        rc &= data->pack(addr);
-        for(const auto& c : font_data) {
-            rc &= data->pack(c);
-        }
+        if(addr() > 0xFF)
+            rc &= data->pack(addr);
+        else
+            rc &= data->pack(uint8_t(addr()));
+        rc &= data->pack(font_data);
         if(!rc) data.reset();
         return data;
     }
@@ -2263,7 +2357,7 @@ struct VtxConfig : public Message {
     bool freq_set;
     Value<uint16_t> frequency;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc  = true;
         freq_set = false;
         rc &= data.unpack(device_type);
@@ -2330,7 +2424,7 @@ struct AdvancedConfig : public AdvancedConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_ADVANCED_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc           = true;
         pwm_inversion_set = false;
         rc &= data.unpack(gyro_sync_denom);
@@ -2390,7 +2484,7 @@ struct FilterConfig : public FilterConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_FILTER_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc               = true;
         dterm_filter_type_set = false;
         rc &= data.unpack(gyro_soft_lpf_hz);
@@ -2456,7 +2550,7 @@ struct PidAdvanced : public PidAdvancedSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_PID_ADVANCED; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(rollPitchItermIgnoreRate);
         rc &= data.unpack(yawItermIgnoreRate);
@@ -2514,7 +2608,7 @@ struct SensorConfig : public SensorConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_SENSOR_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc           = true;
         extended_contents = false;
         rc &= data.unpack(acc_hardware);
@@ -2600,7 +2694,7 @@ struct Ident : public Message {
     Value<uint8_t> msp_version;
     std::set<Capability> capabilities;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
 
         rc &= data.unpack(version);
@@ -2670,38 +2764,39 @@ struct Ident : public Message {
     }
 };
 
+// wire format of the sensor flags: bits 0-6 match the Sensor enum, the
+// general health flag is transmitted in bit 15
+inline uint16_t sensorsToWire(const FlagSet<Sensor>& sensors) {
+    const uint32_t bits = sensors.bits();
+    return uint16_t((bits & 0x7F) | ((bits >> 7) & 1) << 15);
+}
+
+inline void sensorsFromWire(const uint16_t sensor, FlagSet<Sensor>& sensors) {
+    sensors.setBits(uint32_t(sensor & 0x7F) | uint32_t((sensor >> 15) & 1)
+                                                  << 7);
+}
+
 struct StatusBase : public Packable {
     Value<uint16_t> cycle_time;  // in us
     Value<uint16_t> i2c_errors;
-    std::set<Sensor> sensors;
-    std::set<size_t> box_mode_flags;
+    FlagSet<Sensor> sensors;
+    FlagSet<size_t> box_mode_flags;
     Value<uint8_t> current_profile;
 
-    bool unpack_from(const ByteVector& data) {
+    bool unpack_from(const ByteView& data) {
         bool rc = true;
         rc &= data.unpack(cycle_time);
         rc &= data.unpack(i2c_errors);
 
         // get sensors
-        sensors.clear();
         uint16_t sensor = 0;
         rc &= data.unpack(sensor);
-        if(sensor & (1 << 0)) sensors.insert(Sensor::Accelerometer);
-        if(sensor & (1 << 1)) sensors.insert(Sensor::Barometer);
-        if(sensor & (1 << 2)) sensors.insert(Sensor::Magnetometer);
-        if(sensor & (1 << 3)) sensors.insert(Sensor::GPS);
-        if(sensor & (1 << 4)) sensors.insert(Sensor::Sonar);
-        if(sensor & (1 << 5)) sensors.insert(Sensor::OpticalFlow);
-        if(sensor & (1 << 6)) sensors.insert(Sensor::Pitot);
-        if(sensor & (1 << 15)) sensors.insert(Sensor::GeneralHealth);
+        sensorsFromWire(sensor, sensors);
 
         // check active boxes
-        box_mode_flags.clear();
         uint32_t flag = 0;
         rc &= data.unpack(flag);
-        for(size_t ibox(0); ibox < sizeof(flag) * CHAR_BIT; ibox++) {
-            if(flag & (1 << ibox)) box_mode_flags.insert(ibox);
-        }
+        box_mode_flags.setBits(flag);
 
         rc &= data.unpack(current_profile);
         return rc;
@@ -2711,45 +2806,8 @@ struct StatusBase : public Packable {
         bool rc = true;
         rc &= data.pack(cycle_time);
         rc &= data.pack(i2c_errors);
-
-        Value<uint16_t> sensor_pack;
-        sensor_pack = 0;
-        for(const auto& s : sensors) {
-            switch(s) {
-            case Sensor::Accelerometer:
-                sensor_pack() |= (1 << 0);
-                break;
-            case Sensor::Barometer:
-                sensor_pack() |= (1 << 1);
-                break;
-            case Sensor::Magnetometer:
-                sensor_pack() |= (1 << 2);
-                break;
-            case Sensor::GPS:
-                sensor_pack() |= (1 << 3);
-                break;
-            case Sensor::Sonar:
-                sensor_pack() |= (1 << 4);
-                break;
-            case Sensor::OpticalFlow:
-                sensor_pack() |= (1 << 5);
-                break;
-            case Sensor::Pitot:
-                sensor_pack() |= (1 << 6);
-                break;
-            case Sensor::GeneralHealth:
-                sensor_pack() |= (1 << 15);
-                break;
-            }
-        }
-        rc &= data.pack(sensor_pack);
-
-        Value<uint32_t> box_pack;
-        box_pack = 0;
-        for(const auto& b : box_mode_flags) {
-            box_pack() |= (1 << b);
-        }
-        rc &= data.pack(box_pack);
+        rc &= data.pack(sensorsToWire(sensors));
+        rc &= data.pack(box_mode_flags.bits());
         return rc;
     }
 };
@@ -2763,7 +2821,7 @@ struct Status : public StatusBase, public Message {
     Value<uint16_t> avg_system_load_pct;
     Value<uint16_t> gyro_cycle_time;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= StatusBase::unpack_from(data);
 
@@ -2838,7 +2896,7 @@ struct RawImu : public Message {
     std::array<Value<int16_t>, 3> gyro;
     std::array<Value<int16_t>, 3> mag;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(auto& a : acc) {
             rc &= data.unpack(a);
@@ -2908,10 +2966,8 @@ struct Servo : public Message {
 
     std::array<uint16_t, N_SERVO> servo;  // [1000, 2000]
 
-    virtual bool decode(const ByteVector& data) override {
-        bool rc = true;
-        for(auto& s : servo) rc &= data.unpack(s);
-        return rc;
+    virtual bool decode(const ByteView& data) override {
+        return data.unpack(servo);
     }
 
     virtual std::ostream& print(std::ostream& s) const override {
@@ -2932,10 +2988,8 @@ struct Motor : public Message {
 
     std::array<uint16_t, N_MOTOR> motor;  // [1000, 2000]
 
-    virtual bool decode(const ByteVector& data) override {
-        bool rc = true;
-        for(auto& m : motor) rc &= data.unpack(m);
-        return rc;
+    virtual bool decode(const ByteView& data) override {
+        return data.unpack(motor);
     }
 
     virtual std::ostream& print(std::ostream& s) const override {
@@ -2956,15 +3010,9 @@ struct Rc : public Message {
 
     std::vector<uint16_t> channels;  // [1000, 2000]
 
-    virtual bool decode(const ByteVector& data) override {
-        channels.clear();
-        bool rc = true;
-        while(rc) {
-            uint16_t rc_data;
-            rc &= data.unpack(rc_data);
-            if(rc) channels.push_back(rc_data);
-        }
-        return !channels.empty();
+    virtual bool decode(const ByteView& data) override {
+        // all channels sent by the FC
+        return data.unpack(channels) && !channels.empty();
     }
 
     virtual std::ostream& print(std::ostream& s) const override {
@@ -2993,7 +3041,7 @@ struct RawGPS : public Message {
     bool hdop_set;
     Value<float> hdop;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc  = true;
         hdop_set = false;
         rc &= data.unpack(fix);
@@ -3033,7 +3081,7 @@ struct CompGPS : public Message {
     Value<uint16_t> directionToHome;  // [-180, +180] degree
     Value<uint8_t> update;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(distanceToHome);
         rc &= data.unpack(directionToHome);
@@ -3061,7 +3109,7 @@ struct Attitude : public Message {
     Value<float> pitch;  // [-90, +90] degree
     Value<int16_t> yaw;  // [-180, +180] degree
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack<int16_t>(roll, 10);
         rc &= data.unpack<int16_t>(pitch, 10);
@@ -3090,7 +3138,7 @@ struct Altitude : public Message {
     bool baro_altitude_set;
     Value<float> baro_altitude;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack<int32_t>(altitude, 100);
         rc &= data.unpack<int16_t>(vario, 100);
@@ -3126,7 +3174,7 @@ struct Analog : public Message {
     Value<uint16_t> rssi;   // Received Signal Strength Indication [0, 1023]
     Value<float> amperage;  // Ampere
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack<uint8_t>(vbat, 10);
         rc &= data.unpack<uint16_t>(powerMeterSum, 1000);
@@ -3177,7 +3225,7 @@ struct RcTuning : public RcTuningSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_RC_TUNING; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(rcRates[0]);
         rc &= data.unpack(rcExpo[0]);
@@ -3203,7 +3251,7 @@ struct PidTerms : public Packable {
     uint8_t I;
     uint8_t D;
 
-    bool unpack_from(const ByteVector& data) {
+    bool unpack_from(const ByteView& data) {
         bool rc = true;
         rc &= data.unpack(P);
         rc &= data.unpack(I);
@@ -3291,7 +3339,7 @@ struct Pid : public PidSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_PID; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(uint8_t i = 0;
             i < static_cast<uint8_t>(PID_Element::PID_ITEM_COUNT);
@@ -3311,7 +3359,7 @@ struct ActiveBoxes : public Message {
     // box activation pattern
     std::vector<std::array<std::set<SwitchPosition>, NAUX>> box_pattern;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         box_pattern.clear();
         bool rc = true;
         while(rc && data.unpacking_remaining() > 1) {
@@ -3396,7 +3444,7 @@ struct Misc : public MiscSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_MISC; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(mid_rc);
         rc &= data.unpack(min_throttle);
@@ -3427,7 +3475,7 @@ struct MotorPins : public Message {
 
     Value<uint8_t> pwm_pin[N_MOTOR];
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(auto& pin : pwm_pin) rc &= data.unpack(pin);
         return rc;
@@ -3452,7 +3500,7 @@ struct BoxNames : public Message {
 
     std::vector<std::string> box_names;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         box_names.clear();
         bool rc = true;
         std::string str;
@@ -3482,7 +3530,7 @@ struct PidNames : public Message {
 
     std::vector<std::string> pid_names;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         pid_names.clear();
         bool rc = true;
         std::string str;
@@ -3511,21 +3559,36 @@ struct WayPoint : public Message {
     virtual ID id() const override { return ID::MSP_WP; }
 
     Value<uint8_t> wp_no;
+    Value<uint8_t> action;  // INAV only
     Value<uint32_t> lat;
     Value<uint32_t> lon;
     Value<uint32_t> altHold;
-    Value<uint16_t> heading;
-    Value<uint16_t> staytime;
+    Value<uint16_t> heading;   // p1 in INAV
+    Value<uint16_t> staytime;  // p2 in INAV
+    Value<uint16_t> p3;        // INAV only
     Value<uint8_t> navflag;
 
-    virtual bool decode(const ByteVector& data) override {
+    // the request selects the waypoint by its number
+    virtual ByteVectorUptr encode() const override {
+        ByteVectorUptr data = std::make_unique<ByteVector>();
+        if(!data->pack(wp_no)) data.reset();
+        return data;
+    }
+
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(wp_no);
+        if(fw_variant == FirmwareVariant::INAV) {
+            rc &= data.unpack(action);
+        }
         rc &= data.unpack(lat);
         rc &= data.unpack(lon);
         rc &= data.unpack(altHold);
         rc &= data.unpack(heading);
         rc &= data.unpack(staytime);
+        if(fw_variant == FirmwareVariant::INAV) {
+            rc &= data.unpack(p3);
+        }
         rc &= data.unpack(navflag);
         return rc;
     }
@@ -3539,12 +3602,8 @@ struct BoxIds : public Message {
 
     ByteVector box_ids;
 
-    virtual bool decode(const ByteVector& data) override {
-        box_ids.clear();
-
-        for(uint8_t bi : data) box_ids.push_back(bi);
-        ;
-
+    virtual bool decode(const ByteView& data) override {
+        box_ids.assign(data.begin(), data.end());
         return true;
     }
 
@@ -3572,7 +3631,7 @@ struct ServoConf : public Message {
 
     ServoConfRange servo_conf[N_SERVO];
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(size_t i(0); i < N_SERVO; i++) {
             rc &= data.unpack(servo_conf[i].min);
@@ -3597,7 +3656,7 @@ struct NavStatus : public Message {
     Value<uint8_t> NAV_error;
     int16_t target_bearing;  // degrees
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(GPS_mode);
         rc &= data.unpack(NAV_state);
@@ -3646,7 +3705,7 @@ struct NavConfig : public Message, public GpsConf {
 
     virtual ID id() const override { return ID::MSP_NAV_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(filtering);
         rc &= data.unpack(lead_filter);
@@ -3689,7 +3748,7 @@ struct Motor3dConfig : public Message {
     Value<uint16_t> deadband3d_high;
     Value<uint16_t> neutral_3d;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(deadband3d_low);
         rc &= data.unpack(deadband3d_high);
@@ -3710,7 +3769,7 @@ struct RcDeadband : public RcDeadbandSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_RC_DEADBAND; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(deadband);
         rc &= data.unpack(yaw_deadband);
@@ -3731,7 +3790,7 @@ struct SensorAlignment : public SensorAlignmentSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_SENSOR_ALIGNMENT; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(gyro_align);
         rc &= data.unpack(acc_align);
@@ -3752,16 +3811,12 @@ struct LedStripModecolor : public Message {
     Value<uint8_t> reserved;
     Value<uint8_t> led_strip_aux_channel;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         for(auto& mode : mode_colors) {
-            for(auto& color : mode) {
-                rc &= data.unpack(color);
-            }
-        }
-        for(auto& special : special_colors) {
-            rc &= data.unpack(special);
+            rc &= data.unpack(mode);
         }
+        rc &= data.unpack(special_colors);
 
         rc &= data.unpack(led_aux_channel);
         rc &= data.unpack(reserved);
@@ -3782,7 +3837,7 @@ struct VoltageMeters : public Message {
 
     std::vector<VoltageMeter> meters;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         const size_t nmeter = data.size() / 2;
         meters.resize(nmeter);
         bool rc = true;
@@ -3815,7 +3870,7 @@ struct CurrentMeters : public Message {
 
     std::vector<CurrentMeter> meters;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         const size_t nmeter = data.size() / 5;
         meters.resize(nmeter);
         bool rc = true;
@@ -3851,7 +3906,7 @@ struct BatteryState : public Message {
     Value<uint16_t> amperage;      // A
     Value<state_t> state;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(cell_count);
         rc &= data.unpack(capacity_mAh);
@@ -3907,7 +3962,7 @@ struct MotorConfig : public MotorConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_MOTOR_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(min_throttle);
         rc &= data.unpack(max_throttle);
@@ -3928,7 +3983,7 @@ struct GpsConfig : public GpsConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_GPS_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(provider);
         rc &= data.unpack(sbas_mode);
@@ -3945,7 +4000,7 @@ struct CompassConfig : public Message {
 
     Value<uint16_t> mag_declination;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(mag_declination);
     }
 };
@@ -3963,7 +4018,7 @@ struct EscSensorData : public Message {
     Value<uint8_t> motor_count;
     std::vector<EscData> esc_data;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         if(data.empty()) {
             motor_count = 0;
             return true;
@@ -3993,7 +4048,7 @@ struct StatusEx : public StatusBase, public Message {
     Value<uint16_t> arming_flags;
     Value<uint8_t> acc_calibration_axis_flags;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= StatusBase::unpack_from(data);
         if(fw_variant == FirmwareVariant::INAV) {
@@ -4024,7 +4079,7 @@ struct SensorStatus : public Message {
     Value<uint8_t> hw_pitometer_status;
     Value<uint8_t> hw_optical_flow_status;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(hardware_healthy);
         rc &= data.unpack(hw_gyro_status);
@@ -4049,7 +4104,7 @@ struct Uid : public Message {
     Value<uint32_t> u_id_1;
     Value<uint32_t> u_id_2;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(u_id_0);
         rc &= data.unpack(u_id_1);
@@ -4076,7 +4131,7 @@ struct GpsSvInfo : public Message {
     Value<uint8_t> channel_count;
     std::vector<GpsSvInfoSettings> sv_info;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         if(fw_variant == FirmwareVariant::INAV) {
             rc &= data.consume(4);
@@ -4110,7 +4165,7 @@ struct GpsStatistics : public Message {
     Value<uint16_t> eph;
     Value<uint16_t> epv;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(last_msg_dt);
         rc &= data.unpack(errors);
@@ -4130,7 +4185,7 @@ struct OsdVideoConfig : public Message {
 
     virtual ID id() const override { return ID::MSP_OSD_VIDEO_CONFIG; }
 
-    virtual bool decode(const ByteVector& /*data*/) override { return false; }
+    virtual bool decode(const ByteView& /*data*/) override { return false; }
 };
 
 // MSP_SET_OSD_VIDEO_CONFIG        = 181,
@@ -4158,8 +4213,8 @@ struct Displayport : public Message {
         if(sub_cmd() == 3) {
             rc &= data->pack(row);
             rc &= data->pack(col);
+            // attribute, the characters follow without a length
             rc &= data->pack(uint8_t(0));
-            rc &= data->pack(uint8_t(str().size()));
             rc &= data->pack(str);
         }
         if(!rc) data.reset();
@@ -4200,7 +4255,7 @@ struct BeeperConfig : public BeeperConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_BEEPER_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(beeper_off_mask);
         rc &= data.unpack(beacon_tone);
@@ -4252,7 +4307,7 @@ struct TxInfo : public Message {
     Value<uint8_t> rssi_source;
     Value<uint8_t> rtc_date_time_status;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(rssi_source);
         rc &= data.unpack(rtc_date_time_status);
@@ -4276,11 +4331,7 @@ struct SetRawRc : public Message {
 
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
-        bool rc             = true;
-        for(const uint16_t& c : channels) {
-            rc &= data->pack(c);
-        }
-        if(!rc) data.reset();
+        if(!data->pack(channels)) data.reset();
         return data;
     }
 };
@@ -4548,8 +4599,7 @@ struct SetMotor : public Message {
 
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
-        bool rc             = true;
-        for(size_t i(0); i < N_MOTOR; i++) rc &= data->pack(motor[i]);
+        const bool rc       = data->pack(motor);
         assert(data->size() == N_MOTOR * 2);
         if(!rc) data.reset();
         return data;
@@ -4730,7 +4780,7 @@ struct AccTrim : public AccTrimSettings, public Message {
 
     virtual ID id() const override { return ID::MSP_ACC_TRIM; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(pitch);
         rc &= data.unpack(roll);
@@ -4747,7 +4797,7 @@ struct ServoMixRule : public Packable {
     uint8_t max;
     uint8_t box;
 
-    bool unpack_from(const ByteVector& data) {
+    bool unpack_from(const ByteView& data) {
         bool rc = true;
         rc &= data.unpack(target_channel);
         rc &= data.unpack(input_source);
@@ -4781,7 +4831,7 @@ struct ServoMixRules : public Message {
 
     std::vector<Value<ServoMixRule>> rules;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         while(data.unpacking_remaining()) {
             Value<ServoMixRule> rule;
@@ -4842,7 +4892,7 @@ struct Set4WayIF : public Message {
         return data;
     }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(esc_count);
     }
 };
@@ -4876,7 +4926,7 @@ struct Rtc : public RtcVals, public Message {
 
     virtual ID id() const override { return ID::MSP_RTC; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(secs);
         rc &= data.unpack(millis);
@@ -4913,7 +4963,7 @@ struct DebugMessage : public Message {
 
     Value<std::string> debug_msg;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(debug_msg);
     }
 };
@@ -4929,7 +4979,7 @@ struct Debug : public Message {
     Value<uint16_t> debug3;
     Value<uint16_t> debug4;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(debug1);
         rc &= data.unpack(debug2);
@@ -4955,7 +5005,7 @@ struct CommonTz : public Message {
 
     Value<uint16_t> tz_offset;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(tz_offset);
     }
 };
@@ -5013,7 +5063,7 @@ struct CommonSetting : public Message {
         return data;
     }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         switch(expected_data_type) {
         case DATA_TYPE::UINT8:
             return data.unpack(uint8_val);
@@ -5117,7 +5167,7 @@ struct MotorMixer : public Packable {
     Value<float> pitch;
     Value<float> yaw;
 
-    bool unpack_from(const ByteVector& data) {
+    bool unpack_from(const ByteView& data) {
         bool rc = true;
         rc &= data.unpack<uint16_t>(throttle, 1000);
         rc &= data.unpack<uint16_t>(roll, 1000, 1);
@@ -5144,7 +5194,7 @@ struct CommonMotorMixer : public Message {
 
     std::vector<MotorMixer> mixer;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         while(data.unpacking_remaining()) {
             MotorMixer m;
@@ -5184,23 +5234,15 @@ struct InavStatus : public StatusBase, public Message {
     Value<uint8_t> config_profile;
     Value<uint32_t> arming_flags;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(cycle_time);
         rc &= data.unpack(i2c_errors);
 
         // get sensors
-        sensors.clear();
         uint16_t sensor = 0;
         rc &= data.unpack(sensor);
-        if(sensor & (1 << 0)) sensors.insert(Sensor::Accelerometer);
-        if(sensor & (1 << 1)) sensors.insert(Sensor::Barometer);
-        if(sensor & (1 << 2)) sensors.insert(Sensor::Magnetometer);
-        if(sensor & (1 << 3)) sensors.insert(Sensor::GPS);
-        if(sensor & (1 << 4)) sensors.insert(Sensor::Sonar);
-        if(sensor & (1 << 5)) sensors.insert(Sensor::OpticalFlow);
-        if(sensor & (1 << 6)) sensors.insert(Sensor::Pitot);
-        if(sensor & (1 << 15)) sensors.insert(Sensor::GeneralHealth);
+        sensorsFromWire(sensor, sensors);
 
         rc &= data.unpack(avg_system_load_pct);
         rc &= data.unpack(config_profile);
@@ -5208,12 +5250,9 @@ struct InavStatus : public StatusBase, public Message {
         rc &= data.unpack(arming_flags);
 
         // check active boxes
-        box_mode_flags.clear();
         uint32_t flag = 0;
         rc &= data.unpack(flag);
-        for(size_t ibox(0); ibox < sizeof(flag) * CHAR_BIT; ibox++) {
-            if(flag & (1 << ibox)) box_mode_flags.insert(ibox);
-        }
+        box_mode_flags.setBits(flag);
 
         return rc;
     }
@@ -5288,7 +5327,7 @@ struct InavOpticalFlow : public Message {
     Value<uint16_t> body_rate_x;
     Value<uint16_t> body_rate_y;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(raw_quality);
         rc &= data.unpack(flow_rate_x);
@@ -5310,7 +5349,7 @@ struct InavAnalog : public Message {
     Value<uint16_t> rssi;
     Value<uint16_t> amperage;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(battery_voltage);
         rc &= data.unpack(mAh_drawn);
@@ -5321,24 +5360,109 @@ struct InavAnalog : public Message {
 };
 
 struct InavMiscSettings {
-    Value<uint16_t> mid_rc;
-    Value<uint16_t> min_throttle;
-    Value<uint16_t> max_throttle;
-    Value<uint16_t> min_command;
-    Value<uint16_t> failsafe_throttle;
-    Value<uint8_t> gps_provider;
-    Value<uint8_t> gps_baudrate;
-    Value<uint8_t> gps_ubx_sbas;
-    Value<uint8_t> rssi_channel;
-    Value<uint16_t> mag_declination;
-    Value<uint16_t> voltage_scale;
-    Value<uint16_t> cell_min;
-    Value<uint16_t> cell_max;
-    Value<uint16_t> cell_warning;
-    Value<uint32_t> capacity;
-    Value<uint32_t> capacity_warning;
-    Value<uint32_t> capacity_critical;
-    Value<uint8_t> capacity_units;
+    // presence flags of the fields below
+    ValueMask<> present;
+    uint32_t capacity_          = 0;
+    uint32_t capacity_warning_  = 0;
+    uint32_t capacity_critical_ = 0;
+    uint16_t mid_rc_            = 0;
+    uint16_t min_throttle_      = 0;
+    uint16_t max_throttle_      = 0;
+    uint16_t min_command_       = 0;
+    uint16_t failsafe_throttle_ = 0;
+    uint16_t mag_declination_   = 0;
+    uint16_t voltage_scale_     = 0;
+    uint16_t cell_min_          = 0;
+    uint16_t cell_max_          = 0;
+    uint16_t cell_warning_      = 0;
+    uint8_t gps_provider_       = 0;
+    uint8_t gps_baudrate_       = 0;
+    uint8_t gps_ubx_sbas_       = 0;
+    uint8_t rssi_channel_       = 0;
+    uint8_t capacity_units_     = 0;
+
+    ValueRef<uint16_t> mid_rc() { return present.ref(mid_rc_, 0); }
+    ValueRef<const uint16_t> mid_rc() const { return present.ref(mid_rc_, 0); }
+    ValueRef<uint16_t> min_throttle() { return present.ref(min_throttle_, 1); }
+    ValueRef<const uint16_t> min_throttle() const {
+        return present.ref(min_throttle_, 1);
+    }
+    ValueRef<uint16_t> max_throttle() { return present.ref(max_throttle_, 2); }
+    ValueRef<const uint16_t> max_throttle() const {
+        return present.ref(max_throttle_, 2);
+    }
+    ValueRef<uint16_t> min_command() { return present.ref(min_command_, 3); }
+    ValueRef<const uint16_t> min_command() const {
+        return present.ref(min_command_, 3);
+    }
+    ValueRef<uint16_t> failsafe_throttle() {
+        return present.ref(failsafe_throttle_, 4);
+    }
+    ValueRef<const uint16_t> failsafe_throttle() const {
+        return present.ref(failsafe_throttle_, 4);
+    }
+    ValueRef<uint8_t> gps_provider() { return present.ref(gps_provider_, 5); }
+    ValueRef<const uint8_t> gps_provider() const {
+        return present.ref(gps_provider_, 5);
+    }
+    ValueRef<uint8_t> gps_baudrate() { return present.ref(gps_baudrate_, 6); }
+    ValueRef<const uint8_t> gps_baudrate() const {
+        return present.ref(gps_baudrate_, 6);
+    }
+    ValueRef<uint8_t> gps_ubx_sbas() { return present.ref(gps_ubx_sbas_, 7); }
+    ValueRef<const uint8_t> gps_ubx_sbas() const {
+        return present.ref(gps_ubx_sbas_, 7);
+    }
+    ValueRef<uint8_t> rssi_channel() { return present.ref(rssi_channel_, 8); }
+    ValueRef<const uint8_t> rssi_channel() const {
+        return present.ref(rssi_channel_, 8);
+    }
+    ValueRef<uint16_t> mag_declination() {
+        return present.ref(mag_declination_, 9);
+    }
+    ValueRef<const uint16_t> mag_declination() const {
+        return present.ref(mag_declination_, 9);
+    }
+    ValueRef<uint16_t> voltage_scale() {
+        return present.ref(voltage_scale_, 10);
+    }
+    ValueRef<const uint16_t> voltage_scale() const {
+        return present.ref(voltage_scale_, 10);
+    }
+    ValueRef<uint16_t> cell_min() { return present.ref(cell_min_, 11); }
+    ValueRef<const uint16_t> cell_min() const {
+        return present.ref(cell_min_, 11);
+    }
+    ValueRef<uint16_t> cell_max() { return present.ref(cell_max_, 12); }
+    ValueRef<const uint16_t> cell_max() const {
+        return present.ref(cell_max_, 12);
+    }
+    ValueRef<uint16_t> cell_warning() { return present.ref(cell_warning_, 13); }
+    ValueRef<const uint16_t> cell_warning() const {
+        return present.ref(cell_warning_, 13);
+    }
+    ValueRef<uint32_t> capacity() { return present.ref(capacity_, 14); }
+    ValueRef<const uint32_t> capacity() const {
+        return present.ref(capacity_, 14);
+    }
+    ValueRef<uint32_t> capacity_warning() {
+        return present.ref(capacity_warning_, 15);
+    }
+    ValueRef<const uint32_t> capacity_warning() const {
+        return present.ref(capacity_warning_, 15);
+    }
+    ValueRef<uint32_t> capacity_critical() {
+        return present.ref(capacity_critical_, 16);
+    }
+    ValueRef<const uint32_t> capacity_critical() const {
+        return present.ref(capacity_critical_, 16);
+    }
+    ValueRef<uint8_t> capacity_units() {
+        return present.ref(capacity_units_, 17);
+    }
+    ValueRef<const uint8_t> capacity_units() const {
+        return present.ref(capacity_units_, 17);
+    }
 };
 
 // MSP2_INAV_MISC                  = 0x2003,
@@ -5347,26 +5471,26 @@ struct InavMisc : public InavMiscSettings, public Message {
 
     virtual ID id() const override { return ID::MSP2_INAV_MISC; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
-        rc &= data.unpack(mid_rc);
-        rc &= data.unpack(min_throttle);
-        rc &= data.unpack(max_throttle);
-        rc &= data.unpack(min_command);
-        rc &= data.unpack(failsafe_throttle);
-        rc &= data.unpack(gps_provider);
-        rc &= data.unpack(gps_baudrate);
-        rc &= data.unpack(gps_ubx_sbas);
-        rc &= data.unpack(rssi_channel);
-        rc &= data.unpack(mag_declination);
-        rc &= data.unpack(voltage_scale);
-        rc &= data.unpack(cell_min);
-        rc &= data.unpack(cell_max);
-        rc &= data.unpack(cell_warning);
-        rc &= data.unpack(capacity);
-        rc &= data.unpack(capacity_warning);
-        rc &= data.unpack(capacity_critical);
-        rc &= data.unpack(capacity_units);
+        rc &= data.unpack(mid_rc());
+        rc &= data.unpack(min_throttle());
+        rc &= data.unpack(max_throttle());
+        rc &= data.unpack(min_command());
+        rc &= data.unpack(failsafe_throttle());
+        rc &= data.unpack(gps_provider());
+        rc &= data.unpack(gps_baudrate());
+        rc &= data.unpack(gps_ubx_sbas());
+        rc &= data.unpack(rssi_channel());
+        rc &= data.unpack(mag_declination());
+        rc &= data.unpack(voltage_scale());
+        rc &= data.unpack(cell_min());
+        rc &= data.unpack(cell_max());
+        rc &= data.unpack(cell_warning());
+        rc &= data.unpack(capacity());
+        rc &= data.unpack(capacity_warning());
+        rc &= data.unpack(capacity_critical());
+        rc &= data.unpack(capacity_units());
         return rc;
     }
 };
@@ -5380,25 +5504,24 @@ struct InavSetMisc : public InavMiscSettings, public Message {
     virtual ByteVectorUptr encode() const override {
         ByteVectorUptr data = std::make_unique<ByteVector>();
         bool rc             = true;
-        rc &= data->pack(mid_rc);
-        rc &= data->pack(min_throttle);
-        rc &= data->pack(mid_rc);
-        rc &= data->pack(max_throttle);
-        rc &= data->pack(min_command);
-        rc &= data->pack(failsafe_throttle);
-        rc &= data->pack(gps_provider);
-        rc &= data->pack(gps_baudrate);
-        rc &= data->pack(gps_ubx_sbas);
-        rc &= data->pack(rssi_channel);
-        rc &= data->pack(mag_declination);
-        rc &= data->pack(voltage_scale);
-        rc &= data->pack(cell_min);
-        rc &= data->pack(cell_max);
-        rc &= data->pack(cell_warning);
-        rc &= data->pack(capacity);
-        rc &= data->pack(capacity_warning);
-        rc &= data->pack(capacity_critical);
-        rc &= data->pack(capacity_units);
+        rc &= data->pack(mid_rc());
+        rc &= data->pack(min_throttle());
+        rc &= data->pack(max_throttle());
+        rc &= data->pack(min_command());
+        rc &= data->pack(failsafe_throttle());
+        rc &= data->pack(gps_provider());
+        rc &= data->pack(gps_baudrate());
+        rc &= data->pack(gps_ubx_sbas());
+        rc &= data->pack(rssi_channel());
+        rc &= data->pack(mag_declination());
+        rc &= data->pack(voltage_scale());
+        rc &= data->pack(cell_min());
+        rc &= data->pack(cell_max());
+        rc &= data->pack(cell_warning());
+        rc &= data->pack(capacity());
+        rc &= data->pack(capacity_warning());
+        rc &= data->pack(capacity_critical());
+        rc &= data->pack(capacity_units());
         if(!rc) data.reset();
         return data;
     }
@@ -5423,7 +5546,7 @@ struct InavBatteryConfig : public InavBatteryConfigSettings, public Message {
 
     virtual ID id() const override { return ID::MSP2_INAV_BATTERY_CONFIG; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(voltage_scale);
         rc &= data.unpack(cell_min);
@@ -5488,7 +5611,7 @@ struct InavRateProfile : public InavRateProfileSettings, public Message {
 
     virtual ID id() const override { return ID::MSP2_INAV_RATE_PROFILE; }
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         bool rc = true;
         rc &= data.unpack(throttle_rc_mid);
         rc &= data.unpack(throttle_rc_expo);
@@ -5548,147 +5671,283 @@ struct InavAirSpeed : public InavMiscSettings, public Message {
 
     Value<uint32_t> speed;
 
-    virtual bool decode(const ByteVector& data) override {
+    virtual bool decode(const ByteView& data) override {
         return data.unpack(speed);
     }
 };
 
 // MSP2_BTFL_PUSH_60           = 0x300B,
-struct BtflPush60 : public Message {
-    BtflPush60(FirmwareVariant v) : Message(v) {}
-
-    virtual ID id() const override { return ID::MSP2_BTFL_PUSH_60; }
-
-    Value<uint32_t> current_time_us;
-
-    Value<int16_t> acc_x;
-    Value<int16_t> acc_y;
-    Value<int16_t> acc_z;
+struct BtflPush60Data {
+    // presence flags of the fields below
+    ValueMask<> present;
+    uint32_t current_time_us_ = 0;
+    float altitude_           = 0;  // m
+    float vario_              = 0;  // m/s
+    float voltage_            = 0;  // Volt
+    float amperage_           = 0;  // Ampere
+    int16_t acc_x_            = 0;
+    int16_t acc_y_            = 0;
+    int16_t acc_z_            = 0;
+    int16_t gyro_x_           = 0;
+    int16_t gyro_y_           = 0;
+    int16_t gyro_z_           = 0;
+
+    ValueRef<uint32_t> current_time_us() {
+        return present.ref(current_time_us_, 0);
+    }
+    ValueRef<const uint32_t> current_time_us() const {
+        return present.ref(current_time_us_, 0);
+    }
+
+    ValueRef<int16_t> acc_x() { return present.ref(acc_x_, 1); }
+    ValueRef<const int16_t> acc_x() const { return present.ref(acc_x_, 1); }
+    ValueRef<int16_t> acc_y() { return present.ref(acc_y_, 2); }
+    ValueRef<const int16_t> acc_y() const { return present.ref(acc_y_, 2); }
+    ValueRef<int16_t> acc_z() { return present.ref(acc_z_, 3); }
+    ValueRef<const int16_t> acc_z() const { return present.ref(acc_z_, 3); }
 
     // filtered gyro data
-    Value<int16_t> gyro_x;
-    Value<int16_t> gyro_y;
-    Value<int16_t> gyro_z;
-
-    Value<float> altitude;      // m
-    Value<float> vario;         // m/s
-
-    Value<float> voltage;       // Volt
-    Value<float> amperage;      // Ampere
-
-    virtual bool decode(const ByteVector& data) override {
+    ValueRef<int16_t> gyro_x() { return present.ref(gyro_x_, 4); }
+    ValueRef<const int16_t> gyro_x() const { return present.ref(gyro_x_, 4); }
+    ValueRef<int16_t> gyro_y() { return present.ref(gyro_y_, 5); }
+    ValueRef<const int16_t> gyro_y() const { return present.ref(gyro_y_, 5); }
+    ValueRef<int16_t> gyro_z() { return present.ref(gyro_z_, 6); }
+    ValueRef<const int16_t> gyro_z() const { return present.ref(gyro_z_, 6); }
+
+    ValueRef<float> altitude() { return present.ref(altitude_, 7); }
+    ValueRef<const float> altitude() const { return present.ref(altitude_, 7); }
+    ValueRef<float> vario() { return present.ref(vario_, 8); }
+    ValueRef<const float> vario() const { return present.ref(vario_, 8); }
+
+    ValueRef<float> voltage() { return present.ref(voltage_, 9); }
+    ValueRef<const float> voltage() const { return present.ref(voltage_, 9); }
+    ValueRef<float> amperage() { return present.ref(amperage_, 10); }
+    ValueRef<const float> amperage() const {
+        return present.ref(amperage_, 10);
+    }
+
+    bool decode(const ByteView& data) {
         bool rc = true;
 
-        rc &= data.unpack(current_time_us);
+        rc &= data.unpack(current_time_us());
 
-        rc &= data.unpack(acc_x);
-        rc &= data.unpack(acc_y);
-        rc &= data.unpack(acc_z);
+        rc &= data.unpack(acc_x());
+        rc &= data.unpack(acc_y());
+        rc &= data.unpack(acc_z());
 
-        rc &= data.unpack(gyro_x);
-        rc &= data.unpack(gyro_y);
-        rc &= data.unpack(gyro_z);
+        rc &= data.unpack(gyro_x());
+        rc &= data.unpack(gyro_y());
+        rc &= data.unpack(gyro_z());
 
-        rc &= data.unpack<int32_t>(altitude, 100);
-        rc &= data.unpack<int16_t>(vario, 100);
+        rc &= data.unpack<int32_t>(altitude(), 100);
+        rc &= data.unpack<int16_t>(vario(), 100);
 
-        rc &= data.unpack<uint16_t>(voltage, 100);
-        rc &= data.unpack<int16_t>(amperage, 100);
+        rc &= data.unpack<uint16_t>(voltage(), 100);
+        rc &= data.unpack<int16_t>(amperage(), 100);
 
         return rc;
     }
 };
 
-// MSP2_BTFL_PUSH_120           = 0x300C,
-struct BtflPush120 : public Message {
-    BtflPush120(FirmwareVariant v) : Message(v) {}
+static_assert(std::is_trivially_copyable<BtflPush60Data>::value,
+              "push samples must be trivially copyable");
 
-    virtual ID id() const override { return ID::MSP2_BTFL_PUSH_120; }
+struct BtflPush60 : public BtflPush60Data, public Message {
+    BtflPush60(FirmwareVariant v) : Message(v) {}
+
+    typedef BtflPush60Data sample_type;
 
-    Value<uint32_t> current_time_us;
+    virtual ID id() const override { return ID::MSP2_BTFL_PUSH_60; }
 
-    Value<int16_t> acc_x;
-    Value<int16_t> acc_y;
-    Value<int16_t> acc_z;
+    virtual bool decode(const ByteView& data) override {
+        return BtflPush60Data::decode(data);
+    }
+};
+
+// MSP2_BTFL_PUSH_120           = 0x300C,
+struct BtflPush120Data {
+    // presence flags of the fields below
+    ValueMask<> present;
+    uint32_t current_time_us_ = 0;
+    float att_roll_           = 0;  // [-180, +180] degree
+    float att_pitch_          = 0;  // [-90, +90] degree
+    float att_yaw_            = 0;  // [-180, +180] degree
+    int16_t acc_x_            = 0;
+    int16_t acc_y_            = 0;
+    int16_t acc_z_            = 0;
+    int16_t gyro_x_           = 0;
+    int16_t gyro_y_           = 0;
+    int16_t gyro_z_           = 0;
+    int16_t rc_roll_          = 0;
+    int16_t rc_pitch_         = 0;
+    int16_t rc_yaw_           = 0;
+    int16_t rc_throttle_      = 0;
+    int16_t rc_aux1_          = 0;
+    int16_t rc_aux2_          = 0;
+
+    ValueRef<uint32_t> current_time_us() {
+        return present.ref(current_time_us_, 0);
+    }
+    ValueRef<const uint32_t> current_time_us() const {
+        return present.ref(current_time_us_, 0);
+    }
+
+    ValueRef<int16_t> acc_x() { return present.ref(acc_x_, 1); }
+    ValueRef<const int16_t> acc_x() const { return present.ref(acc_x_, 1); }
+    ValueRef<int16_t> acc_y() { return present.ref(acc_y_, 2); }
+    ValueRef<const int16_t> acc_y() const { return present.ref(acc_y_, 2); }
+    ValueRef<int16_t> acc_z() { return present.ref(acc_z_, 3); }
+    ValueRef<const int16_t> acc_z() const { return present.ref(acc_z_, 3); }
 
     // filtered gyro data
-    Value<int16_t> gyro_x;
-    Value<int16_t> gyro_y;
-    Value<int16_t> gyro_z;
-
-    Value<float> att_roll;  // [-180, +180] degree
-    Value<float> att_pitch; // [-90, +90] degree
-    Value<float> att_yaw; // [-180, +180] degree
-
-    Value<int16_t> rc_roll;
-    Value<int16_t> rc_pitch;
-    Value<int16_t> rc_yaw;
-    Value<int16_t> rc_throttle;
-    Value<int16_t> rc_aux1;
-    Value<int16_t> rc_aux2;
-
-    virtual bool decode(const ByteVector& data) override {
+    ValueRef<int16_t> gyro_x() { return present.ref(gyro_x_, 4); }
+    ValueRef<const int16_t> gyro_x() const { return present.ref(gyro_x_, 4); }
+    ValueRef<int16_t> gyro_y() { return present.ref(gyro_y_, 5); }
+    ValueRef<const int16_t> gyro_y() const { return present.ref(gyro_y_, 5); }
+    ValueRef<int16_t> gyro_z() { return present.ref(gyro_z_, 6); }
+    ValueRef<const int16_t> gyro_z() const { return present.ref(gyro_z_, 6); }
+
+    ValueRef<float> att_roll() { return present.ref(att_roll_, 7); }
+    ValueRef<const float> att_roll() const { return present.ref(att_roll_, 7); }
+    ValueRef<float> att_pitch() { return present.ref(att_pitch_, 8); }
+    ValueRef<const float> att_pitch() const {
+        return present.ref(att_pitch_, 8);
+    }
+    ValueRef<float> att_yaw() { return present.ref(att_yaw_, 9); }
+    ValueRef<const float> att_yaw() const { return present.ref(att_yaw_, 9); }
+
+    ValueRef<int16_t> rc_roll() { return present.ref(rc_roll_, 10); }
+    ValueRef<const int16_t> rc_roll() const {
+        return present.ref(rc_roll_, 10);
+    }
+    ValueRef<int16_t> rc_pitch() { return present.ref(rc_pitch_, 11); }
+    ValueRef<const int16_t> rc_pitch() const {
+        return present.ref(rc_pitch_, 11);
+    }
+    ValueRef<int16_t> rc_yaw() { return present.ref(rc_yaw_, 12); }
+    ValueRef<const int16_t> rc_yaw() const { return present.ref(rc_yaw_, 12); }
+    ValueRef<int16_t> rc_throttle() { return present.ref(rc_throttle_, 13); }
+    ValueRef<const int16_t> rc_throttle() const {
+        return present.ref(rc_throttle_, 13);
+    }
+    ValueRef<int16_t> rc_aux1() { return present.ref(rc_aux1_, 14); }
+    ValueRef<const int16_t> rc_aux1() const {
+        return present.ref(rc_aux1_, 14);
+    }
+    ValueRef<int16_t> rc_aux2() { return present.ref(rc_aux2_, 15); }
+    ValueRef<const int16_t> rc_aux2() const {
+        return present.ref(rc_aux2_, 15);
+    }
+
+    bool decode(const ByteView& data) {
         bool rc = true;
 
-        rc &= data.unpack(current_time_us);
+        rc &= data.unpack(current_time_us());
 
-        rc &= data.unpack(acc_x);
-        rc &= data.unpack(acc_y);
-        rc &= data.unpack(acc_z);
+        rc &= data.unpack(acc_x());
+        rc &= data.unpack(acc_y());
+        rc &= data.unpack(acc_z());
 
-        rc &= data.unpack(gyro_x);
-        rc &= data.unpack(gyro_y);
-        rc &= data.unpack(gyro_z);
+        rc &= data.unpack(gyro_x());
+        rc &= data.unpack(gyro_y());
+        rc &= data.unpack(gyro_z());
 
-        rc &= data.unpack<int16_t>(att_roll, 10);
-        rc &= data.unpack<int16_t>(att_pitch, 10);
-        rc &= data.unpack<int16_t>(att_yaw, 10);
+        rc &= data.unpack<int16_t>(att_roll(), 10);
+        rc &= data.unpack<int16_t>(att_pitch(), 10);
+        rc &= data.unpack<int16_t>(att_yaw(), 10);
 
-        rc &= data.unpack(rc_roll);
-        rc &= data.unpack(rc_pitch);
-        rc &= data.unpack(rc_yaw);
-        rc &= data.unpack(rc_throttle);
-        rc &= data.unpack(rc_aux1);
-        rc &= data.unpack(rc_aux2);
+        rc &= data.unpack(rc_roll());
+        rc &= data.unpack(rc_pitch());
+        rc &= data.unpack(rc_yaw());
+        rc &= data.unpack(rc_throttle());
+        rc &= data.unpack(rc_aux1());
+        rc &= data.unpack(rc_aux2());
 
         return rc;
     }
 };
 
-// MSP2_BTFL_PUSH_480           = 0x300D,
-struct BtflPush480 : public Message {
-    BtflPush480(FirmwareVariant v) : Message(v) {}
+static_assert(std::is_trivially_copyable<BtflPush120Data>::value,
+              "push samples must be trivially copyable");
 
-    virtual ID id() const override { return ID::MSP2_BTFL_PUSH_480; }
+struct BtflPush120 : public BtflPush120Data, public Message {
+    BtflPush120(FirmwareVariant v) : Message(v) {}
 
-    Value<uint32_t> current_time_us;
+    typedef BtflPush120Data sample_type;
 
-    Value<int16_t> acc_x;
-    Value<int16_t> acc_y;
-    Value<int16_t> acc_z;
+    virtual ID id() const override { return ID::MSP2_BTFL_PUSH_120; }
 
-    // filtered gyro data
-    Value<int16_t> gyro_x;
-    Value<int16_t> gyro_y;
-    Value<int16_t> gyro_z;
+    virtual bool decode(const ByteView& data) override {
+        return BtflPush120Data::decode(data);
+    }
+};
+
+// MSP2_BTFL_PUSH_480           = 0x300D,
+struct BtflPush480Data {
+    // presence flags of the fields below
+    ValueMask<> present;
+    uint32_t current_time_us_ = 0;
+    int16_t acc_x_            = 0;
+    int16_t acc_y_            = 0;
+    int16_t acc_z_            = 0;
+    int16_t gyro_x_           = 0;
+    int16_t gyro_y_           = 0;
+    int16_t gyro_z_           = 0;
+
+    ValueRef<uint32_t> current_time_us() {
+        return present.ref(current_time_us_, 0);
+    }
+    ValueRef<const uint32_t> current_time_us() const {
+        return present.ref(current_time_us_, 0);
+    }
+
+    ValueRef<int16_t> acc_x() { return present.ref(acc_x_, 1); }
+    ValueRef<const int16_t> acc_x() const { return present.ref(acc_x_, 1); }
+    ValueRef<int16_t> acc_y() { return present.ref(acc_y_, 2); }
+    ValueRef<const int16_t> acc_y() const { return present.ref(acc_y_, 2); }
+    ValueRef<int16_t> acc_z() { return present.ref(acc_z_, 3); }
+    ValueRef<const int16_t> acc_z() const { return present.ref(acc_z_, 3); }
 
-    virtual bool decode(const ByteVector& data) override {
+    // filtered gyro data
+    ValueRef<int16_t> gyro_x() { return present.ref(gyro_x_, 4); }
+    ValueRef<const int16_t> gyro_x() const { return present.ref(gyro_x_, 4); }
+    ValueRef<int16_t> gyro_y() { return present.ref(gyro_y_, 5); }
+    ValueRef<const int16_t> gyro_y() const { return present.ref(gyro_y_, 5); }
+    ValueRef<int16_t> gyro_z() { return present.ref(gyro_z_, 6); }
+    ValueRef<const int16_t> gyro_z() const { return present.ref(gyro_z_, 6); }
+
+    bool decode(const ByteView& data) {
         bool rc = true;
 
-        rc &= data.unpack(current_time_us);
+        rc &= data.unpack(current_time_us());
 
-        rc &= data.unpack(acc_x);
-        rc &= data.unpack(acc_y);
-        rc &= data.unpack(acc_z);
+        rc &= data.unpack(acc_x());
+        rc &= data.unpack(acc_y());
+        rc &= data.unpack(acc_z());
 
-        rc &= data.unpack(gyro_x);
-        rc &= data.unpack(gyro_y);
-        rc &= data.unpack(gyro_z);
+        rc &= data.unpack(gyro_x());
+        rc &= data.unpack(gyro_y());
+        rc &= data.unpack(gyro_z());
 
         return rc;
     }
 };
 
+static_assert(std::is_trivially_copyable<BtflPush480Data>::value,
+              "push samples must be trivially copyable");
+
+struct BtflPush480 : public BtflPush480Data, public Message {
+    BtflPush480(FirmwareVariant v) : Message(v) {}
+
+    typedef BtflPush480Data sample_type;
+
+    virtual ID id() const override { return ID::MSP2_BTFL_PUSH_480; }
+
+    virtual bool decode(const ByteView& data) override {
+        return BtflPush480Data::decode(data);
+    }
+};
+
 }  // namespace msg
 }  // namespace msp
 
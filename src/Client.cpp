@@ -1,6 +1,10 @@
 #include <Client.hpp>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include "msp_msg.hpp"
 
 typedef unsigned int uint;
 
@@ -9,11 +13,29 @@ namespace client {
 
 Client::Client() :
     port(io),
+    pending_count(0),
+    cache_count(0),
+    push_stream_count(0),
+    max_payload_size_(4096),
+    frames_received(0),
+    crc_errors(0),
+    resyncs(0),
+    bytes_discarded(0),
+    realtime_enabled_(false),
+    serial_tuning_enabled_(false),
+    baudrate_(0),
+    supervisor_stop(false),
+    link_lost(false),
+    auto_reconnect_(false),
+    reconnect_period_(0.1),
+    passthrough_(false),
+    mode_switch_(false),
+    has_frame_tap_(false),
     log_level_(SILENT),
     msp_ver_(1),
     fw_variant(FirmwareVariant::INAV) {}
 
-Client::~Client() {}
+Client::~Client() { stopSupervisor(); }
 
 void Client::setLoggingLevel(const LoggingLevel& level) { log_level_ = level; }
 
@@ -32,26 +54,125 @@ void Client::setVariant(const FirmwareVariant& v) { fw_variant = v; }
 FirmwareVariant Client::getVariant() const { return fw_variant; }
 
 bool Client::start(const std::string& device, const size_t baudrate) {
+    // keep the settings for reopening the device
+    device_   = device;
+    baudrate_ = baudrate;
     return connectPort(device, baudrate) && startReadThread() &&
-           startSubscriptions();
+           startSupervisor() && startSubscriptions();
 }
 
 bool Client::stop() {
+    stopSupervisor();
     return disconnectPort() && stopReadThread() && stopSubscriptions();
 }
 
+size_t Client::probeBaudrate(const std::string& device,
+                             const BaudrateProbe& probe) {
+    std::vector<size_t> rates = probe.rates;
+    std::sort(rates.begin(), rates.end(), std::greater<size_t>());
+    for(const size_t rate : rates) {
+        if(isConnected()) {
+            if(!setBaudrate(rate)) continue;
+        }
+        else if(!start(device, rate)) {
+            return 0;
+        }
+        if(log_level_ >= INFO)
+            std::cout << "probing baudrate " << rate << std::endl;
+
+        // the first ping may be lost in data from the previous rate
+        msp::msg::ApiVersion ping(fw_variant);
+        if(!sendMessage(ping, probe.timeout) &&
+           !sendMessage(ping, probe.timeout))
+            continue;
+
+        // the rate has to be stable, not just work by chance
+        const uint64_t crc_before = crc_errors;
+        size_t failures           = 0;
+        for(size_t i = 0; i < probe.burst; ++i) {
+            if(!sendMessage(ping, probe.timeout)) failures++;
+        }
+        const size_t errors =
+            std::max(failures, size_t(crc_errors - crc_before));
+        if(double(errors) <= probe.max_error_rate * double(probe.burst)) {
+            if(log_level_ >= INFO)
+                std::cout << "selected baudrate " << rate << " (" << errors
+                          << " errors in " << probe.burst << " pings)"
+                          << std::endl;
+            return rate;
+        }
+        if(log_level_ >= INFO)
+            std::cout << "baudrate " << rate << " is unstable (" << errors
+                      << " errors in " << probe.burst << " pings)"
+                      << std::endl;
+    }
+    stop();
+    return 0;
+}
+
+bool Client::setBaudrate(const size_t baudrate) {
+    std::lock_guard<std::mutex> lock(mutex_send);
+    asio::error_code ec;
+    port.set_option(asio::serial_port::baud_rate(uint(baudrate)), ec);
+#ifdef __linux__
+    if(ec && port.is_open() &&
+       setCustomBaudrate(port.native_handle(), baudrate))
+        ec = asio::error_code();
+#endif
+    if(ec) {
+        if(log_level_ >= WARNING)
+            std::cerr << "cannot set baudrate " << baudrate << ": "
+                      << ec.message() << std::endl;
+        return false;
+    }
+    baudrate_ = baudrate;
+    return true;
+}
+
+size_t Client::getBaudrate() const { return baudrate_; }
+
+void Client::setSerialTuning(const SerialTuning& tuning) {
+    serial_tuning_enabled_ = true;
+    serial_tuning_         = tuning;
+    // the asynchronous reads would see an idle port as closed
+    if(serial_tuning_.vmin == 0) serial_tuning_.vmin = 1;
+}
+
+SerialStatus Client::getSerialStatus() {
+    std::lock_guard<std::mutex> lock(mutex_send);
+#ifdef __linux__
+    if(port.is_open()) return querySerialStatus(port.native_handle(), device_);
+#endif
+    return SerialStatus();
+}
+
 bool Client::connectPort(const std::string& device, const size_t baudrate) {
+    std::lock_guard<std::mutex> lock(mutex_send);
     try {
         port.open(device);
-        port.set_option(asio::serial_port::baud_rate(uint(baudrate)));
         port.set_option(
             asio::serial_port::parity(asio::serial_port::parity::none));
         port.set_option(asio::serial_port::character_size(
             asio::serial_port::character_size(8)));
         port.set_option(
             asio::serial_port::stop_bits(asio::serial_port::stop_bits::one));
+        // asio only knows the standard rates
+        asio::error_code ec;
+        port.set_option(asio::serial_port::baud_rate(uint(baudrate)), ec);
+#ifdef __linux__
+        if(ec && setCustomBaudrate(port.native_handle(), baudrate))
+            ec = asio::error_code();
+        if(serial_tuning_enabled_ &&
+           !applySerialTuning(port.native_handle(), device, serial_tuning_) &&
+           log_level_ >= WARNING)
+            std::cerr << "cannot apply all serial settings to " << device
+                      << std::endl;
+#endif
+        if(ec) throw std::system_error(ec);
     }
     catch(const std::system_error& e) {
+        asio::error_code ec;
+        port.close(ec);
         const int ecode = e.code().value();
         throw std::runtime_error("Error when opening '" + device +
                                  "': " + e.code().category().message(ecode) +
@@ -62,6 +183,7 @@ bool Client::connectPort(const std::string& device, const size_t baudrate) {
 }
 
 bool Client::disconnectPort() {
+    std::lock_guard<std::mutex> lock(mutex_send);
     asio::error_code ec;
     port.close(ec);
     if(ec) return false;
@@ -70,6 +192,138 @@ bool Client::disconnectPort() {
 
 bool Client::isConnected() const { return port.is_open(); }
 
+void Client::setAutoReconnect(const bool enable, const double& period) {
+    std::lock_guard<std::mutex> lock(mutex_supervisor);
+    auto_reconnect_   = enable;
+    reconnect_period_ = period;
+}
+
+void Client::setReconnectCallback(const std::function<bool()>& callback) {
+    std::lock_guard<std::mutex> lock(mutex_supervisor);
+    reconnect_callback = callback;
+}
+
+ConnectionStats Client::getConnectionStats() const {
+    std::lock_guard<std::mutex> lock(mutex_supervisor);
+    return connection_stats;
+}
+
+void Client::linkLost(const asio::error_code& ec) {
+    if(log_level_ >= WARNING)
+        std::cerr << "lost connection to " << device_ << ": " << ec.message()
+                  << std::endl;
+    disconnectPort();
+    buffer.consume(buffer.size());
+    // a reconnected flight controller talks MSP again
+    passthrough_ = false;
+
+    // the flight controller which comes back may answer differently
+    clearCache();
+
+    // nobody will answer the pending requests
+    {
+        std::lock_guard<std::mutex> lock2(cv_response_mtx);
+        std::lock_guard<std::mutex> lock(mutex_response);
+        for(auto& pending : pending_requests) pending.second->failed = true;
+        pending_requests.clear();
+        pending_count = 0;
+    }
+    cv_response.notify_all();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_supervisor);
+        connection_stats.link_losses++;
+        if(!link_lost) link_lost_stamp = std::chrono::steady_clock::now();
+        link_lost = true;
+    }
+    cv_supervisor.notify_all();
+}
+
+bool Client::reopenPort() {
+    stopReadThread();
+    disconnectPort();
+    buffer.consume(buffer.size());
+    try {
+        if(!connectPort(device_, baudrate_)) return false;
+    }
+    catch(const std::runtime_error& e) {
+        // the device has not reappeared yet
+        if(log_level_ >= DEBUG) std::cout << e.what() << std::endl;
+        return false;
+    }
+    return startReadThread();
+}
+
+bool Client::startSupervisor() {
+    std::lock_guard<std::mutex> lock(mutex_supervisor);
+    if(!auto_reconnect_ || supervisor.joinable()) return true;
+    supervisor_stop = false;
+    link_lost       = false;
+    supervisor      = std::thread(&Client::supervise, this);
+    return true;
+}
+
+void Client::stopSupervisor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_supervisor);
+        supervisor_stop = true;
+    }
+    cv_supervisor.notify_all();
+    if(supervisor.joinable()) supervisor.join();
+}
+
+void Client::supervise() {
+    ThreadPolicy policy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_threads);
+        policy = thread_config_.supervisor;
+    }
+    if(!applyThreadPolicy(pthread_self(), policy, "msp-supervisor") &&
+       log_level_ >= WARNING)
+        std::cerr << "cannot apply the policy of the supervisor thread"
+                  << std::endl;
+
+    std::unique_lock<std::mutex> lock(mutex_supervisor);
+    while(true) {
+        cv_supervisor.wait(lock,
+                           [this] { return supervisor_stop || link_lost; });
+        if(supervisor_stop) return;
+        const auto lost_stamp = link_lost_stamp;
+        const std::function<bool()> callback = reconnect_callback;
+        const std::chrono::duration<double> period(reconnect_period_);
+
+        // the subscriptions cannot send requests until the link is back
+        lock.unlock();
+        stopSubscriptions();
+        while(true) {
+            lock.lock();
+            if(supervisor_stop) return;
+            // a loss during the handshake is handled by the next attempt
+            link_lost = false;
+            lock.unlock();
+            if(reopenPort() && (!callback || callback())) break;
+            lock.lock();
+            cv_supervisor.wait_for(
+                lock, period, [this] { return supervisor_stop; });
+            lock.unlock();
+        }
+        startSubscriptions();
+
+        lock.lock();
+        const double latency = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() -
+                                   lost_stamp)
+                                   .count();
+        connection_stats.reconnects++;
+        connection_stats.last_latency = latency;
+        connection_stats.max_latency =
+            std::max(connection_stats.max_latency, latency);
+        if(log_level_ >= INFO)
+            std::cout << "reconnected to " << device_ << " after " << latency
+                      << " s" << std::endl;
+    }
+}
+
 bool Client::startReadThread() {
     // no point reading if we arent connected to anything
     if(!isConnected()) return false;
@@ -77,26 +331,90 @@ bool Client::startReadThread() {
     if(running_.test_and_set()) return false;
     // hit it!
     thread = std::thread([this] {
-        asio::async_read_until(port,
-                               buffer,
-                               std::bind(&Client::messageReady,
-                                         this,
-                                         std::placeholders::_1,
-                                         std::placeholders::_2),
-                               std::bind(&Client::processOneMessage,
-                                         this,
-                                         std::placeholders::_1,
-                                         std::placeholders::_2));
+        ThreadPolicy policy;
+        {
+            std::lock_guard<std::mutex> lock(mutex_threads);
+            policy = thread_config_.io;
+        }
+        if(!applyThreadPolicy(pthread_self(), policy, "msp-io") &&
+           log_level_ >= WARNING)
+            std::cerr << "cannot apply the policy of the read thread"
+                      << std::endl;
+        if(!prepareRealtime() && log_level_ >= WARNING)
+            std::cerr << "cannot lock the memory of the process" << std::endl;
+        scheduleRead();
         io.run();
     });
     return true;
 }
 
 bool Client::setRealtimePriority() {
-    sched_param sch_params;
-    sch_params.sched_priority = 80;
+    ThreadConfig config = getThreadConfig();
+    config.io           = ThreadPolicy::realtime();
+    return setThreadConfig(config);
+}
+
+bool Client::setThreadConfig(const ThreadConfig& config) {
+    bool rc = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_threads);
+        thread_config_ = config;
+        if(thread.joinable())
+            rc &= applyThreadPolicy(thread.native_handle(), config.io, "");
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_supervisor);
+        if(supervisor.joinable())
+            rc &= applyThreadPolicy(
+                supervisor.native_handle(), config.supervisor, "");
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_subscriptions);
+        for(const auto& sub : subscriptions)
+            rc &= sub.second->setThreadPolicy(config.scheduler);
+    }
+    if(config.lock_memory) rc &= lockMemory();
+    return rc;
+}
+
+ThreadConfig Client::getThreadConfig() const {
+    std::lock_guard<std::mutex> lock(mutex_threads);
+    return thread_config_;
+}
+
+void Client::setRealtimeProfile(const RealtimeProfile& profile) {
+    std::lock_guard<std::mutex> lock(mutex_threads);
+    realtime_enabled_ = true;
+    realtime_profile_ = profile;
+}
+
+RealtimeProfile Client::getRealtimeProfile() const {
+    std::lock_guard<std::mutex> lock(mutex_threads);
+    return realtime_profile_;
+}
 
-    return pthread_setschedparam(this->thread.native_handle(), SCHED_FIFO, &sch_params) != 0;
+bool Client::prepareRealtime() {
+    RealtimeProfile profile;
+    {
+        std::lock_guard<std::mutex> lock(mutex_threads);
+        if(!realtime_enabled_) return true;
+        profile = realtime_profile_;
+    }
+    // header and CRCs of a MSPv2 frame tunnelled in a jumbo MSPv1 frame
+    const std::size_t frame = profile.max_payload + 16;
+    // resize() writes to every page, clear() keeps the capacity
+    {
+        std::lock_guard<std::mutex> lock(mutex_send);
+        tx_frame.resize(std::max(tx_frame.capacity(), frame));
+        tx_frame.clear();
+    }
+    rx_message.payload.resize(std::max(rx_message.payload.capacity(), frame));
+    rx_message.payload.clear();
+    // asio reads up to 64 KiB at once into the stream buffer
+    const auto space = buffer.prepare(65536 + 2 * frame);
+    std::memset(space.data(), 0, space.size());
+    prefaultStack(profile.prefault_stack);
+    return !profile.lock_memory || lockMemory();
 }
 
 bool Client::stopReadThread() {
@@ -127,61 +445,503 @@ bool Client::stopSubscriptions() {
     return rc;
 }
 
-bool Client::sendMessage(msp::Message& message, const double& timeout) {
+bool Client::sendMessage(msp::Message& message, const double& timeout,
+                         const bool use_cache) {
     if(log_level_ >= DEBUG)
         std::cout << "sending message - ID " << size_t(message.id())
                   << std::endl;
-    if(!sendData(message.id(), message.encode())) {
+    ByteVectorUptr data = message.encode();
+    if(!data) data = std::make_unique<ByteVector>();
+    const bool shared = data->empty() && isRead(message.id());
+
+    // near-static messages may be answered locally
+    if(shared) {
+        const std::shared_ptr<const ReceivedMessage> cached =
+            use_cache ? getCachedResponse(message.id()) : nullptr;
+        if(cached) return decodeResponse(message, *cached);
+    }
+    else {
+        clearCache();
+    }
+
+    // depending on the timeout, we may wait a fixed amount of time, or
+    // indefinitely
+    typedef std::chrono::steady_clock::time_point time_point;
+    const time_point end =
+        timeout > 0 ? std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(size_t(timeout * 1e3))
+                    : time_point::max();
+
+    // share a request for the same ID, which is already on the wire
+    bool owner = false;
+    const std::shared_ptr<PendingRequest> request =
+        registerRequest(message.id(), shared, data->size(), end, owner);
+    if(!request) {
+        if(log_level_ >= INFO)
+            std::cout << "timed out waiting for pending request of message ID "
+                      << size_t(message.id()) << std::endl;
+        return false;
+    }
+    if(owner && !sendData(message.id(), *data)) {
         if(log_level_ >= WARNING)
             std::cerr << "message failed to send" << std::endl;
+        unregisterRequest(message.id(), request, true);
         return false;
     }
+
     // prepare the condition check
-    std::unique_lock<std::mutex> lock(cv_response_mtx);
+    std::shared_ptr<const ReceivedMessage> response;
+    bool failed          = false;
     const auto predicate = [&] {
-        mutex_response.lock();
-        const bool received = (request_received != nullptr) &&
-                              (request_received->id == message.id());
-        // unlock to wait for next message
-        if(!received) {
-            mutex_response.unlock();
-        }
-        return received;
+        std::lock_guard<std::mutex> lock_response(mutex_response);
+        response = request->response;
+        failed   = request->failed;
+        return response != nullptr || failed;
     };
-    // depending on the timeout, we may wait a fixed amount of time, or
-    // indefinitely
-    if(timeout > 0) {
-        if(!cv_response.wait_for(
-               lock,
-               std::chrono::milliseconds(size_t(timeout * 1e3)),
-               predicate)) {
+    // time at which the request has to be resent
+    time_point check = time_point::min();
+    std::unique_lock<std::mutex> lock(cv_response_mtx);
+    while(!predicate()) {
+        const time_point now = std::chrono::steady_clock::now();
+        if(now >= end) {
             if(log_level_ >= INFO)
                 std::cout << "timed out waiting for response to message ID "
                           << size_t(message.id()) << std::endl;
+            lock.unlock();
+            // other callers sharing the request still wait for the response
+            unregisterRequest(message.id(), request, false);
             return false;
         }
+        if(now >= check) {
+            lock.unlock();
+            check = retransmit(message.id(), request, *data);
+            lock.lock();
+            continue;
+        }
+        const time_point wake = std::min(check, end);
+        if(wake == time_point::max())
+            cv_response.wait(lock);
+        else
+            cv_response.wait_until(lock, wake);
+    }
+    lock.unlock();
+    if(failed) return false;
+    return decodeResponse(message, *response);
+}
+
+std::vector<bool> Client::sendMessages(
+    const std::vector<msp::Message*>& messages, const double& timeout) {
+    std::vector<bool> results(messages.size(), false);
+
+    typedef std::chrono::steady_clock::time_point time_point;
+    const time_point end =
+        timeout > 0 ? std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(size_t(timeout * 1e3))
+                    : time_point::max();
+
+    // register all requests before sending, so that no response is missed
+    std::vector<ByteVectorUptr> data(messages.size());
+    std::vector<std::shared_ptr<PendingRequest>> requests(messages.size());
+    std::vector<bool> owner(messages.size(), false);
+    for(size_t i(0); i < messages.size(); ++i) {
+        data[i] = messages[i]->encode();
+        if(!data[i]) data[i] = std::make_unique<ByteVector>();
+        const bool shared = data[i]->empty() && isRead(messages[i]->id());
+        if(shared) {
+            const std::shared_ptr<const ReceivedMessage> cached =
+                getCachedResponse(messages[i]->id());
+            if(cached) {
+                results[i] = decodeResponse(*messages[i], *cached);
+                continue;
+            }
+        }
+        else {
+            clearCache();
+        }
+        // a request which cannot share an earlier one of this batch would
+        // wait for itself
+        bool duplicate = false;
+        for(size_t k(0); k < i && !duplicate; ++k) {
+            duplicate = requests[k] && messages[k]->id() == messages[i]->id() &&
+                        !(shared && requests[k]->shared);
+        }
+        if(duplicate) {
+            if(log_level_ >= WARNING)
+                std::cerr << "message ID " << size_t(messages[i]->id())
+                          << " used twice in batch" << std::endl;
+            continue;
+        }
+        // never wait for a busy ID while holding registrations which are not
+        // sent yet, two batches of the same IDs in opposite order would wait
+        // for each other
+        bool is_owner = false;
+        requests[i]   = registerRequest(messages[i]->id(),
+                                        shared,
+                                        data[i]->size(),
+                                        std::chrono::steady_clock::now(),
+                                        is_owner);
+        owner[i]      = is_owner;
+        if(!requests[i] && log_level_ >= INFO)
+            std::cout << "message ID " << size_t(messages[i]->id())
+                      << " is busy with a pending request" << std::endl;
+    }
+
+    // send all requests back to back
+    std::vector<bool> waiting(messages.size(), false);
+    size_t n_waiting = 0;
+    for(size_t i(0); i < messages.size(); ++i) {
+        if(!requests[i]) continue;
+        if(!owner[i]) {
+            waiting[i] = true;
+            n_waiting++;
+            continue;
+        }
+        if(log_level_ >= DEBUG)
+            std::cout << "sending batched message - ID "
+                      << size_t(messages[i]->id()) << std::endl;
+        if(sendData(messages[i]->id(), *data[i])) {
+            waiting[i] = true;
+            n_waiting++;
+        }
+        else {
+            if(log_level_ >= WARNING)
+                std::cerr << "batched message failed to send" << std::endl;
+            unregisterRequest(messages[i]->id(), requests[i], true);
+        }
+    }
+
+    // collect responses as they arrive
+    // times at which the requests have to be resent
+    std::vector<time_point> check(messages.size(), time_point::min());
+    std::unique_lock<std::mutex> lock(cv_response_mtx);
+    while(n_waiting > 0) {
+        std::vector<std::pair<size_t, std::shared_ptr<const ReceivedMessage>>>
+            received;
+        {
+            std::lock_guard<std::mutex> lock_response(mutex_response);
+            for(size_t i(0); i < messages.size(); ++i) {
+                if(!waiting[i]) continue;
+                if(requests[i]->response || requests[i]->failed)
+                    received.emplace_back(i, requests[i]->response);
+            }
+        }
+
+        if(received.empty()) {
+            const time_point now = std::chrono::steady_clock::now();
+            if(now >= end) {
+                if(log_level_ >= INFO)
+                    std::cout << "timed out waiting for " << n_waiting
+                              << " batched responses" << std::endl;
+                break;
+            }
+            // resend the requests whose attempt timed out
+            bool checked    = false;
+            time_point wake = end;
+            for(size_t i(0); i < messages.size(); ++i) {
+                if(!waiting[i]) continue;
+                if(now >= check[i]) {
+                    lock.unlock();
+                    check[i] =
+                        retransmit(messages[i]->id(), requests[i], *data[i]);
+                    lock.lock();
+                    checked = true;
+                }
+                wake = std::min(wake, check[i]);
+            }
+            if(checked) continue;
+            if(wake == time_point::max())
+                cv_response.wait(lock);
+            else
+                cv_response.wait_until(lock, wake);
+            continue;
+        }
+
+        // decode without blocking the read thread
+        lock.unlock();
+        for(auto& r : received) {
+            results[r.first] =
+                r.second && decodeResponse(*messages[r.first], *r.second);
+            waiting[r.first] = false;
+            n_waiting--;
+        }
+        lock.lock();
+    }
+    lock.unlock();
+
+    // give up on the requests which timed out
+    for(size_t i(0); i < messages.size(); ++i) {
+        if(waiting[i]) unregisterRequest(messages[i]->id(), requests[i], false);
+    }
+
+    return results;
+}
+
+std::shared_ptr<Client::PendingRequest> Client::registerRequest(
+    const msp::ID& id, const bool shared, const std::size_t size,
+    const std::chrono::steady_clock::time_point& end, bool& owner) {
+    std::unique_lock<std::mutex> lock2(cv_response_mtx);
+    std::unique_lock<std::mutex> lock(mutex_response);
+    // a request still registered has callers waiting for its response, it
+    // must not be replaced by a request which cannot share it
+    auto it = pending_requests.find(id);
+    while(it != pending_requests.end() &&
+          !(shared && it->second->shared)) {
+        lock.unlock();
+        if(end == std::chrono::steady_clock::time_point::max())
+            cv_response.wait(lock2);
+        else if(cv_response.wait_until(lock2, end) ==
+                std::cv_status::timeout)
+            return nullptr;
+        lock.lock();
+        it = pending_requests.find(id);
+    }
+    owner = it == pending_requests.end();
+    std::shared_ptr<PendingRequest>& request = pending_requests[id];
+    pending_count = pending_requests.size();
+    if(owner) {
+        request           = std::make_shared<PendingRequest>();
+        request->shared   = shared;
+        request->size     = size;
+        request->attempts = 1;
+        request->sent     = std::chrono::steady_clock::now();
+        const double tout = attemptTimeout(id, size, 0);
+        request->deadline =
+            tout > 0 ? request->sent +
+                           std::chrono::duration_cast<
+                               std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(tout))
+                     : std::chrono::steady_clock::time_point::max();
+    }
+    request->waiters++;
+    return request;
+}
+
+void Client::unregisterRequest(const msp::ID& id,
+                               const std::shared_ptr<PendingRequest>& request,
+                               const bool failed) {
+    {
+        std::lock_guard<std::mutex> lock2(cv_response_mtx);
+        std::lock_guard<std::mutex> lock(mutex_response);
+        if(request->waiters > 0) request->waiters--;
+        if(failed) request->failed = true;
+        const auto it = pending_requests.find(id);
+        if(it != pending_requests.end() && it->second == request &&
+           (failed || request->waiters == 0))
+            pending_requests.erase(it);
+        pending_count = pending_requests.size();
+    }
+    // wake up callers sharing the failed request, and callers waiting to
+    // register a request for the same ID
+    cv_response.notify_all();
+}
+
+std::chrono::steady_clock::time_point Client::retransmit(
+    const msp::ID& id, const std::shared_ptr<PendingRequest>& request,
+    const ByteVector& data) {
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    const std::size_t max_retries = getRetryPolicy().max_retries;
+    std::size_t attempts          = 0;
+    std::chrono::steady_clock::time_point deadline;
+    {
+        std::lock_guard<std::mutex> lock(mutex_response);
+        if(request->response || request->failed || request->deadline > now)
+            return request->deadline;
+        attempts = request->attempts;
+        if(attempts <= max_retries) {
+            const double tout = attemptTimeout(id, request->size, attempts);
+            request->deadline =
+                now + std::chrono::duration_cast<
+                          std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double>(tout));
+            request->attempts++;
+            deadline = request->deadline;
+        }
+    }
+
+    if(attempts > max_retries) {
+        if(log_level_ >= INFO)
+            std::cout << "no response to message ID " << size_t(id)
+                      << " after " << attempts << " attempts" << std::endl;
+        unregisterRequest(id, request, true);
+        return std::chrono::steady_clock::time_point::max();
+    }
+
+    if(log_level_ >= DEBUG)
+        std::cout << "resending message - ID " << size_t(id) << std::endl;
+    if(!sendData(id, data)) {
+        if(log_level_ >= WARNING)
+            std::cerr << "message failed to resend" << std::endl;
+        unregisterRequest(id, request, true);
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return deadline;
+}
+
+void Client::setRetryPolicy(const RetryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_rtt);
+    retry_policy = policy;
+}
+
+RetryPolicy Client::getRetryPolicy() const {
+    std::lock_guard<std::mutex> lock(mutex_rtt);
+    return retry_policy;
+}
+
+RttEstimator Client::getRttEstimate() const {
+    std::lock_guard<std::mutex> lock(mutex_rtt);
+    return rtt_link;
+}
+
+double Client::getRequestTimeout(const msp::ID& id,
+                                 const std::size_t size) const {
+    return attemptTimeout(id, size, 0);
+}
+
+double Client::attemptTimeout(const msp::ID& id, const std::size_t size,
+                              const std::size_t attempt) const {
+    std::lock_guard<std::mutex> lock(mutex_rtt);
+    const RetryPolicy& policy = retry_policy;
+    // without retries and adaptation the caller's timeout applies
+    if(!policy.adaptive && policy.max_retries == 0) return 0;
+    if(!policy.adaptive) return policy.max_timeout;
+
+    const RttEstimator* estimator = &rtt_link;
+    if(policy.per_size) {
+        // the response size is taken from the last response to the ID
+        const auto response = response_sizes.find(id);
+        const std::size_t bytes =
+            size + (response != response_sizes.end() ? response->second : 0);
+        const auto it = rtt_by_size.find(sizeClass(bytes));
+        if(it != rtt_by_size.end()) estimator = &it->second;
+    }
+    // exponential backoff of retransmissions
+    const double tout =
+        estimator->timeout(policy.min_timeout, policy.max_timeout) *
+        std::pow(policy.backoff, double(attempt));
+    return std::min(tout, policy.max_timeout);
+}
+
+void Client::updateRtt(const msp::ID& id, const std::size_t size,
+                       const std::size_t response_size,
+                       const std::chrono::steady_clock::time_point& sent) {
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_rtt);
+    // a response to a poll which was still on the wire when the request was
+    // sent, or which was sent after it, would shorten the measurement
+    const auto unmatched = unmatched_sent.find(id);
+    if(unmatched != unmatched_sent.end() &&
+       std::chrono::duration<double>(sent - unmatched->second).count() <
+           retry_policy.max_timeout)
+        return;
+    const double rtt = std::chrono::duration<double>(now - sent).count();
+    rtt_link.update(rtt);
+    rtt_by_size[sizeClass(size + response_size)].update(rtt);
+    response_sizes[id] = response_size;
+}
+
+std::size_t Client::sizeClass(std::size_t bytes) {
+    // payloads up to 31 bytes share a class, then one class per power of two
+    std::size_t c = 0;
+    for(bytes >>= 5; bytes > 0; bytes >>= 1) ++c;
+    return c;
+}
+
+void Client::markRead(const msp::ID& id, const bool read) {
+    std::lock_guard<std::mutex> lock(mutex_cache);
+    if(read) {
+        read_ids.insert(id);
     }
     else {
-        cv_response.wait(lock, predicate);
+        read_ids.erase(id);
+        response_cache.erase(id);
+        cache_count = response_cache.size();
     }
-    // check status
-    const bool recv_success = request_received->status == OK;
-    ByteVector data;
-    if(recv_success) {
-        // make local copy of the data so that the read thread can keep moving
-        data = request_received->payload;
+}
+
+void Client::noteUnmatchedSend(const msp::ID& id) {
+    std::lock_guard<std::mutex> lock(mutex_rtt);
+    unmatched_sent[id] = std::chrono::steady_clock::now();
+}
+
+bool Client::isRead(const msp::ID& id) const {
+    std::lock_guard<std::mutex> lock(mutex_cache);
+    return read_ids.count(id) > 0;
+}
+
+void Client::setCacheTtl(const msp::ID& id, const double& ttl) {
+    std::lock_guard<std::mutex> lock(mutex_cache);
+    if(ttl > 0) {
+        response_cache[id].ttl = ttl;
+        read_ids.insert(id);
+    }
+    else {
+        response_cache.erase(id);
     }
-    mutex_response.unlock();
-    // decode the local copy of the payload
-    const bool decode_success = data.size() == 0 ? true : message.decode(data);
-    return recv_success && decode_success;
+    cache_count = response_cache.size();
+}
+
+void Client::clearCache() {
+    std::lock_guard<std::mutex> lock(mutex_cache);
+    for(auto& entry : response_cache) entry.second.response.reset();
+}
+
+std::shared_ptr<const ReceivedMessage> Client::getCachedResponse(
+    const msp::ID& id) {
+    std::lock_guard<std::mutex> lock(mutex_cache);
+    const auto it = response_cache.find(id);
+    if(it == response_cache.end() || !it->second.response) return nullptr;
+    const double age = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - it->second.stamp)
+                           .count();
+    if(age > it->second.ttl) return nullptr;
+    return it->second.response;
+}
+
+bool Client::decodeResponse(msp::Message& message,
+                            const ReceivedMessage& response) {
+    if(response.status != OK) return false;
+    // decode the shared payload through a private view, so that the read
+    // thread and subscriptions can keep using it
+    const ByteView data(response.payload);
+    return data.size() == 0 ? true : message.decode(data);
+}
+
+void Client::setMaxPayloadSize(const std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_framing);
+    max_payload_size_ = size;
+}
+
+void Client::setMaxPayloadSize(const msp::ID& id, const std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_framing);
+    max_payload_sizes[id] = size;
+}
+
+std::size_t Client::maxPayloadSize(const msp::ID& id) const {
+    std::lock_guard<std::mutex> lock(mutex_framing);
+    const auto it = max_payload_sizes.find(id);
+    return it != max_payload_sizes.end() ? it->second : max_payload_size_;
+}
+
+FramingStats Client::getFramingStats() const {
+    FramingStats stats;
+    stats.frames          = frames_received;
+    stats.crc_errors      = crc_errors;
+    stats.resyncs         = resyncs;
+    stats.bytes_discarded = bytes_discarded;
+    return stats;
 }
 
 bool Client::sendMessageNoWait(const msp::Message& message) {
     if(log_level_ >= DEBUG)
         std::cout << "async sending message - ID " << size_t(message.id())
                   << std::endl;
-    if(!sendData(message.id(), message.encode())) {
+    ByteVectorUptr data = message.encode();
+    // any message but a read may change the cached values
+    if(cache_count > 0 && ((data && !data->empty()) || !isRead(message.id())))
+        clearCache();
+    noteUnmatchedSend(message.id());
+    if(!sendData(message.id(), std::move(data))) {
         if(log_level_ >= WARNING)
             std::cerr << "async sendData failed" << std::endl;
         return false;
@@ -189,6 +949,84 @@ bool Client::sendMessageNoWait(const msp::Message& message) {
     return true;
 }
 
+bool Client::sendBatchNoWait(const msp::ID id,
+                             const std::vector<ByteVector>& payloads) {
+    if(log_level_ >= DEBUG)
+        std::cout << "async sending " << payloads.size()
+                  << " messages - ID " << size_t(id) << std::endl;
+    if(passthrough_) {
+        if(log_level_ >= WARNING)
+            std::cerr << "cannot send message " << size_t(id)
+                      << " in passthrough" << std::endl;
+        return false;
+    }
+    noteUnmatchedSend(id);
+    asio::error_code ec;
+    std::size_t bytes_written = 0;
+    std::size_t size          = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_send);
+        tx_frame.clear();
+        for(const ByteVector& data : payloads) {
+            if(!appendMessage(id, data, tx_frame)) {
+                if(log_level_ >= WARNING)
+                    std::cerr << "payload of message " << size_t(id)
+                              << " is too large (" << data.size()
+                              << " bytes)" << std::endl;
+                return false;
+            }
+        }
+        size = tx_frame.size();
+        if(size > 0)
+            bytes_written =
+                asio::write(port, asio::buffer(tx_frame.data(), size), ec);
+    }
+    if(ec && log_level_ >= WARNING)
+        std::cerr << "async sendBatchNoWait failed" << std::endl;
+    return !ec && bytes_written == size;
+}
+
+bool Client::removeListener(const msp::ID& id, const ListenerId& listener) {
+    std::lock_guard<std::mutex> lock(mutex_subscriptions);
+    const auto it = subscriptions.find(id);
+    if(it == subscriptions.end() || !it->second->removeListener(listener))
+        return false;
+    if(it->second->listenerCount() == 0) subscriptions.erase(it);
+    return true;
+}
+
+bool Client::setListenerPeriod(const msp::ID& id, const ListenerId& listener,
+                               const double& tp) {
+    if(!(tp >= 0.0)) throw std::runtime_error("Period must be positive!");
+    std::lock_guard<std::mutex> lock(mutex_subscriptions);
+    const auto it = subscriptions.find(id);
+    return it != subscriptions.end() &&
+           it->second->setListenerPeriod(listener, tp);
+}
+
+bool Client::unsubscribe(const msp::ID& id) {
+    std::lock_guard<std::mutex> lock(mutex_subscriptions);
+    return subscriptions.erase(id) == 1;
+}
+
+bool Client::closePushStream(const msp::ID& id) {
+    std::lock_guard<std::mutex> lock(mutex_push_streams);
+    const bool closed = push_streams.erase(id) == 1;
+    push_stream_count = push_streams.size();
+    return closed;
+}
+
+bool Client::hasPushStream(const msp::ID& id) {
+    std::lock_guard<std::mutex> lock(mutex_push_streams);
+    return push_streams.count(id) == 1;
+}
+
+void Client::setFrameTap(const FrameTap& tap) {
+    std::lock_guard<std::mutex> lock(mutex_frame_tap);
+    frame_tap_     = tap;
+    has_frame_tap_ = bool(tap);
+}
+
 uint8_t Client::extractChar() {
     if(buffer.sgetc() == EOF) {
         if(log_level_ >= WARNING)
@@ -202,20 +1040,32 @@ uint8_t Client::extractChar() {
 bool Client::sendData(const msp::ID id, const ByteVector& data) {
     if(log_level_ >= DEBUG)
         std::cout << "sending: " << size_t(id) << " | " << data;
-    ByteVector msg;
-    if(msp_ver_ == 2) {
-        msg = packMessageV2(id, data);
-    }
-    else {
-        msg = packMessageV1(id, data);
+    if(passthrough_) {
+        if(log_level_ >= WARNING)
+            std::cerr << "cannot send message " << size_t(id)
+                      << " in passthrough" << std::endl;
+        return false;
     }
-    if(log_level_ >= DEBUG) std::cout << "packed: " << msg;
     asio::error_code ec;
-    std::size_t bytes_written;
+    std::size_t bytes_written = 0;
+    std::size_t size          = 0;
     {
         std::lock_guard<std::mutex> lock(mutex_send);
-        bytes_written =
-            asio::write(port, asio::buffer(msg.data(), msg.size()), ec);
+        // the frame buffer keeps its capacity, so that sending a message of
+        // a known size does not allocate
+        if(packMessage(id, data, tx_frame)) {
+            if(log_level_ >= DEBUG) std::cout << "packed: " << tx_frame;
+            size = tx_frame.size();
+            bytes_written =
+                asio::write(port, asio::buffer(tx_frame.data(), size), ec);
+        }
+    }
+    if(size == 0) {
+        if(log_level_ >= WARNING)
+            std::cerr << "payload of message " << size_t(id)
+                      << " is too large (" << data.size() << " bytes)"
+                      << std::endl;
+        return false;
     }
     if(ec == asio::error::operation_aborted && log_level_ >= WARNING) {
         // operation_aborted error probably means the client is being closed
@@ -224,70 +1074,75 @@ bool Client::sendData(const msp::ID id, const ByteVector& data) {
         return false;
     }
     if(log_level_ >= DEBUG)
-        std::cout << "write complete: " << bytes_written << " vs " << msg.size()
+        std::cout << "write complete: " << bytes_written << " vs " << size
                   << std::endl;
-    return (bytes_written == msg.size());
+    return (bytes_written == size);
 }
 
-ByteVector Client::packMessageV1(const msp::ID id,
-                                 const ByteVector& data) const {
+ByteVector Client::packMessage(const msp::ID id,
+                               const ByteVector& data) const {
     ByteVector msg;
-    msg.push_back('$');                               // preamble1
-    msg.push_back('M');                               // preamble2
-    msg.push_back('<');                               // direction
-    msg.push_back(uint8_t(data.size()));              // data size
-    msg.push_back(uint8_t(id));                       // message_id
-    msg.insert(msg.end(), data.begin(), data.end());  // data
-    msg.push_back(crcV1(uint8_t(id), data));          // crc
+    packMessage(id, data, msg);
     return msg;
 }
 
-uint8_t Client::crcV1(const uint8_t id, const ByteVector& data) const {
-    uint8_t crc = uint8_t(data.size()) ^ id;
-    for(const uint8_t d : data) {
-        crc = crc ^ d;
-    }
-    return crc;
+bool Client::packMessage(const msp::ID id, const ByteVector& data,
+                         ByteVector& msg) const {
+    msg.clear();
+    return appendMessage(id, data, msg);
 }
 
-ByteVector Client::packMessageV2(const msp::ID id,
+bool Client::appendMessage(const msp::ID id, const ByteVector& data,
+                           ByteVector& msg) const {
+    // the MSPv2 header stores the payload size in 16 bit
+    if(data.size() > 0xFFFF) return false;
+    // legacy IDs fit into the shorter MSPv1 frame
+    if(uint16_t(id) < MSP_V2_FRAME_ID)
+        packMessageV1(id, data, msg);
+    else if(msp_ver_ == 2)
+        packMessageV2(id, data, msg);
+    // the tunnel adds the MSPv2 header and CRC to the payload
+    else if(data.size() > 0xFFFF - 6)
+        return false;
+    else
+        packMessageV2OverV1(id, data, msg);
+    return true;
+}
+
+ByteVector Client::packMessageV1(const msp::ID id,
                                  const ByteVector& data) const {
     ByteVector msg;
-    msg.push_back('$');                           // preamble1
-    msg.push_back('X');                           // preamble2
-    msg.push_back('<');                           // direction
-    msg.push_back(0);                             // flag
-    msg.push_back(uint8_t(uint16_t(id) & 0xFF));  // message_id low bits
-    msg.push_back(uint8_t(uint16_t(id) >> 8));    // message_id high bits
-
-    const uint16_t size = uint16_t(data.size());
-    msg.push_back(uint8_t(size & 0xFF));  // data size low bits
-    msg.push_back(uint8_t(size >> 8));    // data size high bits
+    packMessageV1(id, data, msg);
+    return msg;
+}
 
-    msg.insert(msg.end(), data.begin(), data.end());                  // data
-    msg.push_back(crcV2(0, ByteVector(msg.begin() + 3, msg.end())));  // crc
+void Client::packMessageV1(const msp::ID id, const ByteVector& data,
+                           ByteVector& msg) const {
+    appendFrameV1(msg, FrameDirection::REQUEST, uint8_t(id), data);
+}
 
+ByteVector Client::packMessageV2OverV1(const msp::ID id,
+                                       const ByteVector& data) const {
+    ByteVector msg;
+    packMessageV2OverV1(id, data, msg);
     return msg;
 }
 
-uint8_t Client::crcV2(uint8_t crc, const ByteVector& data) const {
-    for(const uint8_t& p : data) {
-        crc = crcV2(crc, p);
-    }
-    return crc;
+void Client::packMessageV2OverV1(const msp::ID id, const ByteVector& data,
+                                 ByteVector& msg) const {
+    appendFrameV2OverV1(msg, FrameDirection::REQUEST, uint16_t(id), data);
 }
 
-uint8_t Client::crcV2(uint8_t crc, const uint8_t& b) const {
-    crc ^= b;
-    for(int ii = 0; ii < 8; ++ii) {
-        if(crc & 0x80) {
-            crc = uint8_t(crc << 1) ^ 0xD5;
-        }
-        else {
-            crc = uint8_t(crc << 1);
-        }
-    }
-    return crc;
+ByteVector Client::packMessageV2(const msp::ID id,
+                                 const ByteVector& data) const {
+    ByteVector msg;
+    packMessageV2(id, data, msg);
+    return msg;
+}
+
+void Client::packMessageV2(const msp::ID id, const ByteVector& data,
+                           ByteVector& msg) const {
+    appendFrameV2(msg, FrameDirection::REQUEST, uint16_t(id), data);
 }
 
 void Client::processOneMessage(const asio::error_code& ec,
@@ -297,124 +1152,392 @@ void Client::processOneMessage(const asio::error_code& ec,
                   << std::endl;
 
     if(ec == asio::error::operation_aborted) {
+        if(mode_switch_) {
+            // cancelled to continue in passthrough
+            mode_switch_ = false;
+            scheduleRead();
+            return;
+        }
         // operation_aborted error probably means the client is being closed
         // notify waiting request methods
         cv_response.notify_all();
         return;
     }
-
-    // ignore and remove header bytes
-    const uint8_t msg_marker = extractChar();
-    if(msg_marker != '$')
-        std::cerr << "Message marker " << size_t(msg_marker)
-                  << " is not recognised!" << std::endl;
-
-    // message version
-    int ver                  = 0;
-    const uint8_t ver_marker = extractChar();
-    if(ver_marker == 'M') ver = 1;
-    if(ver_marker == 'X') ver = 2;
-    if(ver == 0) {
-        std::cerr << "Version marker " << size_t(ver_marker)
-                  << " is not recognised!" << std::endl;
+    if(ec) {
+        // e.g. the device was unplugged, stop reading
+        linkLost(ec);
+        return;
     }
 
-    ReceivedMessage recv_msg;
-    if(ver == 2)
-        recv_msg = processOneMessageV2();
-    else
-        recv_msg = processOneMessageV1();
-
-    {
-        std::lock_guard<std::mutex> lock2(cv_response_mtx);
-        std::lock_guard<std::mutex> lock(mutex_response);
-        request_received.reset(new ReceivedMessage(recv_msg));
+    // skip the corrupt data in front of the frame found by messageReady
+    const auto bufs = buffer.data();
+    const FrameLocation frame =
+        buffer.size() == 0
+            ? FrameLocation()
+            : findFrame(reinterpret_cast<const uint8_t*>(
+                            &*iterator::begin(bufs)),
+                        buffer.size());
+    if(frame.skip > 0) {
+        if(log_level_ >= WARNING)
+            std::cerr << "discarding " << frame.skip
+                      << " bytes of corrupt data" << std::endl;
+        resyncs++;
+        bytes_discarded += frame.skip;
+        buffer.consume(frame.skip);
     }
-    // notify waiting request methods
-    cv_response.notify_all();
 
-    // check subscriptions
-    {
-        std::lock_guard<std::mutex> lock(mutex_subscriptions);
-        std::lock_guard<std::mutex> lock2(mutex_response);
-        if(request_received->status == OK &&
-           subscriptions.count(ID(request_received->id))) {
-            subscriptions.at(ID(request_received->id))
-                ->decode(request_received->payload);
+    if(frame.complete) {
+        // the preamble has been checked already
+        extractChar();
+        const uint8_t ver_marker = extractChar();
+
+        // the payload buffer keeps its capacity between frames
+        ReceivedMessage& recv_msg = rx_message;
+        if(ver_marker == 'X')
+            processOneMessageV2(recv_msg);
+        else
+            processOneMessageV1(recv_msg);
+        // the ID of a corrupt frame cannot be trusted, so the frame is
+        // dropped and the pending request of the ID is resent or times out
+        const bool corrupt = (recv_msg.status == FAIL_CRC);
+        if(corrupt)
+            crc_errors++;
+        else
+            frames_received++;
+
+        if(recv_msg.status == OK && has_frame_tap_) {
+            std::lock_guard<std::mutex> lock(mutex_frame_tap);
+            if(frame_tap_) frame_tap_(recv_msg.id, ByteView(recv_msg.payload));
+        }
+
+        // unsolicited push telemetry goes straight into its ring
+        std::shared_ptr<PushStreamBase> push_stream;
+        if(recv_msg.status == OK && push_stream_count > 0) {
+            std::lock_guard<std::mutex> lock(mutex_push_streams);
+            const auto it = push_streams.find(recv_msg.id);
+            if(it != push_streams.end()) push_stream = it->second;
+        }
+        if(push_stream) {
+            push_stream->push(ByteView(recv_msg.payload));
+        }
+        else if(!corrupt) {
+            dispatchMessage(recv_msg);
         }
     }
 
-    asio::async_read_until(port,
-                           buffer,
-                           std::bind(&Client::messageReady,
-                                     this,
-                                     std::placeholders::_1,
-                                     std::placeholders::_2),
-                           std::bind(&Client::processOneMessage,
-                                     this,
-                                     std::placeholders::_1,
-                                     std::placeholders::_2));
+    scheduleRead();
 
     if(log_level_ >= DEBUG)
         std::cout << "processOneMessage finished" << std::endl;
 }
 
-std::pair<iterator, bool> Client::messageReady(iterator begin,
-                                               iterator end) const {
-    iterator i             = begin;
-    const size_t available = size_t(std::distance(begin, end));
+void Client::scheduleRead() {
+    if(!passthrough_) {
+        asio::async_read_until(port,
+                               buffer,
+                               std::bind(&Client::messageReady,
+                                         this,
+                                         std::placeholders::_1,
+                                         std::placeholders::_2),
+                               std::bind(&Client::processOneMessage,
+                                         this,
+                                         std::placeholders::_1,
+                                         std::placeholders::_2));
+        return;
+    }
+    // hand over everything in the buffer, including data which was received
+    // before the switch and not parsed yet
+    if(buffer.size() > 0) {
+        const auto bufs = buffer.data();
+        {
+            std::lock_guard<std::mutex> lock(mutex_passthrough);
+            if(passthrough_handler_)
+                passthrough_handler_(
+                    reinterpret_cast<const uint8_t*>(&*iterator::begin(bufs)),
+                    buffer.size());
+        }
+        buffer.consume(buffer.size());
+    }
+    port.async_read_some(buffer.prepare(4096),
+                         std::bind(&Client::processRaw,
+                                   this,
+                                   std::placeholders::_1,
+                                   std::placeholders::_2));
+}
+
+void Client::processRaw(const asio::error_code& ec,
+                        const std::size_t bytes_transferred) {
+    if(ec == asio::error::operation_aborted) {
+        if(mode_switch_) {
+            // cancelled to continue with MSP
+            mode_switch_ = false;
+            scheduleRead();
+            return;
+        }
+        cv_response.notify_all();
+        return;
+    }
+    if(ec) {
+        linkLost(ec);
+        return;
+    }
+    buffer.commit(bytes_transferred);
+    scheduleRead();
+}
+
+void Client::switchReadMode() {
+    // asio objects are not thread safe, the pending read is cancelled by the
+    // receiving thread
+    io.post([this] {
+        if(!port.is_open()) return;
+        asio::error_code ec;
+        mode_switch_ = true;
+        port.cancel(ec);
+        if(ec) mode_switch_ = false;
+    });
+}
 
-    if(available < 2) return std::make_pair(begin, false);
+bool Client::enterPassthrough(msp::Message& request,
+                              const PassthroughHandler& handler,
+                              const double& timeout) {
+    if(passthrough_) return false;
+    // the requests of the subscriptions would reach the bridged device
+    stopSubscriptions();
+    if(!sendMessage(request, timeout)) {
+        startSubscriptions();
+        return false;
+    }
+    return startPassthrough(handler);
+}
+
+bool Client::startPassthrough(const PassthroughHandler& handler) {
+    if(!isConnected() || passthrough_) return false;
+    stopSubscriptions();
+    {
+        std::lock_guard<std::mutex> lock(mutex_passthrough);
+        passthrough_handler_ = handler;
+    }
+    passthrough_ = true;
+    switchReadMode();
+    if(log_level_ >= INFO)
+        std::cout << "switched " << device_ << " to passthrough" << std::endl;
+    return true;
+}
 
-    if(*i == '$' && *(i + 1) == 'M') {
-        // not even enough data for a header
-        if(available < 6) return std::make_pair(begin, false);
+bool Client::stopPassthrough() {
+    if(!passthrough_.exchange(false)) return false;
+    {
+        // the handler is not called anymore once this returns
+        std::lock_guard<std::mutex> lock(mutex_passthrough);
+        passthrough_handler_ = nullptr;
+    }
+    switchReadMode();
+    startSubscriptions();
+    if(log_level_ >= INFO)
+        std::cout << "switched " << device_ << " back to MSP" << std::endl;
+    return true;
+}
 
-        const uint8_t payload_size = uint8_t(*(i + 3));
-        // incomplete xfer
-        if(available < size_t(5 + payload_size + 1))
-            return std::make_pair(begin, false);
+bool Client::writeRaw(const uint8_t* data, const std::size_t size) {
+    if(!passthrough_) return false;
+    asio::error_code ec;
+    std::size_t bytes_written = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_send);
+        bytes_written = asio::write(port, asio::buffer(data, size), ec);
+    }
+    return !ec && bytes_written == size;
+}
 
-        std::advance(i, 5 + payload_size + 1);
+void Client::dispatchMessage(const ReceivedMessage& msg) {
+    // copy shared read-only by the cache and the requests, only made if one
+    // of them keeps the message
+    std::shared_ptr<const ReceivedMessage> received;
+
+    // update the cache before waking up the requests
+    if(cache_count > 0) {
+        // a response which arrives while a request with payload is on the
+        // wire may hold the values from before that request, and the
+        // response to that request invalidates the responses received before
+        bool write_pending = false;
+        bool write_answer  = false;
+        if(pending_count > 0) {
+            std::lock_guard<std::mutex> lock(mutex_response);
+            for(const auto& pending : pending_requests) {
+                if(pending.second->shared) continue;
+                write_pending = true;
+                write_answer  = write_answer || pending.first == msg.id;
+            }
+        }
+        if(write_answer) {
+            clearCache();
+        }
+        else if(msg.status == OK && !write_pending) {
+            std::lock_guard<std::mutex> lock(mutex_cache);
+            const auto cached = response_cache.find(msg.id);
+            if(cached != response_cache.end()) {
+                received = std::make_shared<const ReceivedMessage>(msg);
+                cached->second.response = received;
+                cached->second.stamp    = std::chrono::steady_clock::now();
+            }
+        }
     }
-    else if(*i == '$' && *(i + 1) == 'X') {
-        // not even enough data for a header
-        if(available < 9) return std::make_pair(begin, false);
 
-        const uint16_t payload_size =
-            uint8_t(*(i + 6)) | uint8_t(*(i + 7) << 8);
+    // a request is registered before it is sent, so it is visible here
+    // before its response arrives
+    if(pending_count > 0) {
+        {
+            std::lock_guard<std::mutex> lock2(cv_response_mtx);
+            std::lock_guard<std::mutex> lock(mutex_response);
+            // answer all callers waiting for this ID
+            const auto pending = pending_requests.find(msg.id);
+            if(pending != pending_requests.end()) {
+                const std::shared_ptr<PendingRequest>& request =
+                    pending->second;
+                if(!received)
+                    received = std::make_shared<const ReceivedMessage>(msg);
+                request->response = received;
+                // the response to a retransmitted request cannot be matched
+                // to an attempt, so only the first attempt is measured
+                if(request->attempts == 1 && msg.status == OK)
+                    updateRtt(msg.id,
+                              request->size,
+                              msg.payload.size(),
+                              request->sent);
+                pending_requests.erase(pending);
+                pending_count = pending_requests.size();
+            }
+        }
+        // notify waiting request methods
+        cv_response.notify_all();
+    }
 
-        // incomplete xfer
-        if(available < size_t(8 + payload_size + 1))
-            return std::make_pair(begin, false);
+    // check subscriptions
+    if(msg.status == OK) {
+        std::lock_guard<std::mutex> lock(mutex_subscriptions);
+        const auto it = subscriptions.find(msg.id);
+        if(it != subscriptions.end()) it->second->decode(ByteView(msg.payload));
+    }
+}
 
-        std::advance(i, 8 + payload_size + 1);
+std::pair<iterator, bool> Client::messageReady(iterator begin,
+                                               iterator end) const {
+    const size_t available = size_t(std::distance(begin, end));
+    if(available == 0) return std::make_pair(begin, false);
+
+    // the streambuf stores the received data contiguously
+    const FrameLocation frame =
+        findFrame(reinterpret_cast<const uint8_t*>(&*begin), available);
+    if(!frame.complete) {
+        // continue the search at the first candidate frame
+        return std::make_pair(begin + long(frame.skip), false);
     }
-    else {
-        for(; i != end; ++i) {
-            if(*i == '$') break;
+    return std::make_pair(begin + long(frame.skip + frame.size), true);
+}
+
+Client::FrameLocation Client::findFrame(const uint8_t* data,
+                                        const std::size_t size) const {
+    FrameLocation frame;
+    std::size_t pos = 0;
+    while(pos < size) {
+        // memchr is vectorised by the C library
+        const void* found = std::memchr(data + pos, '$', size - pos);
+        if(found == nullptr) break;
+        const std::size_t start =
+            std::size_t(static_cast<const uint8_t*>(found) - data);
+
+        std::size_t frame_size = 0;
+        const FrameCheck check =
+            checkFrame(data + start, size - start, frame_size);
+        if(check == FRAME_INVALID) {
+            pos = start + 1;
+            continue;
+        }
+        frame.skip = start;
+        if(check == FRAME_VALID) {
+            frame.size     = frame_size;
+            frame.complete = true;
+            return frame;
         }
-        // implicitly consume all if $ not found
+
+        // the candidate may be a random '$' in corrupt data, a valid frame
+        // which starts within its span proves that
+        const FrameLocation next = findValidFrame(data, size, start + 1);
+        if(next.complete && (check == FRAME_INCOMPLETE ||
+                             next.skip < start + frame_size))
+            return next;
+        if(check == FRAME_CRC_ERROR) {
+            // pass on the corrupt frame to be counted and dropped
+            frame.size     = frame_size;
+            frame.complete = true;
+        }
+        return frame;
     }
+    // nothing that looks like a frame
+    frame.skip = size;
+    return frame;
+}
 
-    return std::make_pair(i, true);
+Client::FrameLocation Client::findValidFrame(const uint8_t* data,
+                                             const std::size_t size,
+                                             const std::size_t from) const {
+    FrameLocation frame;
+    std::size_t pos = from;
+    while(pos < size) {
+        const void* found = std::memchr(data + pos, '$', size - pos);
+        if(found == nullptr) break;
+        const std::size_t start =
+            std::size_t(static_cast<const uint8_t*>(found) - data);
+        std::size_t frame_size = 0;
+        if(checkFrame(data + start, size - start, frame_size) == FRAME_VALID) {
+            frame.skip     = start;
+            frame.size     = frame_size;
+            frame.complete = true;
+            return frame;
+        }
+        pos = start + 1;
+    }
+    return frame;
 }
 
-ReceivedMessage Client::processOneMessageV1() {
-    ReceivedMessage ret;
+FrameCheck Client::checkFrame(const uint8_t* data, const std::size_t size,
+                              std::size_t& frame_size) const {
+    FrameHeader header;
+    const FrameCheck check = readFrameHeader(data, size, header);
+    if(check != FRAME_VALID) return check;
+    // a corrupt size must not swallow the following frames
+    if(header.payload_size > maxPayloadSize(msp::ID(header.id)))
+        return FRAME_INVALID;
+
+    frame_size = header.frameSize();
+    return checkFramePayload(data, size, header);
+}
 
+void Client::processOneMessageV1(ReceivedMessage& ret) {
     ret.status = OK;
+    ret.payload.clear();
 
     // message direction
     const uint8_t dir = extractChar();
     const bool ok_id  = (dir != '!');
 
     // payload length
-    const uint8_t len = extractChar();
+    const uint8_t len_v1 = extractChar();
+    uint8_t exp_crc      = len_v1;
 
     // message ID
     uint8_t id = extractChar();
     ret.id     = msp::ID(id);
+    exp_crc ^= id;
+
+    // jumbo frames carry the real payload length after the ID
+    size_t len = len_v1;
+    if(len_v1 == 255) {
+        const uint8_t len_low  = extractChar();
+        const uint8_t len_high = extractChar();
+        len     = size_t(len_low) | (size_t(len_high) << 8);
+        exp_crc = exp_crc ^ len_low ^ len_high;
+    }
 
     if(log_level_ >= WARNING && !ok_id) {
         std::cerr << "Message v1 with ID " << size_t(ret.id)
@@ -422,13 +1545,16 @@ ReceivedMessage Client::processOneMessageV1() {
     }
 
     // payload
+    ret.payload.reserve(len);
     for(size_t i(0); i < len; i++) {
         ret.payload.push_back(extractChar());
     }
 
     // CRC
+    const uint8_t* payload = ret.payload.data();
+    exp_crc = crcV1(exp_crc, payload, payload + ret.payload.size());
+
     const uint8_t rcv_crc = extractChar();
-    const uint8_t exp_crc = crcV1(id, ret.payload);
     const bool ok_crc     = (rcv_crc == exp_crc);
 
     if(log_level_ >= WARNING && !ok_crc) {
@@ -443,14 +1569,36 @@ ReceivedMessage Client::processOneMessageV1() {
     else if(!ok_crc) {
         ret.status = FAIL_CRC;
     }
-
-    return ret;
+    else if(id == MSP_V2_FRAME_ID) {
+        unpackV2Frame(ret);
+    }
 }
 
-ReceivedMessage Client::processOneMessageV2() {
-    ReceivedMessage ret;
+void Client::unpackV2Frame(ReceivedMessage& msg) const {
+    uint16_t id     = 0;
+    std::size_t len = 0;
+    const FrameCheck check =
+        readTunnelledFrame(msg.payload.data(), msg.payload.size(), id, len);
+    if(check != FRAME_VALID) {
+        if(log_level_ >= WARNING)
+            std::cerr << "MSP_V2_FRAME of " << msg.payload.size()
+                      << " bytes has "
+                      << (check == FRAME_CRC_ERROR ? "a wrong inner CRC"
+                                                   : "a wrong inner size")
+                      << std::endl;
+        msg.status = FAIL_CRC;
+        return;
+    }
 
+    msg.id = msp::ID(id);
+    // move the inner payload to the front, keeping the capacity
+    msg.payload.erase(msg.payload.begin(), msg.payload.begin() + 5);
+    msg.payload.resize(len);
+}
+
+void Client::processOneMessageV2(ReceivedMessage& ret) {
     ret.status = OK;
+    ret.payload.clear();
 
     uint8_t exp_crc = 0;
 
@@ -487,12 +1635,13 @@ ReceivedMessage Client::processOneMessageV2() {
     }
 
     // payload
-    ByteVector data;
+    ret.payload.reserve(len);
     for(size_t i(0); i < len; i++) {
         ret.payload.push_back(extractChar());
     }
 
-    exp_crc = crcV2(exp_crc, ret.payload);
+    exp_crc = crcV2(
+        exp_crc, ret.payload.data(), ret.payload.data() + ret.payload.size());
 
     // CRC
     const uint8_t rcv_crc = extractChar();
@@ -511,8 +1660,6 @@ ReceivedMessage Client::processOneMessageV2() {
     else if(!ok_crc) {
         ret.status = FAIL_CRC;
     }
-
-    return ret;
 }
 
 }  // namespace client
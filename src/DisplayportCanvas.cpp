@@ -0,0 +1,132 @@
+#include "DisplayportCanvas.hpp"
+#include <algorithm>
+
+namespace fcu {
+
+// bytes of a string write besides the characters: MSPv1 header and checksum,
+// sub-command, row, column and attribute
+static const std::size_t WRITE_OVERHEAD = 6 + 4;
+
+DisplayportCanvas::DisplayportCanvas(msp::client::Client& client,
+                                     const DisplayportCanvasOptions& options) :
+    client_(client),
+    options_(options),
+    back_chars_(std::size_t(options.rows) * options.cols, options.blank),
+    back_attrs_(back_chars_.size(), 0),
+    front_chars_(back_chars_.size(), options.blank),
+    front_attrs_(back_chars_.size(), 0),
+    front_valid_(false) {}
+
+void DisplayportCanvas::clear() {
+    std::fill(back_chars_.begin(), back_chars_.end(), options_.blank);
+    std::fill(back_attrs_.begin(), back_attrs_.end(), 0);
+}
+
+std::size_t DisplayportCanvas::write(const uint8_t row, const uint8_t col,
+                                     const std::string& text,
+                                     const uint8_t attr) {
+    if(row >= options_.rows || col >= options_.cols) return 0;
+    const std::size_t n =
+        std::min<std::size_t>(text.size(), options_.cols - col);
+    const std::size_t i = index(row, col);
+    std::copy(text.begin(), text.begin() + long(n),
+              back_chars_.begin() + long(i));
+    std::fill(back_attrs_.begin() + long(i),
+              back_attrs_.begin() + long(i + n),
+              attr);
+    return n;
+}
+
+bool DisplayportCanvas::put(const uint8_t row, const uint8_t col,
+                            const uint8_t chr, const uint8_t attr) {
+    if(row >= options_.rows || col >= options_.cols) return false;
+    back_chars_[index(row, col)] = chr;
+    back_attrs_[index(row, col)] = attr;
+    return true;
+}
+
+uint8_t DisplayportCanvas::character(const uint8_t row,
+                                     const uint8_t col) const {
+    if(row >= options_.rows || col >= options_.cols) return options_.blank;
+    return back_chars_[index(row, col)];
+}
+
+uint8_t DisplayportCanvas::attribute(const uint8_t row,
+                                     const uint8_t col) const {
+    if(row >= options_.rows || col >= options_.cols) return 0;
+    return back_attrs_[index(row, col)];
+}
+
+void DisplayportCanvas::invalidate() { front_valid_ = false; }
+
+bool DisplayportCanvas::commit() {
+    stats_ = DisplayportCommitStats();
+    payloads_.clear();
+    if(!front_valid_) {
+        addCommand(DisplayportCommand::CLEAR_SCREEN);
+        std::fill(front_chars_.begin(), front_chars_.end(), options_.blank);
+        std::fill(front_attrs_.begin(), front_attrs_.end(), 0);
+        stats_.full = true;
+    }
+    for(uint8_t row = 0; row < options_.rows; ++row) diffRow(row);
+    addCommand(DisplayportCommand::DRAW_SCREEN);
+
+    front_valid_ =
+        client_.sendBatchNoWait(msp::ID::MSP_DISPLAYPORT, payloads_);
+    if(front_valid_) {
+        std::copy(back_chars_.begin(), back_chars_.end(), front_chars_.begin());
+        std::copy(back_attrs_.begin(), back_attrs_.end(), front_attrs_.begin());
+    }
+    return front_valid_;
+}
+
+void DisplayportCanvas::diffRow(const uint8_t row) {
+    const std::size_t max_run = std::max<std::size_t>(options_.max_run, 1);
+    const std::size_t base    = index(row, 0);
+    std::size_t begin         = 0;
+    std::size_t end           = 0;
+    for(std::size_t col = 0; col < options_.cols; ++col) {
+        if(!changed(base + col)) continue;
+        stats_.cells++;
+        if(end > begin && col + 1 - begin <= max_run &&
+           col - end <= WRITE_OVERHEAD) {
+            // resending the unchanged cells in between is shorter than a new
+            // write, if they share the attribute of the run
+            const uint8_t attr = back_attrs_[base + begin];
+            const auto first   = back_attrs_.begin() + long(base + end);
+            const auto last    = back_attrs_.begin() + long(base + col + 1);
+            if(std::all_of(first, last,
+                           [attr](const uint8_t a) { return a == attr; })) {
+                end = col + 1;
+                continue;
+            }
+        }
+        if(end > begin) addRun(row, begin, end);
+        begin = col;
+        end   = col + 1;
+    }
+    if(end > begin) addRun(row, begin, end);
+}
+
+void DisplayportCanvas::addRun(const uint8_t row, const std::size_t begin,
+                               const std::size_t end) {
+    const std::size_t i = index(row, 0);
+    payloads_.emplace_back();
+    msp::ByteVector& payload = payloads_.back();
+    payload.push_back(uint8_t(DisplayportCommand::WRITE_STRING));
+    payload.push_back(row);
+    payload.push_back(uint8_t(begin));
+    payload.push_back(back_attrs_[i + begin]);
+    payload.insert(payload.end(), back_chars_.data() + i + begin,
+                   back_chars_.data() + i + end);
+    stats_.writes++;
+    stats_.bytes += payload.size() + 6;
+}
+
+void DisplayportCanvas::addCommand(const DisplayportCommand command) {
+    payloads_.emplace_back();
+    payloads_.back().push_back(uint8_t(command));
+    stats_.bytes += 1 + 6;
+}
+
+}  // namespace fcu
@@ -1,19 +1,71 @@
 #include "FlightController.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
+#include <thread>
 
 namespace fcu {
 
+/**
+ * @brief Resolves the name of a box to its bit mask
+ * @param box_name_ids Mapping of box names to box IDs
+ * @param box_name Name of the box
+ * @return Bit mask of the box, or 0 if the box is unknown
+ */
+static uint32_t boxMask(const std::map<std::string, size_t> &box_name_ids,
+                        const std::string &box_name) {
+    const auto box = box_name_ids.find(box_name);
+    if(box == box_name_ids.end() || box->second >= 32) return 0;
+    return uint32_t(1) << box->second;
+}
+
 FlightController::FlightController() :
+    fw_variant_(msp::FirmwareVariant::NONE),
     msp_version_(1),
+    connect_time_(0.0),
+    status_period_(0.05),
+    status_stream_(false),
+    status_listener_(0),
+    box_mode_flags_(0),
+    status_stamp_(0),
+    arm_mask_(0),
+    failsafe_mask_(0),
     control_source_(ControlSource::NONE),
-    msp_timer_(std::bind(&FlightController::generateMSP, this), 0.1) {}
+    msp_timer_(std::bind(&FlightController::generateMSP, this), 0.1) {
+    client_.setReconnectCallback(
+        std::bind(&FlightController::restoreConnection, this));
+    // queries which may be shared by concurrent callers
+    for(const msp::ID id : {msp::ID::MSP_FC_VARIANT,
+                            msp::ID::MSP_API_VERSION,
+                            msp::ID::MSP_FC_VERSION,
+                            msp::ID::MSP_BOARD_INFO,
+                            msp::ID::MSP_BUILD_INFO,
+                            msp::ID::MSP_STATUS,
+                            msp::ID::MSP_IDENT,
+                            msp::ID::MSP_BOXNAMES,
+                            msp::ID::MSP_BOXIDS,
+                            msp::ID::MSP_RX_MAP,
+                            msp::ID::MSP_CF_SERIAL_CONFIG,
+                            msp::ID::MSP_FEATURE})
+        client_.markRead(id);
+}
 
 FlightController::~FlightController() { disconnect(); }
 
 bool FlightController::connect(const std::string &device, const size_t baudrate,
                                const double &timeout, const bool print_info) {
-    if(!client_.start(device, baudrate)) return false;
+    const auto tstart = std::chrono::steady_clock::now();
+
+    if(baudrate == 0) {
+        if(client_.probeBaudrate(device) == 0) return false;
+    }
+    else if(!client_.start(device, baudrate)) {
+        return false;
+    }
 
+    // the firmware variant and protocol version determine how all other
+    // messages are encoded, so these have to be queried first
     msp::msg::FcVariant fcvar(fw_variant_);
     if(client_.sendMessage(fcvar, 1.0) && !fcvar.identifier().empty()) {
         fw_variant_ = msp::variant_map.at(fcvar.identifier());
@@ -26,6 +78,8 @@ bool FlightController::connect(const std::string &device, const size_t baudrate,
         return false;
     }
 
+    client_.setVariant(fw_variant_);
+
     if(fw_variant_ != msp::FirmwareVariant::MWII) {
         msp::msg::ApiVersion api_version(fw_variant_);
         if(client_.sendMessage(api_version, timeout)) {
@@ -35,56 +89,91 @@ bool FlightController::connect(const std::string &device, const size_t baudrate,
         }
     }
 
+    // all remaining queries are independent of each other, so they are sent
+    // back to back and collected as the responses arrive, the timeout bounds
+    // the whole batch
+    msp::msg::FcVersion fcver(fw_variant_);
+    msp::msg::BoardInfo boardinfo(fw_variant_);
+    msp::msg::BuildInfo buildinfo(fw_variant_);
+    msp::msg::Status status(fw_variant_);
+    msp::msg::Ident ident(fw_variant_);
+    msp::msg::BoxNames box_names(fw_variant_);
+    msp::msg::BoxIds box_ids(fw_variant_);
+    msp::msg::RxMap rx_map(fw_variant_);
+
+    std::vector<msp::Message *> requests = {
+        &boardinfo, &status, &ident, &box_names, &box_ids};
+    if(fw_variant_ != msp::FirmwareVariant::MWII) requests.push_back(&rx_map);
     if(print_info) {
-        msp::msg::FcVersion fcver(fw_variant_);
-        if(client_.sendMessage(fcver, timeout)) {
-            std::cout << fcver;
-        }
+        requests.push_back(&fcver);
+        requests.push_back(&buildinfo);
     }
 
-    msp::msg::BoardInfo boardinfo(fw_variant_);
-    if(client_.sendMessage(boardinfo, timeout)) {
+    const std::vector<bool> received =
+        client_.sendMessages(requests, timeout);
+    const auto has_response = [&](const msp::Message &msg) {
+        const auto it = std::find(requests.begin(), requests.end(), &msg);
+        return it != requests.end() && received[it - requests.begin()];
+    };
+
+    if(print_info && has_response(fcver)) std::cout << fcver;
+
+    if(has_response(boardinfo)) {
         if(print_info) std::cout << boardinfo;
+        std::lock_guard<std::mutex> lock(identity_mutex_);
         board_name_ = boardinfo.name();
     }
 
-    if(print_info) {
-        msp::msg::BuildInfo buildinfo(fw_variant_);
-        if(client_.sendMessage(buildinfo, timeout)) std::cout << buildinfo;
-    }
+    if(print_info && has_response(buildinfo)) std::cout << buildinfo;
 
-    msp::msg::Status status(fw_variant_);
-    client_.sendMessage(status, timeout);
-    if(print_info) std::cout << status;
-    sensors_ = status.sensors;
+    if(has_response(status)) {
+        if(print_info) std::cout << status;
+        sensors_ = status.sensors;
+        updateStatus(status);
+    }
 
-    msp::msg::Ident ident(fw_variant_);
-    client_.sendMessage(ident, timeout);
-    if(print_info) std::cout << ident;
-    capabilities_ = ident.capabilities;
+    if(has_response(ident)) {
+        if(print_info) std::cout << ident;
+        capabilities_ = ident.capabilities;
+    }
 
     // get boxes
-    initBoxes();
+    if(!has_response(box_names))
+        throw std::runtime_error("Cannot get BoxNames!");
+    if(!has_response(box_ids)) throw std::runtime_error("Cannot get BoxIds!");
+    updateBoxes(box_names, box_ids);
 
     // determine channel mapping
     if(getFwVariant() == msp::FirmwareVariant::MWII) {
         // default mapping
+        std::lock_guard<std::mutex> lock(identity_mutex_);
         for(uint8_t i(0); i < msp::msg::MAX_MAPPABLE_RX_INPUTS; ++i) {
             channel_map_[i] = i;
         }
     }
     else {
         // get channel mapping from MSP_RX_MAP
-        msp::msg::RxMap rx_map(fw_variant_);
-        client_.sendMessage(rx_map, timeout);
         if(print_info) std::cout << rx_map;
+        std::lock_guard<std::mutex> lock(identity_mutex_);
         channel_map_ = rx_map.map;
     }
 
+    // keep the box mode flags up to date for non-blocking status queries
+    startStatusStream();
+
+    connect_time_ = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - tstart)
+                        .count();
+    if(print_info)
+        std::cout << "connected in " << connect_time_ << " s" << std::endl;
+
     return true;
 }
 
-bool FlightController::disconnect() { return client_.stop(); }
+bool FlightController::disconnect() {
+    status_stream_ = false;
+    return client_.stop();
+}
 
 bool FlightController::isConnected() const { return client_.isConnected(); }
 
@@ -104,10 +193,16 @@ FlightMode FlightController::getFlightMode() const { return flight_mode_; }
 
 void FlightController::setControlSource(ControlSource source) {
     if(source == control_source_) return;
+    applyControlSource(source);
+}
 
+bool FlightController::applyControlSource(const ControlSource source,
+                                          const double &timeout) {
     msp::msg::RxConfig rxConfig(fw_variant_);
-    if(!client_.sendMessage(rxConfig))
+    if(!client_.sendMessage(rxConfig, timeout)) {
         std::cout << "client_.sendMessage(rxConfig) failed" << std::endl;
+        return false;
+    }
     std::cout << rxConfig;
 
     msp::msg::SetRxConfig setRxConfig(fw_variant_);
@@ -115,22 +210,70 @@ void FlightController::setControlSource(ControlSource source) {
         static_cast<msp::msg::RxConfigSettings &>(rxConfig);
 
     if(source == ControlSource::SBUS) {
-        setRxConfig.receiverType      = 3;
-        setRxConfig.serialrx_provider = 2;
+        setRxConfig.receiverType()      = 3;
+        setRxConfig.serialrx_provider() = 2;
     }
     else if(source == ControlSource::MSP) {
-        setRxConfig.receiverType = 4;
+        setRxConfig.receiverType() = 4;
     }
-    client_.sendMessage(setRxConfig);
+    if(!client_.sendMessage(setRxConfig, timeout)) return false;
 
     control_source_ = source;
+    return true;
+}
+
+bool FlightController::restoreConnection() {
+    // the flags from before the link loss do not describe the flight
+    // controller which came back
+    status_stamp_.store(0, std::memory_order_release);
+
+    // the protocol settings are kept by the client, the cached handshake only
+    // checks that the same flight controller came back
+    msp::msg::FcVariant fcvar(fw_variant_);
+    msp::msg::BoardInfo boardinfo(fw_variant_);
+    const std::vector<bool> received =
+        client_.sendMessages({&fcvar, &boardinfo}, 1.0);
+    if(!received[0] || !received[1]) return false;
+
+    const auto variant = msp::variant_map.find(fcvar.identifier());
+    if(variant == msp::variant_map.end()) return false;
+    if(variant->second != fw_variant_ || boardinfo.name() != getBoardName()) {
+        std::cerr << "a different flight controller (" << boardinfo.name()
+                  << ") was connected, updating box and channel maps"
+                  << std::endl;
+        fw_variant_ = variant->second;
+        {
+            std::lock_guard<std::mutex> lock(identity_mutex_);
+            board_name_ = boardinfo.name();
+        }
+        client_.setVariant(fw_variant_);
+        try {
+            initBoxes(1.0);
+        }
+        catch(const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
+        if(fw_variant_ != msp::FirmwareVariant::MWII) {
+            msp::msg::RxMap rx_map(fw_variant_);
+            if(!client_.sendMessage(rx_map, 1.0)) return false;
+            std::lock_guard<std::mutex> lock(identity_mutex_);
+            channel_map_ = rx_map.map;
+        }
+    }
+
+    // the receiver configuration is lost if the flight controller rebooted
+    if(control_source_ == ControlSource::MSP ||
+       control_source_ == ControlSource::SBUS)
+        return applyControlSource(control_source_, 1.0);
+    return true;
 }
 
 ControlSource FlightController::getControlSource() {
     msp::msg::RxConfig rxConfig(fw_variant_);
     client_.sendMessage(rxConfig);
 
-    if(rxConfig.receiverType.set() && rxConfig.receiverType() == 4)
+    if(rxConfig.receiverType().set() && rxConfig.receiverType() == 4)
         return ControlSource::MSP;
     else if(rxConfig.serialrx_provider() == 2)
         return ControlSource::SBUS;
@@ -192,55 +335,188 @@ bool FlightController::reboot() {
     return client_.sendMessage(reboot);
 }
 
+bool FlightController::setMspBaudrate(const uint8_t port_identifier,
+                                      const size_t baudrate,
+                                      const double timeout) {
+    // index of the baudrate in the table of the firmware
+    static const std::vector<size_t> baudrates_betaflight = {
+        0,      9600,   19200,   38400,   57600,   115200,  230400,  250000,
+        400000, 460800, 500000, 921600, 1000000, 1500000, 2000000, 2470000};
+    static const std::vector<size_t> baudrates_inav = {
+        0,      1200,   2400,   4800,   9600,    19200,   38400,   57600,
+        115200, 230400, 250000, 460800, 921600, 1000000, 1500000, 2000000,
+        2470000};
+    if(fw_variant_ == msp::FirmwareVariant::MWII) return false;
+    const std::vector<size_t> &baudrates =
+        (fw_variant_ == msp::FirmwareVariant::INAV) ? baudrates_inav
+                                                    : baudrates_betaflight;
+    const auto index = std::find(baudrates.begin(), baudrates.end(), baudrate);
+    if(baudrate == 0 || index == baudrates.end()) return false;
+
+    msp::msg::CfSerialConfig config(fw_variant_);
+    if(!client_.sendMessage(config, 1.0)) return false;
+    msp::msg::SetCfSerialConfig set_config(fw_variant_);
+    set_config.configs = config.configs;
+    bool found = false;
+    for(msp::msg::CfSerialConfigSettings &port : set_config.configs) {
+        if(port.identifier() != port_identifier) continue;
+        port.mspBaudrateIndx = uint8_t(index - baudrates.begin());
+        found                = true;
+    }
+    if(!found || !client_.sendMessage(set_config, 1.0)) return false;
+
+    // the serial configuration is applied after a reboot
+    if(!saveSettings()) return false;
+    msp::msg::Reboot reboot(fw_variant_);
+    client_.sendMessage(reboot, 1.0);
+    if(!client_.setBaudrate(baudrate)) return false;
+
+    // wait for the flight controller to come back at the new rate
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(size_t(timeout * 1e3));
+    msp::msg::ApiVersion ping(fw_variant_);
+    while(std::chrono::steady_clock::now() < deadline) {
+        if(client_.sendMessage(ping, 0.1)) return true;
+        // the device may be gone while the flight controller reboots
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
 msp::FirmwareVariant FlightController::getFwVariant() const {
     return fw_variant_;
 }
 
 int FlightController::getProtocolVersion() const { return msp_version_; }
 
-std::string FlightController::getBoardName() const { return board_name_; }
+std::string FlightController::getBoardName() const {
+    std::lock_guard<std::mutex> lock(identity_mutex_);
+    return board_name_;
+}
 
-void FlightController::initBoxes() {
-    // get box names
-    msp::msg::BoxNames box_names(fw_variant_);
-    if(!client_.sendMessage(box_names))
-        throw std::runtime_error("Cannot get BoxNames!");
+double FlightController::getConnectTime() const { return connect_time_; }
 
-    // get box IDs
+void FlightController::initBoxes(const double &timeout) {
+    // get box names and IDs
+    msp::msg::BoxNames box_names(fw_variant_);
     msp::msg::BoxIds box_ids(fw_variant_);
-    if(!client_.sendMessage(box_ids))
-        throw std::runtime_error("Cannot get BoxIds!");
+    const std::vector<bool> received =
+        client_.sendMessages({&box_names, &box_ids}, timeout);
+    if(!received[0]) throw std::runtime_error("Cannot get BoxNames!");
+    if(!received[1]) throw std::runtime_error("Cannot get BoxIds!");
+
+    updateBoxes(box_names, box_ids);
+}
+
+void FlightController::updateBoxes(const msp::msg::BoxNames &box_names,
+                                   const msp::msg::BoxIds &box_ids) {
     assert(box_names.box_names.size() == box_ids.box_ids.size());
 
-    box_name_ids_.clear();
+    // the map is built aside, readers only see the old or the new one
+    std::map<std::string, size_t> box_name_ids;
     for(size_t ibox(0); ibox < box_names.box_names.size(); ibox++) {
         if(getFwVariant() == msp::FirmwareVariant::CLFL) {
             // workaround for wrong box ids in cleanflight
             // cleanflight's box ids are in order of the box names
             // https://github.com/cleanflight/cleanflight/issues/2606
-            box_name_ids_[box_names.box_names[ibox]] = ibox;
+            box_name_ids[box_names.box_names[ibox]] = ibox;
         }
         else {
-            box_name_ids_[box_names.box_names[ibox]] = box_ids.box_ids[ibox];
+            box_name_ids[box_names.box_names[ibox]] = box_ids.box_ids[ibox];
         }
     }
+
+    std::lock_guard<std::mutex> lock(identity_mutex_);
+    box_name_ids_.swap(box_name_ids);
+    arm_mask_      = boxMask(box_name_ids_, "ARM");
+    failsafe_mask_ = boxMask(box_name_ids_, "FAILSAFE");
+}
+
+uint32_t FlightController::getBoxMask(const std::string &box_name) const {
+    std::lock_guard<std::mutex> lock(identity_mutex_);
+    return boxMask(box_name_ids_, box_name);
+}
+
+void FlightController::setStatusPeriod(const double period) {
+    status_period_ = period;
+    if(!isConnected()) return;
+    if(period > 0.0) {
+        startStatusStream();
+    }
+    else if(status_stream_) {
+        // keep the listener for updating the cache, but stop polling for it
+        status_stream_ = false;
+        client_.setListenerPeriod(msp::ID::MSP_STATUS, status_listener_, 0.0);
+    }
+}
+
+void FlightController::startStatusStream() {
+    if(!(status_period_ > 0.0)) return;
+    if(!client_.setListenerPeriod(
+           msp::ID::MSP_STATUS, status_listener_, status_period_)) {
+        status_listener_ = client_.addListener<msp::msg::Status>(
+            std::bind(
+                &FlightController::updateStatus, this, std::placeholders::_1),
+            status_period_);
+    }
+    status_stream_ = true;
+}
+
+void FlightController::updateStatus(const msp::msg::Status &status) {
+    box_mode_flags_.store(status.box_mode_flags.bits(),
+                          std::memory_order_release);
+    status_stamp_.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count(),
+        std::memory_order_release);
+}
+
+double FlightController::getStatusAge() const {
+    const int64_t stamp = status_stamp_.load(std::memory_order_acquire);
+    if(stamp == 0) return std::numeric_limits<double>::infinity();
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    return (now - stamp) / 1e9;
+}
+
+bool FlightController::isStatusFresh(const double &max_age) const {
+    // a status which missed a few periods of the stream is outdated, e.g.
+    // because the link is down
+    const double limit = max_age > 0 ? max_age : 4 * status_period_;
+    return getStatusAge() <= limit;
 }
 
 bool FlightController::isStatusActive(const std::string &status_name,
-                                      const double &timeout) {
-    if(box_name_ids_.count(status_name) == 0) {
-        // box ids have not been initialised or requested status is unsupported
-        // by FC
-        throw std::runtime_error(
-            "Box ID of " + status_name +
-            " is unknown! You need to call 'initBoxes()' first.");
+                                      const double &timeout,
+                                      const double &max_age) {
+    uint32_t mask = 0;
+    {
+        std::lock_guard<std::mutex> lock(identity_mutex_);
+        if(box_name_ids_.count(status_name) == 0) {
+            // box ids have not been initialised or requested status is
+            // unsupported by FC
+            throw std::runtime_error(
+                "Box ID of " + status_name +
+                " is unknown! You need to call 'initBoxes()' first.");
+        }
+        mask = boxMask(box_name_ids_, status_name);
     }
 
+    // serve the request from the cache if it is recent enough
+    if((status_stream_ || max_age > 0) && isStatusFresh(max_age))
+        return isBoxActive(mask);
+
+    // the response cache of the client may hold an older status, and an
+    // unanswered request tells nothing about the status
     msp::msg::Status status(fw_variant_);
-    client_.sendMessage(status, timeout);
+    if(!client_.sendMessage(status, timeout, false))
+        throw std::runtime_error("Cannot get Status!");
+    updateStatus(status);
 
-    // check if ARM box id is amongst active box IDs
-    return status.box_mode_flags.count(box_name_ids_.at(status_name));
+    // check if box id is amongst active box IDs
+    return status.box_mode_flags.bits() & mask;
 }
 
 bool FlightController::setRc(const uint16_t roll, const uint16_t pitch,
@@ -251,10 +527,13 @@ bool FlightController::setRc(const uint16_t roll, const uint16_t pitch,
     msp::msg::SetRawRc rc(fw_variant_);
     // insert mappable channels
     rc.channels.resize(msp::msg::MAX_MAPPABLE_RX_INPUTS);
-    rc.channels[channel_map_[0]] = roll;
-    rc.channels[channel_map_[1]] = pitch;
-    rc.channels[channel_map_[2]] = yaw;
-    rc.channels[channel_map_[3]] = throttle;
+    {
+        std::lock_guard<std::mutex> lock(identity_mutex_);
+        rc.channels[channel_map_[0]] = roll;
+        rc.channels[channel_map_[1]] = pitch;
+        rc.channels[channel_map_[2]] = yaw;
+        rc.channels[channel_map_[3]] = throttle;
+    }
 
     rc.channels.emplace_back(aux1);
     rc.channels.emplace_back(aux2);
@@ -0,0 +1,355 @@
+#include "FontTransfer.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace fcu {
+
+// largest address of the 16 bit character address
+static const std::size_t MAX_CHARACTERS = 0x10000;
+
+bool OsdFont::read(std::istream& in) {
+    std::string line;
+    if(!std::getline(in, line)) return false;
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    if(line != "MAX7456") return false;
+
+    std::vector<uint8_t> bytes;
+    while(std::getline(in, line)) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if(line.empty()) continue;
+        if(line.size() != 8) return false;
+        uint8_t byte = 0;
+        for(const char c : line) {
+            if(c != '0' && c != '1') return false;
+            byte = uint8_t(byte << 1 | (c - '0'));
+        }
+        bytes.push_back(byte);
+    }
+    if(bytes.empty() || bytes.size() % CHARACTER_BYTES != 0) return false;
+
+    characters.resize(bytes.size() / CHARACTER_BYTES);
+    for(std::size_t i = 0; i < characters.size(); ++i) {
+        std::copy(bytes.begin() + long(i * CHARACTER_BYTES),
+                  bytes.begin() + long((i + 1) * CHARACTER_BYTES),
+                  characters[i].begin());
+    }
+    return true;
+}
+
+bool OsdFont::write(std::ostream& out) const {
+    out << "MAX7456\r\n";
+    for(const Character& chr : characters) {
+        for(const uint8_t byte : chr) {
+            for(int bit = 7; bit >= 0; --bit) out << ((byte >> bit) & 1);
+            out << "\r\n";
+        }
+    }
+    return bool(out);
+}
+
+bool OsdFont::load(const std::string& path) {
+    std::ifstream file(path);
+    return file.is_open() && read(file);
+}
+
+bool OsdFont::save(const std::string& path) const {
+    std::ofstream file(path);
+    return file.is_open() && write(file);
+}
+
+FontTransfer::FontTransfer(msp::client::Client& client) :
+    client_(client),
+    acks_(0) {}
+
+FontTransferReport FontTransfer::upload(const OsdFont& font,
+                                        const FontTransferOptions& options) {
+    start_             = std::chrono::steady_clock::now();
+    options_           = options;
+    report_            = FontTransferReport();
+    report_.characters = font.characters.size();
+
+    const std::size_t n = font.characters.size();
+    if(n == 0 || n > MAX_CHARACTERS) {
+        report_.duration = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count();
+        return report_;
+    }
+
+    msp::msg::OsdCharRead probe(client_.getVariant());
+    probe.addr = 0;
+    report_.readback =
+        client_.sendMessage(probe, options.timeout) && probe.addr() == 0;
+
+    const msp::client::ListenerId read_listener =
+        client_.addListener<msp::msg::OsdCharRead>(
+            std::bind(&FontTransfer::onRead, this, std::placeholders::_1), 0);
+    const msp::client::ListenerId write_listener =
+        client_.addListener<msp::msg::OsdCharWrite>(
+            std::bind(&FontTransfer::onWriteAck, this, std::placeholders::_1),
+            0);
+
+    std::vector<std::size_t> pending(n);
+    for(std::size_t i = 0; i < n; ++i) pending[i] = i;
+
+    if(report_.readback && options.skip_matching) {
+        const std::map<std::size_t, Visible> current =
+            readRound(pending, FontTransferPhase::READ);
+        pending.clear();
+        for(std::size_t i = 0; i < n; ++i) {
+            const auto it = current.find(i);
+            if(it == current.end() || it->second != visible(font.characters[i]))
+                pending.push_back(i);
+        }
+        report_.skipped = n - pending.size();
+    }
+
+    const bool verify = report_.readback && options.verify;
+    bool acked        = true;
+    for(std::size_t round = 0; !pending.empty(); ++round) {
+        if(round > 0) report_.retries += pending.size();
+        acked = writeRound(font, pending);
+        if(!verify) break;
+
+        const std::map<std::size_t, Visible> written =
+            readRound(pending, FontTransferPhase::VERIFY);
+        std::vector<std::size_t> failed;
+        for(const std::size_t i : pending) {
+            const auto it = written.find(i);
+            if(it == written.end() || it->second != visible(font.characters[i]))
+                failed.push_back(i);
+        }
+        pending.swap(failed);
+        if(round == options.max_retries) break;
+    }
+
+    client_.removeListener(msp::ID::MSP_OSD_CHAR_READ, read_listener);
+    client_.removeListener(msp::ID::MSP_OSD_CHAR_WRITE, write_listener);
+
+    // without read-back it is unknown which write got lost
+    if(verify || !acked) report_.failed = pending;
+    report_.success  = report_.failed.empty();
+    report_.duration = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+    return report_;
+}
+
+FontTransferReport FontTransfer::download(OsdFont& font,
+                                          const std::size_t characters,
+                                          const FontTransferOptions& options) {
+    start_             = std::chrono::steady_clock::now();
+    options_           = options;
+    report_            = FontTransferReport();
+    report_.characters = characters;
+
+    msp::msg::OsdCharRead probe(client_.getVariant());
+    probe.addr = 0;
+    report_.readback =
+        client_.sendMessage(probe, options.timeout) && probe.addr() == 0;
+    if(!report_.readback || characters == 0 || characters > MAX_CHARACTERS) {
+        report_.duration = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start_)
+                               .count();
+        return report_;
+    }
+
+    const msp::client::ListenerId listener =
+        client_.addListener<msp::msg::OsdCharRead>(
+            std::bind(&FontTransfer::onRead, this, std::placeholders::_1), 0);
+
+    std::vector<std::size_t> pending(characters);
+    for(std::size_t i = 0; i < characters; ++i) pending[i] = i;
+
+    OsdFont result;
+    result.characters.assign(characters, OsdFont::Character());
+    for(std::size_t round = 0; !pending.empty(); ++round) {
+        if(round > 0) report_.retries += pending.size();
+        const std::map<std::size_t, Visible> received =
+            readRound(pending, FontTransferPhase::READ);
+        std::vector<std::size_t> missing;
+        for(const std::size_t i : pending) {
+            const auto it = received.find(i);
+            if(it == received.end()) {
+                missing.push_back(i);
+                continue;
+            }
+            std::copy(it->second.begin(), it->second.end(),
+                      result.characters[i].begin());
+        }
+        pending.swap(missing);
+        if(round == options.max_retries) break;
+    }
+
+    client_.removeListener(msp::ID::MSP_OSD_CHAR_READ, listener);
+
+    report_.failed  = pending;
+    report_.success = pending.empty();
+    if(report_.success) font = result;
+    report_.duration = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+    return report_;
+}
+
+std::map<std::size_t, FontTransfer::Visible> FontTransfer::readRound(
+    const std::vector<std::size_t>& addrs, const FontTransferPhase phase) {
+    const auto timeout =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options_.timeout));
+    const std::size_t window = std::max<std::size_t>(options_.window, 1);
+
+    // deadlines keyed by the address, the first entry was sent first
+    std::map<std::size_t, std::chrono::steady_clock::time_point> in_flight;
+    std::map<std::size_t, Visible> result;
+    std::size_t next = 0;
+    std::size_t done = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(next < addrs.size() || !in_flight.empty()) {
+        while(next < addrs.size() && in_flight.size() < window) {
+            const std::size_t addr = addrs[next++];
+            received_.erase(addr);
+            lock.unlock();
+            msp::msg::OsdCharRead request(client_.getVariant());
+            request.addr  = uint16_t(addr);
+            const bool ok = client_.sendMessageNoWait(request);
+            lock.lock();
+            if(ok)
+                in_flight[addr] = std::chrono::steady_clock::now() + timeout;
+            else
+                done++;
+        }
+        if(in_flight.empty()) break;
+
+        const auto oldest = std::min_element(
+            in_flight.begin(), in_flight.end(),
+            [](const std::pair<const std::size_t,
+                               std::chrono::steady_clock::time_point>& a,
+               const std::pair<const std::size_t,
+                               std::chrono::steady_clock::time_point>& b) {
+                return a.second < b.second;
+            });
+        cv_.wait_until(lock, oldest->second, [&] {
+            for(const auto& entry : in_flight) {
+                if(received_.count(entry.first)) return true;
+            }
+            return false;
+        });
+
+        const auto now          = std::chrono::steady_clock::now();
+        const std::size_t prior = done;
+        for(auto it = in_flight.begin(); it != in_flight.end();) {
+            const auto rx = received_.find(it->first);
+            if(rx != received_.end()) {
+                result[it->first] = rx->second;
+                report_.bytes += OsdFont::VISIBLE_BYTES;
+                it = in_flight.erase(it);
+                done++;
+            }
+            else if(it->second <= now) {
+                it = in_flight.erase(it);
+                done++;
+            }
+            else {
+                ++it;
+            }
+        }
+        if(done != prior) {
+            lock.unlock();
+            reportProgress(phase, done, addrs.size());
+            lock.lock();
+        }
+    }
+    return result;
+}
+
+bool FontTransfer::writeRound(const OsdFont& font,
+                              const std::vector<std::size_t>& addrs) {
+    const auto timeout =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options_.timeout));
+    const std::size_t window = std::max<std::size_t>(options_.window, 1);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    const std::size_t base = acks_;
+    std::size_t sent       = 0;
+    std::size_t lost       = 0;
+    // acknowledgements are matched in order, late ones may exceed the writes
+    const auto completed = [&] {
+        return std::min(acks_ - base + lost, sent);
+    };
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while(completed() < addrs.size()) {
+        if(sent < addrs.size() && sent - completed() < window) {
+            if(sent == completed())
+                deadline = std::chrono::steady_clock::now() + timeout;
+            const std::size_t addr = addrs[sent++];
+            lock.unlock();
+            msp::msg::OsdCharWrite request(client_.getVariant());
+            request.addr = uint16_t(addr);
+            std::copy(font.characters[addr].begin(),
+                      font.characters[addr].begin() + OsdFont::VISIBLE_BYTES,
+                      request.font_data.begin());
+            const bool ok = client_.sendMessageNoWait(request);
+            report_.written++;
+            report_.bytes += OsdFont::VISIBLE_BYTES;
+            lock.lock();
+            if(!ok) lost++;
+            continue;
+        }
+
+        const std::size_t prior = completed();
+        if(!cv_.wait_until(lock, deadline,
+                           [&] { return completed() > prior; })) {
+            // the oldest write in flight got no acknowledgement
+            lost++;
+        }
+        deadline = std::chrono::steady_clock::now() + timeout;
+        const std::size_t done = completed();
+        lock.unlock();
+        reportProgress(FontTransferPhase::WRITE, done, addrs.size());
+        lock.lock();
+    }
+    return lost == 0;
+}
+
+void FontTransfer::onRead(const msp::msg::OsdCharRead& chr) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        received_[chr.addr()] = chr.font_data;
+    }
+    cv_.notify_all();
+}
+
+void FontTransfer::onWriteAck(const msp::msg::OsdCharWrite&) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        acks_++;
+    }
+    cv_.notify_all();
+}
+
+void FontTransfer::reportProgress(const FontTransferPhase phase,
+                                  const std::size_t done,
+                                  const std::size_t total) {
+    if(!options_.progress) return;
+    FontTransferProgress progress;
+    progress.phase   = phase;
+    progress.done    = done;
+    progress.total   = total;
+    progress.bytes   = report_.bytes;
+    progress.elapsed = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+    options_.progress(progress);
+}
+
+FontTransfer::Visible FontTransfer::visible(const OsdFont::Character& chr) {
+    Visible v;
+    std::copy(chr.begin(), chr.begin() + OsdFont::VISIBLE_BYTES, v.begin());
+    return v;
+}
+
+}  // namespace fcu
@@ -0,0 +1,174 @@
+#include "Framing.hpp"
+
+namespace msp {
+namespace client {
+
+uint8_t crcV1(uint8_t crc, const uint8_t* begin, const uint8_t* end) {
+    for(; begin != end; ++begin) {
+        crc = crc ^ *begin;
+    }
+    return crc;
+}
+
+uint8_t crcV2(uint8_t crc, const uint8_t b) {
+    crc ^= b;
+    for(int ii = 0; ii < 8; ++ii) {
+        if(crc & 0x80) {
+            crc = uint8_t(crc << 1) ^ 0xD5;
+        }
+        else {
+            crc = uint8_t(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint8_t crcV2(uint8_t crc, const uint8_t* begin, const uint8_t* end) {
+    for(; begin != end; ++begin) {
+        crc = crcV2(crc, *begin);
+    }
+    return crc;
+}
+
+/**
+ * @brief Appends the header of a MSPv1 frame
+ * @param out Buffer receiving the frame
+ * @param direction Direction of the frame
+ * @param id Message ID
+ * @param size Size of the payload
+ */
+static void appendHeaderV1(ByteVector& out, const FrameDirection direction,
+                           const uint8_t id, const std::size_t size) {
+    out.push_back('$');                 // preamble1
+    out.push_back('M');                 // preamble2
+    out.push_back(uint8_t(direction));  // direction
+    if(size >= 255) {
+        out.push_back(255);                          // jumbo marker
+        out.push_back(id);                           // message_id
+        out.push_back(uint8_t(size & 0xFF));         // data size low
+        out.push_back(uint8_t((size >> 8) & 0xFF));  // data size high
+    }
+    else {
+        out.push_back(uint8_t(size));  // data size
+        out.push_back(id);             // message_id
+    }
+}
+
+/**
+ * @brief Appends a MSPv2 frame without preamble and direction, which is
+ * covered by the MSPv2 checksum
+ * @param out Buffer receiving the frame
+ * @param id Message ID
+ * @param payload Payload
+ */
+static void appendBodyV2(ByteVector& out, const uint16_t id,
+                         const ByteVector& payload) {
+    const std::size_t offset = out.size();
+    out.push_back(0);                                       // flag
+    out.push_back(uint8_t(id & 0xFF));                      // message_id low
+    out.push_back(uint8_t(id >> 8));                        // message_id high
+    out.push_back(uint8_t(payload.size() & 0xFF));          // data size low
+    out.push_back(uint8_t((payload.size() >> 8) & 0xFF));   // data size high
+    out.insert(out.end(), payload.begin(), payload.end());  // data
+    out.push_back(crcV2(0, out.data() + offset, out.data() + out.size()));
+}
+
+void appendFrameV1(ByteVector& out, const FrameDirection direction,
+                   const uint8_t id, const ByteVector& payload) {
+    const std::size_t offset = out.size();
+    out.reserve(offset + 8 + payload.size());
+    appendHeaderV1(out, direction, id, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());  // data
+    out.push_back(
+        crcV1(0, out.data() + offset + 3, out.data() + out.size()));  // crc
+}
+
+void appendFrameV2(ByteVector& out, const FrameDirection direction,
+                   const uint16_t id, const ByteVector& payload) {
+    out.reserve(out.size() + 9 + payload.size());
+    out.push_back('$');                 // preamble1
+    out.push_back('X');                 // preamble2
+    out.push_back(uint8_t(direction));  // direction
+    appendBodyV2(out, id, payload);
+}
+
+void appendFrameV2OverV1(ByteVector& out, const FrameDirection direction,
+                         const uint16_t id, const ByteVector& payload) {
+    // inner MSPv2 frame without preamble and direction
+    const std::size_t inner_size = 5 + payload.size() + 1;
+    const std::size_t offset     = out.size();
+    out.reserve(offset + 8 + inner_size);
+    appendHeaderV1(out, direction, MSP_V2_FRAME_ID, inner_size);
+    appendBodyV2(out, id, payload);
+    out.push_back(
+        crcV1(0, out.data() + offset + 3, out.data() + out.size()));  // crc
+}
+
+FrameCheck readFrameHeader(const uint8_t* data, const std::size_t size,
+                           FrameHeader& header) {
+    // preamble and direction
+    if(size < 2) return FRAME_INCOMPLETE;
+    const bool v2 = (data[1] == 'X');
+    if(data[1] != 'M' && !v2) return FRAME_INVALID;
+    if(size < 3) return FRAME_INCOMPLETE;
+    if(data[2] != uint8_t(FrameDirection::REQUEST) &&
+       data[2] != uint8_t(FrameDirection::RESPONSE) &&
+       data[2] != uint8_t(FrameDirection::ERROR_RESPONSE))
+        return FRAME_INVALID;
+
+    std::size_t header_size = v2 ? 8 : 5;
+    if(size < header_size) return FRAME_INCOMPLETE;
+    uint16_t id              = 0;
+    std::size_t payload_size = 0;
+    if(v2) {
+        id           = uint16_t(data[4] | (data[5] << 8));
+        payload_size = std::size_t(data[6]) | (std::size_t(data[7]) << 8);
+    }
+    else {
+        id           = data[4];
+        payload_size = data[3];
+        if(payload_size == 255) {
+            // jumbo frame with 16 bit size after the message ID
+            header_size = 7;
+            if(size < header_size) return FRAME_INCOMPLETE;
+            payload_size = std::size_t(data[5]) | (std::size_t(data[6]) << 8);
+        }
+    }
+
+    header.v2           = v2;
+    header.direction    = FrameDirection(data[2]);
+    header.id           = id;
+    header.header_size  = header_size;
+    header.payload_size = payload_size;
+    return FRAME_VALID;
+}
+
+FrameCheck checkFramePayload(const uint8_t* data, const std::size_t size,
+                             const FrameHeader& header) {
+    const std::size_t frame_size = header.frameSize();
+    if(size < frame_size) return FRAME_INCOMPLETE;
+
+    // the MSPv1 checksum covers the size, ID and payload, the MSPv2 checksum
+    // additionally covers the flags
+    const uint8_t crc = header.v2
+                            ? crcV2(0, data + 3, data + frame_size - 1)
+                            : crcV1(0, data + 3, data + frame_size - 1);
+    return crc == data[frame_size - 1] ? FRAME_VALID : FRAME_CRC_ERROR;
+}
+
+FrameCheck readTunnelledFrame(const uint8_t* payload, const std::size_t size,
+                              uint16_t& id, std::size_t& inner_size) {
+    // flag, 16 bit ID, 16 bit size and CRC
+    if(size < 6) return FRAME_INVALID;
+    const std::size_t len =
+        std::size_t(payload[3]) | (std::size_t(payload[4]) << 8);
+    if(size != 5 + len + 1) return FRAME_INVALID;
+    if(crcV2(0, payload, payload + 5 + len) != payload[5 + len])
+        return FRAME_CRC_ERROR;
+    id         = uint16_t(payload[1] | (payload[2] << 8));
+    inner_size = len;
+    return FRAME_VALID;
+}
+
+}  // namespace client
+}  // namespace msp
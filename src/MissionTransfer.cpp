@@ -0,0 +1,252 @@
+#include "MissionTransfer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace fcu {
+
+// maximum number of waypoints addressable by the 8 bit waypoint number
+static const std::size_t MAX_WAYPOINTS = 255;
+
+static const uint8_t NAV_WP_FLAG_LAST = 0xA5;
+
+MissionTransfer::MissionTransfer(msp::client::Client& client) :
+    client_(client) {}
+
+MissionTransferReport MissionTransfer::upload(
+    const Mission& mission, const MissionTransferOptions& options) {
+    const auto tstart = std::chrono::steady_clock::now();
+    MissionTransferReport report;
+    report.waypoints = mission.size();
+
+    const bool inav = (client_.getVariant() == msp::FirmwareVariant::INAV);
+    mission_        = mission;
+    for(std::size_t i = 0; i < mission_.size(); ++i) {
+        mission_[i].flag = (i + 1 == mission_.size()) ? NAV_WP_FLAG_LAST : 0;
+        // only INAV transfers the action and the third parameter
+        if(!inav) {
+            mission_[i].action = 0;
+            mission_[i].p3     = 0;
+        }
+    }
+
+    std::vector<Pending> pending(mission_.size());
+    for(std::size_t i = 0; i < pending.size(); ++i) pending[i] = {i, true};
+
+    msp::msg::WpGetInfo info(client_.getVariant());
+    report.requests++;
+    const bool has_info = client_.sendMessage(info, options.timeout);
+    if(mission_.empty() || mission_.size() > MAX_WAYPOINTS ||
+       (has_info && info.max_waypoints() > 0 &&
+        mission_.size() > info.max_waypoints())) {
+        for(const Pending& p : pending) report.failed.push_back(p.index);
+        report.duration =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          tstart)
+                .count();
+        return report;
+    }
+
+    const msp::client::ListenerId listener =
+        client_.addListener<msp::msg::WayPoint>(
+            std::bind(&MissionTransfer::onWaypoint, this,
+                      std::placeholders::_1),
+            0);
+
+    while(!pending.empty() && report.rounds <= options.max_retries) {
+        if(report.rounds > 0) report.retries += pending.size();
+        report.rounds++;
+        pending = transferRound(pending, true, options, report);
+        if(!has_info) continue;
+        // ordered stores (INAV) only accept the waypoint following the last
+        // accepted one, everything behind a lost write has to be sent again
+        report.requests++;
+        if(!client_.sendMessage(info, options.timeout) ||
+           info.wp_count() >= mission_.size())
+            continue;
+        std::vector<bool> write(mission_.size(), false);
+        for(const Pending& p : pending) write[p.index] = p.write;
+        for(std::size_t i = info.wp_count(); i < mission_.size(); ++i) {
+            write[i] = true;
+        }
+        std::vector<Pending> merged;
+        for(std::size_t i = 0, k = 0; i < mission_.size(); ++i) {
+            const bool listed = (k < pending.size() && pending[k].index == i);
+            if(listed) k++;
+            if(listed || write[i]) merged.push_back({i, write[i]});
+        }
+        pending.swap(merged);
+    }
+
+    client_.removeListener(msp::ID::MSP_WP, listener);
+
+    for(const Pending& p : pending) report.failed.push_back(p.index);
+    report.success = pending.empty();
+    if(report.success && options.save) {
+        msp::msg::WpMissionSave save(client_.getVariant());
+        report.requests++;
+        report.saved   = client_.sendMessage(save, options.save_timeout);
+        report.success = report.saved;
+    }
+    report.duration = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - tstart)
+                          .count();
+    return report;
+}
+
+MissionTransferReport MissionTransfer::download(
+    Mission& mission, const MissionTransferOptions& options) {
+    const auto tstart = std::chrono::steady_clock::now();
+    MissionTransferReport report;
+
+    msp::msg::WpGetInfo info(client_.getVariant());
+    report.requests++;
+    if(!client_.sendMessage(info, options.timeout)) {
+        report.duration = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - tstart)
+                              .count();
+        return report;
+    }
+    report.waypoints = info.wp_count();
+    mission_.assign(report.waypoints, Waypoint());
+
+    std::vector<Pending> pending(mission_.size());
+    for(std::size_t i = 0; i < pending.size(); ++i) pending[i] = {i, false};
+
+    const msp::client::ListenerId listener =
+        client_.addListener<msp::msg::WayPoint>(
+            std::bind(&MissionTransfer::onWaypoint, this,
+                      std::placeholders::_1),
+            0);
+
+    while(!pending.empty() && report.rounds <= options.max_retries) {
+        if(report.rounds > 0) report.retries += pending.size();
+        report.rounds++;
+        pending = transferRound(pending, false, options, report);
+    }
+
+    client_.removeListener(msp::ID::MSP_WP, listener);
+
+    for(const Pending& p : pending) report.failed.push_back(p.index);
+    report.success = pending.empty();
+    if(report.success) mission = mission_;
+    report.duration = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - tstart)
+                          .count();
+    return report;
+}
+
+std::vector<MissionTransfer::Pending> MissionTransfer::transferRound(
+    const std::vector<Pending>& pending, const bool upload,
+    const MissionTransferOptions& options, MissionTransferReport& report) {
+    const auto timeout =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options.timeout));
+    const std::size_t window = std::max<std::size_t>(options.window, 1);
+
+    struct InFlight {
+        std::size_t index;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    // keyed by the waypoint number, the first entry was sent first
+    std::map<uint8_t, InFlight> in_flight;
+    std::vector<Pending> failed;
+    std::size_t next = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(next < pending.size() || !in_flight.empty()) {
+        while(next < pending.size() && in_flight.size() < window) {
+            const Pending& p    = pending[next++];
+            const uint8_t wp_no = uint8_t(p.index + 1);
+            received_.erase(wp_no);
+            lock.unlock();
+            bool sent = true;
+            if(p.write) {
+                report.requests++;
+                sent &= sendWaypoint(p.index);
+            }
+            report.requests++;
+            sent &= requestWaypoint(p.index);
+            lock.lock();
+            if(!sent) {
+                failed.push_back(p);
+                continue;
+            }
+            in_flight[wp_no] = {p.index,
+                                std::chrono::steady_clock::now() + timeout};
+        }
+        if(in_flight.empty()) break;
+
+        cv_.wait_until(lock, in_flight.begin()->second.deadline, [&] {
+            for(const auto& entry : in_flight) {
+                if(received_.count(entry.first)) return true;
+            }
+            return false;
+        });
+
+        const auto now = std::chrono::steady_clock::now();
+        for(auto it = in_flight.begin(); it != in_flight.end();) {
+            const std::size_t index = it->second.index;
+            const auto rx           = received_.find(it->first);
+            if(rx != received_.end()) {
+                if(!upload)
+                    mission_[index] = rx->second;
+                else if(rx->second != mission_[index])
+                    failed.push_back({index, true});
+                it = in_flight.erase(it);
+            }
+            else if(it->second.deadline <= now) {
+                failed.push_back({index, false});
+                it = in_flight.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    std::sort(failed.begin(), failed.end(),
+              [](const Pending& a, const Pending& b) {
+                  return a.index < b.index;
+              });
+    return failed;
+}
+
+void MissionTransfer::onWaypoint(const msp::msg::WayPoint& wp) {
+    Waypoint waypoint;
+    waypoint.action = wp.action();
+    waypoint.lat    = int32_t(wp.lat());
+    waypoint.lon    = int32_t(wp.lon());
+    waypoint.alt    = int32_t(wp.altHold());
+    waypoint.p1     = wp.heading();
+    waypoint.p2     = wp.staytime();
+    waypoint.p3     = wp.p3();
+    waypoint.flag   = wp.navflag();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        received_[wp.wp_no()] = waypoint;
+    }
+    cv_.notify_all();
+}
+
+bool MissionTransfer::sendWaypoint(const std::size_t index) {
+    const Waypoint& waypoint = mission_[index];
+    msp::msg::SetWp wp(client_.getVariant());
+    wp.wp_no    = uint8_t(index + 1);
+    wp.action   = waypoint.action;
+    wp.lat      = uint32_t(waypoint.lat);
+    wp.lon      = uint32_t(waypoint.lon);
+    wp.alt      = uint32_t(waypoint.alt);
+    wp.p1       = waypoint.p1;
+    wp.p2       = waypoint.p2;
+    wp.p3       = waypoint.p3;
+    wp.nav_flag = waypoint.flag;
+    return client_.sendMessageNoWait(wp);
+}
+
+bool MissionTransfer::requestWaypoint(const std::size_t index) {
+    msp::msg::WayPoint wp(client_.getVariant());
+    wp.wp_no = uint8_t(index + 1);
+    return client_.sendMessageNoWait(wp);
+}
+
+}  // namespace fcu
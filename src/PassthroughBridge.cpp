@@ -0,0 +1,263 @@
+#include "PassthroughBridge.hpp"
+#include <algorithm>
+#include "Socket.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#endif
+
+namespace msp {
+namespace client {
+
+// bytes from the device queued for a slow peer, further bytes are dropped
+static const std::size_t MAX_BACKLOG = 64 * 1024;
+
+PassthroughBridge::PassthroughBridge(Client& client) :
+    client_(client),
+    running_(false),
+    pty_master_(-1),
+    pty_slave_(-1),
+    listen_fd_(-1),
+    peer_fd_(-1),
+    to_device_(0),
+    from_device_(0),
+    dropped_(0) {}
+
+PassthroughBridge::~PassthroughBridge() { stop(); }
+
+bool PassthroughBridge::start(msp::Message& request, const double timeout) {
+    if(running_) return false;
+    if(!client_.enterPassthrough(
+           request,
+           std::bind(&PassthroughBridge::onDeviceData,
+                     this,
+                     std::placeholders::_1,
+                     std::placeholders::_2),
+           timeout))
+        return false;
+    running_ = true;
+    thread_  = std::thread(&PassthroughBridge::run, this);
+    return true;
+}
+
+bool PassthroughBridge::start() {
+    if(running_) return false;
+    if(!client_.startPassthrough(std::bind(&PassthroughBridge::onDeviceData,
+                                           this,
+                                           std::placeholders::_1,
+                                           std::placeholders::_2)))
+        return false;
+    running_ = true;
+    thread_  = std::thread(&PassthroughBridge::run, this);
+    return true;
+}
+
+void PassthroughBridge::stop() {
+    if(running_.exchange(false)) {
+        // onDeviceData is not called anymore once the client switched back
+        client_.stopPassthrough();
+        if(thread_.joinable()) thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_peer_);
+    closeFds();
+}
+
+#ifdef __linux__
+
+std::string PassthroughBridge::openPty() {
+    // the bridge thread polls the descriptors without holding the lock
+    if(running_) return std::string();
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0) return std::string();
+    const char* name = nullptr;
+    if(grantpt(master) != 0 || unlockpt(master) != 0 ||
+       (name = ptsname(master)) == nullptr || !setNonBlocking(master)) {
+        close(master);
+        return std::string();
+    }
+    const std::string path(name);
+    const int slave = open(path.c_str(), O_RDWR | O_NOCTTY);
+    if(slave < 0) {
+        close(master);
+        return std::string();
+    }
+    // the tools expect a serial device without line discipline
+    termios tio;
+    if(tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_peer_);
+    closeFds();
+    pty_master_ = master;
+    pty_slave_  = slave;
+    peer_fd_    = master;
+    return path;
+}
+
+uint16_t PassthroughBridge::listenTcp(const uint16_t port,
+                                      const std::string& address) {
+    if(running_) return 0;
+    uint16_t bound_port = 0;
+    const int fd        = listenTcpSocket(port, address, 1, bound_port);
+    if(fd < 0) return 0;
+
+    std::lock_guard<std::mutex> lock(mutex_peer_);
+    closeFds();
+    listen_fd_ = fd;
+    return bound_port;
+}
+
+void PassthroughBridge::onDeviceData(const uint8_t* data,
+                                     const std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_peer_);
+    if(peer_fd_ < 0) {
+        dropped_ += size;
+        return;
+    }
+    // queued bytes go first, the bridge thread writes them once the peer
+    // can take more
+    const std::size_t written = backlog_.empty() ? writePeer(data, size) : 0;
+    const std::size_t queued =
+        std::min(size - written, MAX_BACKLOG - backlog_.size());
+    backlog_.insert(backlog_.end(), data + written, data + written + queued);
+    from_device_ += written;
+    dropped_ += size - written - queued;
+}
+
+std::size_t PassthroughBridge::writePeer(const uint8_t* data,
+                                         const std::size_t size) {
+    const bool socket   = (peer_fd_ != pty_master_);
+    std::size_t written = 0;
+    while(written < size) {
+        // a closed socket must not raise SIGPIPE
+        const ssize_t n =
+            socket ? send(peer_fd_, data + written, size - written,
+                          MSG_NOSIGNAL)
+                   : write(peer_fd_, data + written, size - written);
+        if(n > 0) {
+            written += std::size_t(n);
+            continue;
+        }
+        if(n < 0 && errno == EINTR) continue;
+        break;
+    }
+    return written;
+}
+
+void PassthroughBridge::clearBacklog() {
+    dropped_ += backlog_.size();
+    backlog_.clear();
+}
+
+void PassthroughBridge::run() {
+    // forwarding is as latency critical as the receiving thread
+    applyThreadPolicy(
+        pthread_self(), client_.getThreadConfig().io, "msp-bridge");
+
+    uint8_t buf[4096];
+    while(running_) {
+        // the listening socket only changes while the bridge is stopped, the
+        // peer is only closed or replaced by this thread
+        int listen_fd;
+        int peer;
+        bool backlog;
+        {
+            std::lock_guard<std::mutex> lock(mutex_peer_);
+            listen_fd = listen_fd_;
+            peer      = peer_fd_;
+            backlog   = !backlog_.empty();
+        }
+        pollfd fds[2];
+        nfds_t count = 0;
+        if(listen_fd >= 0) fds[count++] = {listen_fd, POLLIN, 0};
+        if(peer >= 0)
+            fds[count++] = {peer, short(POLLIN | (backlog ? POLLOUT : 0)), 0};
+        if(poll(fds, count, 50) <= 0) continue;
+
+        for(nfds_t i = 0; i < count; ++i) {
+            if(fds[i].revents == 0) continue;
+            if(fds[i].fd == listen_fd) {
+                const int conn = acceptSocket(listen_fd, true);
+                if(conn < 0) continue;
+                // the latest connection wins
+                std::lock_guard<std::mutex> lock(mutex_peer_);
+                if(peer_fd_ >= 0) close(peer_fd_);
+                peer_fd_ = conn;
+                clearBacklog();
+                continue;
+            }
+            if(fds[i].revents & POLLOUT) {
+                std::lock_guard<std::mutex> lock(mutex_peer_);
+                if(peer_fd_ == fds[i].fd) {
+                    const std::size_t n =
+                        writePeer(backlog_.data(), backlog_.size());
+                    backlog_.erase(backlog_.begin(),
+                                   backlog_.begin() + long(n));
+                    from_device_ += n;
+                }
+            }
+            if(!(fds[i].revents & ~POLLOUT)) continue;
+            const ssize_t n = read(fds[i].fd, buf, sizeof(buf));
+            if(n > 0) {
+                if(client_.writeRaw(buf, std::size_t(n)))
+                    to_device_ += std::size_t(n);
+            }
+            else if(n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                // the TCP peer disconnected
+                std::lock_guard<std::mutex> lock(mutex_peer_);
+                if(peer_fd_ == fds[i].fd && peer_fd_ != pty_master_) {
+                    close(peer_fd_);
+                    peer_fd_ = -1;
+                    clearBacklog();
+                }
+            }
+        }
+    }
+}
+
+void PassthroughBridge::closeFds() {
+    clearBacklog();
+    if(peer_fd_ >= 0 && peer_fd_ != pty_master_) close(peer_fd_);
+    if(pty_master_ >= 0) close(pty_master_);
+    if(pty_slave_ >= 0) close(pty_slave_);
+    if(listen_fd_ >= 0) close(listen_fd_);
+    peer_fd_    = -1;
+    pty_master_ = -1;
+    pty_slave_  = -1;
+    listen_fd_  = -1;
+}
+
+#else
+
+std::string PassthroughBridge::openPty() { return std::string(); }
+
+uint16_t PassthroughBridge::listenTcp(const uint16_t, const std::string&) {
+    return 0;
+}
+
+void PassthroughBridge::onDeviceData(const uint8_t*, const std::size_t size) {
+    dropped_ += size;
+}
+
+std::size_t PassthroughBridge::writePeer(const uint8_t*, const std::size_t) {
+    return 0;
+}
+
+void PassthroughBridge::clearBacklog() {}
+
+void PassthroughBridge::run() {}
+
+void PassthroughBridge::closeFds() {}
+
+#endif
+
+}  // namespace client
+}  // namespace msp
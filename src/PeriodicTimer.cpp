@@ -19,6 +19,10 @@ bool PeriodicTimer::start() {
     mutex_timer.lock();
     // start the thread
     thread_ptr = std::shared_ptr<std::thread>(new std::thread([this] {
+        {
+            std::lock_guard<std::mutex> lock(mutex_policy);
+            applyThreadPolicy(pthread_self(), policy_, "msp-timer");
+        }
         // log now.
         tstart = std::chrono::steady_clock::now();
         while(true) {
@@ -59,11 +63,16 @@ void PeriodicTimer::setPeriod(const double& period_seconds) {
     start();
 }
 
-bool PeriodicTimer::setRealtimePriority() {
-    sched_param sch_params;
-    sch_params.sched_priority = 80;
+bool PeriodicTimer::setThreadPolicy(const ThreadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_policy);
+    policy_ = policy;
+    // a stopped thread applies the policy when it is started again
+    if(thread_ptr == nullptr || !thread_ptr->joinable()) return true;
+    return applyThreadPolicy(thread_ptr->native_handle(), policy_, "");
+}
 
-    return pthread_setschedparam(this->thread_ptr->native_handle(), SCHED_FIFO, &sch_params) == 0;
+bool PeriodicTimer::setRealtimePriority() {
+    return setThreadPolicy(ThreadPolicy::realtime());
 }
 
 }  // namespace msp
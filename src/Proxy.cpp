@@ -0,0 +1,442 @@
+#include "Proxy.hpp"
+#include <algorithm>
+#include "Socket.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Message with an opaque payload, which forwards a request of a
+ * connection through the client
+ */
+class RawMessage : public msp::Message {
+public:
+    RawMessage(const FirmwareVariant v, const uint16_t id,
+               const ByteVector& request) :
+        Message(v),
+        id_(id),
+        request_(request) {}
+
+    virtual ID id() const override { return ID(id_); }
+
+    virtual ByteVectorUptr encode() const override {
+        return std::make_unique<ByteVector>(request_);
+    }
+
+    using Message::decode;
+
+    virtual bool decode(const ByteView& data) override {
+        response.assign(data.begin(), data.end());
+        return true;
+    }
+
+    // payload of the response, empty if the response has no payload
+    ByteVector response;
+
+private:
+    const uint16_t id_;
+    const ByteVector& request_;
+};
+
+Proxy::Proxy(Client& client, const ProxyOptions& options) :
+    client_(client),
+    options_(options),
+    running_(false),
+    wake_fd_(-1) {}
+
+Proxy::~Proxy() { stop(); }
+
+void Proxy::stop() {
+    if(running_.exchange(false)) {
+        if(thread_.joinable()) thread_.join();
+    }
+    // waits for the requests on the link, their responses are dropped
+    pool_.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    closeAll();
+}
+
+std::size_t Proxy::connections() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::size_t(std::count_if(
+        connections_.begin(),
+        connections_.end(),
+        [](const std::shared_ptr<Connection>& c) { return !c->closed; }));
+}
+
+ProxyStats Proxy::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void Proxy::respond(ByteVector& out, const Framing framing, const bool error,
+                    const uint16_t id, const ByteVector& payload) {
+    const FrameDirection direction =
+        error ? FrameDirection::ERROR_RESPONSE : FrameDirection::RESPONSE;
+    const ByteVector empty;
+    const ByteVector& data = error ? empty : payload;
+    if(framing == Framing::V1)
+        appendFrameV1(out, direction, uint8_t(id), data);
+    else if(framing == Framing::V2_OVER_V1)
+        appendFrameV2OverV1(out, direction, id, data);
+    else
+        appendFrameV2(out, direction, id, data);
+}
+
+void Proxy::parse(Connection& connection) {
+    const ByteVector& in = connection.input;
+    std::size_t pos      = 0;
+    while(pos < in.size()) {
+        if(in[pos] != '$') {
+            pos++;
+            continue;
+        }
+        const uint8_t* f       = in.data() + pos;
+        const std::size_t left = in.size() - pos;
+        FrameHeader header;
+        FrameCheck check = readFrameHeader(f, left, header);
+        if(check == FRAME_INCOMPLETE) break;
+        if(check == FRAME_INVALID ||
+           header.direction != FrameDirection::REQUEST) {
+            // not the start of a request
+            pos++;
+            continue;
+        }
+        check = checkFramePayload(f, left, header);
+        if(check == FRAME_INCOMPLETE) break;
+
+        Request request;
+        request.id             = header.id;
+        request.framing        = header.v2 ? Framing::V2 : Framing::V1;
+        const uint8_t* payload = f + header.header_size;
+        std::size_t size       = header.payload_size;
+        if(check == FRAME_VALID && !header.v2 &&
+           header.id == MSP_V2_FRAME_ID) {
+            // MSPv2 frame in the payload, with its own size and CRC
+            check = readTunnelledFrame(payload, size, request.id, size);
+            payload += 5;
+            request.framing = Framing::V2_OVER_V1;
+        }
+        if(check != FRAME_VALID) {
+            // resynchronise on the next preamble
+            stats_.corrupt++;
+            pos++;
+            continue;
+        }
+        request.payload.assign(payload, payload + size);
+        pos += header.frameSize();
+        stats_.requests++;
+        if(connection.queue.size() >= options_.max_queue) {
+            stats_.rejected++;
+            respond(connection.output,
+                    request.framing,
+                    true,
+                    request.id,
+                    request.payload);
+            continue;
+        }
+        connection.queue.push_back(std::move(request));
+    }
+    connection.input.erase(connection.input.begin(),
+                           connection.input.begin() + pos);
+}
+
+void Proxy::schedule() {
+    while(true) {
+        // merge the reads without payload into the jobs on the link and
+        // find the connection to serve next, the first of the highest
+        // priority in the turn order
+        std::size_t next = connections_.size();
+        for(std::size_t i = 0; i < connections_.size(); ++i) {
+            Connection& c = *connections_[i];
+            if(c.closed) continue;
+            while(!c.queue.empty()) {
+                const Request& head = c.queue.front();
+                const auto job      = jobs_.find(head.id);
+                if(job == jobs_.end() || !head.payload.empty() ||
+                   !job->second->payload.empty() ||
+                   !client_.isRead(msp::ID(head.id)))
+                    break;
+                job->second->waiters.emplace_back(connections_[i],
+                                                  head.framing);
+                c.queue.pop_front();
+                stats_.merged++;
+            }
+            // requests of an ID on the link wait for its response
+            if(c.queue.empty() || jobs_.count(c.queue.front().id)) continue;
+            if(next == connections_.size() ||
+               c.priority > connections_[next]->priority)
+                next = i;
+        }
+        if(next == connections_.size() ||
+           jobs_.size() >= options_.max_in_flight)
+            return;
+
+        const std::shared_ptr<Connection> connection = connections_[next];
+        Request& head = connection->queue.front();
+        const std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->id                        = head.id;
+        job->payload                   = std::move(head.payload);
+        job->waiters.emplace_back(connection, head.framing);
+        connection->queue.pop_front();
+        jobs_[job->id] = job;
+        stats_.forwarded++;
+        // the served connection takes its next turn after all others
+        std::rotate(connections_.begin() + long(next),
+                    connections_.begin() + long(next) + 1,
+                    connections_.end());
+        pool_->post([this, job] { execute(job); });
+    }
+}
+
+void Proxy::execute(const std::shared_ptr<Job>& job) {
+    RawMessage message(client_.getVariant(), job->id, job->payload);
+    const bool ok = client_.sendMessage(message, options_.timeout);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.erase(job->id);
+        for(const auto& waiter : job->waiters) {
+            if(waiter.first->closed) continue;
+            respond(waiter.first->output,
+                    waiter.second,
+                    !ok,
+                    job->id,
+                    message.response);
+        }
+        if(!ok) stats_.failed += job->waiters.size();
+    }
+    // the proxy thread writes the responses and schedules the next requests
+    notify();
+}
+
+#ifdef __linux__
+
+bool Proxy::listenUnix(const std::string& path, const int priority) {
+    sockaddr_un addr;
+    addr.sun_family = AF_UNIX;
+    if(path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    std::copy(path.begin(), path.end(), addr.sun_path);
+    addr.sun_path[path.size()] = '\0';
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) return false;
+    // a socket left behind by a crashed proxy is replaced, any other file is
+    // kept
+    struct stat info;
+    if(lstat(path.c_str(), &info) == 0) {
+        if(!S_ISSOCK(info.st_mode) || unlink(path.c_str()) != 0) {
+            close(fd);
+            return false;
+        }
+    }
+    if(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       listen(fd, 16) != 0 || !setNonBlocking(fd)) {
+        close(fd);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Listener listener;
+    listener.fd       = fd;
+    listener.priority = priority;
+    listener.path     = path;
+    listeners_.push_back(listener);
+    return true;
+}
+
+uint16_t Proxy::listenTcp(const uint16_t port, const std::string& address,
+                          const int priority) {
+    uint16_t bound_port = 0;
+    const int fd        = listenTcpSocket(port, address, 16, bound_port);
+    if(fd < 0) return 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Listener listener;
+    listener.fd       = fd;
+    listener.priority = priority;
+    listeners_.push_back(listener);
+    return bound_port;
+}
+
+bool Proxy::start() {
+    if(running_) return false;
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(wake_fd_ < 0) return false;
+    pool_ = std::make_unique<ThreadPool>(
+        std::max<std::size_t>(options_.max_in_flight, 1), options_.policy);
+    running_ = true;
+    thread_  = std::thread(&Proxy::run, this);
+    return true;
+}
+
+void Proxy::notify() {
+    const uint64_t one = 1;
+    if(write(wake_fd_, &one, sizeof(one)) < 0) return;
+}
+
+void Proxy::run() {
+    applyThreadPolicy(pthread_self(), options_.policy, "msp-proxy");
+
+    std::vector<pollfd> fds;
+    std::vector<Listener> listeners;
+    std::vector<std::shared_ptr<Connection>> connections;
+    while(running_) {
+        // the listeners and connections may change while polling
+        fds.clear();
+        fds.push_back({wake_fd_, POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            listeners   = listeners_;
+            connections = connections_;
+            for(const Listener& l : listeners) fds.push_back({l.fd, POLLIN, 0});
+            for(const auto& c : connections) {
+                const short events =
+                    short(POLLIN | (c->output.empty() ? 0 : POLLOUT));
+                fds.push_back({c->fd, events, 0});
+            }
+        }
+        if(poll(fds.data(), nfds_t(fds.size()), 50) < 0) continue;
+
+        if(fds[0].revents & POLLIN) {
+            uint64_t count;
+            if(read(wake_fd_, &count, sizeof(count)) < 0) count = 0;
+        }
+        for(std::size_t i = 0; i < listeners.size(); ++i) {
+            if(fds[1 + i].revents & POLLIN) accept(listeners[i]);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(std::size_t i = 0; i < connections.size(); ++i) {
+            const short revents = fds[1 + listeners.size() + i].revents;
+            if(revents & (POLLIN | POLLHUP | POLLERR))
+                receive(connections[i]);
+        }
+        schedule();
+        // write the responses right away, POLLOUT only covers a full socket
+        for(const auto& c : connections_) {
+            if(!c->output.empty()) flush(c);
+        }
+        // in flight requests of a closed connection keep it until they are
+        // answered, but its socket is closed immediately
+        const auto closed = std::stable_partition(
+            connections_.begin(),
+            connections_.end(),
+            [](const std::shared_ptr<Connection>& c) { return !c->closed; });
+        for(auto it = closed; it != connections_.end(); ++it) {
+            close((*it)->fd);
+            (*it)->fd = -1;
+        }
+        connections_.erase(closed, connections_.end());
+    }
+}
+
+void Proxy::accept(const Listener& listener) {
+    const int fd = acceptSocket(listener.fd, listener.path.empty());
+    if(fd < 0) return;
+
+    const std::shared_ptr<Connection> connection =
+        std::make_shared<Connection>();
+    connection->fd       = fd;
+    connection->priority = listener.priority;
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.push_back(connection);
+    stats_.connections++;
+}
+
+void Proxy::receive(const std::shared_ptr<Connection>& connection) {
+    if(connection->closed) return;
+    uint8_t buf[4096];
+    while(true) {
+        const ssize_t n = read(connection->fd, buf, sizeof(buf));
+        if(n > 0) {
+            connection->input.insert(connection->input.end(), buf, buf + n);
+            continue;
+        }
+        if(n < 0 && errno == EINTR) continue;
+        if(n == 0 || errno != EAGAIN) {
+            // the program disconnected, its queued requests are dropped
+            connection->closed = true;
+            connection->queue.clear();
+            return;
+        }
+        break;
+    }
+    parse(*connection);
+}
+
+void Proxy::flush(const std::shared_ptr<Connection>& connection) {
+    ByteVector& out = connection->output;
+    std::size_t written = 0;
+    while(written < out.size()) {
+        // a closed socket must not raise SIGPIPE
+        const ssize_t n = send(connection->fd,
+                               out.data() + written,
+                               out.size() - written,
+                               MSG_NOSIGNAL);
+        if(n > 0) {
+            written += std::size_t(n);
+            continue;
+        }
+        if(n < 0 && errno == EINTR) continue;
+        if(n < 0 && errno != EAGAIN) {
+            connection->closed = true;
+            connection->queue.clear();
+        }
+        break;
+    }
+    out.erase(out.begin(), out.begin() + long(written));
+}
+
+void Proxy::closeAll() {
+    for(const auto& c : connections_) {
+        if(c->fd >= 0) close(c->fd);
+        c->fd     = -1;
+        c->closed = true;
+    }
+    connections_.clear();
+    for(const Listener& l : listeners_) {
+        close(l.fd);
+        if(!l.path.empty()) unlink(l.path.c_str());
+    }
+    listeners_.clear();
+    jobs_.clear();
+    if(wake_fd_ >= 0) close(wake_fd_);
+    wake_fd_ = -1;
+}
+
+#else
+
+bool Proxy::listenUnix(const std::string&, const int) { return false; }
+
+uint16_t Proxy::listenTcp(const uint16_t, const std::string&, const int) {
+    return 0;
+}
+
+bool Proxy::start() { return false; }
+
+void Proxy::notify() {}
+
+void Proxy::run() {}
+
+void Proxy::accept(const Listener&) {}
+
+void Proxy::receive(const std::shared_ptr<Connection>&) {}
+
+void Proxy::flush(const std::shared_ptr<Connection>&) {}
+
+void Proxy::closeAll() {}
+
+#endif
+
+}  // namespace client
+}  // namespace msp
@@ -0,0 +1,104 @@
+#include "SerialTuning.hpp"
+
+#ifdef __linux__
+// termios2 is only declared by the kernel headers, which cannot be combined
+// with the termios.h of the C library (included by asio)
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#endif
+
+namespace msp {
+namespace client {
+
+#ifdef __linux__
+
+// sysfs attribute with the latency timer of FTDI adapters
+static std::string latencyTimerPath(const std::string& device) {
+    // resolve symlinks like /dev/serial/by-id/...
+    char path[PATH_MAX];
+    if(realpath(device.c_str(), path) == nullptr) return std::string();
+    const std::string name(path);
+    return "/sys/class/tty/" + name.substr(name.find_last_of('/') + 1) +
+           "/device/latency_timer";
+}
+
+bool applySerialTuning(const int fd, const std::string& device,
+                       const SerialTuning& tuning) {
+    bool rc = true;
+
+    struct serial_struct serial;
+    const bool has_serial = (ioctl(fd, TIOCGSERIAL, &serial) == 0);
+    if(has_serial && (tuning.low_latency || tuning.xmit_fifo_size > 0)) {
+        if(tuning.low_latency) serial.flags |= ASYNC_LOW_LATENCY;
+        if(tuning.xmit_fifo_size > 0)
+            serial.xmit_fifo_size = tuning.xmit_fifo_size;
+        rc &= (ioctl(fd, TIOCSSERIAL, &serial) == 0);
+    }
+
+    if(tuning.low_latency) {
+        // FTDI adapters buffer up to 16 ms by default, only some kernels
+        // lower the timer for ASYNC_LOW_LATENCY
+        std::ofstream timer(latencyTimerPath(device));
+        if(timer.is_open()) rc &= bool(timer << 1 << std::endl);
+    }
+
+    if(tuning.vmin >= 0 || tuning.vtime >= 0) {
+        struct termios2 tio;
+        if(ioctl(fd, TCGETS2, &tio) != 0) return false;
+        if(tuning.vmin >= 0) tio.c_cc[VMIN] = cc_t(tuning.vmin);
+        if(tuning.vtime >= 0) tio.c_cc[VTIME] = cc_t(tuning.vtime);
+        rc &= (ioctl(fd, TCSETS2, &tio) == 0);
+    }
+
+    if(tuning.flush_input) rc &= (ioctl(fd, TCFLSH, TCIFLUSH) == 0);
+    return rc;
+}
+
+bool setCustomBaudrate(const int fd, const size_t baudrate) {
+    struct termios2 tio;
+    if(ioctl(fd, TCGETS2, &tio) != 0) return false;
+    tio.c_cflag &= ~tcflag_t(CBAUD);
+    tio.c_cflag |= BOTHER;
+    tio.c_ispeed = speed_t(baudrate);
+    tio.c_ospeed = speed_t(baudrate);
+    return ioctl(fd, TCSETS2, &tio) == 0;
+}
+
+SerialStatus querySerialStatus(const int fd, const std::string& device) {
+    SerialStatus status;
+    struct serial_struct serial;
+    if(ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        status.low_latency    = (serial.flags & ASYNC_LOW_LATENCY) != 0;
+        status.xmit_fifo_size = serial.xmit_fifo_size;
+    }
+    struct termios2 tio;
+    if(ioctl(fd, TCGETS2, &tio) == 0) {
+        status.baudrate = long(tio.c_ospeed);
+        status.vmin     = tio.c_cc[VMIN];
+        status.vtime    = tio.c_cc[VTIME];
+    }
+    std::ifstream timer(latencyTimerPath(device));
+    if(timer.is_open()) timer >> status.latency_timer;
+    return status;
+}
+
+#else
+
+bool applySerialTuning(const int, const std::string&, const SerialTuning&) {
+    return false;
+}
+
+bool setCustomBaudrate(const int, const size_t) { return false; }
+
+SerialStatus querySerialStatus(const int, const std::string&) {
+    return SerialStatus();
+}
+
+#endif
+
+}  // namespace client
+}  // namespace msp
@@ -0,0 +1,70 @@
+#include "Socket.hpp"
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace msp {
+namespace client {
+
+#ifdef __linux__
+
+bool setNonBlocking(const int fd) {
+    const int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int listenTcpSocket(const uint16_t port, const std::string& address,
+                    const int backlog, uint16_t& bound_port) {
+    sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    if(inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) return -1;
+
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) return -1;
+    const int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    socklen_t len = sizeof(addr);
+    if(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       listen(fd, backlog) != 0 || !setNonBlocking(fd) ||
+       getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    bound_port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int acceptSocket(const int listen_fd, const bool tcp) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if(fd < 0) return -1;
+    if(tcp) {
+        // small frames must not wait for more data
+        const int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    setNonBlocking(fd);
+    return fd;
+}
+
+#else
+
+bool setNonBlocking(const int) { return false; }
+
+int listenTcpSocket(const uint16_t, const std::string&, const int,
+                    uint16_t&) {
+    return -1;
+}
+
+int acceptSocket(const int, const bool) { return -1; }
+
+#endif
+
+}  // namespace client
+}  // namespace msp
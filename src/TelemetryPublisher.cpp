@@ -0,0 +1,175 @@
+#include "TelemetryPublisher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace msp {
+namespace client {
+
+TelemetryPublisher::TelemetryPublisher(
+    const std::string& name, const TelemetryPublisherOptions& options) :
+    name_(name),
+    options_(options),
+    client_(nullptr),
+    base_(nullptr),
+    size_(0),
+    header_(nullptr),
+    ring_capacity_(1),
+    published_(0),
+    oversized_(0),
+    no_slot_(0) {
+    while(ring_capacity_ < options_.ring_capacity) ring_capacity_ <<= 1;
+}
+
+TelemetryPublisher::~TelemetryPublisher() { close(); }
+
+bool TelemetryPublisher::attach(Client& client) {
+    if(!isOpen()) return false;
+    detach();
+    client_ = &client;
+    client.setFrameTap(std::bind(&TelemetryPublisher::publish,
+                                 this,
+                                 std::placeholders::_1,
+                                 std::placeholders::_2));
+    return true;
+}
+
+void TelemetryPublisher::detach() {
+    // the tap is not called anymore once this returns
+    if(client_ != nullptr) client_->setFrameTap(FrameTap());
+    client_ = nullptr;
+}
+
+bool TelemetryPublisher::publish(const msp::ID id, const ByteView& payload) {
+    if(header_ == nullptr) return false;
+    if(!options_.ids.empty() &&
+       std::find(options_.ids.begin(), options_.ids.end(), id) ==
+           options_.ids.end())
+        return false;
+    if(payload.size() > options_.max_payload) {
+        oversized_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const uint64_t stamp = uint64_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+
+    // the slots are assigned in the order in which the IDs arrive
+    const uint32_t key = uint32_t(id) + 1;
+    auto slot = std::find(slot_keys_.begin(), slot_keys_.end(), key);
+    if(slot == slot_keys_.end()) {
+        slot = std::find(slot_keys_.begin(), slot_keys_.end(), 0);
+        if(slot != slot_keys_.end()) *slot = key;
+    }
+    if(slot != slot_keys_.end()) {
+        shm::Record* r = record(std::size_t(slot - slot_keys_.begin()));
+        write(r, id, r->sequence + 1, stamp, payload);
+        r->key.store(key, std::memory_order_release);
+    }
+    else {
+        no_slot_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const uint64_t head = header_->head.load(std::memory_order_relaxed);
+    write(record(options_.slots + (head & (ring_capacity_ - 1))),
+          id,
+          head,
+          stamp,
+          payload);
+    header_->head.store(head + 1, std::memory_order_release);
+    published_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+TelemetryPublisherStats TelemetryPublisher::stats() const {
+    TelemetryPublisherStats s;
+    s.published = published_.load(std::memory_order_relaxed);
+    s.oversized = oversized_.load(std::memory_order_relaxed);
+    s.no_slot   = no_slot_.load(std::memory_order_relaxed);
+    return s;
+}
+
+shm::Record* TelemetryPublisher::record(const std::size_t index) const {
+    uint8_t* records =
+        static_cast<uint8_t*>(base_) + (sizeof(shm::Header) + 63) / 64 * 64;
+    return reinterpret_cast<shm::Record*>(
+        records + index * shm::recordSize(options_.max_payload));
+}
+
+void TelemetryPublisher::write(shm::Record* record, const msp::ID id,
+                               const uint64_t sequence, const uint64_t stamp,
+                               const ByteView& payload) {
+    // an odd lock makes readers retry until the record is complete
+    const uint32_t lock = record->lock.load(std::memory_order_relaxed);
+    record->lock.store(lock + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record->sequence = sequence;
+    record->stamp    = stamp;
+    record->id       = uint32_t(id);
+    record->size     = uint32_t(payload.size());
+    if(!payload.empty())
+        std::memcpy(shm::payload(record), payload.data(), payload.size());
+    record->lock.store(lock + 2, std::memory_order_release);
+}
+
+#ifdef __linux__
+
+bool TelemetryPublisher::open() {
+    close();
+    size_ = shm::regionSize(
+        options_.slots, ring_capacity_, options_.max_payload);
+    // a region left behind by a crashed publisher is replaced
+    shm_unlink(name_.c_str());
+    const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0) return false;
+    void* base = MAP_FAILED;
+    if(ftruncate(fd, off_t(size_)) == 0)
+        base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(base == MAP_FAILED) {
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    base_ = base;
+
+    // the region is zero filled, readers wait for the magic number
+    header_                = new(base_) shm::Header();
+    header_->version       = shm::VERSION;
+    header_->slot_count    = uint32_t(options_.slots);
+    header_->ring_capacity = uint32_t(ring_capacity_);
+    header_->max_payload   = uint32_t(options_.max_payload);
+    header_->record_size   = uint32_t(shm::recordSize(options_.max_payload));
+    header_->head.store(0, std::memory_order_relaxed);
+    for(std::size_t i = 0; i < options_.slots + ring_capacity_; ++i)
+        new(record(i)) shm::Record();
+    slot_keys_.assign(options_.slots, 0);
+    header_->magic.store(shm::MAGIC, std::memory_order_release);
+    return true;
+}
+
+void TelemetryPublisher::close() {
+    detach();
+    if(base_ == nullptr) return;
+    munmap(base_, size_);
+    shm_unlink(name_.c_str());
+    base_   = nullptr;
+    header_ = nullptr;
+}
+
+#else
+
+bool TelemetryPublisher::open() { return false; }
+
+void TelemetryPublisher::close() { detach(); }
+
+#endif
+
+}  // namespace client
+}  // namespace msp
@@ -0,0 +1,147 @@
+#include "TelemetryReader.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace msp {
+namespace client {
+
+// attempts to copy a slot while the publisher keeps rewriting it, bounded so
+// that a publisher which died in the middle of a write cannot block readers
+static const int MAX_ATTEMPTS = 1000;
+
+TelemetryReader::TelemetryReader() :
+    base_(nullptr),
+    size_(0),
+    header_(nullptr),
+    cursor_(0),
+    lost_(0) {}
+
+TelemetryReader::~TelemetryReader() { close(); }
+
+bool TelemetryReader::latest(const msp::ID id,
+                             TelemetrySample& sample) const {
+    if(header_ == nullptr) return false;
+    const uint32_t key = uint32_t(id) + 1;
+    for(std::size_t i = 0; i < header_->slot_count; ++i) {
+        const shm::Record* r = record(i);
+        const uint32_t k     = r->key.load(std::memory_order_acquire);
+        // slots are assigned in order, the first free one ends the search
+        if(k == 0) return false;
+        if(k != key) continue;
+        for(int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            if(copy(r, sample)) return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+std::size_t TelemetryReader::read(TelemetrySample* out, const std::size_t n) {
+    if(header_ == nullptr) return 0;
+    const uint64_t capacity = header_->ring_capacity;
+    const uint64_t head     = header_->head.load(std::memory_order_acquire);
+    if(head - cursor_ > capacity) {
+        lost_ += head - cursor_ - capacity;
+        cursor_ = head - capacity;
+    }
+    std::size_t count = 0;
+    while(count < n && cursor_ < head) {
+        const shm::Record* r =
+            record(header_->slot_count + (cursor_ & (capacity - 1)));
+        // a record which is being written or holds a newer position was
+        // overwritten by the publisher before it could be read
+        if(copy(r, out[count]) && out[count].sequence == cursor_)
+            count++;
+        else
+            lost_++;
+        cursor_++;
+    }
+    return count;
+}
+
+std::size_t TelemetryReader::available() const {
+    if(header_ == nullptr) return 0;
+    const uint64_t head = header_->head.load(std::memory_order_acquire);
+    return std::size_t(
+        std::min<uint64_t>(head - cursor_, header_->ring_capacity));
+}
+
+const shm::Record* TelemetryReader::record(const std::size_t index) const {
+    const uint8_t* records = static_cast<const uint8_t*>(base_) +
+                             (sizeof(shm::Header) + 63) / 64 * 64;
+    return reinterpret_cast<const shm::Record*>(
+        records + index * header_->record_size);
+}
+
+bool TelemetryReader::copy(const shm::Record* record,
+                           TelemetrySample& sample) const {
+    const uint32_t lock = record->lock.load(std::memory_order_acquire);
+    if(lock & 1) return false;
+    // the size may be torn by a concurrent write, which the lock detects
+    const std::size_t size =
+        std::min<std::size_t>(record->size, header_->max_payload);
+    const uint8_t* payload = shm::payload(record);
+    sample.id              = uint16_t(record->id);
+    sample.sequence        = record->sequence;
+    sample.stamp           = record->stamp;
+    sample.payload.assign(payload, payload + size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return record->lock.load(std::memory_order_relaxed) == lock;
+}
+
+#ifdef __linux__
+
+bool TelemetryReader::open(const std::string& name) {
+    close();
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0) return false;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && std::size_t(st.st_size) >= sizeof(shm::Header))
+        base = mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED,
+                    fd, 0);
+    ::close(fd);
+    if(base == MAP_FAILED) return false;
+    base_   = base;
+    size_   = std::size_t(st.st_size);
+    header_ = static_cast<const shm::Header*>(base_);
+
+    // reject regions of other programs, other versions and truncated ones
+    const uint32_t capacity = header_->ring_capacity;
+    if(header_->magic.load(std::memory_order_acquire) != shm::MAGIC ||
+       header_->version != shm::VERSION || capacity == 0 ||
+       (capacity & (capacity - 1)) != 0 ||
+       header_->record_size != shm::recordSize(header_->max_payload) ||
+       shm::regionSize(header_->slot_count, capacity,
+                       header_->max_payload) > size_) {
+        close();
+        return false;
+    }
+    cursor_ = header_->head.load(std::memory_order_acquire);
+    lost_   = 0;
+    return true;
+}
+
+void TelemetryReader::close() {
+    if(base_ == nullptr) return;
+    munmap(const_cast<void*>(base_), size_);
+    base_   = nullptr;
+    header_ = nullptr;
+}
+
+#else
+
+bool TelemetryReader::open(const std::string&) { return false; }
+
+void TelemetryReader::close() {}
+
+#endif
+
+}  // namespace client
+}  // namespace msp
@@ -0,0 +1,69 @@
+#include "ThreadPolicy.hpp"
+#include <sched.h>
+#include <sys/mman.h>
+
+namespace msp {
+
+bool applyThreadPolicy(const pthread_t thread, const ThreadPolicy& policy,
+                       const std::string& name) {
+    bool rc = true;
+
+    if(policy.scheduler != ThreadPolicy::Scheduler::INHERIT) {
+        int sched = SCHED_OTHER;
+        switch(policy.scheduler) {
+        case ThreadPolicy::Scheduler::FIFO:
+            sched = SCHED_FIFO;
+            break;
+        case ThreadPolicy::Scheduler::RR:
+            sched = SCHED_RR;
+            break;
+#ifdef __linux__
+        case ThreadPolicy::Scheduler::BATCH:
+            sched = SCHED_BATCH;
+            break;
+        case ThreadPolicy::Scheduler::IDLE:
+            sched = SCHED_IDLE;
+            break;
+#endif
+        default:
+            break;
+        }
+        sched_param param;
+        // the time sharing classes only accept priority 0
+        param.sched_priority =
+            (sched == SCHED_FIFO || sched == SCHED_RR) ? policy.priority : 0;
+        rc &= (pthread_setschedparam(thread, sched, &param) == 0);
+    }
+
+#ifdef __linux__
+    if(!policy.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(const int cpu : policy.cpus) {
+            if(cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        rc &= (pthread_setaffinity_np(thread, sizeof(set), &set) == 0);
+    }
+
+    // the kernel limits names to 16 bytes including the terminator
+    if(!name.empty())
+        rc &= (pthread_setname_np(thread, name.substr(0, 15).c_str()) == 0);
+#else
+    if(!policy.cpus.empty()) rc = false;
+    (void)name;
+#endif
+    return rc;
+}
+
+bool lockMemory() { return mlockall(MCL_CURRENT | MCL_FUTURE) == 0; }
+
+void prefaultStack(const std::size_t bytes) {
+    volatile unsigned char page[4096];
+    page[0]                = 0;
+    page[sizeof(page) - 1] = 0;
+    if(bytes > sizeof(page)) prefaultStack(bytes - sizeof(page));
+    // using the page after the call prevents a tail call reusing the frame
+    page[1] = page[0];
+}
+
+}  // namespace msp
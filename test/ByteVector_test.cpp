@@ -1,5 +1,10 @@
 #include "ByteVector.hpp"
+#include <array>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace msp {
@@ -272,6 +277,156 @@ TYPED_TEST(ByteVectorScaledTest, Pack1FloatSaturationMin) {
     EXPECT_FLOAT_EQ(std::numeric_limits<TypeParam>::min(), ref);
 }
 
+TYPED_TEST(ByteVectorBasicTest, PackArray) {
+    ByteVector b;
+    const std::array<TypeParam, 3> ref = {
+        std::numeric_limits<TypeParam>::min(), TypeParam(1),
+        std::numeric_limits<TypeParam>::max()};
+    EXPECT_TRUE(b.pack(ref));
+    EXPECT_EQ(3 * sizeof(TypeParam), b.size());
+    std::array<TypeParam, 3> out;
+    EXPECT_TRUE(b.unpack(out));
+    EXPECT_EQ(ref, out);
+    EXPECT_EQ(std::size_t(0), b.unpacking_remaining());
+}
+
+TYPED_TEST(ByteVectorBasicTest, PackArrayElementwise) {
+    // bulk packing produces the same bytes as packing each element
+    const std::array<TypeParam, 4> ref = {
+        TypeParam(0), TypeParam(1), std::numeric_limits<TypeParam>::max(),
+        std::numeric_limits<TypeParam>::min()};
+    ByteVector bulk, single;
+    EXPECT_TRUE(bulk.pack(ref.data(), ref.size()));
+    for(const auto& v : ref) EXPECT_TRUE(single.pack(v));
+    EXPECT_EQ(single, bulk);
+}
+
+TEST(ByteVectorBasicTest, PackLittleEndian) {
+    ByteVector b;
+    const std::vector<uint16_t> ref = {0x1234, 0xABCD};
+    EXPECT_TRUE(b.pack(ref));
+    ASSERT_EQ(std::size_t(4), b.size());
+    EXPECT_EQ(uint8_t(0x34), b[0]);
+    EXPECT_EQ(uint8_t(0x12), b[1]);
+    EXPECT_EQ(uint8_t(0xCD), b[2]);
+    EXPECT_EQ(uint8_t(0xAB), b[3]);
+}
+
+TEST(ByteVectorBasicTest, UnpackVector) {
+    ByteVector b;
+    const std::vector<int16_t> ref = {-1, 2, -3, 4, -5};
+    EXPECT_TRUE(b.pack(ref));
+    // incomplete trailing element is not consumed
+    EXPECT_TRUE(b.pack(uint8_t(7)));
+    std::vector<int16_t> out;
+    EXPECT_TRUE(b.unpack(out));
+    EXPECT_EQ(ref, out);
+    EXPECT_EQ(std::size_t(1), b.unpacking_remaining());
+}
+
+TEST(ByteVectorBasicTest, UnpackArrayTooShort) {
+    ByteVector b;
+    EXPECT_TRUE(b.pack(uint16_t(1)));
+    EXPECT_TRUE(b.pack(uint8_t(2)));
+    std::array<uint16_t, 2> out = {0, 0};
+    EXPECT_FALSE(b.unpack(out));
+    // nothing is consumed on failure
+    EXPECT_EQ(std::size_t(0), b.unpacking_offset());
+    std::vector<uint16_t> vec;
+    EXPECT_FALSE(b.unpack(vec, 2));
+    EXPECT_TRUE(b.unpack(vec, 1));
+    EXPECT_EQ(std::vector<uint16_t>({1}), vec);
+}
+
+TEST(ByteVectorBasicTest, UnpackString) {
+    ByteVector b;
+    EXPECT_TRUE(b.pack(std::string("abc")));
+    std::string s;
+    EXPECT_TRUE(b.unpack(s, 3));
+    EXPECT_EQ("abc", s);
+    EXPECT_TRUE(b.unpack(s));
+    EXPECT_EQ(std::string(1, '\0'), s);
+}
+
+TEST(ByteVectorBasicTest, UnpackByteVector) {
+    ByteVector b;
+    EXPECT_TRUE(b.pack(uint8_t(1)));
+    EXPECT_TRUE(b.pack(uint8_t(2)));
+    EXPECT_TRUE(b.pack(uint8_t(3)));
+    EXPECT_TRUE(b.consume(1));
+    ByteVector out;
+    EXPECT_TRUE(b.unpack(out, 2));
+    ASSERT_EQ(std::size_t(2), out.size());
+    EXPECT_EQ(uint8_t(2), out[0]);
+    EXPECT_EQ(uint8_t(3), out[1]);
+    EXPECT_FALSE(b.unpack(out, 1));
+}
+
+TEST(ByteVectorBasicTest, InlineStorage) {
+    ByteVector b;
+    EXPECT_TRUE(b.is_inline());
+    EXPECT_EQ(ByteVector::inline_capacity, b.capacity());
+    for(size_t i = 0; i < ByteVector::inline_capacity; ++i) {
+        EXPECT_TRUE(b.pack(uint8_t(i)));
+    }
+    EXPECT_TRUE(b.is_inline());
+    // spill to the heap
+    EXPECT_TRUE(b.pack(uint8_t(0xFF)));
+    EXPECT_FALSE(b.is_inline());
+    EXPECT_EQ(ByteVector::inline_capacity + 1, b.size());
+    for(size_t i = 0; i < ByteVector::inline_capacity; ++i) {
+        EXPECT_EQ(uint8_t(i), b[i]);
+    }
+    EXPECT_EQ(uint8_t(0xFF), b.back());
+}
+
+TEST(ByteVectorBasicTest, CopyMove) {
+    const ByteVector small = {1, 2, 3};
+    const ByteVector large(2 * ByteVector::inline_capacity, 7);
+
+    ByteVector c1(small);
+    ByteVector c2(large);
+    EXPECT_EQ(small, c1);
+    EXPECT_EQ(large, c2);
+    EXPECT_TRUE(c1.is_inline());
+    EXPECT_FALSE(c2.is_inline());
+
+    // copy the unpacking position along with the data
+    EXPECT_TRUE(c1.consume(1));
+    ByteVector c3(c1);
+    EXPECT_EQ(std::size_t(1), c3.unpacking_offset());
+
+    ByteVector m1(std::move(c1));
+    ByteVector m2(std::move(c2));
+    EXPECT_EQ(small, m1);
+    EXPECT_EQ(large, m2);
+    EXPECT_TRUE(c1.empty());
+    EXPECT_TRUE(c2.empty());
+
+    m1 = std::move(m2);
+    EXPECT_EQ(large, m1);
+    m2 = small;
+    EXPECT_EQ(small, m2);
+    m1.swap(m2);
+    EXPECT_EQ(small, m1);
+    EXPECT_EQ(large, m2);
+}
+
+TEST(ByteVectorBasicTest, InsertErase) {
+    ByteVector b = {1, 5};
+    const uint8_t mid[] = {2, 3, 4};
+    b.insert(b.begin() + 1, mid, mid + 3);
+    EXPECT_EQ(ByteVector({1, 2, 3, 4, 5}), b);
+    // insert a range of the vector into itself
+    b.insert(b.end(), b.begin(), b.begin() + 2);
+    EXPECT_EQ(ByteVector({1, 2, 3, 4, 5, 1, 2}), b);
+    b.erase(b.begin() + 1, b.begin() + 5);
+    EXPECT_EQ(ByteVector({1, 1, 2}), b);
+    b.assign(b.begin() + 1, b.end());
+    EXPECT_EQ(ByteVector({1, 2}), b);
+    EXPECT_THROW(b.at(2), std::out_of_range);
+}
+
 }  // namespace msp
 
 int main(int argc, char **argv) {
@@ -0,0 +1,152 @@
+#include "ByteView.hpp"
+#include <string>
+#include <vector>
+#include "ByteVector.hpp"
+#include "gtest/gtest.h"
+
+namespace msp {
+
+TEST(ByteViewTest, Initialization) {
+    ByteView v;
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(std::size_t(0), v.size());
+    EXPECT_EQ(std::size_t(0), v.unpacking_remaining());
+
+    const std::vector<uint8_t> b = {1, 2, 3};
+    const ByteView w(b);
+    EXPECT_EQ(b.data(), w.data());
+    EXPECT_EQ(std::size_t(3), w.size());
+    EXPECT_EQ(std::size_t(3), w.unpacking_remaining());
+}
+
+TEST(ByteViewTest, UnpackIntegral) {
+    const std::vector<uint8_t> b = {0x01, 0xFF, 0xFF, 0x78, 0x56, 0x34, 0x12, 0x80};
+    const ByteView v(b);
+    uint8_t u8;
+    int16_t i16;
+    uint32_t u32;
+    EXPECT_TRUE(v.unpack(u8));
+    EXPECT_EQ(uint8_t(1), u8);
+    EXPECT_TRUE(v.unpack(i16));
+    EXPECT_EQ(int16_t(-1), i16);
+    EXPECT_TRUE(v.unpack(u32));
+    EXPECT_EQ(uint32_t(0x12345678), u32);
+    EXPECT_EQ(std::size_t(7), v.unpacking_offset());
+    // not enough bytes left
+    EXPECT_FALSE(v.unpack(u32));
+    EXPECT_EQ(std::size_t(1), v.unpacking_remaining());
+}
+
+TEST(ByteViewTest, IndependentCursors) {
+    const std::vector<uint8_t> b = {0x34, 0x12};
+    const ByteView v1(b);
+    const ByteView v2(b);
+    uint16_t x1 = 0, x2 = 0;
+    EXPECT_TRUE(v1.unpack(x1));
+    EXPECT_FALSE(v1.unpack(x1));
+    EXPECT_TRUE(v2.unpack(x2));
+    EXPECT_EQ(x1, x2);
+}
+
+TEST(ByteViewTest, UnpackFloat) {
+    ByteVector b;
+    EXPECT_TRUE(b.pack(1.5f));
+    EXPECT_TRUE(b.pack(-2.25));
+    const ByteView v(b);
+    float f;
+    double d;
+    EXPECT_TRUE(v.unpack(f));
+    EXPECT_TRUE(v.unpack(d));
+    EXPECT_EQ(1.5f, f);
+    EXPECT_EQ(-2.25, d);
+}
+
+TEST(ByteViewTest, UnpackScaled) {
+    ByteVector b;
+    EXPECT_TRUE(b.pack<uint16_t>(12.5, 10.0));
+    const ByteView v(b);
+    double d;
+    EXPECT_TRUE(v.unpack<uint16_t>(d, 10.0));
+    EXPECT_DOUBLE_EQ(12.5, d);
+}
+
+TEST(ByteViewTest, UnpackString) {
+    const std::vector<uint8_t> b = {'a', 'b', 'c', 'd'};
+    const ByteView v(b);
+    std::string s;
+    EXPECT_TRUE(v.unpack(s, 2));
+    EXPECT_EQ("ab", s);
+    EXPECT_FALSE(v.unpack(s, 3));
+    EXPECT_TRUE(v.unpack(s));
+    EXPECT_EQ("cd", s);
+}
+
+TEST(ByteViewTest, UnpackSubview) {
+    const std::vector<uint8_t> b = {1, 2, 3, 4, 5};
+    const ByteView v(b);
+    ByteView sub;
+    EXPECT_TRUE(v.consume(1));
+    EXPECT_TRUE(v.unpack(sub, 3));
+    EXPECT_EQ(b.data() + 1, sub.data());
+    EXPECT_EQ(std::size_t(3), sub.size());
+    EXPECT_EQ(uint8_t(4), sub[2]);
+    EXPECT_EQ(std::size_t(1), v.unpacking_remaining());
+    EXPECT_FALSE(v.consume(2));
+
+    const ByteView tail = v.subview(3);
+    EXPECT_EQ(std::size_t(2), tail.size());
+    EXPECT_TRUE(v.subview(10).empty());
+}
+
+TEST(ByteViewTest, UnpackValue) {
+    ByteVector b;
+    EXPECT_TRUE(b.pack(uint16_t(42)));
+    // strings are packed with a terminating null byte
+    EXPECT_TRUE(b.pack(std::string("xyz")));
+    const ByteView v(b);
+    Value<uint16_t> u;
+    Value<ByteVector> bytes;
+    EXPECT_TRUE(v.unpack(u));
+    EXPECT_TRUE(u.set());
+    EXPECT_EQ(uint16_t(42), u());
+    EXPECT_TRUE(v.unpack(bytes));
+    EXPECT_TRUE(bytes.set());
+    EXPECT_EQ(std::vector<uint8_t>({'x', 'y', 'z', 0}), bytes());
+    // failed unpacking leaves the Value unset
+    EXPECT_FALSE(v.unpack(u));
+    EXPECT_FALSE(u.set());
+}
+
+struct Pair : public Packable {
+    uint8_t a = 0;
+    uint16_t b = 0;
+    bool pack_into(ByteVector& data) const override {
+        return data.pack(a) && data.pack(b);
+    }
+    bool unpack_from(const ByteView& data) override {
+        return data.unpack(a) && data.unpack(b);
+    }
+};
+
+TEST(ByteViewTest, UnpackPackable) {
+    const std::vector<uint8_t> raw = {1, 2, 0, 3, 4, 0};
+    const ByteVector b(raw.begin(), raw.end());
+    Pair p;
+    // unpacking from a ByteVector advances its cursor past the object
+    EXPECT_TRUE(b.unpack(p));
+    EXPECT_EQ(uint8_t(1), p.a);
+    EXPECT_EQ(uint16_t(2), p.b);
+    EXPECT_EQ(std::size_t(3), b.unpacking_offset());
+    const ByteView v(b);
+    EXPECT_TRUE(v.consume(3));
+    EXPECT_TRUE(v.unpack(p));
+    EXPECT_EQ(uint8_t(3), p.a);
+    EXPECT_EQ(uint16_t(4), p.b);
+}
+
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
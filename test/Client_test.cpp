@@ -0,0 +1,678 @@
+#include "Client.hpp"
+#include <unistd.h>
+#include <future>
+#include <ostream>
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+// exposes the framing of the client without opening a serial port
+class FramingClient : public Client {
+public:
+    using Client::packMessage;
+    using Client::packMessageV1;
+    using Client::packMessageV2;
+    using Client::packMessageV2OverV1;
+    using Client::FrameLocation;
+
+    FrameLocation find(const ByteVector& data) const {
+        return findFrame(data.data(), data.size());
+    }
+
+    std::pair<std::size_t, bool> ready(const ByteVector& frame) {
+        feed(frame);
+        const auto bufs     = buffer.data();
+        const iterator b    = iterator::begin(bufs);
+        const auto res      = messageReady(b, iterator::end(bufs));
+        const std::size_t n = std::size_t(std::distance(b, res.first));
+        buffer.consume(buffer.size());
+        return std::make_pair(n, res.second);
+    }
+
+    ReceivedMessage receive(const ByteVector& frame) {
+        feed(frame);
+        ReceivedMessage msg;
+        const uint8_t marker = extractChar();
+        const uint8_t ver    = extractChar();
+        if(marker == '$' && ver == 'X')
+            processOneMessageV2(msg);
+        else
+            processOneMessageV1(msg);
+        buffer.consume(buffer.size());
+        return msg;
+    }
+
+private:
+    void feed(const ByteVector& frame) {
+        std::ostream os(&buffer);
+        os.write(reinterpret_cast<const char*>(frame.data()),
+                 std::streamsize(frame.size()));
+    }
+};
+
+static ByteVector payload(const std::size_t size) {
+    ByteVector data;
+    for(std::size_t i = 0; i < size; ++i) data.push_back(uint8_t(i * 7));
+    return data;
+}
+
+// turns an outgoing frame into an incoming frame
+static ByteVector response(ByteVector frame) {
+    frame[2] = '>';
+    return frame;
+}
+
+static const uint16_t ATTITUDE = uint16_t(msp::ID::MSP_ATTITUDE);
+
+TEST(ClientFraming, LegacyIdUsesV1) {
+    FramingClient client;
+    client.setVersion(2);
+    const ByteVector data = {1, 2, 3};
+    const ByteVector msg  = client.packMessage(msp::ID(102), data);
+    EXPECT_EQ(ByteVector({'$', 'M', '<', 3, 102, 1, 2, 3, 3 ^ 102 ^ 1 ^ 2 ^ 3}),
+              msg);
+}
+
+TEST(ClientFraming, V2IdSelection) {
+    FramingClient client;
+    const ByteVector data = {4, 5};
+    const msp::ID id      = msp::ID(0x1F03);
+
+    client.setVersion(2);
+    EXPECT_EQ(client.packMessageV2(id, data), client.packMessage(id, data));
+
+    client.setVersion(1);
+    const ByteVector tunnel = client.packMessage(id, data);
+    EXPECT_EQ(client.packMessageV2OverV1(id, data), tunnel);
+    ASSERT_EQ(std::size_t(6 + 5 + 2 + 1), tunnel.size());
+    EXPECT_EQ('M', tunnel[1]);
+    EXPECT_EQ(uint8_t(5 + 2 + 1), tunnel[3]);
+    EXPECT_EQ(uint8_t(255), tunnel[4]);
+    // the inner frame equals a native MSPv2 frame without preamble
+    const ByteVector native = client.packMessageV2(id, data);
+    EXPECT_TRUE(
+        std::equal(native.begin() + 3, native.end(), tunnel.begin() + 5));
+}
+
+TEST(ClientFraming, JumboV1) {
+    FramingClient client;
+    const ByteVector data = payload(300);
+    const ByteVector msg  = client.packMessage(msp::ID(89), data);
+    ASSERT_EQ(std::size_t(8 + 300), msg.size());
+    EXPECT_EQ(uint8_t(255), msg[3]);
+    EXPECT_EQ(uint8_t(89), msg[4]);
+    EXPECT_EQ(uint8_t(300 & 0xFF), msg[5]);
+    EXPECT_EQ(uint8_t(300 >> 8), msg[6]);
+
+    EXPECT_EQ(std::make_pair(msg.size(), true), client.ready(msg));
+    const ReceivedMessage recv = client.receive(response(msg));
+    EXPECT_EQ(OK, recv.status);
+    EXPECT_EQ(msp::ID(89), recv.id);
+    EXPECT_EQ(data, recv.payload);
+}
+
+TEST(ClientFraming, IncompleteFrames) {
+    FramingClient client;
+    ByteVector msg = client.packMessageV1(msp::ID(89), payload(300));
+    msg.pop_back();
+    EXPECT_FALSE(client.ready(msg).second);
+
+    msg = client.packMessageV2(msp::ID(0x1F03), payload(300));
+    EXPECT_EQ(std::make_pair(msg.size(), true), client.ready(msg));
+    msg.pop_back();
+    EXPECT_FALSE(client.ready(msg).second);
+}
+
+TEST(ClientFraming, UnwrapV2Frame) {
+    FramingClient client;
+    for(const std::size_t size : {std::size_t(3), std::size_t(400)}) {
+        const ByteVector data = payload(size);
+        const ByteVector msg =
+            client.packMessageV2OverV1(msp::ID(0x3002), data);
+        EXPECT_EQ(std::make_pair(msg.size(), true), client.ready(msg));
+        const ReceivedMessage recv = client.receive(response(msg));
+        EXPECT_EQ(OK, recv.status);
+        EXPECT_EQ(msp::ID(0x3002), recv.id);
+        EXPECT_EQ(data, recv.payload);
+    }
+}
+
+TEST(ClientFraming, CorruptV2Frame) {
+    FramingClient client;
+    ByteVector msg = client.packMessageV2OverV1(msp::ID(0x3002), payload(4));
+    // corrupt the inner CRC and fix the outer one
+    msg[msg.size() - 2] ^= 0x10;
+    msg[msg.size() - 1] ^= 0x10;
+    const ReceivedMessage recv = client.receive(response(msg));
+    EXPECT_EQ(FAIL_CRC, recv.status);
+}
+
+static ByteVector concat(const std::vector<ByteVector>& parts) {
+    ByteVector data;
+    for(const ByteVector& p : parts)
+        data.insert(data.end(), p.begin(), p.end());
+    return data;
+}
+
+TEST(ClientResync, SkipGarbage) {
+    FramingClient client;
+    const ByteVector frame =
+        response(client.packMessageV1(msp::ID(108), payload(6)));
+    const ByteVector garbage = {'x', '$', 'Q', '$', 'M', '?', 0};
+    const ByteVector data    = concat({garbage, frame});
+    EXPECT_EQ(std::make_pair(data.size(), true), client.ready(data));
+    const FramingClient::FrameLocation loc = client.find(data);
+    EXPECT_TRUE(loc.complete);
+    EXPECT_EQ(garbage.size(), loc.skip);
+    EXPECT_EQ(frame.size(), loc.size);
+
+    // data without a plausible header is discarded completely
+    EXPECT_FALSE(client.find(garbage).complete);
+    EXPECT_EQ(garbage.size(), client.find(garbage).skip);
+    // an incomplete header is kept
+    EXPECT_EQ(std::size_t(1), client.find({'a', '$'}).skip);
+    EXPECT_EQ(std::size_t(1), client.find({'a', '$', 'X', '>', 0}).skip);
+}
+
+TEST(ClientResync, CorruptSize) {
+    FramingClient client;
+    const ByteVector frame1 =
+        response(client.packMessageV1(msp::ID(108), payload(6)));
+    const ByteVector frame2 =
+        response(client.packMessageV2(msp::ID(0x1F03), payload(10)));
+    // the size byte of the first frame is damaged and claims 200 bytes
+    ByteVector broken = frame1;
+    broken[3]         = 200;
+    const ByteVector data = concat({broken, frame1, frame2});
+    const FramingClient::FrameLocation loc = client.find(data);
+    ASSERT_TRUE(loc.complete);
+    EXPECT_EQ(broken.size(), loc.skip);
+    EXPECT_EQ(frame1.size(), loc.size);
+
+    // a damaged size which still fits into the data fails the checksum
+    broken[3] = uint8_t(frame1.size());
+    const ByteVector data2 = concat({broken, frame1, frame2});
+    EXPECT_EQ(broken.size(), client.find(data2).skip);
+}
+
+TEST(ClientResync, CorruptPayload) {
+    FramingClient client;
+    ByteVector frame =
+        response(client.packMessageV1(msp::ID(108), payload(6)));
+    frame[6] ^= 0x01;
+    // the corrupt frame is passed on to be counted
+    const FramingClient::FrameLocation loc = client.find(frame);
+    EXPECT_TRUE(loc.complete);
+    EXPECT_EQ(std::size_t(0), loc.skip);
+    EXPECT_EQ(FAIL_CRC, client.receive(frame).status);
+}
+
+TEST(ClientResync, PayloadLimit) {
+    FramingClient client;
+    const ByteVector jumbo =
+        response(client.packMessageV1(msp::ID(89), payload(300)));
+    EXPECT_TRUE(client.find(jumbo).complete);
+    client.setMaxPayloadSize(100);
+    EXPECT_FALSE(client.find(jumbo).complete);
+    client.setMaxPayloadSize(msp::ID(89), 300);
+    EXPECT_TRUE(client.find(jumbo).complete);
+}
+
+TEST(ClientResync, NoisyLink) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    // a glitch which looks like the header of a long frame
+    fc.sendRaw({'$', 'M', '>', 200});
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(int16_t(30), attitude.yaw());
+    const FramingStats stats = client.getFramingStats();
+    EXPECT_EQ(uint64_t(1), stats.resyncs);
+    EXPECT_EQ(uint64_t(4), stats.bytes_discarded);
+    EXPECT_EQ(uint64_t(1), stats.frames);
+    EXPECT_EQ(uint64_t(0), stats.crc_errors);
+    client.stop();
+}
+
+TEST(ClientResync, CorruptResponseIsResent) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    RetryPolicy policy;
+    policy.max_retries = 2;
+    policy.max_timeout = 0.2;
+    client.setRetryPolicy(policy);
+
+    // the response is damaged by a bit flip
+    fc.dropNext(ATTITUDE, 1);
+    std::future<bool> request = std::async(std::launch::async, [&client] {
+        msg::Attitude attitude(FirmwareVariant::BTFL);
+        return client.sendMessage(attitude, 2.0) && attitude.yaw() == 30;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::vector<uint8_t> corrupt = test::FakeFlightController::frameV1(
+        uint8_t(ATTITUDE), {10, 0, 20, 0, 30, 0});
+    corrupt[6] ^= 0x01;
+    fc.sendRaw(corrupt);
+
+    // the corrupt frame does not fail the request, which is resent
+    EXPECT_TRUE(request.get());
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+    const FramingStats stats = client.getFramingStats();
+    EXPECT_EQ(uint64_t(1), stats.crc_errors);
+    EXPECT_EQ(uint64_t(1), stats.frames);
+    client.stop();
+}
+
+TEST(ClientSubscriptions, SharedSubscription) {
+    Client client;
+    int calls = 0;
+    const std::function<void(const msg::Attitude &)> callback =
+        [&calls](const msg::Attitude &) { ++calls; };
+    const auto sub       = client.subscribe(callback, 0);
+    const ListenerId id2 = client.addListener(callback, 0);
+    EXPECT_EQ(sub, client.getSubscription(msp::ID::MSP_ATTITUDE));
+    EXPECT_EQ(std::size_t(2), sub->listenerCount());
+
+    const ByteVector data = {0, 0, 0, 0, 0, 0};
+    sub->decode(ByteView(data));
+    EXPECT_EQ(2, calls);
+
+    EXPECT_TRUE(client.removeListener(msp::ID::MSP_ATTITUDE, id2));
+    EXPECT_EQ(std::size_t(1), sub->listenerCount());
+    EXPECT_TRUE(client.unsubscribe(msp::ID::MSP_ATTITUDE));
+    EXPECT_FALSE(client.hasSubscription(msp::ID::MSP_ATTITUDE));
+}
+
+TEST(ClientRequests, ConcurrentRequestsShareOneFrame) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setDelay(50);
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    client.markRead(msp::ID::MSP_ATTITUDE);
+
+    std::vector<std::future<bool>> results;
+    for(int i = 0; i < 4; ++i) {
+        results.push_back(std::async(std::launch::async, [&client] {
+            msg::Attitude attitude(FirmwareVariant::BTFL);
+            return client.sendMessage(attitude, 1.0) && attitude.yaw() == 30;
+        }));
+    }
+    for(auto& result : results) EXPECT_TRUE(result.get());
+    EXPECT_EQ(1, fc.requests(ATTITUDE));
+
+    // a later request goes over the wire again
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+TEST(ClientRequests, SharedWaiterTimesOut) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setDelay(150);
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    client.markRead(msp::ID::MSP_ATTITUDE);
+
+    std::future<bool> patient = std::async(std::launch::async, [&client] {
+        msg::Attitude attitude(FirmwareVariant::BTFL);
+        return client.sendMessage(attitude, 2.0) && attitude.yaw() == 30;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // the shorter timeout expires first, the other waiter keeps the request
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_FALSE(client.sendMessage(attitude, 0.05));
+    EXPECT_TRUE(patient.get());
+    EXPECT_EQ(1, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+// request of the attitude with a payload, which cannot share a request
+struct AttitudeWrite : public msg::Attitude {
+    using msg::Attitude::Attitude;
+
+    virtual ByteVectorUptr encode() const override {
+        return std::make_unique<ByteVector>(ByteVector{1});
+    }
+};
+
+TEST(ClientRequests, WriteWaitsForPendingRead) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setDelay(100);
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    client.markRead(msp::ID::MSP_ATTITUDE);
+
+    std::future<bool> read = std::async(std::launch::async, [&client] {
+        msg::Attitude attitude(FirmwareVariant::BTFL);
+        return client.sendMessage(attitude, 2.0) && attitude.yaw() == 30;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // the write does not replace the read, both are answered
+    AttitudeWrite write(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(write, 2.0));
+    EXPECT_TRUE(read.get());
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+TEST(ClientRequests, CrossedBatchesDoNotWaitForEachOther) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setDelay(50);
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+
+    const auto batch = [&client](const bool rc_first) {
+        msg::SetRawRc rc(FirmwareVariant::BTFL);
+        rc.channels = {1500, 1500, 1500, 1000};
+        AttitudeWrite write(FirmwareVariant::BTFL);
+        if(rc_first) return client.sendMessages({&rc, &write});
+        return client.sendMessages({&write, &rc});
+    };
+    // a pending write keeps one ID busy while both batches are registered,
+    // the batches must not wait for the other one without a timeout
+    for(int round = 0; round < 10; ++round) {
+        std::future<bool> busy = std::async(std::launch::async, [&client] {
+            msg::SetRawRc rc(FirmwareVariant::BTFL);
+            rc.channels = {1500, 1500, 1500, 1000};
+            return client.sendMessage(rc, 1.0);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::future<std::vector<bool>> first =
+            std::async(std::launch::async, batch, true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::future<std::vector<bool>> second =
+            std::async(std::launch::async, batch, false);
+
+        const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        ASSERT_EQ(std::future_status::ready, first.wait_until(deadline));
+        ASSERT_EQ(std::future_status::ready, second.wait_until(deadline));
+        EXPECT_TRUE(busy.get());
+    }
+    client.stop();
+}
+
+TEST(ClientRequests, ResponseCache) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    client.setCacheTtl(msp::ID::MSP_ATTITUDE, 10);
+
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    const std::vector<bool> batch = client.sendMessages({&attitude}, 1.0);
+    EXPECT_TRUE(batch[0]);
+    EXPECT_EQ(int16_t(30), attitude.yaw());
+    EXPECT_EQ(1, fc.requests(ATTITUDE));
+
+    // messages with payload invalidate the cache
+    msg::SetRawRc rc(FirmwareVariant::BTFL);
+    rc.channels = {1500, 1500, 1500, 1000};
+    EXPECT_TRUE(client.sendMessage(rc, 1.0));
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+
+    client.setCacheTtl(msp::ID::MSP_ATTITUDE, 0);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(3, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+TEST(ClientRequests, WriteWithoutPayloadIsNotShared) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setResponse(uint16_t(msp::ID::MSP_EEPROM_WRITE), {});
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    client.setCacheTtl(msp::ID::MSP_ATTITUDE, 10);
+    EXPECT_TRUE(client.isRead(msp::ID::MSP_ATTITUDE));
+    EXPECT_FALSE(client.isRead(msp::ID::MSP_EEPROM_WRITE));
+
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(1, fc.requests(ATTITUDE));
+
+    // every caller writes the settings on its own
+    fc.setDelay(50);
+    std::vector<std::future<bool>> results;
+    for(int i = 0; i < 2; ++i) {
+        results.push_back(std::async(std::launch::async, [&client] {
+            msg::WriteEEPROM write(FirmwareVariant::BTFL);
+            return client.sendMessage(write, 1.0);
+        }));
+    }
+    for(auto& result : results) EXPECT_TRUE(result.get());
+    EXPECT_EQ(2, fc.requests(uint16_t(msp::ID::MSP_EEPROM_WRITE)));
+
+    // and the write invalidates the cache
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+
+    // a write is never answered from the cache
+    client.markRead(msp::ID::MSP_ATTITUDE, false);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(3, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+TEST(ClientRequests, ResponseCacheIgnoresReadsBeforeWrite) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setDelay(100);
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    client.setCacheTtl(msp::ID::MSP_ATTITUDE, 10);
+
+    // the read is on the wire before the write and answered after it was sent
+    std::future<bool> read = std::async(std::launch::async, [&client] {
+        msg::Attitude attitude(FirmwareVariant::BTFL);
+        return client.sendMessage(attitude, 2.0);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    msg::SetRawRc rc(FirmwareVariant::BTFL);
+    rc.channels = {1500, 1500, 1500, 1000};
+    EXPECT_TRUE(client.sendMessage(rc, 2.0));
+    EXPECT_TRUE(read.get());
+
+    // the response from before the write was not cached
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(attitude, 2.0));
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+    EXPECT_TRUE(client.sendMessage(attitude, 2.0));
+    EXPECT_EQ(2, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+TEST(ClientRequests, AdaptiveRetransmission) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    RetryPolicy policy;
+    policy.adaptive    = true;
+    policy.max_retries = 2;
+    policy.min_timeout = 0.02;
+    policy.max_timeout = 2.0;
+    client.setRetryPolicy(policy);
+    // without measurements the first attempt waits the longest
+    EXPECT_DOUBLE_EQ(2.0, client.getRequestTimeout(msp::ID::MSP_ATTITUDE));
+
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    for(int i = 0; i < 10; ++i) ASSERT_TRUE(client.sendMessage(attitude));
+    EXPECT_EQ(std::size_t(10), client.getRttEstimate().samples());
+    EXPECT_GT(client.getRttEstimate().srtt(), 0);
+    EXPECT_LT(client.getRequestTimeout(msp::ID::MSP_ATTITUDE), 1.0);
+
+    // a lost request is resent after roughly one round trip
+    fc.dropNext(ATTITUDE, 1);
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(client.sendMessage(attitude));
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    EXPECT_LT(elapsed, 1.0);
+    EXPECT_EQ(12, fc.requests(ATTITUDE));
+    // the retransmitted request is not measured
+    EXPECT_EQ(std::size_t(10), client.getRttEstimate().samples());
+
+    // batched requests are resent as well
+    fc.dropNext(ATTITUDE, 1);
+    EXPECT_TRUE(client.sendMessages({&attitude})[0]);
+    EXPECT_EQ(14, fc.requests(ATTITUDE));
+
+    // give up when all retries are lost
+    fc.dropNext(ATTITUDE, 3);
+    EXPECT_FALSE(client.sendMessage(attitude));
+    EXPECT_EQ(17, fc.requests(ATTITUDE));
+    client.stop();
+}
+
+TEST(ClientRequests, PollsAreNotMeasured) {
+    test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    fc.setDelay(100);
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+    RetryPolicy policy;
+    policy.adaptive    = true;
+    policy.max_timeout = 0.3;
+    client.setRetryPolicy(policy);
+
+    // the response to the poll answers the request, which was sent later
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    ASSERT_TRUE(client.sendMessageNoWait(attitude));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(std::size_t(0), client.getRttEstimate().samples());
+
+    // without a poll on the wire the request is measured again
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+    EXPECT_EQ(std::size_t(1), client.getRttEstimate().samples());
+    EXPECT_GT(client.getRttEstimate().srtt(), 0.09);
+    client.stop();
+}
+
+TEST(ClientConnection, ProbeBaudrate) {
+    test::FakeFlightController fc;
+    fc.setResponse(uint16_t(msp::ID::MSP_API_VERSION), {0, 1, 42});
+    fc.setBaudrate(B230400);
+    Client client;
+    BaudrateProbe probe;
+    probe.rates = {115200, 230400, 460800, 921600};
+    EXPECT_EQ(size_t(230400), client.probeBaudrate(fc.path(), probe));
+    EXPECT_EQ(size_t(230400), client.getBaudrate());
+    EXPECT_TRUE(client.isConnected());
+    // both pings failed at every faster rate
+    EXPECT_EQ(2 * 2 + 1 + int(probe.burst),
+              fc.requests(uint16_t(msp::ID::MSP_API_VERSION)));
+
+    // no rate matches
+    fc.setBaudrate(B9600);
+    probe.rates = {115200};
+    probe.burst = 2;
+    EXPECT_EQ(size_t(0), client.probeBaudrate(fc.path(), probe));
+    EXPECT_FALSE(client.isConnected());
+}
+
+TEST(ClientConnection, SerialTuning) {
+    test::FakeFlightController fc;
+    fc.setResponse(uint16_t(msp::ID::MSP_API_VERSION), {0, 1, 42});
+    Client client;
+    SerialTuning tuning;
+    tuning.vmin = 0;
+    client.setSerialTuning(tuning);
+    // not supported by asio
+    ASSERT_TRUE(client.start(fc.path(), 1500000));
+    const SerialStatus status = client.getSerialStatus();
+    EXPECT_EQ(1500000, status.baudrate);
+    EXPECT_EQ(1, status.vmin);
+    EXPECT_EQ(0, status.vtime);
+
+    msp::msg::ApiVersion api(FirmwareVariant::BTFL);
+    EXPECT_TRUE(client.sendMessage(api, 1.0));
+    EXPECT_EQ(42, api.minor());
+
+    EXPECT_TRUE(client.setBaudrate(2000000));
+    EXPECT_EQ(2000000, client.getSerialStatus().baudrate);
+    EXPECT_TRUE(client.stop());
+}
+
+using test::eventually;
+
+TEST(ClientConnection, Reconnect) {
+    // the device node is a symlink, which is replaced like a udev alias
+    char dir[] = "/tmp/msp_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    const std::string device = std::string(dir) + "/ttyFC";
+
+    std::unique_ptr<test::FakeFlightController> fc(
+        new test::FakeFlightController());
+    fc->setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    ASSERT_EQ(0, symlink(fc->path().c_str(), device.c_str()));
+
+    Client client;
+    client.setAutoReconnect(true, 0.01);
+    std::atomic<int> handshakes(0);
+    client.setReconnectCallback([&client, &handshakes] {
+        msg::Attitude attitude(FirmwareVariant::BTFL);
+        if(!client.sendMessage(attitude, 1.0)) return false;
+        handshakes++;
+        return true;
+    });
+    ASSERT_TRUE(client.start(device));
+    std::atomic<int> yaws(0);
+    client.subscribe<msg::Attitude>(
+        [&yaws](const msg::Attitude&) { yaws++; }, 0.01);
+    EXPECT_TRUE(eventually([&yaws] { return yaws > 0; }));
+
+    // unplug
+    fc.reset();
+    ASSERT_EQ(0, unlink(device.c_str()));
+    EXPECT_TRUE(eventually(
+        [&client] { return client.getConnectionStats().link_losses == 1; }));
+    EXPECT_FALSE(client.isConnected());
+    msg::Attitude attitude(FirmwareVariant::BTFL);
+    EXPECT_FALSE(client.sendMessage(attitude));
+
+    // plug in again
+    fc.reset(new test::FakeFlightController());
+    fc->setResponse(ATTITUDE, {10, 0, 20, 0, 30, 0});
+    ASSERT_EQ(0, symlink(fc->path().c_str(), device.c_str()));
+    EXPECT_TRUE(eventually(
+        [&client] { return client.getConnectionStats().reconnects == 1; }));
+    EXPECT_EQ(1, handshakes);
+    EXPECT_TRUE(client.isConnected());
+    EXPECT_GT(client.getConnectionStats().last_latency, 0);
+    EXPECT_TRUE(client.sendMessage(attitude, 1.0));
+
+    // the subscription is resumed
+    const int before = yaws;
+    EXPECT_TRUE(eventually([&yaws, before] { return yaws > before; }));
+
+    client.stop();
+    unlink(device.c_str());
+    rmdir(dir);
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
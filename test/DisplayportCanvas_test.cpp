@@ -0,0 +1,237 @@
+#include "DisplayportCanvas.hpp"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+static const uint16_t DISPLAYPORT = uint16_t(msp::ID::MSP_DISPLAYPORT);
+
+/**
+ * @brief Screen of a DisplayPort receiver
+ */
+class Screen {
+public:
+    Screen(msp::test::FakeFlightController& fc, const std::size_t rows,
+           const std::size_t cols) :
+        rows_(rows),
+        cols_(cols),
+        chars_(rows * cols, 0),
+        attrs_(rows * cols, 0),
+        shown_(chars_),
+        draws_(0),
+        writes_(0),
+        clears_(0) {
+        fc.setHandler(DISPLAYPORT, [this](const std::vector<uint8_t>& p) {
+            command(p);
+            return std::vector<uint8_t>();
+        });
+    }
+
+    // waits for the draw command of a commit
+    bool waitDraws(const int draws) {
+        const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while(std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(draws_ >= draws) return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    std::string row(const std::size_t r) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::string(shown_.begin() + long(r * cols_),
+                           shown_.begin() + long((r + 1) * cols_));
+    }
+
+    uint8_t attribute(const std::size_t r, const std::size_t c) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return attrs_[r * cols_ + c];
+    }
+
+    int writes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writes_;
+    }
+
+    int clears() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return clears_;
+    }
+
+private:
+    void command(const std::vector<uint8_t>& p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(p.empty()) return;
+        switch(DisplayportCommand(p[0])) {
+        case DisplayportCommand::CLEAR_SCREEN:
+            chars_.assign(rows_ * cols_, ' ');
+            attrs_.assign(rows_ * cols_, 0);
+            clears_++;
+            break;
+        case DisplayportCommand::WRITE_STRING: {
+            ASSERT_GE(p.size(), std::size_t(5));
+            const std::size_t i = p[1] * cols_ + p[2];
+            ASSERT_LE(p[2] + p.size() - 4, cols_);
+            for(std::size_t k = 4; k < p.size(); ++k) {
+                chars_[i + k - 4] = p[k];
+                attrs_[i + k - 4] = p[3];
+            }
+            writes_++;
+            break;
+        }
+        case DisplayportCommand::DRAW_SCREEN:
+            shown_ = chars_;
+            draws_++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::mutex mutex_;
+    std::size_t rows_;
+    std::size_t cols_;
+    std::vector<uint8_t> chars_;
+    std::vector<uint8_t> attrs_;
+    std::vector<uint8_t> shown_;
+    int draws_;
+    int writes_;
+    int clears_;
+};
+
+class DisplayportCanvasTest : public msp::test::FakeClientTest {
+protected:
+    DisplayportCanvasTest() : screen(fc, 20, 53) {}
+
+    Screen screen;
+};
+
+TEST_F(DisplayportCanvasTest, FirstCommitClearsTheScreen) {
+    DisplayportCanvas canvas(client);
+    EXPECT_EQ(std::size_t(5), canvas.write(2, 3, "HELLO"));
+    ASSERT_TRUE(canvas.commit());
+    ASSERT_TRUE(screen.waitDraws(1));
+
+    const DisplayportCommitStats& stats = canvas.lastCommit();
+    EXPECT_TRUE(stats.full);
+    EXPECT_EQ(std::size_t(5), stats.cells);
+    EXPECT_EQ(std::size_t(1), stats.writes);
+    // clear, one write of 5 characters and draw
+    EXPECT_EQ(std::size_t(7 + 6 + 4 + 5 + 7), stats.bytes);
+    EXPECT_EQ(1, screen.clears());
+    EXPECT_EQ("   HELLO" + std::string(45, ' '), screen.row(2));
+}
+
+TEST_F(DisplayportCanvasTest, UnchangedCanvasOnlyDraws) {
+    DisplayportCanvas canvas(client);
+    canvas.write(0, 0, "ALT 12M");
+    ASSERT_TRUE(canvas.commit());
+    ASSERT_TRUE(canvas.commit());
+    ASSERT_TRUE(screen.waitDraws(2));
+
+    EXPECT_FALSE(canvas.lastCommit().full);
+    EXPECT_EQ(std::size_t(0), canvas.lastCommit().writes);
+    EXPECT_EQ(std::size_t(7), canvas.lastCommit().bytes);
+    EXPECT_EQ(1, screen.writes());
+}
+
+TEST_F(DisplayportCanvasTest, TrafficScalesWithChanges) {
+    DisplayportCanvas canvas(client);
+    for(uint8_t row = 0; row < canvas.rows(); ++row) {
+        std::string line;
+        for(uint8_t col = 0; col < canvas.cols(); ++col)
+            line.push_back(char('A' + (row + col) % 26));
+        canvas.write(row, 0, line);
+    }
+    ASSERT_TRUE(canvas.commit());
+    const std::size_t full = canvas.lastCommit().bytes;
+    EXPECT_GT(full, std::size_t(20 * 53));
+
+    canvas.write(10, 20, "1");
+    ASSERT_TRUE(canvas.commit());
+    ASSERT_TRUE(screen.waitDraws(2));
+    EXPECT_EQ(std::size_t(1), canvas.lastCommit().cells);
+    EXPECT_EQ(std::size_t(6 + 4 + 1 + 7), canvas.lastCommit().bytes);
+    EXPECT_EQ('1', screen.row(10)[20]);
+    EXPECT_EQ('A' + (10 + 21) % 26, screen.row(10)[21]);
+}
+
+TEST_F(DisplayportCanvasTest, NearbyChangesAreMerged) {
+    DisplayportCanvas canvas(client);
+    ASSERT_TRUE(canvas.commit());
+
+    // the gap of 4 cells is shorter than the overhead of a write
+    canvas.put(5, 0, 'X');
+    canvas.put(5, 5, 'Y');
+    ASSERT_TRUE(canvas.commit());
+    EXPECT_EQ(std::size_t(2), canvas.lastCommit().cells);
+    EXPECT_EQ(std::size_t(1), canvas.lastCommit().writes);
+
+    // a gap of 20 cells is not
+    canvas.put(6, 0, 'X');
+    canvas.put(6, 21, 'Y');
+    ASSERT_TRUE(canvas.commit());
+    EXPECT_EQ(std::size_t(2), canvas.lastCommit().writes);
+
+    ASSERT_TRUE(screen.waitDraws(3));
+    EXPECT_EQ("X    Y" + std::string(47, ' '), screen.row(5));
+    EXPECT_EQ('Y', screen.row(6)[21]);
+}
+
+TEST_F(DisplayportCanvasTest, RunsAreSplit) {
+    DisplayportCanvasOptions options;
+    options.max_run = 30;
+    DisplayportCanvas canvas(client, options);
+    ASSERT_TRUE(canvas.commit());
+
+    // a full row exceeds the longest write
+    const std::string line(53, 'Z');
+    canvas.write(0, 0, line);
+    // a different attribute needs a write of its own
+    canvas.write(1, 0, "AB", 0);
+    canvas.write(1, 2, "CD", 1);
+    ASSERT_TRUE(canvas.commit());
+    EXPECT_EQ(std::size_t(4), canvas.lastCommit().writes);
+
+    ASSERT_TRUE(screen.waitDraws(2));
+    EXPECT_EQ(line, screen.row(0));
+    EXPECT_EQ(0, screen.attribute(1, 1));
+    EXPECT_EQ(1, screen.attribute(1, 2));
+}
+
+TEST_F(DisplayportCanvasTest, InvalidateRedraws) {
+    DisplayportCanvas canvas(client);
+    canvas.write(3, 50, "CLIPPED");
+    EXPECT_EQ('C', canvas.character(3, 50));
+    EXPECT_EQ(' ', canvas.character(3, 53));
+    ASSERT_TRUE(canvas.commit());
+
+    canvas.invalidate();
+    ASSERT_TRUE(canvas.commit());
+    EXPECT_TRUE(canvas.lastCommit().full);
+    EXPECT_EQ(std::size_t(3), canvas.lastCommit().cells);
+
+    canvas.clear();
+    ASSERT_TRUE(canvas.commit());
+    ASSERT_TRUE(screen.waitDraws(3));
+    EXPECT_EQ(2, screen.clears());
+    EXPECT_EQ(std::string(53, ' '), screen.row(3));
+}
+
+}  // namespace fcu
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+#include "Executor.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <vector>
+#include "Subscription.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+TEST(ExecutorTest, InlineExecutor) {
+    InlineExecutor executor;
+    int calls = 0;
+    executor.post([&calls] { ++calls; });
+    EXPECT_EQ(1, calls);
+}
+
+TEST(ExecutorTest, ThreadPoolRunsQueuedTasks) {
+    std::atomic<int> calls(0);
+    {
+        ThreadPool pool(3);
+        EXPECT_EQ(std::size_t(3), pool.size());
+        for(int i = 0; i < 1000; ++i) pool.post([&calls] { ++calls; });
+    }
+    // the destructor waits for all tasks
+    EXPECT_EQ(1000, calls);
+}
+
+TEST(ExecutorTest, StrandKeepsOrder) {
+    const auto pool = std::make_shared<ThreadPool>(4);
+    std::vector<int> order;
+    std::promise<void> done;
+    {
+        Strand strand(pool);
+        for(int i = 0; i < 1000; ++i) {
+            strand.post([&order, i] { order.push_back(i); });
+        }
+        strand.post([&done] { done.set_value(); });
+    }
+    // the queued tasks outlive the strand
+    done.get_future().wait();
+    ASSERT_EQ(std::size_t(1000), order.size());
+    for(int i = 0; i < 1000; ++i) EXPECT_EQ(i, order[std::size_t(i)]);
+}
+
+TEST(ExecutorTest, StrandsRunInParallel) {
+    const auto pool = std::make_shared<ThreadPool>(2);
+    Strand a(pool);
+    Strand b(pool);
+    std::promise<void> b_started;
+    std::promise<bool> a_saw_b;
+    a.post([&] {
+        const auto started = b_started.get_future();
+        a_saw_b.set_value(started.wait_for(std::chrono::seconds(5)) ==
+                          std::future_status::ready);
+    });
+    b.post([&] { b_started.set_value(); });
+    EXPECT_TRUE(a_saw_b.get_future().get());
+}
+
+TEST(ExecutorTest, SubscriptionCallbacksOnPool) {
+    const auto pool = std::make_shared<ThreadPool>(4);
+    Subscription<msg::Attitude> sub(
+        nullptr, std::make_unique<msg::Attitude>(FirmwareVariant::BTFL));
+    const std::thread::id reader = std::this_thread::get_id();
+
+    std::mutex mutex;
+    std::vector<int16_t> yaws;
+    std::atomic<bool> other_thread(true);
+    sub.addListener(
+        [&](const msg::Attitude &a) {
+            if(std::this_thread::get_id() == reader) other_thread = false;
+            std::lock_guard<std::mutex> lock(mutex);
+            yaws.push_back(a.yaw());
+        },
+        0,
+        pool);
+
+    for(int16_t yaw = 0; yaw < 500; ++yaw) {
+        ByteVector data;
+        data.pack(int16_t(0));
+        data.pack(int16_t(0));
+        data.pack(yaw);
+        sub.decode(ByteView(data));
+    }
+    for(int i = 0; i < 5000; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(yaws.size() == 500) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(std::size_t(500), yaws.size());
+    // every callback got its own copy of the message, in order
+    for(int16_t yaw = 0; yaw < 500; ++yaw) {
+        EXPECT_EQ(yaw, yaws[std::size_t(yaw)]);
+    }
+    EXPECT_TRUE(other_thread);
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,274 @@
+#ifndef FAKE_FLIGHT_CONTROLLER_HPP
+#define FAKE_FLIGHT_CONTROLLER_HPP
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Client.hpp"
+#include "gtest/gtest.h"
+
+namespace msp {
+namespace test {
+
+/**
+ * @brief Flight controller simulated on a pseudo terminal. It answers MSPv1
+ * and MSPv2 requests with fixed payloads after a configurable delay.
+ */
+class FakeFlightController {
+public:
+    FakeFlightController() :
+        running_(true),
+        delay_ms_(0),
+        speed_(0),
+        raw_mode_(false),
+        passthrough_id_(0) {
+        int slave = -1;
+        if(openpty(&master_, &slave, nullptr, nullptr, nullptr) != 0) return;
+        termios tio;
+        tcgetattr(slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+        path_ = ttyname(slave);
+        // keep the slave open, so that the master does not see a hangup
+        slave_ = slave;
+        thread_ = std::thread(&FakeFlightController::run, this);
+    }
+
+    ~FakeFlightController() {
+        running_ = false;
+        if(thread_.joinable()) thread_.join();
+        close(master_);
+        close(slave_);
+    }
+
+    const std::string& path() const { return path_; }
+
+    void setResponse(const uint16_t id, const std::vector<uint8_t>& payload) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        responses_[id] = payload;
+    }
+
+    // computes the response from the request payload, replaces setResponse
+    void setHandler(const uint16_t id,
+                    const std::function<std::vector<uint8_t>(
+                        const std::vector<uint8_t>&)>& handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handlers_[id] = handler;
+    }
+
+    // switches to a raw byte pipe after answering the request with the id,
+    // the handler computes the bytes sent back from the bytes received
+    void setPassthrough(const uint16_t id,
+                        const std::function<std::vector<uint8_t>(
+                            const std::vector<uint8_t>&)>& handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        passthrough_id_      = id;
+        passthrough_handler_ = handler;
+    }
+
+    // returns to MSP, may be called by the passthrough handler
+    void leavePassthrough() { raw_mode_ = false; }
+
+    bool inPassthrough() const { return raw_mode_; }
+
+    void setDelay(const int ms) { delay_ms_ = ms; }
+
+    // emulates a UART, requests are only understood at the given speed
+    void setBaudrate(const speed_t speed) { speed_ = speed; }
+
+    void dropNext(const uint16_t id, const int count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drops_[id] = count;
+    }
+
+    void sendRaw(const std::vector<uint8_t>& bytes) {
+        if(write(master_, bytes.data(), bytes.size()) < 0) return;
+    }
+
+    int requests(const uint16_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_[id];
+    }
+
+    // response frames as sent by a flight controller
+    static std::vector<uint8_t> frameV1(const uint8_t id,
+                                        const std::vector<uint8_t>& p) {
+        std::vector<uint8_t> f = {'$', 'M', '>', uint8_t(p.size()), id};
+        uint8_t crc            = uint8_t(p.size()) ^ id;
+        for(const uint8_t b : p) crc ^= b;
+        f.insert(f.end(), p.begin(), p.end());
+        f.push_back(crc);
+        return f;
+    }
+
+    static std::vector<uint8_t> frameV2(const uint16_t id,
+                                        const std::vector<uint8_t>& p) {
+        std::vector<uint8_t> f = {'$',
+                                  'X',
+                                  '>',
+                                  0,
+                                  uint8_t(id & 0xFF),
+                                  uint8_t(id >> 8),
+                                  uint8_t(p.size() & 0xFF),
+                                  uint8_t(p.size() >> 8)};
+        f.insert(f.end(), p.begin(), p.end());
+        uint8_t crc = 0;
+        for(std::size_t i = 3; i < f.size(); ++i) {
+            crc ^= f[i];
+            for(int k = 0; k < 8; ++k)
+                crc = (crc & 0x80) ? uint8_t((crc << 1) ^ 0xD5)
+                                   : uint8_t(crc << 1);
+        }
+        f.push_back(crc);
+        return f;
+    }
+
+private:
+    struct Reply {
+        std::chrono::steady_clock::time_point due;
+        std::vector<uint8_t> frame;
+    };
+
+    void run() {
+        std::vector<uint8_t> buf;
+        std::vector<Reply> replies;
+        while(running_) {
+            pollfd pfd = {master_, POLLIN, 0};
+            if(poll(&pfd, 1, 1) > 0 && (pfd.revents & POLLIN)) {
+                uint8_t tmp[4096];
+                const ssize_t n = read(master_, tmp, sizeof(tmp));
+                if(n > 0) buf.insert(buf.end(), tmp, tmp + n);
+            }
+            parse(buf, replies);
+            const auto now = std::chrono::steady_clock::now();
+            while(!replies.empty() && replies.front().due <= now) {
+                const std::vector<uint8_t>& f = replies.front().frame;
+                if(write(master_, f.data(), f.size()) < 0) break;
+                replies.erase(replies.begin());
+            }
+        }
+    }
+
+    void parse(std::vector<uint8_t>& buf, std::vector<Reply>& replies) {
+        while(!buf.empty()) {
+            if(raw_mode_) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Reply reply;
+                reply.due   = std::chrono::steady_clock::now();
+                reply.frame = passthrough_handler_(buf);
+                buf.clear();
+                if(!reply.frame.empty()) replies.push_back(reply);
+                return;
+            }
+            if(buf.size() < 6) return;
+            std::size_t consumed = 0;
+            std::size_t offset   = 0;
+            uint16_t id          = 0;
+            bool v2              = false;
+            if(buf[0] == '$' && buf[1] == 'M') {
+                consumed = std::size_t(6 + buf[3]);
+                if(buf.size() < consumed) return;
+                id     = buf[4];
+                offset = 5;
+            }
+            else if(buf[0] == '$' && buf[1] == 'X') {
+                if(buf.size() < 9) return;
+                consumed = std::size_t(9 + (buf[6] | buf[7] << 8));
+                if(buf.size() < consumed) return;
+                id     = uint16_t(buf[4] | buf[5] << 8);
+                v2     = true;
+                offset = 8;
+            }
+            else {
+                buf.erase(buf.begin());
+                continue;
+            }
+            const std::vector<uint8_t> request(
+                buf.begin() + long(offset), buf.begin() + long(consumed - 1));
+            buf.erase(buf.begin(), buf.begin() + long(consumed));
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_[id]++;
+            if(drops_[id] > 0) {
+                drops_[id]--;
+                continue;
+            }
+            const std::vector<uint8_t> payload =
+                handlers_.count(id) ? handlers_[id](request) : responses_[id];
+            Reply reply;
+            reply.due = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(delay_ms_.load());
+            reply.frame =
+                v2 ? frameV2(id, payload) : frameV1(uint8_t(id), payload);
+            // the termios settings are shared by both sides of the pty
+            termios tio;
+            if(speed_ != 0 && tcgetattr(master_, &tio) == 0 &&
+               cfgetispeed(&tio) != speed_)
+                reply.frame.assign(reply.frame.size(), 0xF0);
+            replies.push_back(reply);
+            if(passthrough_handler_ && id == passthrough_id_) raw_mode_ = true;
+        }
+    }
+
+    int master_ = -1;
+    int slave_  = -1;
+    std::string path_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<int> delay_ms_;
+    std::atomic<speed_t> speed_;
+    std::atomic<bool> raw_mode_;
+    std::mutex mutex_;
+    std::map<uint16_t, std::vector<uint8_t>> responses_;
+    std::map<uint16_t, std::function<std::vector<uint8_t>(
+                           const std::vector<uint8_t>&)>>
+        handlers_;
+    std::map<uint16_t, int> requests_;
+    std::map<uint16_t, int> drops_;
+    uint16_t passthrough_id_;
+    std::function<std::vector<uint8_t>(const std::vector<uint8_t>&)>
+        passthrough_handler_;
+};
+
+/**
+ * @brief Polls a condition for up to five seconds
+ * @param condition Callable returning true once the condition holds
+ * @return True if the condition held within five seconds
+ */
+template <typename F> bool eventually(F condition) {
+    for(int i = 0; i < 500; ++i) {
+        if(condition()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+/**
+ * @brief Fixture with a client connected to a fake flight controller. The
+ * client is started in SetUp() and stopped in TearDown().
+ */
+class FakeClientTest : public ::testing::Test {
+protected:
+    void SetUp() override { ASSERT_TRUE(client.start(fc.path())); }
+
+    void TearDown() override { EXPECT_TRUE(client.stop()); }
+
+    FakeFlightController fc;
+    msp::client::Client client;
+};
+
+}  // namespace test
+}  // namespace msp
+
+#endif  // FAKE_FLIGHT_CONTROLLER_HPP
@@ -0,0 +1,88 @@
+#include "FlagSet.hpp"
+#include <set>
+#include <vector>
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+
+TEST(FlagSetTest, Initialization) {
+    FlagSet<size_t> f;
+    EXPECT_TRUE(f.empty());
+    EXPECT_EQ(std::size_t(0), f.size());
+    EXPECT_EQ(uint32_t(0), f.bits());
+    EXPECT_TRUE(f.begin() == f.end());
+}
+
+TEST(FlagSetTest, InsertErase) {
+    FlagSet<size_t> f;
+    EXPECT_TRUE(f.insert(3).second);
+    EXPECT_FALSE(f.insert(3).second);
+    EXPECT_TRUE(f.insert(31).second);
+    EXPECT_EQ(std::size_t(1), f.count(3));
+    EXPECT_EQ(std::size_t(1), f.count(31));
+    EXPECT_EQ(std::size_t(0), f.count(4));
+    EXPECT_EQ(std::size_t(2), f.size());
+    EXPECT_EQ(std::size_t(1), f.erase(3));
+    EXPECT_EQ(std::size_t(0), f.erase(3));
+    EXPECT_EQ(std::size_t(0), f.count(3));
+    EXPECT_EQ(uint32_t(1) << 31, f.bits());
+}
+
+TEST(FlagSetTest, OutOfRange) {
+    FlagSet<size_t> f;
+    EXPECT_FALSE(f.insert(32).second);
+    EXPECT_EQ(std::size_t(0), f.count(32));
+    EXPECT_EQ(std::size_t(0), f.count(1000));
+    EXPECT_TRUE(f.empty());
+}
+
+TEST(FlagSetTest, IterationOrder) {
+    FlagSet<size_t> f;
+    f.setBits(0x80000105);
+    const std::vector<size_t> keys(f.begin(), f.end());
+    EXPECT_EQ(std::vector<size_t>({0, 2, 8, 31}), keys);
+    EXPECT_EQ(std::size_t(8), *f.find(8));
+    EXPECT_TRUE(f.find(9) == f.end());
+}
+
+TEST(FlagSetTest, SetConversion) {
+    const FlagSet<msg::Sensor> f = {msg::Sensor::GPS,
+                                    msg::Sensor::Accelerometer};
+    const std::set<msg::Sensor> s = f;
+    EXPECT_EQ(std::set<msg::Sensor>(
+                  {msg::Sensor::Accelerometer, msg::Sensor::GPS}),
+              s);
+}
+
+TEST(FlagSetTest, StatusRoundTrip) {
+    msg::Status status(FirmwareVariant::BTFL);
+    status.cycle_time = 1000;
+    status.i2c_errors = 0;
+    status.sensors.insert(msg::Sensor::Barometer);
+    status.sensors.insert(msg::Sensor::GeneralHealth);
+    status.box_mode_flags.insert(0);
+    status.box_mode_flags.insert(31);
+
+    ByteVector data;
+    EXPECT_TRUE(status.pack_into(data));
+    // sensor flags on the wire
+    EXPECT_EQ(uint8_t(1 << 1), data[4]);
+    EXPECT_EQ(uint8_t(1 << 7), data[5]);
+    data.pack(uint8_t(0));
+
+    msg::Status decoded(FirmwareVariant::INAV);
+    EXPECT_TRUE(decoded.decode(data));
+    EXPECT_TRUE(decoded.hasBarometer());
+    EXPECT_TRUE(decoded.isHealthy());
+    EXPECT_FALSE(decoded.hasGPS());
+    EXPECT_EQ(status.box_mode_flags, decoded.box_mode_flags);
+    EXPECT_EQ(std::size_t(1), decoded.box_mode_flags.count(31));
+}
+
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
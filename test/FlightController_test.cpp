@@ -0,0 +1,185 @@
+#include "FlightController.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+static const uint16_t STATUS = uint16_t(msp::ID::MSP_STATUS);
+
+static const uint32_t ARM      = uint32_t(1) << 0;
+static const uint32_t FAILSAFE = uint32_t(1) << 27;
+
+// status of a Betaflight flight controller with the given active boxes
+static std::vector<uint8_t> statusPayload(const uint32_t boxes) {
+    return {0,
+            0,
+            0,
+            0,
+            0,
+            0,
+            uint8_t(boxes),
+            uint8_t(boxes >> 8),
+            uint8_t(boxes >> 16),
+            uint8_t(boxes >> 24),
+            0,
+            0,
+            0,
+            0,
+            0};
+}
+
+// answers the queries of the handshake of a Betaflight flight controller
+static void setIdentity(msp::test::FakeFlightController& fc,
+                        const std::string& board,
+                        const std::string& box_names,
+                        const std::vector<uint8_t>& box_ids) {
+    fc.setResponse(uint16_t(msp::ID::MSP_FC_VARIANT), {'B', 'T', 'F', 'L'});
+    fc.setResponse(uint16_t(msp::ID::MSP_API_VERSION), {0, 1, 42});
+    std::vector<uint8_t> info = {'S', '4', '0', '5', 0, 0, 0, 0};
+    info.push_back(uint8_t(board.size()));
+    info.insert(info.end(), board.begin(), board.end());
+    fc.setResponse(uint16_t(msp::ID::MSP_BOARD_INFO), info);
+    fc.setResponse(uint16_t(msp::ID::MSP_BOXNAMES),
+                   std::vector<uint8_t>(box_names.begin(), box_names.end()));
+    fc.setResponse(uint16_t(msp::ID::MSP_BOXIDS), box_ids);
+    fc.setResponse(STATUS, statusPayload(0));
+}
+
+class FlightControllerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        setIdentity(fc, "FAKE", "ARM;ANGLE;FAILSAFE;", {0, 1, 27});
+    }
+
+    msp::test::FakeFlightController fc;
+    FlightController fcu;
+};
+
+TEST_F(FlightControllerTest, ConnectSendsQueriesBackToBack) {
+    // one query after the other would take at least 0.8 s
+    fc.setDelay(100);
+    ASSERT_TRUE(fcu.connect(fc.path(), 115200, 2.0));
+    EXPECT_LT(fcu.getConnectTime(), 0.6);
+    EXPECT_EQ(1, fc.requests(uint16_t(msp::ID::MSP_BOARD_INFO)));
+    EXPECT_EQ(1, fc.requests(uint16_t(msp::ID::MSP_BOXNAMES)));
+    EXPECT_EQ(1, fc.requests(uint16_t(msp::ID::MSP_BOXIDS)));
+    EXPECT_EQ("FAKE", fcu.getBoardName());
+    const std::map<std::string, size_t> boxes = fcu.getBoxNames();
+    EXPECT_EQ(3u, boxes.size());
+    EXPECT_EQ(1u, boxes.count("FAILSAFE"));
+}
+
+TEST_F(FlightControllerTest, ConnectSkipsOptionalQueries) {
+    fc.dropNext(uint16_t(msp::ID::MSP_BOARD_INFO), 1);
+    fc.dropNext(uint16_t(msp::ID::MSP_IDENT), 1);
+    ASSERT_TRUE(fcu.connect(fc.path(), 115200, 0.3));
+    // the unanswered queries share the timeout
+    EXPECT_GE(fcu.getConnectTime(), 0.3);
+    EXPECT_LT(fcu.getConnectTime(), 0.55);
+    EXPECT_TRUE(fcu.getBoardName().empty());
+    EXPECT_EQ(3u, fcu.getBoxNames().size());
+    EXPECT_FALSE(fcu.isArmed());
+}
+
+TEST_F(FlightControllerTest, ConnectNeedsBoxes) {
+    fc.dropNext(uint16_t(msp::ID::MSP_BOXIDS), 1);
+    EXPECT_THROW(fcu.connect(fc.path(), 115200, 0.3), std::runtime_error);
+}
+
+TEST_F(FlightControllerTest, StaleStatusIsRequested) {
+    ASSERT_TRUE(fcu.connect(fc.path(), 115200, 1.0));
+    EXPECT_FALSE(fcu.isArmed());
+    EXPECT_FALSE(fcu.isStatusFailsafe());
+
+    // the stream only refreshes the status once per second, and the client
+    // caches the responses
+    fcu.setCacheTtl(msp::ID::MSP_STATUS, 10);
+    fcu.setStatusPeriod(1.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    fc.setResponse(STATUS, statusPayload(ARM | FAILSAFE));
+
+    // the cached status is too old for the caller
+    const int before = fc.requests(STATUS);
+    EXPECT_TRUE(fcu.isArmed(0.05));
+    EXPECT_EQ(before + 1, fc.requests(STATUS));
+    EXPECT_TRUE(fcu.isStatusFailsafe(0.05));
+    EXPECT_EQ(before + 1, fc.requests(STATUS));
+    // an older status is accepted from the stream
+    fc.setResponse(STATUS, statusPayload(0));
+    EXPECT_TRUE(fcu.isArmed());
+}
+
+TEST_F(FlightControllerTest, UnansweredStatusIsNotFalse) {
+    ASSERT_TRUE(fcu.connect(fc.path(), 115200, 1.0));
+    // the last polls of the stream are answered before the link slows down,
+    // and the cached status becomes too old
+    fcu.setStatusPeriod(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    fc.setResponse(STATUS, statusPayload(ARM | FAILSAFE));
+    fc.setDelay(300);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // an unknown state must not be reported as disarmed
+    EXPECT_THROW(fcu.isArmed(0.05), std::runtime_error);
+    EXPECT_THROW(fcu.isStatusFailsafe(0.05, 0.1), std::runtime_error);
+
+    // a patient caller gets the answer
+    EXPECT_TRUE(fcu.isStatusFailsafe(0.05, 2.0));
+}
+
+TEST(FlightControllerReconnect, OtherBoxLayout) {
+    // the device node is a symlink, which is replaced like a udev alias
+    char dir[] = "/tmp/msp_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    const std::string device = std::string(dir) + "/ttyFC";
+
+    std::unique_ptr<msp::test::FakeFlightController> fc(
+        new msp::test::FakeFlightController());
+    setIdentity(*fc, "FAKE", "ARM;ANGLE;FAILSAFE;", {0, 1, 27});
+    ASSERT_EQ(0, symlink(fc->path().c_str(), device.c_str()));
+
+    FlightController fcu;
+    fcu.setAutoReconnect(true, 0.01);
+    ASSERT_TRUE(fcu.connect(device, 115200, 1.0));
+    EXPECT_EQ(0u, fcu.getBoxNames().at("ARM"));
+    EXPECT_FALSE(fcu.isArmed());
+
+    // a flight controller with another firmware build, which has ARM at a
+    // different position, is plugged in
+    fc.reset();
+    ASSERT_EQ(0, unlink(device.c_str()));
+    fc.reset(new msp::test::FakeFlightController());
+    setIdentity(*fc, "OTHER", "ANGLE;FAILSAFE;ARM;", {1, 27, 5});
+    fc->setResponse(STATUS, statusPayload(uint32_t(1) << 5));
+    ASSERT_EQ(0, symlink(fc->path().c_str(), device.c_str()));
+    EXPECT_TRUE(msp::test::eventually(
+        [&fcu] { return fcu.getConnectionStats().reconnects == 1; }));
+
+    EXPECT_EQ("OTHER", fcu.getBoardName());
+    const std::map<std::string, size_t> boxes = fcu.getBoxNames();
+    EXPECT_EQ(3u, boxes.size());
+    EXPECT_EQ(5u, boxes.at("ARM"));
+    EXPECT_TRUE(fcu.isArmed());
+    EXPECT_FALSE(fcu.isStatusFailsafe());
+
+    fcu.disconnect();
+    unlink(device.c_str());
+    rmdir(dir);
+}
+
+}  // namespace fcu
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+#include "FontTransfer.hpp"
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+typedef std::array<uint8_t, OsdFont::VISIBLE_BYTES> Visible;
+
+/**
+ * @brief Character memory of the OSD of a flight controller
+ */
+class CharacterStore {
+public:
+    explicit CharacterStore(msp::test::FakeFlightController& fc) :
+        chars_(256, Visible()),
+        writes_(0) {
+        fc.setHandler(
+            uint16_t(msp::ID::MSP_OSD_CHAR_WRITE),
+            [this](const std::vector<uint8_t>& p) { return write(p); });
+        fc.setHandler(
+            uint16_t(msp::ID::MSP_OSD_CHAR_READ),
+            [this](const std::vector<uint8_t>& p) { return read(p); });
+    }
+
+    void load(const OsdFont& font) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(std::size_t i = 0; i < font.characters.size(); ++i) {
+            std::copy(font.characters[i].begin(),
+                      font.characters[i].begin() + OsdFont::VISIBLE_BYTES,
+                      chars_[i].begin());
+        }
+    }
+
+    Visible character(const std::size_t addr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return chars_[addr];
+    }
+
+    int writes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writes_;
+    }
+
+private:
+    std::vector<uint8_t> write(const std::vector<uint8_t>& p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::size_t addr_size = p.size() - OsdFont::VISIBLE_BYTES;
+        if(addr_size != 1 && addr_size != 2) return {};
+        const std::size_t addr = (addr_size == 1) ? p[0] : (p[0] | p[1] << 8);
+        std::copy(p.begin() + long(addr_size), p.end(), chars_[addr].begin());
+        writes_++;
+        return {};
+    }
+
+    std::vector<uint8_t> read(const std::vector<uint8_t>& p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(p.empty() || p.size() > 2) return {};
+        const std::size_t addr = (p.size() == 1) ? p[0] : (p[0] | p[1] << 8);
+        std::vector<uint8_t> r = {uint8_t(addr & 0xFF), uint8_t(addr >> 8)};
+        r.insert(r.end(), chars_[addr].begin(), chars_[addr].end());
+        return r;
+    }
+
+    std::mutex mutex_;
+    std::vector<Visible> chars_;
+    int writes_;
+};
+
+static OsdFont testFont() {
+    OsdFont font;
+    font.characters.resize(256);
+    for(std::size_t i = 0; i < font.characters.size(); ++i) {
+        for(std::size_t j = 0; j < OsdFont::CHARACTER_BYTES; ++j) {
+            font.characters[i][j] = uint8_t(i * 7 + j + 1);
+        }
+    }
+    return font;
+}
+
+static Visible visible(const OsdFont::Character& chr) {
+    Visible v;
+    std::copy(chr.begin(), chr.begin() + OsdFont::VISIBLE_BYTES, v.begin());
+    return v;
+}
+
+TEST(OsdFont, McmRoundTrip) {
+    const OsdFont font = testFont();
+    std::stringstream mcm;
+    ASSERT_TRUE(font.write(mcm));
+    EXPECT_EQ(0u, mcm.str().find("MAX7456\r\n"));
+
+    OsdFont parsed;
+    ASSERT_TRUE(parsed.read(mcm));
+    EXPECT_EQ(font.characters, parsed.characters);
+}
+
+TEST(OsdFont, RejectsMalformedFiles) {
+    OsdFont font;
+    std::istringstream header("MAX7457\n01010101\n");
+    EXPECT_FALSE(font.read(header));
+    std::istringstream digit("MAX7456\n01010102\n");
+    EXPECT_FALSE(font.read(digit));
+    // a partial character
+    std::istringstream partial("MAX7456\n01010101\n");
+    EXPECT_FALSE(font.read(partial));
+    std::istringstream empty("MAX7456\n");
+    EXPECT_FALSE(font.read(empty));
+}
+
+class FontTransferTest : public msp::test::FakeClientTest {
+protected:
+    FontTransferTest() : store(fc) {}
+
+    CharacterStore store;
+};
+
+TEST_F(FontTransferTest, UploadIsPipelined) {
+    fc.setDelay(5);
+    const OsdFont font = testFont();
+    std::vector<FontTransferProgress> progress;
+    FontTransferOptions options;
+    options.window   = 8;
+    options.progress = [&progress](const FontTransferProgress& p) {
+        progress.push_back(p);
+    };
+    const FontTransferReport report =
+        FontTransfer(client).upload(font, options);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_TRUE(report.readback);
+    EXPECT_EQ(std::size_t(256), report.written);
+    EXPECT_EQ(std::size_t(0), report.skipped);
+    EXPECT_EQ(256, store.writes());
+    for(std::size_t i = 0; i < font.characters.size(); ++i) {
+        EXPECT_EQ(visible(font.characters[i]), store.character(i));
+    }
+    // one write at a time would take 1.28 s, without the reads
+    EXPECT_LT(report.duration, 0.9);
+    EXPECT_GT(report.bytesPerSecond(), 0);
+
+    ASSERT_FALSE(progress.empty());
+    EXPECT_EQ(FontTransferPhase::VERIFY, progress.back().phase);
+    EXPECT_EQ(std::size_t(256), progress.back().done);
+    EXPECT_EQ(std::size_t(256), progress.back().total);
+    EXPECT_GT(progress.back().bytesPerSecond(), 0);
+}
+
+TEST_F(FontTransferTest, SkipsMatchingCharacters) {
+    OsdFont font = testFont();
+    store.load(font);
+    for(std::size_t i = 100; i < 110; ++i) font.characters[i][0] ^= 0xFF;
+    const FontTransferReport report = FontTransfer(client).upload(font);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(246), report.skipped);
+    EXPECT_EQ(std::size_t(10), report.written);
+    EXPECT_EQ(10, store.writes());
+    EXPECT_EQ(visible(font.characters[105]), store.character(105));
+}
+
+TEST_F(FontTransferTest, LostWriteIsRetried) {
+    fc.dropNext(uint16_t(msp::ID::MSP_OSD_CHAR_WRITE), 1);
+    FontTransferOptions options;
+    options.timeout = 0.1;
+    const OsdFont font = testFont();
+    const FontTransferReport report =
+        FontTransfer(client).upload(font, options);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(1), report.retries);
+    EXPECT_EQ(std::size_t(257), report.written);
+    EXPECT_EQ(visible(font.characters[0]), store.character(0));
+}
+
+TEST_F(FontTransferTest, UploadWithoutReadback) {
+    fc.dropNext(uint16_t(msp::ID::MSP_OSD_CHAR_READ), 1000);
+    FontTransferOptions options;
+    options.timeout = 0.1;
+    const OsdFont font = testFont();
+    const FontTransferReport report =
+        FontTransfer(client).upload(font, options);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_FALSE(report.readback);
+    EXPECT_EQ(std::size_t(256), report.written);
+    EXPECT_EQ(1, fc.requests(uint16_t(msp::ID::MSP_OSD_CHAR_READ)));
+    EXPECT_EQ(visible(font.characters[255]), store.character(255));
+}
+
+TEST_F(FontTransferTest, Download) {
+    const OsdFont font = testFont();
+    store.load(font);
+    OsdFont downloaded;
+    const FontTransferReport report =
+        FontTransfer(client).download(downloaded, 256);
+
+    EXPECT_TRUE(report.success);
+    ASSERT_EQ(std::size_t(256), downloaded.characters.size());
+    for(std::size_t i = 0; i < font.characters.size(); ++i) {
+        EXPECT_EQ(visible(font.characters[i]),
+                  visible(downloaded.characters[i]));
+    }
+}
+
+}  // namespace fcu
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
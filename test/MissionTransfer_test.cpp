@@ -0,0 +1,266 @@
+#include "MissionTransfer.hpp"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace fcu {
+
+/**
+ * @brief Waypoint store of an INAV flight controller. The first waypoint
+ * starts a new mission, every other waypoint is only accepted up to the one
+ * following the last accepted waypoint.
+ */
+class WaypointStore {
+public:
+    explicit WaypointStore(msp::test::FakeFlightController& fc) :
+        list_(255), count_(0), valid_(false), saved_(false), ignore_(0),
+        corrupt_(0) {
+        fc.setHandler(uint16_t(msp::ID::MSP_SET_WP),
+                      [this](const std::vector<uint8_t>& p) { return set(p); });
+        fc.setHandler(uint16_t(msp::ID::MSP_WP),
+                      [this](const std::vector<uint8_t>& p) { return get(p); });
+        fc.setHandler(uint16_t(msp::ID::MSP_WP_GETINFO),
+                      [this](const std::vector<uint8_t>&) { return info(); });
+        fc.setHandler(uint16_t(msp::ID::MSP_WP_MISSION_SAVE),
+                      [this](const std::vector<uint8_t>&) {
+                          std::lock_guard<std::mutex> lock(mutex_);
+                          saved_ = true;
+                          return std::vector<uint8_t>();
+                      });
+    }
+
+    // the next write of the waypoint is lost
+    void ignoreWrite(const uint8_t wp_no) { ignore_ = wp_no; }
+
+    // the next write of the waypoint stores a wrong latitude
+    void corruptWrite(const uint8_t wp_no) { corrupt_ = wp_no; }
+
+    void load(const Mission& mission) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(std::size_t i = 0; i < mission.size(); ++i) list_[i] = mission[i];
+        count_ = mission.size();
+        valid_ = true;
+    }
+
+    Mission mission() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return Mission(list_.begin(), list_.begin() + long(count_));
+    }
+
+    bool valid() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return valid_;
+    }
+
+    bool saved() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return saved_;
+    }
+
+private:
+    std::vector<uint8_t> set(const std::vector<uint8_t>& p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(p.size() != 21 || p[0] == 0) return {};
+        const std::size_t wp_no = p[0];
+        if(wp_no == ignore_) {
+            ignore_ = 0;
+            return {};
+        }
+        // the first waypoint starts a new mission
+        if(wp_no == 1) count_ = 0;
+        if(wp_no > count_ + 1) return {};
+        msp::ByteVector data(p.begin(), p.end());
+        Waypoint& wp = list_[wp_no - 1];
+        uint8_t no   = 0;
+        data.unpack(no);
+        data.unpack(wp.action);
+        data.unpack(wp.lat);
+        data.unpack(wp.lon);
+        data.unpack(wp.alt);
+        data.unpack(wp.p1);
+        data.unpack(wp.p2);
+        data.unpack(wp.p3);
+        data.unpack(wp.flag);
+        if(wp_no == corrupt_) {
+            corrupt_ = 0;
+            wp.lat ^= 0x100;
+        }
+        if(wp_no > count_) count_ = wp_no;
+        valid_ = (list_[count_ - 1].flag == 0xA5);
+        return {};
+    }
+
+    std::vector<uint8_t> get(const std::vector<uint8_t>& p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(p.size() != 1 || p[0] == 0) return {};
+        const Waypoint& wp = list_[p[0] - 1];
+        msp::ByteVector data;
+        data.pack(p[0]);
+        data.pack(wp.action);
+        data.pack(wp.lat);
+        data.pack(wp.lon);
+        data.pack(wp.alt);
+        data.pack(wp.p1);
+        data.pack(wp.p2);
+        data.pack(wp.p3);
+        data.pack(wp.flag);
+        return std::vector<uint8_t>(data.begin(), data.end());
+    }
+
+    std::vector<uint8_t> info() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {0, 120, uint8_t(valid_), uint8_t(count_)};
+    }
+
+    std::mutex mutex_;
+    std::vector<Waypoint> list_;
+    std::size_t count_;
+    bool valid_;
+    bool saved_;
+    std::size_t ignore_;
+    std::size_t corrupt_;
+};
+
+static Mission testMission(const std::size_t size) {
+    Mission mission(size);
+    for(std::size_t i = 0; i < size; ++i) {
+        mission[i].lat = 473977420 + int32_t(i) * 1000;
+        mission[i].lon = 85455940 - int32_t(i) * 1000;
+        mission[i].alt = 5000 + int32_t(i) * 10;
+        mission[i].p1  = uint16_t(i);
+    }
+    return mission;
+}
+
+// the uploaded mission with the flag of the last waypoint
+static Mission flagged(Mission mission) {
+    if(!mission.empty()) mission.back().flag = 0xA5;
+    return mission;
+}
+
+class MissionTransferTest : public msp::test::FakeClientTest {
+protected:
+    MissionTransferTest() : store(fc) {}
+
+    void SetUp() override {
+        client.setVariant(msp::FirmwareVariant::INAV);
+        FakeClientTest::SetUp();
+    }
+
+    WaypointStore store;
+};
+
+TEST_F(MissionTransferTest, UploadIsPipelined) {
+    fc.setDelay(10);
+    const Mission mission = testMission(60);
+    MissionTransfer transfer(client);
+    const MissionTransferReport report = transfer.upload(mission);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_TRUE(report.saved);
+    EXPECT_EQ(std::size_t(60), report.waypoints);
+    EXPECT_EQ(std::size_t(1), report.rounds);
+    EXPECT_EQ(std::size_t(0), report.retries);
+    EXPECT_TRUE(report.failed.empty());
+    EXPECT_EQ(flagged(mission), store.mission());
+    EXPECT_TRUE(store.valid());
+    EXPECT_TRUE(store.saved());
+    // a write and a read-back per waypoint would take 1.2 s one at a time
+    EXPECT_LT(report.duration, 0.6);
+}
+
+TEST_F(MissionTransferTest, LostReadBackIsRetried) {
+    fc.dropNext(uint16_t(msp::ID::MSP_WP), 3);
+    MissionTransferOptions options;
+    options.timeout = 0.1;
+    const Mission mission = testMission(20);
+    const MissionTransferReport report =
+        MissionTransfer(client).upload(mission, options);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(2), report.rounds);
+    EXPECT_EQ(std::size_t(3), report.retries);
+    EXPECT_EQ(flagged(mission), store.mission());
+}
+
+TEST_F(MissionTransferTest, LostWriteResendsTail) {
+    store.ignoreWrite(15);
+    const Mission mission = testMission(20);
+    const MissionTransferReport report =
+        MissionTransfer(client).upload(mission);
+
+    // the store rejects the waypoints behind the lost one
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(2), report.rounds);
+    EXPECT_EQ(std::size_t(6), report.retries);
+    EXPECT_EQ(flagged(mission), store.mission());
+    EXPECT_TRUE(store.valid());
+}
+
+TEST_F(MissionTransferTest, LostWriteOverStaleMission) {
+    const Mission mission = testMission(20);
+    store.load(flagged(mission));
+    store.ignoreWrite(15);
+    const MissionTransferReport report =
+        MissionTransfer(client).upload(mission);
+
+    // the stale waypoints read back correctly, the waypoint count does not
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(2), report.rounds);
+    EXPECT_EQ(std::size_t(6), report.retries);
+    EXPECT_EQ(flagged(mission), store.mission());
+}
+
+TEST_F(MissionTransferTest, CorruptedWaypointIsRewritten) {
+    store.corruptWrite(7);
+    const Mission mission = testMission(20);
+    const MissionTransferReport report =
+        MissionTransfer(client).upload(mission);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(2), report.rounds);
+    EXPECT_EQ(std::size_t(1), report.retries);
+    EXPECT_EQ(flagged(mission), store.mission());
+}
+
+TEST_F(MissionTransferTest, FailsWithoutReadBack) {
+    fc.dropNext(uint16_t(msp::ID::MSP_WP), 1000);
+    MissionTransferOptions options;
+    options.timeout     = 0.05;
+    options.max_retries = 1;
+    const MissionTransferReport report =
+        MissionTransfer(client).upload(testMission(10), options);
+
+    EXPECT_FALSE(report.success);
+    EXPECT_FALSE(report.saved);
+    EXPECT_EQ(std::size_t(2), report.rounds);
+    EXPECT_EQ(std::size_t(10), report.failed.size());
+    EXPECT_EQ(0, fc.requests(uint16_t(msp::ID::MSP_WP_MISSION_SAVE)));
+}
+
+TEST_F(MissionTransferTest, Download) {
+    const Mission mission = flagged(testMission(30));
+    store.load(mission);
+    fc.dropNext(uint16_t(msp::ID::MSP_WP), 2);
+    MissionTransferOptions options;
+    options.timeout = 0.1;
+    Mission downloaded;
+    const MissionTransferReport report =
+        MissionTransfer(client).download(downloaded, options);
+
+    EXPECT_TRUE(report.success);
+    EXPECT_EQ(std::size_t(30), report.waypoints);
+    EXPECT_EQ(std::size_t(2), report.retries);
+    EXPECT_EQ(mission, downloaded);
+}
+
+}  // namespace fcu
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
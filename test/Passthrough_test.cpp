@@ -0,0 +1,253 @@
+#include "PassthroughBridge.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+static const uint16_t SET_4WAY_IF = uint16_t(msp::ID::MSP_SET_4WAY_IF);
+static const uint16_t API_VERSION = uint16_t(msp::ID::MSP_API_VERSION);
+
+// leaves the passthrough on this byte, like the exit command of an ESC
+static const uint8_t EXIT = 0xEE;
+
+/**
+ * @brief Collects the bytes from the device
+ */
+class Sink {
+public:
+    PassthroughHandler handler() {
+        return [this](const uint8_t* data, const std::size_t size) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                bytes_.insert(bytes_.end(), data, data + size);
+            }
+            cv_.notify_all();
+        };
+    }
+
+    std::vector<uint8_t> wait(const std::size_t size) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::seconds(2),
+                     [&] { return bytes_.size() >= size; });
+        return bytes_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<uint8_t> bytes_;
+};
+
+// reads from a file descriptor until the size is reached
+static std::vector<uint8_t> readFd(const int fd, const std::size_t size) {
+    std::vector<uint8_t> bytes;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(bytes.size() < size && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if(poll(&pfd, 1, 50) <= 0) continue;
+        uint8_t tmp[4096];
+        const ssize_t n = read(fd, tmp, sizeof(tmp));
+        if(n <= 0) break;
+        bytes.insert(bytes.end(), tmp, tmp + n);
+    }
+    return bytes;
+}
+
+static std::vector<uint8_t> increment(const std::vector<uint8_t>& bytes) {
+    std::vector<uint8_t> out;
+    for(const uint8_t b : bytes) out.push_back(uint8_t(b + 1));
+    return out;
+}
+
+class PassthroughTest : public msp::test::FakeClientTest {
+protected:
+    void SetUp() override {
+        fc.setResponse(SET_4WAY_IF, {4});
+        fc.setResponse(API_VERSION, {0, 2, 4});
+        fc.setPassthrough(SET_4WAY_IF, [this](const std::vector<uint8_t>& b) {
+            for(const uint8_t c : b) {
+                if(c == EXIT) fc.leavePassthrough();
+            }
+            return increment(b);
+        });
+        FakeClientTest::SetUp();
+    }
+
+    msp::msg::Set4WayIF request() {
+        msp::msg::Set4WayIF set(client.getVariant());
+        set.esc_mode       = uint8_t(PassthroughMode::ESC_4WAY);
+        set.esc_port_index = 0;
+        return set;
+    }
+};
+
+TEST_F(PassthroughTest, BytesAreNotParsed) {
+    Sink sink;
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(client.enterPassthrough(set, sink.handler()));
+    EXPECT_EQ(4, set.esc_count());
+    EXPECT_TRUE(client.isPassthrough());
+
+    // becomes an MSP frame on the way back, which must not be dispatched
+    const std::vector<uint8_t> data = {'#', 'L', '=', 0xFF, 100, 100};
+    ASSERT_TRUE(client.writeRaw(data.data(), data.size()));
+    EXPECT_EQ(increment(data), sink.wait(data.size()));
+}
+
+TEST_F(PassthroughTest, LargeTransfer) {
+    Sink sink;
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(client.enterPassthrough(set, sink.handler()));
+
+    std::vector<uint8_t> data(64 * 1024);
+    for(std::size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t((i * 13) % EXIT);
+    for(std::size_t i = 0; i < data.size(); i += 1000) {
+        const std::size_t n = std::min<std::size_t>(1000, data.size() - i);
+        ASSERT_TRUE(client.writeRaw(data.data() + i, n));
+    }
+    EXPECT_EQ(increment(data), sink.wait(data.size()));
+}
+
+TEST_F(PassthroughTest, MspIsPaused) {
+    Sink sink;
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(client.enterPassthrough(set, sink.handler()));
+
+    msp::msg::ApiVersion version(client.getVariant());
+    EXPECT_FALSE(client.sendMessage(version, 0.1));
+    EXPECT_EQ(0, fc.requests(API_VERSION));
+}
+
+TEST_F(PassthroughTest, ReturnsToMsp) {
+    Sink sink;
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(client.enterPassthrough(set, sink.handler()));
+    EXPECT_FALSE(client.enterPassthrough(set, sink.handler()));
+
+    ASSERT_TRUE(client.writeRaw(&EXIT, 1));
+    EXPECT_EQ(std::vector<uint8_t>({uint8_t(EXIT + 1)}), sink.wait(1));
+    EXPECT_FALSE(fc.inPassthrough());
+
+    EXPECT_TRUE(client.stopPassthrough());
+    EXPECT_FALSE(client.isPassthrough());
+    EXPECT_FALSE(client.writeRaw(&EXIT, 1));
+    msp::msg::ApiVersion version(client.getVariant());
+    ASSERT_TRUE(client.sendMessage(version, 1.0));
+    EXPECT_EQ(2, version.major());
+    EXPECT_EQ(4, version.minor());
+}
+
+TEST_F(PassthroughTest, BridgeToPty) {
+    PassthroughBridge bridge(client);
+    const std::string path = bridge.openPty();
+    ASSERT_FALSE(path.empty());
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(bridge.start(set));
+    // the running bridge keeps its peer
+    EXPECT_TRUE(bridge.openPty().empty());
+    EXPECT_EQ(0, bridge.listenTcp());
+
+    const int fd = open(path.c_str(), O_RDWR | O_NOCTTY);
+    ASSERT_GE(fd, 0);
+    const std::vector<uint8_t> data = {1, 2, 3, '$', 'M', '<'};
+    ASSERT_EQ(ssize_t(data.size()), write(fd, data.data(), data.size()));
+    EXPECT_EQ(increment(data), readFd(fd, data.size()));
+    close(fd);
+
+    bridge.stop();
+    EXPECT_FALSE(client.isPassthrough());
+    EXPECT_EQ(data.size(), bridge.bytesToDevice());
+    EXPECT_EQ(data.size(), bridge.bytesFromDevice());
+    EXPECT_EQ(0u, bridge.bytesDropped());
+}
+
+TEST_F(PassthroughTest, SlowPeerDoesNotStallTheLink) {
+    PassthroughBridge bridge(client);
+    const std::string path = bridge.openPty();
+    ASSERT_FALSE(path.empty());
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(bridge.start(set));
+
+    // the peer writes but never reads, the bytes from the device pile up
+    const int fd = open(path.c_str(), O_RDWR | O_NOCTTY);
+    ASSERT_GE(fd, 0);
+    std::vector<uint8_t> data(200000);
+    for(std::size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t((i * 7) % EXIT);
+    const auto start    = std::chrono::steady_clock::now();
+    std::size_t written = 0;
+    while(written < data.size()) {
+        const ssize_t n =
+            write(fd, data.data() + written, data.size() - written);
+        if(n <= 0) break;
+        written += std::size_t(n);
+    }
+    ASSERT_EQ(data.size(), written);
+
+    // the receiving thread drops what the peer cannot take instead of
+    // waiting for it
+    const auto deadline = start + std::chrono::seconds(2);
+    while((bridge.bytesToDevice() < data.size() ||
+           bridge.bytesFromDevice() + bridge.bytesDropped() +
+                   64 * 1024 <
+               data.size()) &&
+          std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    EXPECT_LT(elapsed, 1.0);
+    EXPECT_EQ(data.size(), bridge.bytesToDevice());
+    EXPECT_GT(bridge.bytesDropped(), 0u);
+    close(fd);
+
+    bridge.stop();
+    EXPECT_FALSE(client.isPassthrough());
+}
+
+TEST_F(PassthroughTest, BridgeToTcp) {
+    PassthroughBridge bridge(client);
+    const uint16_t port = bridge.listenTcp();
+    ASSERT_NE(0, port);
+    msp::msg::Set4WayIF set = request();
+    ASSERT_TRUE(bridge.start(set));
+
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_in addr;
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0,
+              connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+
+    std::vector<uint8_t> data(10000);
+    for(std::size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t((i * 7) % EXIT);
+    ASSERT_EQ(ssize_t(data.size()), write(fd, data.data(), data.size()));
+    EXPECT_EQ(increment(data), readFd(fd, data.size()));
+    close(fd);
+
+    bridge.stop();
+    EXPECT_FALSE(client.isPassthrough());
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,433 @@
+#include "Proxy.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+
+namespace msp {
+namespace client {
+
+/**
+ * @brief Response frame received by a program
+ */
+struct Response {
+    uint8_t version   = 0;  ///<! 'M' or 'X'
+    uint8_t direction = 0;
+    uint16_t id       = 0;
+    std::vector<uint8_t> payload;
+};
+
+// request frames as sent by a program
+static std::vector<uint8_t> requestV1(const uint8_t id,
+                                      const std::vector<uint8_t>& p = {}) {
+    std::vector<uint8_t> f = {'$', 'M', '<', uint8_t(p.size()), id};
+    uint8_t crc            = uint8_t(p.size()) ^ id;
+    for(const uint8_t b : p) {
+        f.push_back(b);
+        crc ^= b;
+    }
+    f.push_back(crc);
+    return f;
+}
+
+// MSPv2 frame from the flag to the CRC
+static std::vector<uint8_t> bodyV2(const uint16_t id,
+                                   const std::vector<uint8_t>& p) {
+    std::vector<uint8_t> f = {0,
+                              uint8_t(id & 0xFF),
+                              uint8_t(id >> 8),
+                              uint8_t(p.size() & 0xFF),
+                              uint8_t(p.size() >> 8)};
+    for(const uint8_t b : p) f.push_back(b);
+    uint8_t crc = 0;
+    for(const uint8_t b : f) {
+        crc ^= b;
+        for(int k = 0; k < 8; ++k)
+            crc = (crc & 0x80) ? uint8_t((crc << 1) ^ 0xD5) : uint8_t(crc << 1);
+    }
+    f.push_back(crc);
+    return f;
+}
+
+static std::vector<uint8_t> requestV2(const uint16_t id,
+                                      const std::vector<uint8_t>& p = {}) {
+    std::vector<uint8_t> f = {'$', 'X', '<'};
+    for(const uint8_t b : bodyV2(id, p)) f.push_back(b);
+    return f;
+}
+
+static std::vector<uint8_t> requestV2OverV1(
+    const uint16_t id, const std::vector<uint8_t>& p = {}) {
+    return requestV1(255, bodyV2(id, p));
+}
+
+static std::string socketPath(const std::string& test) {
+    return "/tmp/msp-proxy-" + std::to_string(getpid()) + "-" + test;
+}
+
+static int connectUnix(const std::string& path) {
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int connectTcp(const uint16_t port) {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send(const int fd, const std::vector<uint8_t>& bytes) {
+    return write(fd, bytes.data(), bytes.size()) == ssize_t(bytes.size());
+}
+
+// reads until the number of responses is complete, tunneled MSPv2 frames are
+// unpacked
+static std::vector<Response> receive(const int fd, const std::size_t count) {
+    std::vector<Response> responses;
+    std::vector<uint8_t> buf;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while(responses.size() < count &&
+          std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if(poll(&pfd, 1, 50) <= 0) continue;
+        uint8_t tmp[4096];
+        const ssize_t n = read(fd, tmp, sizeof(tmp));
+        if(n <= 0) break;
+        buf.insert(buf.end(), tmp, tmp + n);
+        while(buf.size() >= 6) {
+            Response r;
+            r.version          = buf[1];
+            r.direction        = buf[2];
+            std::size_t offset = 0;
+            std::size_t size   = 0;
+            if(buf[1] == 'M') {
+                offset = 5;
+                size   = buf[3];
+                r.id   = buf[4];
+            }
+            else {
+                if(buf.size() < 9) break;
+                offset = 8;
+                size   = std::size_t(buf[6] | buf[7] << 8);
+                r.id   = uint16_t(buf[4] | buf[5] << 8);
+            }
+            if(buf.size() < offset + size + 1) break;
+            r.payload.assign(buf.begin() + long(offset),
+                             buf.begin() + long(offset + size));
+            buf.erase(buf.begin(), buf.begin() + long(offset + size + 1));
+            if(r.version == 'M' && r.id == 255 && r.payload.size() >= 6) {
+                // flag, ID, size, payload and CRC of the inner frame
+                r.id      = uint16_t(r.payload[1] | r.payload[2] << 8);
+                r.payload = std::vector<uint8_t>(r.payload.begin() + 5,
+                                                 r.payload.end() - 1);
+            }
+            responses.push_back(r);
+        }
+    }
+    return responses;
+}
+
+class ProxyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // every request is recorded in the order of the link
+        for(uint16_t id = 100; id < 110; ++id) {
+            fc.setHandler(id, [this, id](const std::vector<uint8_t>& p) {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(id);
+                return p.empty() ? std::vector<uint8_t>({uint8_t(id)}) : p;
+            });
+        }
+        ASSERT_TRUE(client.start(fc.path()));
+    }
+
+    void TearDown() override { EXPECT_TRUE(client.stop()); }
+
+    std::vector<uint16_t> linkOrder() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order;
+    }
+
+    msp::test::FakeFlightController fc;
+    Client client;
+    std::mutex mutex;
+    std::vector<uint16_t> order;
+};
+
+TEST_F(ProxyTest, Framings) {
+    client.setVersion(2);
+    Proxy proxy(client);
+    const std::string path = socketPath("framings");
+    ASSERT_TRUE(proxy.listenUnix(path));
+    ASSERT_TRUE(proxy.start());
+    const int fd = connectUnix(path);
+    ASSERT_GE(fd, 0);
+
+    ASSERT_TRUE(send(fd, requestV1(100)));
+    std::vector<Response> r = receive(fd, 1);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ('>', r[0].direction);
+    EXPECT_EQ(100, r[0].id);
+    EXPECT_EQ(std::vector<uint8_t>({100}), r[0].payload);
+
+    fc.setResponse(0x1001, {1, 2, 3});
+    ASSERT_TRUE(send(fd, requestV2(0x1001)));
+    r = receive(fd, 1);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ('X', r[0].version);
+    EXPECT_EQ('>', r[0].direction);
+    EXPECT_EQ(0x1001, r[0].id);
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), r[0].payload);
+
+    ASSERT_TRUE(send(fd, requestV2OverV1(0x1001)));
+    r = receive(fd, 1);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ('M', r[0].version);
+    EXPECT_EQ(0x1001, r[0].id);
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3}), r[0].payload);
+    close(fd);
+
+    proxy.stop();
+    EXPECT_NE(0, access(path.c_str(), F_OK));
+}
+
+TEST_F(ProxyTest, MergesDuplicatePolls) {
+    fc.setDelay(100);
+    client.markRead(msp::ID(100));
+    Proxy proxy(client);
+    const uint16_t port = proxy.listenTcp();
+    ASSERT_NE(0, port);
+    ASSERT_TRUE(proxy.start());
+
+    std::vector<int> fds;
+    for(int i = 0; i < 3; ++i) {
+        fds.push_back(connectTcp(port));
+        ASSERT_GE(fds.back(), 0);
+    }
+    for(const int fd : fds) ASSERT_TRUE(send(fd, requestV1(100)));
+    for(const int fd : fds) {
+        const std::vector<Response> r = receive(fd, 1);
+        ASSERT_EQ(1u, r.size());
+        EXPECT_EQ(std::vector<uint8_t>({100}), r[0].payload);
+        close(fd);
+    }
+    // the poll went over the link once
+    EXPECT_EQ(1, fc.requests(100));
+    const ProxyStats stats = proxy.stats();
+    EXPECT_EQ(3u, stats.requests);
+    EXPECT_EQ(1u, stats.forwarded);
+    EXPECT_EQ(2u, stats.merged);
+}
+
+TEST_F(ProxyTest, DoesNotMergeWrites) {
+    fc.setDelay(50);
+    Proxy proxy(client);
+    const uint16_t port = proxy.listenTcp();
+    ASSERT_NE(0, port);
+    ASSERT_TRUE(proxy.start());
+
+    // a command without payload, e.g. MSP_EEPROM_WRITE, is sent for every
+    // program
+    std::vector<int> fds;
+    for(int i = 0; i < 3; ++i) {
+        fds.push_back(connectTcp(port));
+        ASSERT_GE(fds.back(), 0);
+    }
+    for(const int fd : fds) ASSERT_TRUE(send(fd, requestV1(103)));
+    for(const int fd : fds) {
+        EXPECT_EQ(1u, receive(fd, 1).size());
+        close(fd);
+    }
+    EXPECT_EQ(3, fc.requests(103));
+    EXPECT_EQ(0u, proxy.stats().merged);
+}
+
+TEST_F(ProxyTest, KeepsOnlySocketsAtPath) {
+    Proxy proxy(client);
+    const std::string path = socketPath("file");
+    // a file which is not a socket is kept
+    FILE* file = fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, file);
+    fclose(file);
+    EXPECT_FALSE(proxy.listenUnix(path));
+    EXPECT_EQ(0, access(path.c_str(), F_OK));
+    unlink(path.c_str());
+
+    // a socket left behind is replaced
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un addr;
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(0, bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+    close(fd);
+    EXPECT_TRUE(proxy.listenUnix(path));
+    ASSERT_TRUE(proxy.start());
+    const int conn = connectUnix(path);
+    EXPECT_GE(conn, 0);
+    close(conn);
+    proxy.stop();
+}
+
+TEST_F(ProxyTest, KeepsOrderPerId) {
+    Proxy proxy(client);
+    const std::string path = socketPath("order");
+    ASSERT_TRUE(proxy.listenUnix(path));
+    ASSERT_TRUE(proxy.start());
+    const int fd = connectUnix(path);
+    ASSERT_GE(fd, 0);
+
+    // requests with payload are never merged
+    std::vector<uint8_t> bytes;
+    for(uint8_t i = 1; i <= 3; ++i) {
+        const std::vector<uint8_t> f = requestV1(101, {i});
+        bytes.insert(bytes.end(), f.begin(), f.end());
+    }
+    const std::vector<uint8_t> poll = requestV1(102);
+    bytes.insert(bytes.end(), poll.begin(), poll.end());
+    ASSERT_TRUE(send(fd, bytes));
+
+    const std::vector<Response> r = receive(fd, 4);
+    close(fd);
+    ASSERT_EQ(4u, r.size());
+    std::vector<std::vector<uint8_t>> payloads;
+    for(const Response& response : r) {
+        if(response.id == 101) payloads.push_back(response.payload);
+    }
+    EXPECT_EQ(std::vector<std::vector<uint8_t>>({{1}, {2}, {3}}), payloads);
+    EXPECT_EQ(3, fc.requests(101));
+    EXPECT_EQ(0u, proxy.stats().merged);
+}
+
+TEST_F(ProxyTest, SchedulesByPriorityAndInTurns) {
+    fc.setDelay(50);
+    ProxyOptions options;
+    options.max_in_flight = 1;
+    Proxy proxy(client, options);
+    const std::string path = socketPath("priority");
+    ASSERT_TRUE(proxy.listenUnix(path, 1));
+    const uint16_t port = proxy.listenTcp();
+    ASSERT_NE(0, port);
+    ASSERT_TRUE(proxy.start());
+
+    const int low1 = connectTcp(port);
+    const int low2 = connectTcp(port);
+    const int high = connectUnix(path);
+    ASSERT_GE(low1, 0);
+    ASSERT_GE(low2, 0);
+    ASSERT_GE(high, 0);
+
+    std::vector<uint8_t> bytes;
+    for(uint8_t id = 100; id < 103; ++id) {
+        const std::vector<uint8_t> f = requestV1(id);
+        bytes.insert(bytes.end(), f.begin(), f.end());
+    }
+    ASSERT_TRUE(send(low1, bytes));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bytes.clear();
+    for(uint8_t id = 103; id < 106; ++id) {
+        const std::vector<uint8_t> f = requestV1(id);
+        bytes.insert(bytes.end(), f.begin(), f.end());
+    }
+    ASSERT_TRUE(send(low2, bytes));
+    ASSERT_TRUE(send(high, requestV1(106)));
+
+    EXPECT_EQ(3u, receive(low1, 3).size());
+    EXPECT_EQ(3u, receive(low2, 3).size());
+    EXPECT_EQ(1u, receive(high, 1).size());
+    close(low1);
+    close(low2);
+    close(high);
+
+    // the high priority request overtakes the queued ones, the others take
+    // turns
+    EXPECT_EQ(std::vector<uint16_t>({100, 106, 103, 101, 104, 102, 105}),
+              linkOrder());
+}
+
+TEST_F(ProxyTest, ErrorsAndDisconnects) {
+    ProxyOptions options;
+    options.timeout   = 0.2;
+    options.max_queue = 2;
+    Proxy proxy(client, options);
+    const std::string path = socketPath("errors");
+    ASSERT_TRUE(proxy.listenUnix(path));
+    ASSERT_TRUE(proxy.start());
+    const int fd = connectUnix(path);
+    ASSERT_GE(fd, 0);
+
+    // an unanswered request gets an error frame
+    fc.dropNext(107, 100);
+    ASSERT_TRUE(send(fd, requestV1(107)));
+    std::vector<Response> r = receive(fd, 1);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ('!', r[0].direction);
+    EXPECT_EQ(107, r[0].id);
+    EXPECT_EQ(1u, proxy.stats().failed);
+
+    // corrupt frames are skipped, the next frame is answered
+    std::vector<uint8_t> bytes = requestV1(100);
+    bytes.back() ^= 0xFF;
+    const std::vector<uint8_t> valid = requestV1(100);
+    bytes.insert(bytes.end(), valid.begin(), valid.end());
+    ASSERT_TRUE(send(fd, bytes));
+    r = receive(fd, 1);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ('>', r[0].direction);
+    EXPECT_EQ(1u, proxy.stats().corrupt);
+
+    // requests beyond the queue limit are rejected
+    bytes.clear();
+    for(uint8_t id = 100; id < 104; ++id) {
+        const std::vector<uint8_t> f = requestV1(id);
+        bytes.insert(bytes.end(), f.begin(), f.end());
+    }
+    ASSERT_TRUE(send(fd, bytes));
+    r = receive(fd, 4);
+    ASSERT_EQ(4u, r.size());
+    EXPECT_EQ(2u, proxy.stats().rejected);
+
+    EXPECT_EQ(1u, proxy.connections());
+    close(fd);
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while(proxy.connections() > 0 &&
+          std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(0u, proxy.connections());
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,101 @@
+#include "PushStream.hpp"
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+static ByteVector push480(const uint32_t time, const int16_t acc_x) {
+    ByteVector data;
+    data.pack(time);
+    data.pack(acc_x);
+    for(int i = 0; i < 5; ++i) data.pack(int16_t(i));
+    return data;
+}
+
+TEST(PushStreamTest, Capacity) {
+    PushStream<msg::BtflPush480Data> stream(5);
+    EXPECT_EQ(std::size_t(8), stream.capacity());
+    EXPECT_EQ(std::size_t(0), stream.available());
+    msg::BtflPush480Data sample;
+    EXPECT_FALSE(stream.read(sample));
+}
+
+TEST(PushStreamTest, BatchRead) {
+    PushStream<msg::BtflPush480Data> stream(8);
+    for(uint32_t t = 0; t < 5; ++t) {
+        const ByteVector data = push480(t * 100, int16_t(t));
+        EXPECT_TRUE(stream.push(ByteView(data)));
+    }
+    EXPECT_EQ(std::size_t(5), stream.available());
+
+    msg::BtflPush480Data samples[3];
+    ASSERT_EQ(std::size_t(3), stream.read(samples, 3));
+    for(uint32_t t = 0; t < 3; ++t) {
+        EXPECT_EQ(t * 100, samples[t].current_time_us());
+        EXPECT_EQ(int16_t(t), samples[t].acc_x());
+        EXPECT_TRUE(samples[t].gyro_z().set());
+    }
+    ASSERT_EQ(std::size_t(2), stream.read(samples, 3));
+    EXPECT_EQ(uint32_t(400), samples[1].current_time_us());
+    EXPECT_EQ(std::size_t(0), stream.read(samples, 3));
+}
+
+TEST(PushStreamTest, DropWhenFull) {
+    PushStream<msg::BtflPush480Data> stream(4);
+    for(uint32_t t = 0; t < 6; ++t) {
+        const ByteVector data = push480(t, 0);
+        EXPECT_EQ(t < 4, stream.push(ByteView(data)));
+    }
+    PushStreamStats stats = stream.stats();
+    EXPECT_EQ(uint64_t(4), stats.received);
+    EXPECT_EQ(uint64_t(2), stats.dropped);
+    EXPECT_GT(stats.rate, 0);
+
+    // the oldest samples are kept
+    msg::BtflPush480Data sample;
+    ASSERT_TRUE(stream.read(sample));
+    EXPECT_EQ(uint32_t(0), sample.current_time_us());
+    stream.clear();
+    EXPECT_EQ(std::size_t(0), stream.available());
+}
+
+TEST(PushStreamTest, DecodeError) {
+    PushStream<msg::BtflPush480Data> stream(4);
+    const ByteVector data = {1, 2, 3};
+    EXPECT_FALSE(stream.push(ByteView(data)));
+    EXPECT_EQ(uint64_t(1), stream.stats().decode_errors);
+    EXPECT_EQ(std::size_t(0), stream.available());
+}
+
+TEST(PushStreamTest, ConcurrentReader) {
+    const uint32_t n = 100000;
+    PushStream<msg::BtflPush480Data> stream(64);
+    std::thread producer([&stream, n] {
+        for(uint32_t t = 1; t <= n; ++t) {
+            const ByteVector data = push480(t, 0);
+            while(!stream.push(ByteView(data))) std::this_thread::yield();
+        }
+    });
+
+    std::vector<msg::BtflPush480Data> samples(16);
+    uint32_t expected = 1;
+    while(expected <= n) {
+        const std::size_t count = stream.read(samples.data(), samples.size());
+        for(std::size_t i = 0; i < count; ++i, ++expected) {
+            ASSERT_EQ(expected, samples[i].current_time_us());
+        }
+        if(count == 0) std::this_thread::yield();
+    }
+    producer.join();
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+#ifndef REALTIME_MONITOR_HPP
+#define REALTIME_MONITOR_HPP
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace msp {
+namespace test {
+
+/**
+ * @brief Real time test mode. After the steady state has been marked, heap
+ * allocations and blocking mutex locks in the receiving thread (msp-io) and
+ * the request timers (msp-timer) are counted. It replaces the global operator
+ * new and interposes pthread_mutex_lock, so it must only be included by a
+ * single translation unit of a test binary.
+ */
+class RealtimeMonitor {
+public:
+    /**
+     * @brief Resets the counters and starts monitoring
+     */
+    static void markSteadyState() {
+        allocations_    = 0;
+        blocking_locks_ = 0;
+        armed_          = true;
+    }
+
+    /**
+     * @brief Stops monitoring, the counters are kept
+     */
+    static void stop() { armed_ = false; }
+
+    static int allocations() { return allocations_; }
+
+    static int blockingLocks() { return blocking_locks_; }
+
+    static void onAllocation() {
+        if(armed_ && monitoredThread()) allocations_++;
+    }
+
+    static int lock(pthread_mutex_t* mutex) {
+        if(armed_ && monitoredThread()) {
+            if(pthread_mutex_trylock(mutex) == 0) return 0;
+            blocking_locks_++;
+        }
+        // resolved on first use, which happens before any thread is started
+        if(real_lock_ == nullptr)
+            real_lock_ = reinterpret_cast<int (*)(pthread_mutex_t*)>(
+                dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        return real_lock_(mutex);
+    }
+
+private:
+    // the library names its threads, see ThreadPolicy
+    static bool monitoredThread() {
+        char name[16];
+        if(pthread_getname_np(pthread_self(), name, sizeof(name)) != 0)
+            return false;
+        return std::strncmp(name, "msp-io", 6) == 0 ||
+               std::strncmp(name, "msp-timer", 9) == 0;
+    }
+
+    static inline std::atomic<bool> armed_{false};
+    static inline std::atomic<int> allocations_{0};
+    static inline std::atomic<int> blocking_locks_{0};
+    static inline int (*real_lock_)(pthread_mutex_t*) = nullptr;
+};
+
+}  // namespace test
+}  // namespace msp
+
+// operator new is implemented with malloc, which GCC does not know
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    return msp::test::RealtimeMonitor::lock(mutex);
+}
+
+void* operator new(std::size_t size) {
+    msp::test::RealtimeMonitor::onAllocation();
+    void* p = std::malloc(size > 0 ? size : 1);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    msp::test::RealtimeMonitor::onAllocation();
+    const std::size_t a = std::size_t(align);
+    void* p             = std::aligned_alloc(a, (size + a - 1) / a * a);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // REALTIME_MONITOR_HPP
@@ -0,0 +1,97 @@
+#include "RealtimeMonitor.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+using test::eventually;
+using test::RealtimeMonitor;
+
+static RealtimeProfile testProfile() {
+    RealtimeProfile profile;
+    // mlockall needs CAP_IPC_LOCK or a large RLIMIT_MEMLOCK
+    profile.lock_memory = false;
+    return profile;
+}
+
+TEST(RealtimeMonitor, DetectsAllocationsAndBlockingLocks) {
+    std::mutex mutex;
+    std::unique_lock<std::mutex> held(mutex);
+    RealtimeMonitor::markSteadyState();
+    std::thread t([&mutex] {
+        pthread_setname_np(pthread_self(), "msp-io");
+        int* volatile p = new int(1);
+        delete p;
+        std::lock_guard<std::mutex> lock(mutex);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    held.unlock();
+    t.join();
+    RealtimeMonitor::stop();
+    EXPECT_EQ(1, RealtimeMonitor::allocations());
+    EXPECT_EQ(1, RealtimeMonitor::blockingLocks());
+}
+
+TEST(ClientRealtime, SubscriptionSteadyState) {
+    test::FakeFlightController fc;
+    fc.setResponse(uint16_t(msp::ID::MSP_ATTITUDE), {10, 0, 20, 0, 30, 0});
+    Client client;
+    client.setRealtimeProfile(testProfile());
+    ASSERT_TRUE(client.start(fc.path()));
+
+    std::atomic<int> received(0);
+    client.subscribe<msg::Attitude>(
+        [&received](const msg::Attitude&) { received++; }, 0.005);
+    ASSERT_TRUE(eventually([&received] { return received > 10; }));
+
+    RealtimeMonitor::markSteadyState();
+    const int before = received;
+    EXPECT_TRUE(eventually([&] { return received > before + 50; }));
+    RealtimeMonitor::stop();
+    EXPECT_EQ(0, RealtimeMonitor::allocations());
+    EXPECT_EQ(0, RealtimeMonitor::blockingLocks());
+    EXPECT_TRUE(client.stop());
+}
+
+TEST(ClientRealtime, PushStreamSteadyState) {
+    test::FakeFlightController fc;
+    Client client;
+    client.setVersion(2);
+    client.setRealtimeProfile(testProfile());
+    ASSERT_TRUE(client.start(fc.path()));
+    const auto stream = client.openPushStream<msg::BtflPush60>(256);
+
+    const std::vector<uint8_t> frame = test::FakeFlightController::frameV2(
+        uint16_t(msp::ID::MSP2_BTFL_PUSH_60), std::vector<uint8_t>(26, 1));
+    const auto send = [&](const int count) {
+        for(int i = 0; i < count; ++i) {
+            fc.sendRaw(frame);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+    send(20);
+    ASSERT_TRUE(eventually([&] { return stream->stats().received >= 20; }));
+
+    RealtimeMonitor::markSteadyState();
+    send(200);
+    EXPECT_TRUE(eventually([&] { return stream->stats().received >= 220; }));
+    RealtimeMonitor::stop();
+    EXPECT_EQ(0, RealtimeMonitor::allocations());
+    EXPECT_EQ(0, RealtimeMonitor::blockingLocks());
+    EXPECT_TRUE(client.stop());
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
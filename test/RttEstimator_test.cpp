@@ -0,0 +1,46 @@
+#include "RttEstimator.hpp"
+#include "gtest/gtest.h"
+
+namespace msp {
+namespace client {
+
+TEST(RttEstimatorTest, FirstSample) {
+    RttEstimator rtt;
+    EXPECT_EQ(std::size_t(0), rtt.samples());
+    // without measurements the maximum timeout is used
+    EXPECT_DOUBLE_EQ(1.0, rtt.timeout(0.01, 1.0));
+
+    rtt.update(0.1);
+    EXPECT_DOUBLE_EQ(0.1, rtt.srtt());
+    EXPECT_DOUBLE_EQ(0.05, rtt.rttvar());
+    EXPECT_DOUBLE_EQ(0.3, rtt.timeout(0.01, 1.0));
+}
+
+TEST(RttEstimatorTest, Smoothing) {
+    RttEstimator rtt;
+    rtt.update(0.1);
+    rtt.update(0.2);
+    EXPECT_DOUBLE_EQ(0.875 * 0.1 + 0.125 * 0.2, rtt.srtt());
+    EXPECT_DOUBLE_EQ(0.75 * 0.05 + 0.25 * 0.1, rtt.rttvar());
+
+    // a stable link converges to its round trip time
+    for(int i = 0; i < 200; ++i) rtt.update(0.01);
+    EXPECT_NEAR(0.01, rtt.srtt(), 1e-6);
+    EXPECT_NEAR(0.0, rtt.rttvar(), 1e-6);
+    EXPECT_DOUBLE_EQ(0.02, rtt.timeout(0.02, 1.0));
+    EXPECT_EQ(std::size_t(202), rtt.samples());
+}
+
+TEST(RttEstimatorTest, Bounds) {
+    RttEstimator rtt;
+    rtt.update(5.0);
+    EXPECT_DOUBLE_EQ(1.0, rtt.timeout(0.01, 1.0));
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,82 @@
+#include "SerialTuning.hpp"
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+
+namespace msp {
+namespace client {
+
+class SerialTuningTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(0, openpty(&master, &slave, nullptr, nullptr, nullptr));
+        path = ttyname(slave);
+        termios tio;
+        tcgetattr(slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    void TearDown() override {
+        close(master);
+        close(slave);
+    }
+
+    int master = -1;
+    int slave  = -1;
+    std::string path;
+};
+
+TEST_F(SerialTuningTest, CustomBaudrate) {
+    // not a standard rate of termios
+    ASSERT_TRUE(setCustomBaudrate(slave, 1500000));
+    EXPECT_EQ(1500000, querySerialStatus(slave, path).baudrate);
+    ASSERT_TRUE(setCustomBaudrate(slave, 921600));
+    EXPECT_EQ(921600, querySerialStatus(slave, path).baudrate);
+}
+
+TEST_F(SerialTuningTest, ReadTimeouts) {
+    SerialTuning tuning;
+    tuning.low_latency = false;
+    tuning.vmin        = 1;
+    tuning.vtime       = 2;
+    EXPECT_TRUE(applySerialTuning(slave, path, tuning));
+    const SerialStatus status = querySerialStatus(slave, path);
+    EXPECT_EQ(1, status.vmin);
+    EXPECT_EQ(2, status.vtime);
+}
+
+TEST_F(SerialTuningTest, FlushInput) {
+    ASSERT_EQ(3, write(master, "abc", 3));
+    pollfd pfd = {slave, POLLIN, 0};
+    ASSERT_EQ(1, poll(&pfd, 1, 1000));
+    SerialTuning tuning;
+    tuning.low_latency = false;
+    tuning.vmin        = 0;
+    EXPECT_TRUE(applySerialTuning(slave, path, tuning));
+    // VMIN = VTIME = 0 returns immediately, without the stale data
+    char c;
+    EXPECT_EQ(0, read(slave, &c, 1));
+}
+
+TEST_F(SerialTuningTest, PseudoTerminalHasNoUart) {
+    // a pty has neither serial_struct nor latency timer, the remaining
+    // settings are still applied
+    SerialTuning tuning;
+    applySerialTuning(slave, path, tuning);
+    const SerialStatus status = querySerialStatus(slave, path);
+    EXPECT_FALSE(status.low_latency);
+    EXPECT_EQ(-1, status.latency_timer);
+    EXPECT_EQ(1, status.vmin);
+    EXPECT_EQ(0, status.vtime);
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
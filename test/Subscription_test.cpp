@@ -0,0 +1,93 @@
+#include "Subscription.hpp"
+#include <atomic>
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+typedef Subscription<msg::Attitude> AttitudeSubscription;
+
+static std::unique_ptr<msg::Attitude> attitude() {
+    return std::make_unique<msg::Attitude>(FirmwareVariant::BTFL);
+}
+
+static ByteVector attitudeData(const int16_t yaw) {
+    ByteVector data;
+    data.pack(int16_t(15));
+    data.pack(int16_t(-20));
+    data.pack(yaw);
+    return data;
+}
+
+TEST(SubscriptionTest, FanOut) {
+    AttitudeSubscription sub(nullptr, attitude());
+    std::vector<const msg::Attitude *> received;
+    const auto callback = [&received](const msg::Attitude &a) {
+        received.push_back(&a);
+    };
+    const ListenerId a = sub.addListener(callback, 0);
+    const ListenerId b = sub.addListener(callback, 0);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(std::size_t(2), sub.listenerCount());
+
+    const ByteVector data = attitudeData(90);
+    sub.decode(ByteView(data));
+    // decoded once and shared by reference
+    ASSERT_EQ(std::size_t(2), received.size());
+    EXPECT_EQ(received[0], received[1]);
+    EXPECT_EQ(int16_t(90), received[0]->yaw());
+    EXPECT_FLOAT_EQ(1.5f, received[0]->roll());
+
+    EXPECT_TRUE(sub.removeListener(a));
+    EXPECT_FALSE(sub.removeListener(a));
+    sub.decode(ByteView(data));
+    EXPECT_EQ(std::size_t(3), received.size());
+}
+
+TEST(SubscriptionTest, ListenerRateLimit) {
+    AttitudeSubscription sub(nullptr, attitude());
+    int fast = 0;
+    int slow = 0;
+    sub.addListener([&fast](const msg::Attitude &) { ++fast; }, 0);
+    sub.addListener([&slow](const msg::Attitude &) { ++slow; }, 60);
+
+    const ByteVector data = attitudeData(0);
+    for(int i = 0; i < 5; ++i) sub.decode(ByteView(data));
+    EXPECT_EQ(5, fast);
+    EXPECT_EQ(1, slow);
+}
+
+TEST(SubscriptionTest, RequestPeriodIsSmallestListenerPeriod) {
+    std::atomic<int> requests(0);
+    AttitudeSubscription sub(
+        [&requests](const Message &) {
+            ++requests;
+            return true;
+        },
+        attitude());
+    EXPECT_FALSE(sub.isAutomatic());
+
+    const ListenerId a = sub.addListener(nullptr, 50);
+    EXPECT_DOUBLE_EQ(50, sub.getTimerPeriod());
+    const ListenerId b = sub.addListener(nullptr, 20);
+    EXPECT_DOUBLE_EQ(20, sub.getTimerPeriod());
+    sub.addListener(nullptr, 0);
+    EXPECT_DOUBLE_EQ(20, sub.getTimerPeriod());
+
+    EXPECT_TRUE(sub.setListenerPeriod(a, 10));
+    EXPECT_DOUBLE_EQ(10, sub.getTimerPeriod());
+    EXPECT_TRUE(sub.removeListener(a));
+    EXPECT_DOUBLE_EQ(20, sub.getTimerPeriod());
+    EXPECT_TRUE(sub.removeListener(b));
+    EXPECT_FALSE(sub.isAutomatic());
+    EXPECT_GT(requests, 0);
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "Client.hpp"
+#include "FakeFlightController.hpp"
+#include "TelemetryPublisher.hpp"
+#include "TelemetryReader.hpp"
+#include "gtest/gtest.h"
+#include "msp_msg.hpp"
+
+namespace msp {
+namespace client {
+
+static const uint16_t ATTITUDE = uint16_t(msp::ID::MSP_ATTITUDE);
+
+// roll 12.3, pitch -4.5 and yaw 90 degree
+static const ByteVector ATTITUDE_PAYLOAD = {123, 0, 0xD3, 0xFF, 90, 0};
+
+// region names are unique per process, so that tests can run in parallel
+static std::string regionName(const std::string& test) {
+    return "/msp-test-" + std::to_string(getpid()) + "-" + test;
+}
+
+TEST(TelemetryShm, LatestValue) {
+    TelemetryPublisher publisher(regionName("latest"));
+    ASSERT_TRUE(publisher.open());
+    TelemetryReader reader;
+    ASSERT_TRUE(reader.open(regionName("latest")));
+
+    msp::msg::Attitude attitude(FirmwareVariant::INAV);
+    EXPECT_FALSE(reader.latest(attitude));
+
+    ASSERT_TRUE(publisher.publish(msp::ID::MSP_ATTITUDE, ATTITUDE_PAYLOAD));
+    uint64_t stamp = 0;
+    ASSERT_TRUE(reader.latest(attitude, &stamp));
+    EXPECT_NEAR(12.3, attitude.roll(), 1e-4);
+    EXPECT_NEAR(-4.5, attitude.pitch(), 1e-4);
+    EXPECT_EQ(90, attitude.yaw());
+    EXPECT_GT(stamp, uint64_t(0));
+
+    // a newer payload replaces the slot
+    ASSERT_TRUE(publisher.publish(msp::ID::MSP_ATTITUDE,
+                                  ByteVector({0, 0, 0, 0, 1, 0})));
+    TelemetrySample sample;
+    ASSERT_TRUE(reader.latest(msp::ID::MSP_ATTITUDE, sample));
+    EXPECT_EQ(ATTITUDE, sample.id);
+    EXPECT_EQ(uint64_t(2), sample.sequence);
+    EXPECT_EQ(ByteVector({0, 0, 0, 0, 1, 0}), sample.payload);
+    EXPECT_FALSE(reader.latest(msp::ID::MSP_STATUS, sample));
+}
+
+TEST(TelemetryShm, RingKeepsArrivalOrder) {
+    TelemetryPublisherOptions options;
+    options.ring_capacity = 8;
+    TelemetryPublisher publisher(regionName("ring"), options);
+    ASSERT_TRUE(publisher.open());
+    TelemetryReader reader;
+    ASSERT_TRUE(reader.open(regionName("ring")));
+
+    for(uint8_t i = 0; i < 5; ++i)
+        publisher.publish(msp::ID(100 + i % 2), ByteVector({i}));
+    EXPECT_EQ(std::size_t(5), reader.available());
+
+    TelemetrySample samples[8];
+    ASSERT_EQ(std::size_t(5), reader.read(samples, 8));
+    for(uint8_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(100 + i % 2, samples[i].id);
+        EXPECT_EQ(ByteVector({i}), samples[i].payload);
+    }
+    EXPECT_FALSE(reader.read(samples[0]));
+
+    // the reader falls behind by more than the capacity
+    for(uint8_t i = 0; i < 20; ++i)
+        publisher.publish(msp::ID(100), ByteVector({i}));
+    ASSERT_EQ(std::size_t(8), reader.read(samples, 8));
+    EXPECT_EQ(uint64_t(12), reader.lost());
+    EXPECT_EQ(ByteVector({12}), samples[0].payload);
+    EXPECT_EQ(ByteVector({19}), samples[7].payload);
+}
+
+TEST(TelemetryShm, Limits) {
+    TelemetryPublisherOptions options;
+    options.slots       = 1;
+    options.max_payload = 4;
+    options.ids         = {msp::ID(100), msp::ID(101)};
+    TelemetryPublisher publisher(regionName("limits"), options);
+    ASSERT_TRUE(publisher.open());
+
+    EXPECT_TRUE(publisher.publish(msp::ID(100), ByteVector({1})));
+    EXPECT_FALSE(
+        publisher.publish(msp::ID(100), ByteVector({1, 2, 3, 4, 5})));
+    EXPECT_FALSE(publisher.publish(msp::ID(102), ByteVector({1})));
+    // without a free slot the payload still goes into the ring
+    EXPECT_TRUE(publisher.publish(msp::ID(101), ByteVector({2})));
+
+    const TelemetryPublisherStats stats = publisher.stats();
+    EXPECT_EQ(uint64_t(2), stats.published);
+    EXPECT_EQ(uint64_t(1), stats.oversized);
+    EXPECT_EQ(uint64_t(1), stats.no_slot);
+}
+
+TEST(TelemetryShm, RejectsForeignRegions) {
+    TelemetryReader reader;
+    EXPECT_FALSE(reader.open(regionName("missing")));
+    EXPECT_FALSE(reader.isOpen());
+
+    TelemetryPublisher publisher(regionName("closed"));
+    ASSERT_TRUE(publisher.open());
+    publisher.close();
+    EXPECT_FALSE(reader.open(regionName("closed")));
+}
+
+TEST(TelemetryShm, OtherProcess) {
+    // the name contains the pid of the parent
+    const std::string name = regionName("process");
+    TelemetryPublisher publisher(name);
+    ASSERT_TRUE(publisher.open());
+    ASSERT_TRUE(publisher.publish(msp::ID::MSP_ATTITUDE, ATTITUDE_PAYLOAD));
+
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if(pid == 0) {
+        TelemetryReader reader;
+        msp::msg::Attitude attitude(FirmwareVariant::INAV);
+        const bool ok = reader.open(name) &&
+                        reader.latest(attitude) && attitude.yaw() == 90;
+        _exit(ok ? 0 : 1);
+    }
+    int status = -1;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST(TelemetryShm, PublishesClientFrames) {
+    msp::test::FakeFlightController fc;
+    fc.setResponse(ATTITUDE, std::vector<uint8_t>(ATTITUDE_PAYLOAD.begin(),
+                                                  ATTITUDE_PAYLOAD.end()));
+    Client client;
+    ASSERT_TRUE(client.start(fc.path()));
+
+    TelemetryPublisher publisher(regionName("client"));
+    ASSERT_TRUE(publisher.open());
+    ASSERT_TRUE(publisher.attach(client));
+    TelemetryReader reader;
+    ASSERT_TRUE(reader.open(regionName("client")));
+
+    msp::msg::Attitude request(client.getVariant());
+    ASSERT_TRUE(client.sendMessage(request, 1.0));
+    msp::msg::Attitude attitude(client.getVariant());
+    ASSERT_TRUE(reader.latest(attitude));
+    EXPECT_NEAR(12.3, attitude.roll(), 1e-4);
+
+    TelemetrySample sample;
+    ASSERT_TRUE(reader.read(sample));
+    EXPECT_EQ(ATTITUDE, sample.id);
+
+    // no frames are published after detaching
+    publisher.detach();
+    ASSERT_TRUE(client.sendMessage(request, 1.0));
+    EXPECT_EQ(uint64_t(1), publisher.stats().published);
+    EXPECT_TRUE(client.stop());
+}
+
+}  // namespace client
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,142 @@
+#include "ThreadPolicy.hpp"
+#include <dirent.h>
+#include <sched.h>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <thread>
+#include "Client.hpp"
+#include "Executor.hpp"
+#include "FakeFlightController.hpp"
+#include "PeriodicTimer.hpp"
+#include "gtest/gtest.h"
+
+namespace msp {
+
+// policy and name of the calling thread
+struct ThreadState {
+    int sched = -1;
+    std::string name;
+    bool only_cpu0 = false;
+};
+
+static ThreadState currentThread() {
+    ThreadState state;
+    sched_param param;
+    pthread_getschedparam(pthread_self(), &state.sched, &param);
+    char name[16];
+    if(pthread_getname_np(pthread_self(), name, sizeof(name)) == 0)
+        state.name = name;
+    cpu_set_t set;
+    if(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+        state.only_cpu0 = CPU_ISSET(0, &set) && CPU_COUNT(&set) == 1;
+    return state;
+}
+
+static ThreadPolicy batchOnCpu0() {
+    ThreadPolicy policy;
+    policy.scheduler = ThreadPolicy::Scheduler::BATCH;
+    policy.cpus      = {0};
+    return policy;
+}
+
+TEST(ThreadPolicy, ApplyToThread) {
+    std::promise<void> applied;
+    std::promise<ThreadState> state;
+    std::thread t([&] {
+        applied.get_future().wait();
+        state.set_value(currentThread());
+    });
+    EXPECT_TRUE(
+        applyThreadPolicy(t.native_handle(), batchOnCpu0(), "msp-test"));
+    applied.set_value();
+    const ThreadState s = state.get_future().get();
+    t.join();
+    EXPECT_EQ(SCHED_BATCH, s.sched);
+    EXPECT_EQ("msp-test", s.name);
+    EXPECT_TRUE(s.only_cpu0);
+}
+
+TEST(ThreadPolicy, InheritKeepsThread) {
+    std::thread t([] {
+        const ThreadState before = currentThread();
+        EXPECT_TRUE(applyThreadPolicy(pthread_self(), ThreadPolicy(), ""));
+        const ThreadState after = currentThread();
+        EXPECT_EQ(before.sched, after.sched);
+        EXPECT_EQ(before.name, after.name);
+    });
+    t.join();
+}
+
+TEST(ThreadPolicy, TimerThread) {
+    std::promise<ThreadState> state;
+    std::atomic<bool> first(true);
+    PeriodicTimer timer(
+        [&] {
+            if(first.exchange(false)) state.set_value(currentThread());
+        },
+        0.01);
+    EXPECT_TRUE(timer.setThreadPolicy(batchOnCpu0()));
+    ASSERT_TRUE(timer.start());
+    const ThreadState s = state.get_future().get();
+    timer.stop();
+    EXPECT_EQ(SCHED_BATCH, s.sched);
+    EXPECT_EQ("msp-timer", s.name);
+    EXPECT_TRUE(s.only_cpu0);
+}
+
+TEST(ThreadPolicy, PoolThreads) {
+    std::promise<ThreadState> state;
+    {
+        client::ThreadPool pool(2, batchOnCpu0());
+        pool.post([&state] { state.set_value(currentThread()); });
+    }
+    const ThreadState s = state.get_future().get();
+    EXPECT_EQ(SCHED_BATCH, s.sched);
+    EXPECT_EQ(0u, s.name.find("msp-pool-"));
+    EXPECT_TRUE(s.only_cpu0);
+}
+
+// scheduling class of the threads of this process with the given name
+static std::vector<int> threadsNamed(const std::string& name) {
+    std::vector<int> policies;
+    DIR* dir = opendir("/proc/self/task");
+    if(dir == nullptr) return policies;
+    while(const dirent* entry = readdir(dir)) {
+        if(entry->d_name[0] == '.') continue;
+        std::ifstream comm(std::string("/proc/self/task/") + entry->d_name +
+                           "/comm");
+        std::string comm_name;
+        std::getline(comm, comm_name);
+        if(comm_name == name)
+            policies.push_back(sched_getscheduler(std::stoi(entry->d_name)));
+    }
+    closedir(dir);
+    return policies;
+}
+
+TEST(ThreadPolicy, ClientThreads) {
+    test::FakeFlightController fc;
+    client::Client client;
+    client::ThreadConfig config;
+    config.io = batchOnCpu0();
+    EXPECT_TRUE(client.setThreadConfig(config));
+    ASSERT_TRUE(client.start(fc.path()));
+    // the read thread applies the policy when it starts
+    for(int i = 0; i < 100 && threadsNamed("msp-io").empty(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(std::vector<int>{SCHED_BATCH}, threadsNamed("msp-io"));
+
+    // running threads are updated immediately
+    config.io.scheduler = ThreadPolicy::Scheduler::IDLE;
+    EXPECT_TRUE(client.setThreadConfig(config));
+    EXPECT_EQ(std::vector<int>{SCHED_IDLE}, threadsNamed("msp-io"));
+    EXPECT_TRUE(client.stop());
+}
+
+}  // namespace msp
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -132,6 +132,87 @@ TEST(valueTest, ByteVecAssign) {
     EXPECT_EQ(true, v2.set());
 }
 
+TEST(valueTest, TriviallyCopyable) {
+    EXPECT_TRUE(std::is_trivially_copyable<Value<uint32_t>>::value);
+    EXPECT_TRUE(std::is_trivially_copyable<Value<float>>::value);
+    EXPECT_TRUE(std::is_trivially_copyable<ValueMask<>>::value);
+}
+
+struct MaskedFields {
+    ValueMask<> present;
+    uint32_t a_ = 0;
+    uint8_t b_  = 0;
+
+    ValueRef<uint32_t> a() { return present.ref(a_, 0); }
+    ValueRef<const uint32_t> a() const { return present.ref(a_, 0); }
+    ValueRef<uint8_t> b() { return present.ref(b_, 1); }
+    ValueRef<const uint8_t> b() const { return present.ref(b_, 1); }
+};
+
+TEST(valueTest, MaskInit) {
+    const MaskedFields f;
+    EXPECT_EQ(uint32_t(0), f.present.bits());
+    EXPECT_FALSE(f.a().set());
+    EXPECT_FALSE(f.b().set());
+    EXPECT_EQ(uint32_t(0), f.a()());
+}
+
+TEST(valueTest, MaskAssign) {
+    MaskedFields f;
+    f.a() = 42;
+    EXPECT_TRUE(f.a().set());
+    EXPECT_FALSE(f.b().set());
+    EXPECT_EQ(uint32_t(42), f.a()());
+    EXPECT_EQ(uint32_t(42), uint32_t(f.a()));
+    EXPECT_EQ(uint32_t(1), f.present.bits());
+
+    f.a().set() = false;
+    EXPECT_FALSE(f.a().set());
+    EXPECT_EQ(uint32_t(42), f.a_);
+
+    // copy value and presence flag from another field
+    MaskedFields g;
+    g.b() = 7;
+    f.b() = static_cast<const MaskedFields&>(g).b();
+    EXPECT_TRUE(f.b().set());
+    EXPECT_EQ(uint8_t(7), f.b()());
+    f.a() = static_cast<const MaskedFields&>(g).a();
+    EXPECT_FALSE(f.a().set());
+}
+
+TEST(valueTest, MaskPackUnpack) {
+    MaskedFields f;
+    ByteVector b;
+    // unset fields cannot be packed
+    EXPECT_FALSE(b.pack(f.a()));
+    f.a() = 0x01020304;
+    f.b() = 5;
+    EXPECT_TRUE(b.pack(f.a()));
+    EXPECT_TRUE(b.pack(f.b()));
+    EXPECT_EQ(std::size_t(5), b.size());
+
+    MaskedFields g;
+    const ByteView v(b);
+    EXPECT_TRUE(v.unpack(g.a()));
+    EXPECT_TRUE(v.unpack(g.b()));
+    EXPECT_EQ(f.present.bits(), g.present.bits());
+    EXPECT_EQ(f.a_, g.a_);
+    EXPECT_EQ(f.b_, g.b_);
+    // failed unpack clears the flag
+    EXPECT_FALSE(v.unpack(g.b()));
+    EXPECT_FALSE(g.b().set());
+}
+
+TEST(valueTest, MaskScaled) {
+    ValueMask<> present;
+    float alt = 0;
+    ByteVector b;
+    EXPECT_TRUE(b.pack<int32_t>(12.34f, 100.f));
+    EXPECT_TRUE(b.unpack<int32_t>(present.ref(alt, 3), 100.f));
+    EXPECT_TRUE(present.test(3));
+    EXPECT_FLOAT_EQ(12.34f, alt);
+}
+
 }  // namespace msp
 
 int main(int argc, char **argv) {